@@ -34,18 +34,10 @@ public:
   GLBuffer lightIndexBuffer{GL_ELEMENT_ARRAY_BUFFER};
 
   GLArray planeArray;
-  GLBuffer planePosBuffer{GL_ARRAY_BUFFER};
-  GLBuffer planeNormalBuffer{GL_ARRAY_BUFFER};
-  GLBuffer planeTangentBuffer{GL_ARRAY_BUFFER};
-  GLBuffer planeBinormalBuffer{GL_ARRAY_BUFFER};
-  GLBuffer planeTexCoordBuffer{GL_ARRAY_BUFFER};
+  GLBuffer planeBuffer{GL_ARRAY_BUFFER};
 
   GLArray teapotArray;
-  GLBuffer teapotPosBuffer{GL_ARRAY_BUFFER};
-  GLBuffer teapotNormalBuffer{GL_ARRAY_BUFFER};
-  GLBuffer teapotTangBuffer{GL_ARRAY_BUFFER};
-  GLBuffer teapotBinBuffer{GL_ARRAY_BUFFER};
-  GLBuffer teapotTexCoordBuffer{GL_ARRAY_BUFFER};
+  GLBuffer teapotBuffer{GL_ARRAY_BUFFER};
   GLBuffer teapotIndexBuffer{GL_ELEMENT_ARRAY_BUFFER};
 
   bool leftMouseDown{false};
@@ -71,6 +63,9 @@ public:
   virtual void init() override {
     setupTextures();
     setupGeometry();
+    shaderWatcher.watch(pPhong);
+    shaderWatcher.watch(pLight);
+    shaderWatcher.watch(pSimpleTex);
     GL(glDisable(GL_CULL_FACE));
     GL(glEnable(GL_DEPTH_TEST));
     GL(glDepthFunc(GL_LESS));
@@ -79,17 +74,10 @@ public:
   }
 
   void setupTextures() {
-    Image image = ImageLoader::load("res/Stones_Diffuse.png");
-    stonesDiffuse.setData(image.data,image.width, image.height, image.componentCount);
-
-    image = ImageLoader::load("res/Stones_Specular.png");
-    stonesSpecular.setData(image.data,image.width, image.height, image.componentCount);
-
-    image = ImageLoader::load("res/Stones_Normals.png");
-    stonesNormals.setData(image.data,image.width, image.height, image.componentCount);
-
-    image = ImageLoader::load("res/UDE_Normals.png");
-    udeNormals.setData(image.data,image.width, image.height, image.componentCount);
+    textureLoader.requestCompressed(stonesDiffuse, "res/Stones_Diffuse.png", BCFormat::BC1);
+    textureLoader.requestCompressed(stonesSpecular, "res/Stones_Specular.png", BCFormat::BC1);
+    textureLoader.request(stonesNormals, "res/Stones_Normals.png");
+    textureLoader.request(udeNormals, "res/UDE_Normals.png");
   }
 
   virtual void animate(double animationTime) override {
@@ -112,7 +100,7 @@ public:
 
     pLight.setUniform("MVP", projectionMatrix * viewMatrix * lightModelMatrix);
     lightArray.bind();
-    GL(glDrawElements(GL_TRIANGLES, sizeof(UnitCube::indices) / sizeof(UnitCube::indices[0]), GL_UNSIGNED_INT, (void*)0));
+    GL(glDrawElements(GL_TRIANGLES, GLsizei(lightIndexBuffer.getCount()), lightIndexBuffer.getType(), (void*)0));
 
     pSimpleTex.enable();
     Mat4 modelMatrix = Mat4::scaling(100, 100, 100);
@@ -128,7 +116,7 @@ public:
     pSimpleTex.setTexture("ts", stonesSpecular, 1);
     pSimpleTex.setTexture("tNormals", stonesNormals, 2);
     planeArray.bind();
-    GL(glDrawArrays(GL_TRIANGLES, 0, sizeof(UnitPlane::vertices) / (3*sizeof(UnitPlane::vertices[0]))));
+    GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(planeBuffer.getCount())));
 
     modelMatrix = {};
     modelView = viewMatrix * modelMatrix;
@@ -142,7 +130,7 @@ public:
     pPhong.setUniform("lightPosition", lightPosition);
     pPhong.setTexture("tNormals", udeNormals, 0);
     teapotArray.bind();
-    GL(glDrawElements(GL_TRIANGLES, sizeof(Teapot::indices) / sizeof(Teapot::indices[0]), GL_UNSIGNED_INT, (void*)0));
+    GL(glDrawElements(GL_TRIANGLES, GLsizei(teapotIndexBuffer.getCount()), teapotIndexBuffer.getType(), (void*)0));
   }
 
   virtual void resize(int width, int height) override {
@@ -159,50 +147,30 @@ public:
     lightIndexBuffer.setData(UnitCube::indices, sizeof(UnitCube::indices)/sizeof(UnitCube::indices[0]));
 
 
-    planePosBuffer.setData(UnitPlane::vertices,
-                        sizeof(UnitPlane::vertices)/sizeof(UnitPlane::vertices[0]),
-                        3, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planePosBuffer, pSimpleTex, "vertexPosition", 3);
-    planeNormalBuffer.setData(UnitPlane::normals,
-                           sizeof(UnitPlane::normals)/sizeof(UnitPlane::normals[0]),
-                           3, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planeNormalBuffer, pSimpleTex, "vertexNormal", 3);
-    planeTangentBuffer.setData(UnitPlane::tangents,
-                           sizeof(UnitPlane::tangents)/sizeof(UnitPlane::tangents[0]),
-                           3, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planeTangentBuffer, pSimpleTex, "vertexTangent", 3);
-    planeBinormalBuffer.setData(UnitPlane::binormals,
-                           sizeof(UnitPlane::binormals)/sizeof(UnitPlane::binormals[0]),
-                           3, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planeBinormalBuffer, pSimpleTex, "vertexBinormal", 3);
-    planeTexCoordBuffer.setData(UnitPlane::texCoords,
-                              sizeof(UnitPlane::texCoords)/sizeof(UnitPlane::texCoords[0]),
-                              2, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planeTexCoordBuffer, pSimpleTex, "texCoords", 2);
-
-
-
-
-    teapotPosBuffer.setData(Teapot::vertices,
-                           sizeof(Teapot::vertices)/sizeof(Teapot::vertices[0]),
-                           3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotPosBuffer, pPhong, "vertexPosition", 3);
-    teapotNormalBuffer.setData(Teapot::normals,
-                              sizeof(Teapot::normals)/sizeof(Teapot::normals[0]),
-                              3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotNormalBuffer, pPhong, "vertexNormal", 3);
-    teapotTangBuffer.setData(Teapot::tangents,
-                            sizeof(Teapot::tangents)/sizeof(Teapot::tangents[0]),
-                            3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotTangBuffer, pPhong, "vertexTangent", 3);
-    teapotBinBuffer.setData(Teapot::binormals,
-                           sizeof(Teapot::binormals)/sizeof(Teapot::binormals[0]),
-                           3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotBinBuffer, pPhong, "vertexBinormal", 3);
-    teapotTexCoordBuffer.setData(Teapot::texCoords,
-                                sizeof(Teapot::texCoords)/sizeof(Teapot::texCoords[0]),
-                                3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotTexCoordBuffer, pPhong, "texCoords", 2);
+    // position, normal, tangent, binormal and texture coordinates interleaved in one buffer
+    const VertexFormat planeFormat{{"vertexPosition", GLAttribType::FLOAT, 3},
+                                   {"vertexNormal", GLAttribType::FLOAT, 3},
+                                   {"vertexTangent", GLAttribType::FLOAT, 3},
+                                   {"vertexBinormal", GLAttribType::FLOAT, 3},
+                                   {"texCoords", GLAttribType::FLOAT, 2}};
+    planeBuffer.setData(planeFormat.pack({{UnitPlane::vertices}, {UnitPlane::normals},
+                                          {UnitPlane::tangents}, {UnitPlane::binormals},
+                                          {UnitPlane::texCoords}},
+                                         sizeof(UnitPlane::vertices)/(3*sizeof(UnitPlane::vertices[0]))),
+                        planeFormat);
+    planeArray.configure(planeBuffer, planeFormat, pSimpleTex);
+
+    const VertexFormat teapotFormat{{"vertexPosition", GLAttribType::FLOAT, 3},
+                                    {"vertexNormal", GLAttribType::FLOAT, 3},
+                                    {"vertexTangent", GLAttribType::FLOAT, 3},
+                                    {"vertexBinormal", GLAttribType::FLOAT, 3},
+                                    {"texCoords", GLAttribType::FLOAT, 2}};
+    teapotBuffer.setData(teapotFormat.pack({{Teapot::vertices}, {Teapot::normals},
+                                            {Teapot::tangents}, {Teapot::binormals},
+                                            {Teapot::texCoords, 3}},
+                                           sizeof(Teapot::vertices)/(3*sizeof(Teapot::vertices[0]))),
+                         teapotFormat);
+    teapotArray.configure(teapotBuffer, teapotFormat, pPhong);
     teapotIndexBuffer.setData(Teapot::indices, sizeof(Teapot::indices)/sizeof(Teapot::indices[0]));
   }
 
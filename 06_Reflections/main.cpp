@@ -1,7 +1,10 @@
+#include <algorithm>
+
 #include <ImageLoader.h>
 #include <GLApp.h>
 #include <Vec2.h>
 #include <GLFramebuffer.h>
+#include <SceneGraph.h>
 
 #include "Teapot.h"
 #include "UnitPlane.h"
@@ -26,6 +29,12 @@ public:
 };
 
 
+enum SceneObject : int32_t {
+  PLANE,
+  TEAPOT,
+  LIGHT
+};
+
 class MyGLApp : public GLApp {
 public:
   LightProperties light;
@@ -45,18 +54,10 @@ public:
   GLBuffer lightIndexBuffer{GL_ELEMENT_ARRAY_BUFFER};
 
   GLArray planeArray;
-  GLBuffer planePosBuffer{GL_ARRAY_BUFFER};
-  GLBuffer planeNormalBuffer{GL_ARRAY_BUFFER};
-  GLBuffer planeTangBuffer{GL_ARRAY_BUFFER};
-  GLBuffer planeBinBuffer{GL_ARRAY_BUFFER};
-  GLBuffer planeTexCoordBuffer{GL_ARRAY_BUFFER};
+  GLBuffer planeBuffer{GL_ARRAY_BUFFER};
 
   GLArray teapotArray;
-  GLBuffer teapotPosBuffer{GL_ARRAY_BUFFER};
-  GLBuffer teapotNormalBuffer{GL_ARRAY_BUFFER};
-  GLBuffer teapotTangBuffer{GL_ARRAY_BUFFER};
-  GLBuffer teapotBinBuffer{GL_ARRAY_BUFFER};
-  GLBuffer teapotTexCoordBuffer{GL_ARRAY_BUFFER};
+  GLBuffer teapotBuffer{GL_ARRAY_BUFFER};
   GLBuffer teapotIndexBuffer{GL_ELEMENT_ARRAY_BUFFER};
 
   GLProgram shadowProgram;
@@ -82,6 +83,12 @@ public:
   float mouseSensitivity{0.15f}; // system specific factor
   float mousewheelFactor{10.0f}; // system specific factor
 
+  SceneGraph scene;
+  SceneGraph::NodeID lightOrbitNode;
+  SceneGraph::NodeID lightNode;
+  std::vector<SceneGraph::VisibleObject> visibleObjects;
+  std::vector<SceneGraph::VisibleObject> shadowCasters;
+
   Mat4 viewMatrix;
   Mat4 lightModelMatrix;
   Mat4 lightProjectionMatrix;
@@ -103,6 +110,10 @@ public:
   virtual void init() override {
     setupTextures();
     setupGeometry();
+    shaderWatcher.watch(pPhongBump);
+    shaderWatcher.watch(pPhongBumpTex);
+    shaderWatcher.watch(pLight);
+    setupScene();
     GL(glDisable(GL_CULL_FACE)); // the teapot is not watertight
     GL(glEnable(GL_DEPTH_TEST));
     GL(glDepthFunc(GL_LESS));
@@ -112,21 +123,25 @@ public:
   }
 
   void setupTextures() {
-    Image image = ImageLoader::load("res/Stones_Diffuse.png");
-    stonesDiffuse.setData(image.data,image.width, image.height, image.componentCount);
-
-    image = ImageLoader::load("res/Stones_Specular.png");
-    stonesSpecular.setData(image.data,image.width, image.height, image.componentCount);
-
-    image = ImageLoader::load("res/Stones_Normals.png");
-    stonesNormals.setData(image.data,image.width, image.height, image.componentCount);
+    textureLoader.requestCompressed(stonesDiffuse, "res/Stones_Diffuse.png", BCFormat::BC1);
+    textureLoader.requestCompressed(stonesSpecular, "res/Stones_Specular.png", BCFormat::BC1);
+    textureLoader.request(stonesNormals, "res/Stones_Normals.png");
+    textureLoader.request(udeNormals, "res/UDE_Normals.png");
+  }
 
-    image = ImageLoader::load("res/UDE_Normals.png");
-    udeNormals.setData(image.data,image.width, image.height, image.componentCount);
+  void setupScene() {
+    const SceneGraph::NodeID plane = scene.addNode(SceneGraph::NO_PARENT, Mat4::scaling(100, 100, 100), PLANE);
+    scene.setLocalBounds(plane, AABB::fromPoints(UnitPlane::vertices, sizeof(UnitPlane::vertices)/(3*sizeof(UnitPlane::vertices[0]))));
+    const SceneGraph::NodeID teapot = scene.addNode(SceneGraph::NO_PARENT, Mat4{}, TEAPOT);
+    scene.setLocalBounds(teapot, AABB::fromPoints(Teapot::vertices, sizeof(Teapot::vertices)/(3*sizeof(Teapot::vertices[0]))));
+    lightOrbitNode = scene.addNode();
+    lightNode = scene.addNode(lightOrbitNode, Mat4::translation(-80, 60, 80), LIGHT);
+    scene.setLocalBounds(lightNode, AABB::fromPoints(UnitCube::vertices, sizeof(UnitCube::vertices)/(3*sizeof(UnitCube::vertices[0]))));
   }
 
   virtual void animate(double animationTime) override {
     light.angle = light.degreesPerSecond * float(animationTime);
+    scene.setLocalTransform(lightOrbitNode, Mat4::rotationY(-light.angle));
   }
 
   void updateState() {
@@ -135,7 +150,9 @@ public:
     viewMatrix = viewMatrix * Mat4::rotationY(viewRotation[1]);
     viewMatrix = viewMatrix * Mat4::rotationZ(viewRotation[2]);
 
-    lightModelMatrix = Mat4::rotationY(-light.angle) *  Mat4::translation(-80, 60, 80);
+    scene.update();
+
+    lightModelMatrix = scene.getWorldTransform(lightNode);
     lightPosition =  viewMatrix * lightModelMatrix * Vec4(0, 0, 0, 1);
 
     lightProjectionMatrix = Mat4::perspective(60.0f,
@@ -145,65 +162,66 @@ public:
     lightViewMatrix = Mat4::lookAt(lightModelMatrix * Vec3{0,0,0}, {0,0,0}, {0,1,0});
 
     worldToShadowMatrix = cliptToTextureMatrix*lightProjectionMatrix*lightViewMatrix;
+
+    // cull each pass against its own frustum
+    scene.collectVisible(shadowCasters, Frustum{lightProjectionMatrix*lightViewMatrix});
+    scene.collectVisible(visibleObjects, Frustum{projectionMatrix*viewMatrix});
   }
 
   void renderLightSource() {
+    const bool lightVisible = std::any_of(visibleObjects.begin(), visibleObjects.end(),
+                                          [](const SceneGraph::VisibleObject& o) {return o.object == LIGHT;});
+    if (!lightVisible) return;
+
     pLight.enable();
     pLight.setUniform("MVP", projectionMatrix * viewMatrix * lightModelMatrix);
     lightArray.bind();
-    GL(glDrawElements(GL_TRIANGLES, sizeof(UnitCube::indices) / sizeof(UnitCube::indices[0]), GL_UNSIGNED_INT, (void*)0));
+    GL(glDrawElements(GL_TRIANGLES, GLsizei(lightIndexBuffer.getCount()), lightIndexBuffer.getType(), (void*)0));
   }
 
-  void renderScene(bool forReal) {
-
-    Mat4 modelMatrix = Mat4::scaling(100, 100, 100);
-
+  void renderObject(int32_t object, const Mat4& modelMatrix, bool forReal) {
     if (forReal) {
       const Mat4 modelView = viewMatrix * modelMatrix;
       const Mat4 modelViewProjection = projectionMatrix * modelView;
       const Mat4 modelViewIT = Mat4::transpose(Mat4::inverse(modelView));
-
-      pPhongBumpTex.enable();
-      pPhongBumpTex.setUniform("MVP", modelViewProjection);
-      pPhongBumpTex.setUniform("MV", modelView);
-      pPhongBumpTex.setUniform("M", modelMatrix);
-      pPhongBumpTex.setUniform("worldToShadow", worldToShadowMatrix);
-      pPhongBumpTex.setUniform("MVit", modelViewIT);
-      pPhongBumpTex.setUniform("lightPosition", lightPosition);
-      pPhongBumpTex.setTexture("td", stonesDiffuse,0);
-      pPhongBumpTex.setTexture("ts", stonesSpecular,1);
-      pPhongBumpTex.setTexture("tn", stonesNormals,2);
-      pPhongBumpTex.setTexture("shadowMap", shadowMap,3);
+      const GLProgram& program = object == PLANE ? pPhongBumpTex : pPhongBump;
+
+      program.enable();
+      program.setUniform("MVP", modelViewProjection);
+      program.setUniform("MV", modelView);
+      program.setUniform("M", modelMatrix);
+      program.setUniform("worldToShadow", worldToShadowMatrix);
+      program.setUniform("MVit", modelViewIT);
+      program.setUniform("lightPosition", lightPosition);
+      if (object == PLANE) {
+        program.setTexture("td", stonesDiffuse,0);
+        program.setTexture("ts", stonesSpecular,1);
+        program.setTexture("tn", stonesNormals,2);
+        program.setTexture("shadowMap", shadowMap,3);
+      } else {
+        program.setTexture("tn", udeNormals,0);
+        program.setTexture("shadowMap", shadowMap,1);
+      }
     } else {
-      shadowProgram.enable();
       shadowProgram.setUniform("MVP", lightProjectionMatrix*lightViewMatrix*modelMatrix);
     }
 
-    planeArray.bind();
-    GL(glDrawArrays(GL_TRIANGLES, 0, sizeof(UnitPlane::vertices) / sizeof(UnitPlane::vertices[0])));
-
-    modelMatrix = {};
-
-    if (forReal) {
-      const Mat4 modelView = viewMatrix * modelMatrix;
-      const Mat4 modelViewProjection = projectionMatrix * modelView;
-      const Mat4 modelViewIT = Mat4::transpose(Mat4::inverse(modelView));
-
-      pPhongBump.enable();
-      pPhongBump.setUniform("MVP", modelViewProjection);
-      pPhongBump.setUniform("MV", modelView);
-      pPhongBump.setUniform("M", modelMatrix);
-      pPhongBumpTex.setUniform("worldToShadow", worldToShadowMatrix);
-      pPhongBump.setUniform("MVit", modelViewIT);
-      pPhongBump.setUniform("lightPosition", lightPosition);
-      pPhongBump.setTexture("tn", udeNormals,0);
-      pPhongBump.setTexture("shadowMap", shadowMap,1);
+    if (object == PLANE) {
+      planeArray.bind();
+      GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(planeBuffer.getCount())));
     } else {
-      shadowProgram.setUniform("MVP", lightProjectionMatrix*lightViewMatrix*modelMatrix);
+      teapotArray.bind();
+      GL(glDrawElements(GL_TRIANGLES, GLsizei(teapotIndexBuffer.getCount()), teapotIndexBuffer.getType(), (void*)0));
     }
+  }
 
-    teapotArray.bind();
-    GL(glDrawElements(GL_TRIANGLES, sizeof(Teapot::indices) / sizeof(Teapot::indices[0]), GL_UNSIGNED_INT, (void*)0));
+  void renderScene(bool forReal) {
+    if (!forReal) shadowProgram.enable();
+
+    for (const SceneGraph::VisibleObject& o : forReal ? visibleObjects : shadowCasters) {
+      if (o.object == LIGHT) continue; // drawn unlit by renderLightSource
+      renderObject(o.object, scene.getWorldTransform(o.node), forReal);
+    }
   }
 
   virtual void draw() override {
@@ -236,47 +254,30 @@ public:
     lightIndexBuffer.setData(UnitCube::indices, sizeof(UnitCube::indices)/sizeof(UnitCube::indices[0]));
 
 
-    planePosBuffer.setData(UnitPlane::vertices,
-                        sizeof(UnitPlane::vertices)/sizeof(UnitPlane::vertices[0]),
-                        3, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planePosBuffer, pPhongBumpTex, "vertexPosition", 3);
-    planeNormalBuffer.setData(UnitPlane::normals,
-                           sizeof(UnitPlane::normals)/sizeof(UnitPlane::normals[0]),
-                           3, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planeNormalBuffer, pPhongBumpTex, "vertexNormal", 3);
-    planeTangBuffer.setData(UnitPlane::tangents,
-                           sizeof(UnitPlane::tangents)/sizeof(UnitPlane::tangents[0]),
-                           3, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planeTangBuffer, pPhongBumpTex, "vertexTangent", 3);
-    planeBinBuffer.setData(UnitPlane::binormals,
-                           sizeof(UnitPlane::binormals)/sizeof(UnitPlane::binormals[0]),
-                           3, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planeBinBuffer, pPhongBumpTex, "vertexBinormal", 3);
-    planeTexCoordBuffer.setData(UnitPlane::texCoords,
-                              sizeof(UnitPlane::texCoords)/sizeof(UnitPlane::texCoords[0]),
-                              2, GL_STATIC_DRAW);
-    planeArray.connectVertexAttrib(planeTexCoordBuffer, pPhongBumpTex, "vertexTexCoords", 2);
-
-    teapotPosBuffer.setData(Teapot::vertices,
-                           sizeof(Teapot::vertices)/sizeof(Teapot::vertices[0]),
-                           3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotPosBuffer, pPhongBump, "vertexPosition", 3);
-    teapotNormalBuffer.setData(Teapot::normals,
-                              sizeof(Teapot::normals)/sizeof(Teapot::normals[0]),
-                              3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotNormalBuffer, pPhongBump, "vertexNormal", 3);
-    teapotTangBuffer.setData(Teapot::tangents,
-                            sizeof(Teapot::tangents)/sizeof(Teapot::tangents[0]),
-                            3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotTangBuffer, pPhongBump, "vertexTangent", 3);
-    teapotBinBuffer.setData(Teapot::binormals,
-                           sizeof(Teapot::binormals)/sizeof(Teapot::binormals[0]),
-                           3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotBinBuffer, pPhongBump, "vertexBinormal", 3);
-    teapotTexCoordBuffer.setData(Teapot::texCoords,
-                                sizeof(Teapot::texCoords)/sizeof(Teapot::texCoords[0]),
-                                3, GL_STATIC_DRAW);
-    teapotArray.connectVertexAttrib(teapotTexCoordBuffer, pPhongBump, "vertexTexCoords", 3);
+    // position, normal, tangent, binormal and texture coordinates interleaved in one buffer
+    const VertexFormat planeFormat{{"vertexPosition", GLAttribType::FLOAT, 3},
+                                   {"vertexNormal", GLAttribType::FLOAT, 3},
+                                   {"vertexTangent", GLAttribType::FLOAT, 3},
+                                   {"vertexBinormal", GLAttribType::FLOAT, 3},
+                                   {"vertexTexCoords", GLAttribType::FLOAT, 2}};
+    planeBuffer.setData(planeFormat.pack({{UnitPlane::vertices}, {UnitPlane::normals},
+                                          {UnitPlane::tangents}, {UnitPlane::binormals},
+                                          {UnitPlane::texCoords}},
+                                         sizeof(UnitPlane::vertices)/(3*sizeof(UnitPlane::vertices[0]))),
+                        planeFormat);
+    planeArray.configure(planeBuffer, planeFormat, pPhongBumpTex);
+
+    const VertexFormat teapotFormat{{"vertexPosition", GLAttribType::FLOAT, 3},
+                                    {"vertexNormal", GLAttribType::FLOAT, 3},
+                                    {"vertexTangent", GLAttribType::FLOAT, 3},
+                                    {"vertexBinormal", GLAttribType::FLOAT, 3},
+                                    {"vertexTexCoords", GLAttribType::FLOAT, 3}};
+    teapotBuffer.setData(teapotFormat.pack({{Teapot::vertices}, {Teapot::normals},
+                                            {Teapot::tangents}, {Teapot::binormals},
+                                            {Teapot::texCoords, 3}},
+                                           sizeof(Teapot::vertices)/(3*sizeof(Teapot::vertices[0]))),
+                         teapotFormat);
+    teapotArray.configure(teapotBuffer, teapotFormat, pPhongBump);
     teapotIndexBuffer.setData(Teapot::indices, sizeof(Teapot::indices)/sizeof(Teapot::indices[0]));
   }
 
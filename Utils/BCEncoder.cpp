@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#ifndef __EMSCRIPTEN__
+#include <filesystem>
+#endif
+
+#include "BCEncoder.h"
+#include "ImageLoader.h"
+#include "Parallel.h"
+#include "Hash.h"
+
+namespace BCEncoder {
+
+  /** RGBA texels of one 4x4 block, row by row. */
+  typedef uint8_t Block[16][4];
+
+  static void fetchBlock(const Image& image, uint32_t bx, uint32_t by, Block& block) {
+    const uint8_t c = image.componentCount;
+    for (uint32_t y = 0;y<4;++y) {
+      const uint32_t sy = std::min(by*4+y, image.height-1);
+      for (uint32_t x = 0;x<4;++x) {
+        const uint32_t sx = std::min(bx*4+x, image.width-1);
+        const uint8_t* p = &image.data[image.computeIndex(sx, sy, 0)];
+        uint8_t* t = block[y*4+x];
+        switch (c) {
+          case 1 : t[0] = t[1] = t[2] = p[0]; t[3] = 255; break;
+          case 2 : t[0] = t[1] = t[2] = p[0]; t[3] = p[1]; break;
+          case 3 : t[0] = p[0]; t[1] = p[1]; t[2] = p[2]; t[3] = 255; break;
+          default: t[0] = p[0]; t[1] = p[1]; t[2] = p[2]; t[3] = p[3]; break;
+        }
+      }
+    }
+  }
+
+  static uint16_t to565(const float c[3]) {
+    const int r = std::clamp(int(std::lround(c[0]*31.0f/255.0f)), 0, 31);
+    const int g = std::clamp(int(std::lround(c[1]*63.0f/255.0f)), 0, 63);
+    const int b = std::clamp(int(std::lround(c[2]*31.0f/255.0f)), 0, 31);
+    return uint16_t((r << 11) | (g << 5) | b);
+  }
+
+  static void from565(uint16_t v, int c[3]) {
+    const int r = (v >> 11) & 31;
+    const int g = (v >> 5) & 63;
+    const int b = v & 31;
+    c[0] = (r << 3) | (r >> 2);
+    c[1] = (g << 2) | (g >> 4);
+    c[2] = (b << 3) | (b >> 2);
+  }
+
+  static void writeLE16(uint8_t* out, uint16_t v) {
+    out[0] = uint8_t(v & 0xFF);
+    out[1] = uint8_t(v >> 8);
+  }
+
+  // BC1 color block (8 bytes), always in four color mode
+  static void encodeColorBlock(const Block& block, uint8_t* out) {
+    float mean[3] = {0,0,0};
+    for (size_t i = 0;i<16;++i) {
+      for (size_t k = 0;k<3;++k) mean[k] += block[i][k];
+    }
+    for (size_t k = 0;k<3;++k) mean[k] /= 16.0f;
+
+    float cov[6] = {0,0,0,0,0,0}; // rr rg rb gg gb bb
+    for (size_t i = 0;i<16;++i) {
+      const float r = block[i][0]-mean[0];
+      const float g = block[i][1]-mean[1];
+      const float b = block[i][2]-mean[2];
+      cov[0] += r*r; cov[1] += r*g; cov[2] += r*b;
+      cov[3] += g*g; cov[4] += g*b; cov[5] += b*b;
+    }
+
+    // principal axis by power iteration
+    float axis[3] = {1,1,1};
+    for (size_t iter = 0;iter<8;++iter) {
+      const float x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+      const float y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+      const float z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+      const float l = std::max({std::fabs(x), std::fabs(y), std::fabs(z)});
+      if (l == 0) break;
+      axis[0] = x/l; axis[1] = y/l; axis[2] = z/l;
+    }
+    const float axisLength2 = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+
+    float tMin = 0, tMax = 0;
+    for (size_t i = 0;i<16;++i) {
+      const float t = ((block[i][0]-mean[0])*axis[0] + (block[i][1]-mean[1])*axis[1] +
+                       (block[i][2]-mean[2])*axis[2]) / axisLength2;
+      tMin = std::min(tMin, t);
+      tMax = std::max(tMax, t);
+    }
+    // inset the endpoints slightly, the extremes are rarely worth a palette entry
+    const float inset = (tMax-tMin)/16.0f;
+    tMin += inset;
+    tMax -= inset;
+
+    float e0[3], e1[3];
+    for (size_t k = 0;k<3;++k) {
+      e0[k] = mean[k] + axis[k]*tMax;
+      e1[k] = mean[k] + axis[k]*tMin;
+    }
+    uint16_t c0 = to565(e0);
+    uint16_t c1 = to565(e1);
+    if (c0 < c1) std::swap(c0, c1);
+
+    writeLE16(out, c0);
+    writeLE16(out+2, c1);
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+      int palette[4][3];
+      from565(c0, palette[0]);
+      from565(c1, palette[1]);
+      for (size_t k = 0;k<3;++k) {
+        palette[2][k] = (2*palette[0][k] + palette[1][k])/3;
+        palette[3][k] = (palette[0][k] + 2*palette[1][k])/3;
+      }
+      for (size_t i = 0;i<16;++i) {
+        uint32_t best = 0;
+        int bestDist = INT32_MAX;
+        for (uint32_t p = 0;p<4;++p) {
+          const int dr = block[i][0]-palette[p][0];
+          const int dg = block[i][1]-palette[p][1];
+          const int db = block[i][2]-palette[p][2];
+          const int dist = dr*dr + dg*dg + db*db;
+          if (dist < bestDist) {bestDist = dist; best = p;}
+        }
+        indices |= best << (2*i);
+      }
+    }
+    out[4] = uint8_t(indices);
+    out[5] = uint8_t(indices >> 8);
+    out[6] = uint8_t(indices >> 16);
+    out[7] = uint8_t(indices >> 24);
+  }
+
+  // BC4 block (8 bytes) of one channel, in eight value mode
+  static void encodeChannelBlock(const uint8_t values[16], uint8_t* out) {
+    const uint8_t a0 = *std::max_element(values, values+16);
+    const uint8_t a1 = *std::min_element(values, values+16);
+    out[0] = a0;
+    out[1] = a1;
+
+    uint64_t indices = 0;
+    if (a0 != a1) {
+      int palette[8];
+      palette[0] = a0;
+      palette[1] = a1;
+      for (int i = 2;i<8;++i) palette[i] = ((8-i)*a0 + (i-1)*a1)/7;
+      for (size_t i = 0;i<16;++i) {
+        uint64_t best = 0;
+        int bestDist = INT32_MAX;
+        for (uint64_t p = 0;p<8;++p) {
+          const int dist = std::abs(int(values[i])-palette[p]);
+          if (dist < bestDist) {bestDist = dist; best = p;}
+        }
+        indices |= best << (3*i);
+      }
+    }
+    for (size_t i = 0;i<6;++i) out[2+i] = uint8_t(indices >> (8*i));
+  }
+
+  static void encodeChannel(const Block& block, size_t channel, uint8_t* out) {
+    uint8_t values[16];
+    for (size_t i = 0;i<16;++i) values[i] = block[i][channel];
+    encodeChannelBlock(values, out);
+  }
+
+  size_t blockSize(BCFormat format) {
+    return (format == BCFormat::BC1 || format == BCFormat::BC4) ? 8 : 16;
+  }
+
+  uint8_t componentCount(BCFormat format) {
+    switch (format) {
+      case BCFormat::BC1 : return 3;
+      case BCFormat::BC3 : return 4;
+      case BCFormat::BC4 : return 1;
+      case BCFormat::BC5 : return 2;
+    }
+    return 0;
+  }
+
+  uint32_t glInternalFormat(BCFormat format) {
+    switch (format) {
+      case BCFormat::BC1 : return 0x83F0; // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+      case BCFormat::BC3 : return 0x83F3; // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+      case BCFormat::BC4 : return 0x8DBB; // GL_COMPRESSED_RED_RGTC1
+      case BCFormat::BC5 : return 0x8DBD; // GL_COMPRESSED_RG_RGTC2
+    }
+    return 0;
+  }
+
+  CompressedImage encode(const Image& image, BCFormat format) {
+    CompressedImage result;
+    result.width = image.width;
+    result.height = image.height;
+    result.format = format;
+    if (image.width == 0 || image.height == 0) return result;
+
+    const uint32_t blocksX = (image.width+3)/4;
+    const uint32_t blocksY = (image.height+3)/4;
+    const size_t size = blockSize(format);
+    result.data.resize(size_t(blocksX)*blocksY*size);
+
+    Parallel::forRange(0, size_t(blocksX)*blocksY, [&](size_t begin, size_t end) {
+      Block block;
+      for (size_t b = begin;b<end;++b) {
+        fetchBlock(image, uint32_t(b%blocksX), uint32_t(b/blocksX), block);
+        uint8_t* out = &result.data[b*size];
+        switch (format) {
+          case BCFormat::BC1 :
+            encodeColorBlock(block, out);
+            break;
+          case BCFormat::BC3 :
+            encodeChannel(block, 3, out);
+            encodeColorBlock(block, out+8);
+            break;
+          case BCFormat::BC4 :
+            encodeChannel(block, 0, out);
+            break;
+          case BCFormat::BC5 :
+            // two channel images arrive as luminance/alpha in the block
+            encodeChannel(block, 0, out);
+            encodeChannel(block, image.componentCount == 2 ? 3 : 1, out+8);
+            break;
+        }
+      }
+    }, 64);
+
+    return result;
+  }
+
+  CompressedImage encode(const Grid2D& grid) {
+    const uint32_t width = uint32_t(grid.getWidth());
+    const uint32_t height = uint32_t(grid.getHeight());
+    Image image(width, height, 1);
+    for (uint32_t y = 0;y<height;++y) {
+      for (uint32_t x = 0;x<width;++x) {
+        const float v = std::clamp(grid.getValue(x,y), 0.0f, 1.0f);
+        image.data[size_t(y)*width+x] = uint8_t(std::lround(v*255.0f));
+      }
+    }
+    return encode(image, BCFormat::BC4);
+  }
+
+  static const uint32_t cacheMagic = 0x434E4342; // "BCNC"
+  static const uint32_t encoderVersion = 1;
+
+  CompressedImage loadOrEncode(const std::string& filename, BCFormat format,
+                               bool flipY, const std::string& cacheDirectory) {
+#ifdef __EMSCRIPTEN__
+    return encode(ImageLoader::load(filename, flipY), format);
+#else
+    if (cacheDirectory.empty()) return encode(ImageLoader::load(filename, flipY), format);
+
+    std::ifstream source{filename, std::ios::binary};
+    if (!source) throw ImageLoader::Exception{"Can't open image file " + filename};
+    const std::string contents{std::istreambuf_iterator<char>(source), std::istreambuf_iterator<char>()};
+
+    uint64_t key = Hash::FNV_OFFSET;
+    Hash::add(key, contents);
+    Hash::add(key, &encoderVersion, sizeof(encoderVersion));
+    Hash::add(key, &format, sizeof(format));
+    Hash::add(key, &flipY, sizeof(flipY));
+    const std::string cacheFilename = cacheDirectory + "/" + Hash::toHex(key) + ".bc";
+
+    std::ifstream cached{cacheFilename, std::ios::binary};
+    if (cached) {
+      uint32_t header[5] = {0,0,0,0,0}; // magic, width, height, format, size
+      cached.read(reinterpret_cast<char*>(header), sizeof(header));
+      if (cached && header[0] == cacheMagic && header[3] == uint32_t(format)) {
+        CompressedImage result;
+        result.width = header[1];
+        result.height = header[2];
+        result.format = format;
+        result.data.resize(header[4]);
+        cached.read(reinterpret_cast<char*>(result.data.data()), std::streamsize(result.data.size()));
+        const size_t expected = size_t((result.width+3)/4)*((result.height+3)/4)*blockSize(format);
+        if (cached && result.data.size() == expected) return result;
+      }
+    }
+
+    const CompressedImage result = encode(ImageLoader::load(filename, flipY), format);
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDirectory, ec);
+    std::ofstream file{cacheFilename, std::ios::binary | std::ios::trunc};
+    if (file) {
+      const uint32_t header[5] = {cacheMagic, result.width, result.height,
+                                  uint32_t(format), uint32_t(result.data.size())};
+      file.write(reinterpret_cast<const char*>(header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(result.data.data()), std::streamsize(result.data.size()));
+    }
+    return result;
+#endif
+  }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "Image.h"
+#include "Grid2D.h"
+
+/**
+ * @file BCEncoder.h
+ * @brief Multithreaded CPU encoder for block-compressed textures (BC1/BC3/BC4/BC5).
+ *
+ * Block compression stores every 4x4 texel block in a fixed number of bytes:
+ *  - BC1 (DXT1): RGB, 8 bytes per block (6:1 vs. RGB8).
+ *  - BC3 (DXT5): RGBA, 16 bytes per block (4:1 vs. RGBA8).
+ *  - BC4 (RGTC1): one channel, 8 bytes per block, e.g. heightfields/masks.
+ *  - BC5 (RGTC2): two channels, 16 bytes per block, e.g. tangent-space normal
+ *    maps storing x/y (reconstruct z = sqrt(1-x²-y²) in the shader).
+ *
+ * Color endpoints are fitted along the principal axis of each block, single
+ * channel endpoints span the block's value range. Blocks are independent and
+ * encoded in parallel with @ref Parallel::forRange(). Images whose size is not
+ * a multiple of four are padded by repeating the last row/column.
+ *
+ * Encoded results can be cached on disk with @ref BCEncoder::loadOrEncode(),
+ * keyed by a hash of the source file's contents and the encoder settings.
+ * The result is uploaded with GLTexture2D::setCompressedData().
+ */
+
+/**
+ * @brief Supported block compression formats.
+ */
+enum class BCFormat : uint8_t {
+  BC1, ///< RGB, 4 bpp.
+  BC3, ///< RGBA, 8 bpp.
+  BC4, ///< R, 4 bpp.
+  BC5  ///< RG, 8 bpp.
+};
+
+/**
+ * @brief Block-compressed pixel data of one image.
+ */
+struct CompressedImage {
+  uint32_t width{0};            ///< Width in pixels.
+  uint32_t height{0};           ///< Height in pixels.
+  BCFormat format{BCFormat::BC1}; ///< Block format of @ref data.
+  std::vector<uint8_t> data;    ///< Blocks in row-major block order.
+};
+
+namespace BCEncoder {
+  /** @brief Bytes per 4x4 block of @p format. */
+  size_t blockSize(BCFormat format);
+
+  /** @brief Number of channels @p format stores. */
+  uint8_t componentCount(BCFormat format);
+
+  /** @brief GL internal format constant of @p format (for glCompressedTexImage2D). */
+  uint32_t glInternalFormat(BCFormat format);
+
+  /**
+   * @brief Encode an image.
+   * @param image  Source pixels; 1/2 channel images are treated as
+   *               luminance(/alpha) for BC1/BC3, BC4/BC5 take the first
+   *               one/two channels.
+   * @param format Target format.
+   * @return Compressed image with (ceil(w/4)*ceil(h/4)) blocks.
+   */
+  CompressedImage encode(const Image& image, BCFormat format);
+
+  /**
+   * @brief Encode a scalar field to BC4.
+   * @param grid Values in [0,1] (clamped), e.g. a heightfield.
+   */
+  CompressedImage encode(const Grid2D& grid);
+
+  /**
+   * @brief Load an image file and encode it, reusing an earlier result from disk.
+   * @param filename  Image file (formats supported by stb_image).
+   * @param format    Target format.
+   * @param flipY     Flip rows on load (see ImageLoader::load()).
+   * @param cacheDirectory Directory for encoded files; empty disables caching.
+   * @throw ImageLoader::Exception If the file cannot be read/decoded.
+   */
+  CompressedImage loadOrEncode(const std::string& filename, BCFormat format,
+                               bool flipY=true, const std::string& cacheDirectory="texturecache");
+}
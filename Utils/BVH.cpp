@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <mutex>
+
+#include "BVH.h"
+#include "Parallel.h"
+
+namespace {
+  constexpr size_t BIN_COUNT = 16;
+  constexpr size_t PARALLEL_BINNING = 1 << 16;  ///< Nodes with more triangles bin in parallel.
+  constexpr size_t PARALLEL_SUBTREE = 1 << 14;  ///< Nodes with more triangles build halves concurrently.
+  constexpr int PARALLEL_DEPTH = 6;             ///< Spawn subtree threads only near the root.
+  constexpr int SAH_DEPTH = 64;                 ///< Deeper nodes split at the median to bound the depth.
+
+  float area(const AABB& box) {
+    if (box.isEmpty()) return 0.0f;
+    const Vec3 d = box.maxPos - box.minPos;
+    return 2.0f*(d.x*d.y + d.y*d.z + d.z*d.x);
+  }
+
+  struct Bins {
+    std::array<std::array<AABB, BIN_COUNT>, 3> boxes;
+    std::array<std::array<size_t, BIN_COUNT>, 3> counts{};
+
+    void merge(const Bins& other) {
+      for (size_t a = 0;a<3;++a) {
+        for (size_t b = 0;b<BIN_COUNT;++b) {
+          boxes[a][b].add(other.boxes[a][b]);
+          counts[a][b] += other.counts[a][b];
+        }
+      }
+    }
+  };
+
+  class Builder {
+  public:
+    Builder(std::vector<AABB>& boxes, std::vector<Vec3>& centroids, std::vector<uint32_t>& ids) :
+      boxes(boxes), centroids(centroids), ids(ids) {}
+
+    /** @brief Append the subtree over ids[begin,end) to @p out, returns its root index. */
+    uint32_t build(std::vector<BVHNode>& out, size_t begin, size_t end, int depth) {
+      const size_t count = end-begin;
+      AABB bounds, centroidBounds;
+      for (size_t i = begin;i<end;++i) {
+        bounds.add(boxes[ids[i]]);
+        centroidBounds.add(centroids[ids[i]]);
+      }
+
+      const uint32_t index = uint32_t(out.size());
+      out.push_back(makeNode(bounds));
+      if (count <= BVH::MAX_LEAF_SIZE && count <= 2) {
+        makeLeaf(out[index], begin, count);
+        return index;
+      }
+
+      size_t axis = 0;
+      size_t mid = begin;
+      if (!split(begin, end, depth, bounds, centroidBounds, axis, mid)) {
+        makeLeaf(out[index], begin, count);
+        return index;
+      }
+
+      out[index].count = 0;
+      out[index].axis = uint16_t(axis);
+      if (count > PARALLEL_SUBTREE && depth < PARALLEL_DEPTH) {
+        std::vector<BVHNode> right;
+        std::future<void> job = std::async(std::launch::async, [&]() {
+          right.reserve(2*(end-mid)/BVH::MAX_LEAF_SIZE+1);
+          build(right, mid, end, depth+1);
+        });
+        build(out, begin, mid, depth+1);
+        job.get();
+        const uint32_t base = uint32_t(out.size());
+        for (BVHNode& node : right) {
+          if (node.count == 0) node.offset += base;
+        }
+        out[index].offset = base;
+        out.insert(out.end(), right.begin(), right.end());
+      } else {
+        build(out, begin, mid, depth+1);
+        const uint32_t second = build(out, mid, end, depth+1);
+        out[index].offset = second;
+      }
+      return index;
+    }
+
+  private:
+    std::vector<AABB>& boxes;
+    std::vector<Vec3>& centroids;
+    std::vector<uint32_t>& ids;
+
+    static BVHNode makeNode(const AABB& bounds) {
+      BVHNode node{};
+      for (size_t i = 0;i<3;++i) {
+        node.minPos[i] = bounds.minPos[i];
+        node.maxPos[i] = bounds.maxPos[i];
+      }
+      return node;
+    }
+
+    static void makeLeaf(BVHNode& node, size_t begin, size_t count) {
+      node.offset = uint32_t(begin);
+      node.count = uint16_t(count);
+    }
+
+    void binRange(size_t begin, size_t end, const AABB& centroidBounds,
+                  const Vec3& scale, Bins& bins) const {
+      for (size_t i = begin;i<end;++i) {
+        const uint32_t id = ids[i];
+        for (size_t a = 0;a<3;++a) {
+          const size_t b = std::min(BIN_COUNT-1, size_t((centroids[id][a]-centroidBounds.minPos[a])*scale[a]));
+          bins.boxes[a][b].add(boxes[id]);
+          ++bins.counts[a][b];
+        }
+      }
+    }
+
+    /**
+     * @brief Choose a split of ids[begin,end) and partition it.
+     * @return False if a leaf is cheaper (only for small nodes).
+     */
+    bool split(size_t begin, size_t end, int depth, const AABB& bounds,
+               const AABB& centroidBounds, size_t& axis, size_t& mid) {
+      const size_t count = end-begin;
+      const Vec3 extent = centroidBounds.maxPos - centroidBounds.minPos;
+
+      if (depth < SAH_DEPTH) {
+        Vec3 scale;
+        for (size_t a = 0;a<3;++a) scale[a] = extent[a] > 0.0f ? float(BIN_COUNT)/extent[a] : 0.0f;
+
+        Bins bins;
+        if (count > PARALLEL_BINNING) {
+          std::mutex mutex;
+          Parallel::forRange(begin, end, [&](size_t b, size_t e) {
+            Bins local;
+            binRange(b, e, centroidBounds, scale, local);
+            std::scoped_lock lock(mutex);
+            bins.merge(local);
+          }, PARALLEL_BINNING/4);
+        } else {
+          binRange(begin, end, centroidBounds, scale, bins);
+        }
+
+        // sweep the bins from both sides, cost = 1 + (A_l*N_l + A_r*N_r)/A
+        float bestCost = std::numeric_limits<float>::infinity();
+        size_t bestBin = 0;
+        for (size_t a = 0;a<3;++a) {
+          if (extent[a] <= 0.0f) continue;
+          std::array<float, BIN_COUNT> rightCost{};
+          AABB box;
+          size_t n = 0;
+          for (size_t b = BIN_COUNT-1;b>0;--b) {
+            box.add(bins.boxes[a][b]);
+            n += bins.counts[a][b];
+            rightCost[b] = area(box)*float(n);
+          }
+          box = AABB{};
+          n = 0;
+          for (size_t b = 0;b+1<BIN_COUNT;++b) {
+            box.add(bins.boxes[a][b]);
+            n += bins.counts[a][b];
+            const float cost = area(box)*float(n) + rightCost[b+1];
+            if (cost < bestCost) {
+              bestCost = cost;
+              bestBin = b;
+              axis = a;
+            }
+          }
+        }
+
+        if (bestCost < std::numeric_limits<float>::infinity()) {
+          const float boundsArea = area(bounds);
+          const float splitCost = boundsArea > 0.0f ? 1.0f + bestCost/boundsArea : float(count);
+          if (count <= BVH::MAX_LEAF_SIZE && splitCost >= float(count)) return false;
+
+          const float minPos = centroidBounds.minPos[axis];
+          const float axisScale = scale[axis];
+          const auto middle = std::partition(ids.begin()+std::ptrdiff_t(begin), ids.begin()+std::ptrdiff_t(end),
+                                             [&](uint32_t id) {
+            return std::min(BIN_COUNT-1, size_t((centroids[id][axis]-minPos)*axisScale)) <= bestBin;
+          });
+          mid = size_t(middle - ids.begin());
+          if (mid != begin && mid != end) return true;
+        }
+      }
+
+      // coincident centroids or deep trees: split at the median of the widest axis
+      if (count <= BVH::MAX_LEAF_SIZE && (extent.x <= 0.0f && extent.y <= 0.0f && extent.z <= 0.0f)) {
+        return false;
+      }
+      axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+      mid = begin + count/2;
+      std::nth_element(ids.begin()+std::ptrdiff_t(begin), ids.begin()+std::ptrdiff_t(mid),
+                       ids.begin()+std::ptrdiff_t(end), [&](uint32_t a, uint32_t b) {
+        return centroids[a][axis] < centroids[b][axis];
+      });
+      return true;
+    }
+  };
+
+  struct RayBoxData {
+    Vec3 invDir;
+    std::array<size_t, 3> negative;  ///< 1 if the direction component is negative.
+  };
+
+  /** @brief Slab test, returns the entry distance or infinity on a miss. */
+  inline float intersectBox(const BVHNode& node, const Ray& ray, const RayBoxData& data, float tMax) {
+    const float* bounds[2] = {node.minPos, node.maxPos};
+    float t0 = ray.tMin, t1 = tMax;
+    for (size_t a = 0;a<3;++a) {
+      const float near = (bounds[data.negative[a]][a] - ray.origin[a])*data.invDir[a];
+      const float far = (bounds[1-data.negative[a]][a] - ray.origin[a])*data.invDir[a];
+      t0 = near > t0 ? near : t0;
+      t1 = far < t1 ? far : t1;
+    }
+    return t0 <= t1 ? t0 : std::numeric_limits<float>::infinity();
+  }
+
+  RayBoxData prepare(const Ray& ray) {
+    RayBoxData data;
+    for (size_t a = 0;a<3;++a) {
+      data.invDir[a] = 1.0f / ray.direction[a];
+      data.negative[a] = ray.direction[a] < 0.0f ? 1 : 0;
+    }
+    return data;
+  }
+}
+
+BVH::BVH(const std::vector<Vec3>& positions, const std::vector<uint32_t>& indices) {
+  build(positions, indices);
+}
+
+BVH::BVH(const OBJFile& mesh) {
+  std::vector<uint32_t> indices;
+  indices.reserve(mesh.indices.size()*3);
+  for (const OBJFile::IndexType& triangle : mesh.indices) {
+    for (const size_t v : triangle) indices.push_back(uint32_t(v));
+  }
+  build(mesh.vertices, indices);
+}
+
+void BVH::build(const std::vector<Vec3>& positions, const std::vector<uint32_t>& indices) {
+  const size_t count = indices.size()/3;
+  std::vector<AABB> boxes(count);
+  std::vector<Vec3> centroids(count);
+  std::vector<uint32_t> ids(count);
+  Parallel::forRange(0, count, [&](size_t begin, size_t end) {
+    for (size_t i = begin;i<end;++i) {
+      AABB box;
+      for (size_t k = 0;k<3;++k) box.add(positions[indices[i*3+k]]);
+      boxes[i] = box;
+      centroids[i] = box.center();
+      ids[i] = uint32_t(i);
+    }
+  });
+
+  nodes.clear();
+  if (count == 0) return;
+  nodes.reserve(2*count/MAX_LEAF_SIZE+1);
+  Builder builder(boxes, centroids, ids);
+  builder.build(nodes, 0, count, 0);
+  nodes.shrink_to_fit();
+
+  triangleIds = std::move(ids);
+  triangles.resize(count);
+  for (size_t i = 0;i<count;++i) {
+    const uint32_t id = triangleIds[i];
+    const Vec3& v0 = positions[indices[id*3+0]];
+    triangles[i] = {v0, positions[indices[id*3+1]]-v0, positions[indices[id*3+2]]-v0};
+  }
+}
+
+AABB BVH::getBounds() const {
+  AABB bounds;
+  if (!nodes.empty()) {
+    bounds.add(Vec3{nodes[0].minPos[0], nodes[0].minPos[1], nodes[0].minPos[2]});
+    bounds.add(Vec3{nodes[0].maxPos[0], nodes[0].maxPos[1], nodes[0].maxPos[2]});
+  }
+  return bounds;
+}
+
+bool BVH::intersectTriangle(const Triangle& tri, const Ray& ray, float& t, float& u, float& v) {
+  const Vec3 p = Vec3::cross(ray.direction, tri.e2);
+  const float det = Vec3::dot(tri.e1, p);
+  if (std::fabs(det) < 1e-12f) return false;
+  const float invDet = 1.0f/det;
+  const Vec3 s = ray.origin - tri.v0;
+  const float bu = Vec3::dot(s, p)*invDet;
+  if (bu < 0.0f || bu > 1.0f) return false;
+  const Vec3 q = Vec3::cross(s, tri.e1);
+  const float bv = Vec3::dot(ray.direction, q)*invDet;
+  if (bv < 0.0f || bu+bv > 1.0f) return false;
+  const float bt = Vec3::dot(tri.e2, q)*invDet;
+  if (bt < ray.tMin || bt >= t) return false;
+  t = bt;
+  u = bu;
+  v = bv;
+  return true;
+}
+
+bool BVH::intersect(const Ray& ray, Hit& hit) const {
+  if (nodes.empty()) return false;
+  const RayBoxData data = prepare(ray);
+  float t = ray.tMax;
+  bool found = false;
+
+  uint32_t stack[STACK_SIZE];
+  size_t stackSize = 0;
+  uint32_t current = 0;
+  if (intersectBox(nodes[0], ray, data, t) == std::numeric_limits<float>::infinity()) return false;
+
+  while (true) {
+    const BVHNode& node = nodes[current];
+    if (node.count > 0) {
+      for (uint32_t i = node.offset;i<node.offset+node.count;++i) {
+        if (intersectTriangle(triangles[i], ray, t, hit.u, hit.v)) {
+          hit.triangle = triangleIds[i];
+          found = true;
+        }
+      }
+    } else {
+      // children in split order, swapped when the ray points along -axis
+      uint32_t nearChild = current+1;
+      uint32_t farChild = node.offset;
+      if (data.negative[node.axis]) std::swap(nearChild, farChild);
+      const float tNear = intersectBox(nodes[nearChild], ray, data, t);
+      const float tFar = intersectBox(nodes[farChild], ray, data, t);
+      const bool hitNear = tNear != std::numeric_limits<float>::infinity();
+      const bool hitFar = tFar != std::numeric_limits<float>::infinity();
+      if (hitNear && hitFar) {
+        if (tFar < tNear) std::swap(nearChild, farChild);
+        stack[stackSize++] = farChild;
+        current = nearChild;
+        continue;
+      }
+      if (hitNear || hitFar) {
+        current = hitNear ? nearChild : farChild;
+        continue;
+      }
+    }
+
+    // pop entries that the closest hit so far already rules out
+    bool next = false;
+    while (stackSize > 0 && !next) {
+      current = stack[--stackSize];
+      next = intersectBox(nodes[current], ray, data, t) != std::numeric_limits<float>::infinity();
+    }
+    if (!next) break;
+  }
+
+  if (found) hit.t = t;
+  return found;
+}
+
+bool BVH::occluded(const Ray& ray) const {
+  if (nodes.empty()) return false;
+  const RayBoxData data = prepare(ray);
+
+  uint32_t stack[STACK_SIZE];
+  size_t stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const BVHNode& node = nodes[stack[--stackSize]];
+    if (intersectBox(node, ray, data, ray.tMax) == std::numeric_limits<float>::infinity()) continue;
+    if (node.count > 0) {
+      float t = ray.tMax, u, v;
+      for (uint32_t i = node.offset;i<node.offset+node.count;++i) {
+        if (intersectTriangle(triangles[i], ray, t, u, v)) return true;
+      }
+    } else {
+      const uint32_t index = uint32_t(&node - nodes.data());
+      stack[stackSize++] = node.offset;
+      stack[stackSize++] = index+1;
+    }
+  }
+  return false;
+}
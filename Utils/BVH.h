@@ -0,0 +1,111 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <limits>
+#include <cstdint>
+
+#include "Vec3.h"
+#include "Bounds.h"
+#include "OBJFile.h"
+
+/**
+ * @file BVH.h
+ * @brief Bounding volume hierarchy over triangle meshes for CPU ray casting.
+ *
+ * The tree is built top-down with the surface area heuristic evaluated over
+ * 16 centroid bins per axis. Large nodes bin their triangles in parallel, and
+ * the two halves of large nodes are built on separate threads.
+ *
+ * Nodes are 32 bytes (two per cache line) and stored depth first: an inner
+ * node's first child directly follows it and @ref BVHNode::offset points to
+ * the second, a leaf's @ref BVHNode::offset is the first of its
+ * @ref BVHNode::count consecutive triangles. Triangles are stored in leaf order
+ * as one vertex plus two edges, ready for Moeller-Trumbore tests.
+ *
+ * Traversal visits the nearer child first and keeps the farther one on a
+ * short fixed-size stack on the C++ stack; @ref BVH::occluded() stops at the
+ * first hit for shadow rays.
+ */
+
+/** @brief Ray with a valid parameter interval. */
+struct Ray {
+  Vec3 origin;                                        ///< Start point.
+  Vec3 direction;                                     ///< Direction (need not be unit length).
+  float tMin{0.0f};                                   ///< Nearest accepted hit.
+  float tMax{std::numeric_limits<float>::infinity()}; ///< Farthest accepted hit.
+};
+
+/** @brief Closest intersection found by BVH::intersect(). */
+struct Hit {
+  float t{std::numeric_limits<float>::infinity()}; ///< Ray parameter of the hit.
+  uint32_t triangle{0};                            ///< Index of the triangle in the input mesh.
+  float u{0.0f};                                   ///< Barycentric weight of the second vertex.
+  float v{0.0f};                                   ///< Barycentric weight of the third vertex.
+};
+
+/** @brief BVH node, 32 bytes. */
+struct BVHNode {
+  float minPos[3];  ///< Box minimum.
+  uint32_t offset;  ///< Second child (inner node) or first triangle (leaf).
+  float maxPos[3];  ///< Box maximum.
+  uint16_t count;   ///< Triangles in a leaf, 0 for inner nodes.
+  uint16_t axis;    ///< Split axis of an inner node, orders the traversal.
+};
+static_assert(sizeof(BVHNode) == 32, "BVH nodes are expected to be 32 bytes");
+
+class BVH {
+public:
+  /** @brief Empty hierarchy, every ray misses. */
+  BVH() = default;
+
+  /**
+   * @brief Build over an indexed triangle list.
+   * @param positions Vertex positions.
+   * @param indices   Three indices per triangle.
+   */
+  BVH(const std::vector<Vec3>& positions, const std::vector<uint32_t>& indices);
+
+  /** @brief Build over an OBJ mesh. */
+  explicit BVH(const OBJFile& mesh);
+
+  /**
+   * @brief Find the closest intersection in [ray.tMin, ray.tMax].
+   * @return True if a triangle was hit; @p hit then holds the closest one.
+   */
+  bool intersect(const Ray& ray, Hit& hit) const;
+
+  /** @brief True if any triangle intersects @p ray in [ray.tMin, ray.tMax]. */
+  bool occluded(const Ray& ray) const;
+
+  /** @brief Nodes in depth-first order, the root is node 0. */
+  const std::vector<BVHNode>& getNodes() const {return nodes;}
+  /** @brief Number of triangles. */
+  size_t getTriangleCount() const {return triangleIds.size();}
+  /** @brief Bounds of the whole mesh. */
+  AABB getBounds() const;
+
+  /** @brief Maximum number of triangles in a leaf. */
+  static constexpr uint16_t MAX_LEAF_SIZE = 8;
+  /** @brief Entries of the traversal stack, bounds the tree depth. */
+  static constexpr size_t STACK_SIZE = 128;
+
+private:
+  friend class BVH4;
+
+  /** @brief Triangle prepared for intersection tests. */
+  struct Triangle {
+    Vec3 v0;  ///< First vertex.
+    Vec3 e1;  ///< Second vertex minus first.
+    Vec3 e2;  ///< Third vertex minus first.
+  };
+
+  std::vector<BVHNode> nodes;
+  std::vector<Triangle> triangles;    ///< In leaf order.
+  std::vector<uint32_t> triangleIds;  ///< Input index of each entry of @ref triangles.
+
+  void build(const std::vector<Vec3>& positions, const std::vector<uint32_t>& indices);
+
+  /** @brief Moeller-Trumbore test, updates @p t/@p u/@p v on a closer hit. */
+  static bool intersectTriangle(const Triangle& tri, const Ray& ray, float& t, float& u, float& v);
+};
@@ -0,0 +1,516 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BVH4_USE_SSE
+#include <emmintrin.h>
+#endif
+
+#include "BVH4.h"
+
+namespace {
+  constexpr float INF = std::numeric_limits<float>::infinity();
+  constexpr float DET_EPSILON = 1e-12f;
+
+#ifdef BVH4_USE_SSE
+  struct Float4 {__m128 v;};
+  struct Mask4 {__m128 v;};
+
+  inline Float4 load(const float* p) {return {_mm_load_ps(p)};}
+  inline Float4 set1(float f) {return {_mm_set1_ps(f)};}
+  inline void store(float* p, Float4 a) {_mm_storeu_ps(p, a.v);}
+  inline Float4 operator+(Float4 a, Float4 b) {return {_mm_add_ps(a.v, b.v)};}
+  inline Float4 operator-(Float4 a, Float4 b) {return {_mm_sub_ps(a.v, b.v)};}
+  inline Float4 operator*(Float4 a, Float4 b) {return {_mm_mul_ps(a.v, b.v)};}
+  inline Float4 operator/(Float4 a, Float4 b) {return {_mm_div_ps(a.v, b.v)};}
+  inline Float4 min4(Float4 a, Float4 b) {return {_mm_min_ps(a.v, b.v)};}
+  inline Float4 max4(Float4 a, Float4 b) {return {_mm_max_ps(a.v, b.v)};}
+  inline Float4 abs4(Float4 a) {return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)};}
+  inline Mask4 operator<(Float4 a, Float4 b) {return {_mm_cmplt_ps(a.v, b.v)};}
+  inline Mask4 operator<=(Float4 a, Float4 b) {return {_mm_cmple_ps(a.v, b.v)};}
+  inline Mask4 operator>=(Float4 a, Float4 b) {return {_mm_cmpge_ps(a.v, b.v)};}
+  inline Mask4 operator>(Float4 a, Float4 b) {return {_mm_cmpgt_ps(a.v, b.v)};}
+  inline Mask4 operator&(Mask4 a, Mask4 b) {return {_mm_and_ps(a.v, b.v)};}
+  inline uint32_t bits(Mask4 m) {return uint32_t(_mm_movemask_ps(m.v));}
+  inline Mask4 fromBits(uint32_t b) {
+    const __m128i lanes = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i set = _mm_and_si128(_mm_set1_epi32(int(b)), lanes);
+    return {_mm_castsi128_ps(_mm_cmpeq_epi32(set, lanes))};
+  }
+  inline Float4 select(Mask4 m, Float4 a, Float4 b) {
+    return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))};
+  }
+#else
+  struct Float4 {float v[4];};
+  struct Mask4 {bool v[4];};
+
+  template <typename F>
+  inline Float4 map(Float4 a, Float4 b, F f) {return {{f(a.v[0],b.v[0]), f(a.v[1],b.v[1]), f(a.v[2],b.v[2]), f(a.v[3],b.v[3])}};}
+  template <typename F>
+  inline Mask4 compare(Float4 a, Float4 b, F f) {return {{f(a.v[0],b.v[0]), f(a.v[1],b.v[1]), f(a.v[2],b.v[2]), f(a.v[3],b.v[3])}};}
+
+  inline Float4 load(const float* p) {return {{p[0], p[1], p[2], p[3]}};}
+  inline Float4 set1(float f) {return {{f, f, f, f}};}
+  inline void store(float* p, Float4 a) {std::copy(a.v, a.v+4, p);}
+  inline Float4 operator+(Float4 a, Float4 b) {return map(a, b, [](float x, float y) {return x+y;});}
+  inline Float4 operator-(Float4 a, Float4 b) {return map(a, b, [](float x, float y) {return x-y;});}
+  inline Float4 operator*(Float4 a, Float4 b) {return map(a, b, [](float x, float y) {return x*y;});}
+  inline Float4 operator/(Float4 a, Float4 b) {return map(a, b, [](float x, float y) {return x/y;});}
+  inline Float4 min4(Float4 a, Float4 b) {return map(a, b, [](float x, float y) {return x < y ? x : y;});}
+  inline Float4 max4(Float4 a, Float4 b) {return map(a, b, [](float x, float y) {return x > y ? x : y;});}
+  inline Float4 abs4(Float4 a) {return map(a, a, [](float x, float) {return std::fabs(x);});}
+  inline Mask4 operator<(Float4 a, Float4 b) {return compare(a, b, [](float x, float y) {return x < y;});}
+  inline Mask4 operator<=(Float4 a, Float4 b) {return compare(a, b, [](float x, float y) {return x <= y;});}
+  inline Mask4 operator>=(Float4 a, Float4 b) {return compare(a, b, [](float x, float y) {return x >= y;});}
+  inline Mask4 operator>(Float4 a, Float4 b) {return compare(a, b, [](float x, float y) {return x > y;});}
+  inline Mask4 operator&(Mask4 a, Mask4 b) {return {{a.v[0]&&b.v[0], a.v[1]&&b.v[1], a.v[2]&&b.v[2], a.v[3]&&b.v[3]}};}
+  inline uint32_t bits(Mask4 m) {return uint32_t(m.v[0]) | uint32_t(m.v[1]) << 1 | uint32_t(m.v[2]) << 2 | uint32_t(m.v[3]) << 3;}
+  inline Mask4 fromBits(uint32_t b) {return {{(b&1) != 0, (b&2) != 0, (b&4) != 0, (b&8) != 0}};}
+  inline Float4 select(Mask4 m, Float4 a, Float4 b) {
+    return {{m.v[0] ? a.v[0] : b.v[0], m.v[1] ? a.v[1] : b.v[1], m.v[2] ? a.v[2] : b.v[2], m.v[3] ? a.v[3] : b.v[3]}};
+  }
+#endif
+
+  inline float lane(Float4 a, size_t i) {
+    alignas(16) float values[4];
+    store(values, a);
+    return values[i];
+  }
+
+  inline int firstBit(uint32_t mask) {
+    int i = 0;
+    while (!(mask & 1u)) {mask >>= 1; ++i;}
+    return i;
+  }
+
+  /** @brief One ray broadcast to all lanes, for tests against four boxes or triangles. */
+  struct SingleRay {
+    Float4 origin[3];
+    Float4 direction[3];
+    Float4 invDir[3];
+    size_t negative[3];
+    Float4 tMin;
+
+    explicit SingleRay(const Ray& ray) {
+      for (size_t a = 0;a<3;++a) {
+        origin[a] = set1(ray.origin[a]);
+        direction[a] = set1(ray.direction[a]);
+        invDir[a] = set1(1.0f/ray.direction[a]);
+        negative[a] = ray.direction[a] < 0.0f ? 1 : 0;
+      }
+      tMin = set1(ray.tMin);
+    }
+
+    /** @brief Entry distances into the four child boxes, returns the hit mask. */
+    uint32_t intersect(const BVH4Node& node, Float4 tMax, Float4& tNear) const {
+      Float4 t0 = tMin, t1 = tMax;
+      for (size_t a = 0;a<3;++a) {
+        const Float4 near = (load(node.bounds[a + 3*negative[a]]) - origin[a])*invDir[a];
+        const Float4 far = (load(node.bounds[a + 3*(1-negative[a])]) - origin[a])*invDir[a];
+        t0 = max4(t0, near);
+        t1 = min4(t1, far);
+      }
+      tNear = t0;
+      return bits(t0 <= t1);
+    }
+  };
+
+  /** @brief Four rays in SoA form. */
+  struct Packet {
+    Float4 origin[3];
+    Float4 direction[3];
+    Float4 invDir[3];
+    Float4 tMin;
+
+    explicit Packet(const RayPacket& rays) {
+      alignas(16) float values[4];
+      for (size_t a = 0;a<3;++a) {
+        for (size_t i = 0;i<4;++i) values[i] = rays[i].origin[a];
+        origin[a] = load(values);
+        for (size_t i = 0;i<4;++i) values[i] = rays[i].direction[a];
+        direction[a] = load(values);
+        for (size_t i = 0;i<4;++i) values[i] = 1.0f/rays[i].direction[a];
+        invDir[a] = load(values);
+      }
+      for (size_t i = 0;i<4;++i) values[i] = rays[i].tMin;
+      tMin = load(values);
+    }
+
+    /** @brief Test all rays against child @p c of @p node. */
+    uint32_t intersect(const BVH4Node& node, size_t c, Float4 tMax, Float4& tNear) const {
+      Float4 t0 = tMin, t1 = tMax;
+      for (size_t a = 0;a<3;++a) {
+        const Float4 p0 = (set1(node.bounds[a][c]) - origin[a])*invDir[a];
+        const Float4 p1 = (set1(node.bounds[a+3][c]) - origin[a])*invDir[a];
+        t0 = max4(t0, min4(p0, p1));
+        t1 = min4(t1, max4(p0, p1));
+      }
+      tNear = t0;
+      return bits(t0 <= t1);
+    }
+  };
+
+  /**
+   * @brief Moeller-Trumbore on four lanes.
+   * @return Mask of lanes with a hit in [tMin, tMax); @p t, @p u, @p v hold all lanes' results.
+   */
+  inline uint32_t intersectTriangles(const Float4 o[3], const Float4 d[3],
+                                     const Float4 v0[3], const Float4 e1[3], const Float4 e2[3],
+                                     Float4 tMin, Float4 tMax, Float4& t, Float4& u, Float4& v) {
+    const Float4 p[3] = {d[1]*e2[2] - d[2]*e2[1], d[2]*e2[0] - d[0]*e2[2], d[0]*e2[1] - d[1]*e2[0]};
+    const Float4 det = e1[0]*p[0] + e1[1]*p[1] + e1[2]*p[2];
+    const Float4 invDet = set1(1.0f)/det;
+    const Float4 s[3] = {o[0]-v0[0], o[1]-v0[1], o[2]-v0[2]};
+    u = (s[0]*p[0] + s[1]*p[1] + s[2]*p[2])*invDet;
+    const Float4 q[3] = {s[1]*e1[2] - s[2]*e1[1], s[2]*e1[0] - s[0]*e1[2], s[0]*e1[1] - s[1]*e1[0]};
+    v = (d[0]*q[0] + d[1]*q[1] + d[2]*q[2])*invDet;
+    t = (e2[0]*q[0] + e2[1]*q[1] + e2[2]*q[2])*invDet;
+    const Float4 zero = set1(0.0f);
+    return bits((abs4(det) > set1(DET_EPSILON)) & (u >= zero) & (v >= zero) &
+                (u+v <= set1(1.0f)) & (t >= tMin) & (t < tMax));
+  }
+
+  /** @brief Stack entry of the single ray traversals. */
+  struct Entry {
+    uint32_t child;
+    float tNear;
+  };
+
+  /** @brief Push the children in @p mask so that the nearest is on top. */
+  inline void pushOrdered(const BVH4Node& node, uint32_t mask, Float4 tNear, Entry* stack, size_t& stackSize) {
+    alignas(16) float distances[4];
+    store(distances, tNear);
+    const size_t first = stackSize;
+    for (;mask;mask &= mask-1) {
+      const int c = firstBit(mask);
+      if (node.child[c] == BVH4::EMPTY) continue;
+      // insertion sort, descending distance towards the top
+      size_t i = stackSize++;
+      while (i > first && stack[i-1].tNear < distances[c]) {
+        stack[i] = stack[i-1];
+        --i;
+      }
+      stack[i] = {node.child[c], distances[c]};
+    }
+  }
+
+  constexpr uint32_t BLOCK_SHIFT = 28;
+  constexpr uint32_t FIRST_MASK = (1u << BLOCK_SHIFT)-1;
+
+  inline uint32_t firstBlock(uint32_t leaf) {return leaf & FIRST_MASK;}
+  inline uint32_t blockEnd(uint32_t leaf) {return firstBlock(leaf) + ((leaf & ~BVH4::LEAF_FLAG) >> BLOCK_SHIFT);}
+
+  /** @brief Load the three SoA rows of a triangle block member. */
+  inline void loadRows(const float rows[3][4], Float4 out[3]) {
+    for (size_t a = 0;a<3;++a) out[a] = load(rows[a]);
+  }
+
+  /** @brief Broadcast lane @p lane of three SoA rows. */
+  inline void broadcastRows(const float rows[3][4], size_t lane, Float4 out[3]) {
+    for (size_t a = 0;a<3;++a) out[a] = set1(rows[a][lane]);
+  }
+
+  BVH4Node emptyNode() {
+    BVH4Node node;
+    for (size_t k = 0;k<6;++k) std::fill(node.bounds[k], node.bounds[k]+4, k < 3 ? INF : -INF);
+    std::fill(node.child, node.child+4, BVH4::EMPTY);
+    return node;
+  }
+
+  void setChild(BVH4Node& node, size_t slot, const BVHNode& child) {
+    for (size_t a = 0;a<3;++a) {
+      node.bounds[a][slot] = child.minPos[a];
+      node.bounds[a+3][slot] = child.maxPos[a];
+    }
+  }
+
+  float area(const BVHNode& node) {
+    const float dx = node.maxPos[0]-node.minPos[0];
+    const float dy = node.maxPos[1]-node.minPos[1];
+    const float dz = node.maxPos[2]-node.minPos[2];
+    return dx*dy + dy*dz + dz*dx;
+  }
+}
+
+BVH4::BVH4(const BVH& bvh) :
+  triangleCount(bvh.getTriangleCount())
+{
+  const std::vector<BVHNode>& binary = bvh.getNodes();
+  if (binary.empty()) return;
+  nodes.reserve(binary.size()/2+1);
+  blocks.reserve(triangleCount/2+1);
+
+  if (binary[0].count > 0) {
+    // a lone leaf still needs a root node holding its bounds
+    nodes.push_back(emptyNode());
+    setChild(nodes[0], 0, binary[0]);
+    nodes[0].child[0] = makeLeaf(bvh, binary[0]);
+  } else {
+    collapse(bvh, 0);
+  }
+}
+
+BVH4::BVH4(const std::vector<Vec3>& positions, const std::vector<uint32_t>& indices) :
+  BVH4(BVH(positions, indices))
+{
+}
+
+BVH4::BVH4(const OBJFile& mesh) :
+  BVH4(BVH(mesh))
+{
+}
+
+bool BVH4::usesSIMD() {
+#ifdef BVH4_USE_SSE
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint32_t BVH4::makeLeaf(const BVH& bvh, const BVHNode& leaf) {
+  const uint32_t first = uint32_t(blocks.size());
+  for (uint32_t i = 0;i<leaf.count;i+=4) {
+    TriangleBlock block{};
+    std::fill(block.id, block.id+4, EMPTY);
+    for (uint32_t lane = 0;lane<4 && i+lane<leaf.count;++lane) {
+      const BVH::Triangle& tri = bvh.triangles[leaf.offset+i+lane];
+      for (size_t a = 0;a<3;++a) {
+        block.v0[a][lane] = tri.v0[a];
+        block.e1[a][lane] = tri.e1[a];
+        block.e2[a][lane] = tri.e2[a];
+      }
+      block.id[lane] = bvh.triangleIds[leaf.offset+i+lane];
+    }
+    blocks.push_back(block);
+  }
+  const uint32_t count = uint32_t(blocks.size())-first;
+  return LEAF_FLAG | count << BLOCK_SHIFT | first;
+}
+
+uint32_t BVH4::collapse(const BVH& bvh, uint32_t binaryIndex) {
+  const std::vector<BVHNode>& binary = bvh.getNodes();
+
+  // open the largest inner child until there are four
+  std::array<uint32_t, 4> children{binaryIndex+1, binary[binaryIndex].offset, 0, 0};
+  size_t childCount = 2;
+  while (childCount < 4) {
+    size_t largest = childCount;
+    float largestArea = -1.0f;
+    for (size_t i = 0;i<childCount;++i) {
+      const BVHNode& node = binary[children[i]];
+      if (node.count == 0 && area(node) > largestArea) {
+        largestArea = area(node);
+        largest = i;
+      }
+    }
+    if (largest == childCount) break;
+    const uint32_t opened = children[largest];
+    children[largest] = opened+1;
+    children[childCount++] = binary[opened].offset;
+  }
+
+  const uint32_t index = uint32_t(nodes.size());
+  nodes.push_back(emptyNode());
+  BVH4Node node = emptyNode();
+  for (size_t i = 0;i<childCount;++i) {
+    const BVHNode& child = binary[children[i]];
+    setChild(node, i, child);
+    node.child[i] = child.count > 0 ? makeLeaf(bvh, child) : collapse(bvh, children[i]);
+  }
+  nodes[index] = node;
+  return index;
+}
+
+bool BVH4::intersect(const Ray& ray, Hit& hit) const {
+  if (nodes.empty()) return false;
+  const SingleRay r(ray);
+  float t = ray.tMax;
+  bool found = false;
+
+  Entry stack[BVH::STACK_SIZE*3];
+  size_t stackSize = 0;
+  stack[stackSize++] = {0, ray.tMin};
+
+  while (stackSize > 0) {
+    const Entry entry = stack[--stackSize];
+    if (entry.tNear > t) continue;
+
+    if (!(entry.child & LEAF_FLAG)) {
+      const BVH4Node& node = nodes[entry.child];
+      Float4 tNear;
+      const uint32_t mask = r.intersect(node, set1(t), tNear);
+      pushOrdered(node, mask, tNear, stack, stackSize);
+      continue;
+    }
+
+    for (uint32_t b = firstBlock(entry.child);b<blockEnd(entry.child);++b) {
+      const TriangleBlock& block = blocks[b];
+      Float4 v0[3], e1[3], e2[3], bt, bu, bv;
+      loadRows(block.v0, v0);
+      loadRows(block.e1, e1);
+      loadRows(block.e2, e2);
+      uint32_t mask = intersectTriangles(r.origin, r.direction, v0, e1, e2, r.tMin, set1(t), bt, bu, bv);
+      for (;mask;mask &= mask-1) {
+        const size_t i = size_t(firstBit(mask));
+        const float laneT = lane(bt, i);
+        if (laneT < t) {
+          t = laneT;
+          hit.triangle = block.id[i];
+          hit.u = lane(bu, i);
+          hit.v = lane(bv, i);
+          found = true;
+        }
+      }
+    }
+  }
+
+  if (found) hit.t = t;
+  return found;
+}
+
+bool BVH4::occluded(const Ray& ray) const {
+  if (nodes.empty()) return false;
+  const SingleRay r(ray);
+  const Float4 tMax = set1(ray.tMax);
+
+  uint32_t stack[BVH::STACK_SIZE*3];
+  size_t stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0) {
+    const uint32_t child = stack[--stackSize];
+    if (!(child & LEAF_FLAG)) {
+      const BVH4Node& node = nodes[child];
+      Float4 tNear;
+      for (uint32_t mask = r.intersect(node, tMax, tNear);mask;mask &= mask-1) {
+        const int c = firstBit(mask);
+        if (node.child[c] != EMPTY) stack[stackSize++] = node.child[c];
+      }
+      continue;
+    }
+
+    for (uint32_t b = firstBlock(child);b<blockEnd(child);++b) {
+      const TriangleBlock& block = blocks[b];
+      Float4 v0[3], e1[3], e2[3], bt, bu, bv;
+      loadRows(block.v0, v0);
+      loadRows(block.e1, e1);
+      loadRows(block.e2, e2);
+      if (intersectTriangles(r.origin, r.direction, v0, e1, e2, r.tMin, tMax, bt, bu, bv)) return true;
+    }
+  }
+  return false;
+}
+
+uint32_t BVH4::intersect(const RayPacket& rays, std::array<Hit, 4>& hits, uint32_t mask) const {
+  mask &= 0xF;
+  if (nodes.empty() || !mask) return 0;
+  const Packet p(rays);
+  const Mask4 active = fromBits(mask);
+
+  alignas(16) float values[4];
+  for (size_t i = 0;i<4;++i) values[i] = rays[i].tMax;
+  Float4 t = select(active, load(values), set1(-INF));
+  Float4 u = set1(0.0f), v = set1(0.0f);
+  std::array<uint32_t, 4> ids{};
+  uint32_t found = 0;
+
+  Entry stack[BVH::STACK_SIZE*3];
+  size_t stackSize = 0;
+  stack[stackSize++] = {0, -INF};
+
+  while (stackSize > 0) {
+    const Entry entry = stack[--stackSize];
+    // the packet is done with a subtree once all its rays have closer hits
+    store(values, t);
+    if (entry.tNear > std::max(std::max(values[0], values[1]), std::max(values[2], values[3]))) continue;
+
+    if (!(entry.child & LEAF_FLAG)) {
+      const BVH4Node& node = nodes[entry.child];
+      alignas(16) float nearest[4] = {INF, INF, INF, INF};
+      uint32_t childMask = 0;
+      for (size_t c = 0;c<4;++c) {
+        if (node.child[c] == EMPTY) continue;
+        Float4 tNear;
+        const uint32_t rayMask = p.intersect(node, c, t, tNear);
+        if (!rayMask) continue;
+        childMask |= 1u << c;
+        store(values, tNear);
+        for (uint32_t m = rayMask;m;m &= m-1) nearest[c] = std::min(nearest[c], values[firstBit(m)]);
+      }
+      pushOrdered(node, childMask, load(nearest), stack, stackSize);
+      continue;
+    }
+
+    for (uint32_t b = firstBlock(entry.child);b<blockEnd(entry.child);++b) {
+      const TriangleBlock& block = blocks[b];
+      for (size_t i = 0;i<4 && block.id[i] != EMPTY;++i) {
+        Float4 v0[3], e1[3], e2[3], bt, bu, bv;
+        broadcastRows(block.v0, i, v0);
+        broadcastRows(block.e1, i, e1);
+        broadcastRows(block.e2, i, e2);
+        const uint32_t hitMask = intersectTriangles(p.origin, p.direction, v0, e1, e2, p.tMin, t, bt, bu, bv);
+        if (!hitMask) continue;
+        const Mask4 closer = fromBits(hitMask);
+        t = select(closer, bt, t);
+        u = select(closer, bu, u);
+        v = select(closer, bv, v);
+        for (uint32_t m = hitMask;m;m &= m-1) ids[size_t(firstBit(m))] = block.id[i];
+        found |= hitMask;
+      }
+    }
+  }
+
+  alignas(16) float tValues[4], uValues[4], vValues[4];
+  store(tValues, t);
+  store(uValues, u);
+  store(vValues, v);
+  for (uint32_t m = found;m;m &= m-1) {
+    const size_t i = size_t(firstBit(m));
+    hits[i] = {tValues[i], ids[i], uValues[i], vValues[i]};
+  }
+  return found;
+}
+
+uint32_t BVH4::occluded(const RayPacket& rays, uint32_t mask) const {
+  mask &= 0xF;
+  if (nodes.empty() || !mask) return 0;
+  const Packet p(rays);
+
+  alignas(16) float values[4];
+  for (size_t i = 0;i<4;++i) values[i] = rays[i].tMax;
+  const Float4 tMax = load(values);
+  uint32_t occludedMask = 0;
+
+  uint32_t stack[BVH::STACK_SIZE*3];
+  size_t stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0 && occludedMask != mask) {
+    const uint32_t child = stack[--stackSize];
+    // rays that are already occluded no longer take part
+    const Float4 open = select(fromBits(mask & ~occludedMask), tMax, set1(-INF));
+
+    if (!(child & LEAF_FLAG)) {
+      const BVH4Node& node = nodes[child];
+      for (size_t c = 0;c<4;++c) {
+        Float4 tNear;
+        if (node.child[c] != EMPTY && p.intersect(node, c, open, tNear)) stack[stackSize++] = node.child[c];
+      }
+      continue;
+    }
+
+    for (uint32_t b = firstBlock(child);b<blockEnd(child);++b) {
+      const TriangleBlock& block = blocks[b];
+      for (size_t i = 0;i<4 && block.id[i] != EMPTY;++i) {
+        Float4 v0[3], e1[3], e2[3], bt, bu, bv;
+        broadcastRows(block.v0, i, v0);
+        broadcastRows(block.e1, i, e1);
+        broadcastRows(block.e2, i, e2);
+        occludedMask |= intersectTriangles(p.origin, p.direction, v0, e1, e2, p.tMin, open, bt, bu, bv);
+      }
+    }
+  }
+  return occludedMask & mask;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "BVH.h"
+
+/**
+ * @file BVH4.h
+ * @brief Four-wide BVH with SIMD box and triangle tests and ray packet traversal.
+ *
+ * A @ref BVH4 is collapsed from a binary SAH @ref BVH: every node pulls up
+ * the grandchildren with the largest surface area until it has four children,
+ * so one node visit tests four boxes with one SSE instruction per slab. Leaf
+ * triangles are stored in blocks of four in structure-of-arrays form, so a
+ * ray is tested against four triangles at once.
+ *
+ * Coherent rays (camera rays of a 2x2 pixel quad, shadow rays towards the
+ * same light) can be traced as a @ref RayPacket: the four rays traverse the
+ * tree together, each box and triangle is loaded once and tested against all
+ * rays in SIMD, and the packet only descends into children that at least one
+ * of its rays hits.
+ *
+ * Without SSE2 the same code runs on a scalar four-lane fallback.
+ */
+
+/** @brief Four rays traced together. */
+typedef std::array<Ray, 4> RayPacket;
+
+/** @brief Four-wide BVH node, two cache lines. */
+struct alignas(64) BVH4Node {
+  float bounds[6][4];  ///< minX, minY, minZ, maxX, maxY, maxZ of the four children.
+  uint32_t child[4];   ///< Node index, leaf reference (see BVH4::LEAF_FLAG) or BVH4::EMPTY.
+};
+
+class BVH4 {
+public:
+  /** @brief Empty hierarchy, every ray misses. */
+  BVH4() = default;
+
+  /** @brief Collapse a binary BVH. */
+  explicit BVH4(const BVH& bvh);
+
+  /** @brief Build over an indexed triangle list (three indices per triangle). */
+  BVH4(const std::vector<Vec3>& positions, const std::vector<uint32_t>& indices);
+
+  /** @brief Build over an OBJ mesh. */
+  explicit BVH4(const OBJFile& mesh);
+
+  /** @brief Closest hit of a single ray, see BVH::intersect(). */
+  bool intersect(const Ray& ray, Hit& hit) const;
+
+  /** @brief Any hit of a single ray, see BVH::occluded(). */
+  bool occluded(const Ray& ray) const;
+
+  /**
+   * @brief Closest hits of a packet.
+   * @param rays  Four rays, ideally with similar origins and directions.
+   * @param hits  Receives the hit of every ray whose bit is set in the result.
+   * @param mask  Rays to trace (bit i for rays[i]); unused lanes are ignored.
+   * @return Bit mask of the rays that hit a triangle.
+   */
+  uint32_t intersect(const RayPacket& rays, std::array<Hit, 4>& hits, uint32_t mask=0xF) const;
+
+  /**
+   * @brief Any-hit test of a packet.
+   * @return Bit mask of the rays in @p mask that are occluded.
+   */
+  uint32_t occluded(const RayPacket& rays, uint32_t mask=0xF) const;
+
+  /** @brief Nodes, the root is node 0. */
+  const std::vector<BVH4Node>& getNodes() const {return nodes;}
+  /** @brief Number of triangles. */
+  size_t getTriangleCount() const {return triangleCount;}
+
+  /** @brief True if the SSE code path was compiled in. */
+  static bool usesSIMD();
+
+  /**
+   * @brief Child flag marking a leaf.
+   *
+   * Bits 28-30 of a leaf reference hold the number of triangle blocks, bits
+   * 0-27 the first block.
+   */
+  static constexpr uint32_t LEAF_FLAG = 0x80000000u;
+  /** @brief Unused child slot. */
+  static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+
+private:
+  /** @brief Four triangles in SoA form; unused lanes have zero edges and never hit. */
+  struct alignas(16) TriangleBlock {
+    float v0[3][4];
+    float e1[3][4];
+    float e2[3][4];
+    uint32_t id[4];
+  };
+
+  std::vector<BVH4Node> nodes;
+  std::vector<TriangleBlock> blocks;
+  size_t triangleCount{0};
+
+  uint32_t collapse(const BVH& bvh, uint32_t binaryIndex);
+  uint32_t makeLeaf(const BVH& bvh, const BVHNode& leaf);
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "Vec3.h"
+#include "Mat4.h"
+
+/**
+ * @file Bounds.h
+ * @brief Axis-aligned bounding boxes, bounding spheres, and an SoA box array.
+ *
+ * Provides the bounding volumes used for visibility culling: @ref AABB (min/max
+ * corners) and @ref BoundingSphere, both constructible from point sets, plus
+ * @ref AABBArray, a structure-of-arrays container of boxes in center/extent
+ * form that culling routines can stream through with SIMD.
+ *
+ * @note Transforming a box with @ref AABB::transformed() yields the tight AABB
+ *       of the transformed box (Arvo's method), not of the original geometry.
+ */
+
+/**
+ * @brief Axis-aligned bounding box stored as min/max corners.
+ */
+struct AABB {
+  Vec3 minPos{ 1e30f, 1e30f, 1e30f}; ///< Minimum corner (empty by default).
+  Vec3 maxPos{-1e30f,-1e30f,-1e30f}; ///< Maximum corner (empty by default).
+
+  /** @brief True if no point has been added yet. */
+  bool isEmpty() const {
+    return minPos.x > maxPos.x || minPos.y > maxPos.y || minPos.z > maxPos.z;
+  }
+
+  /** @brief Grow the box to contain @p p. */
+  void add(const Vec3& p) {
+    minPos = Vec3::minV(minPos, p);
+    maxPos = Vec3::maxV(maxPos, p);
+  }
+
+  /** @brief Grow the box to contain @p other. */
+  void add(const AABB& other) {
+    if (other.isEmpty()) return;
+    add(other.minPos);
+    add(other.maxPos);
+  }
+
+  /** @brief Box center. */
+  Vec3 center() const {return (minPos + maxPos) * 0.5f;}
+  /** @brief Half size along each axis. */
+  Vec3 extent() const {return (maxPos - minPos) * 0.5f;}
+
+  /**
+   * @brief Bounding box of this box after transformation by @p m.
+   * @param m Affine transformation.
+   * @return Tight AABB around the eight transformed corners.
+   */
+  AABB transformed(const Mat4& m) const {
+    if (isEmpty()) return *this;
+    const float* e = m;
+    const Vec3 c = center();
+    const Vec3 x = extent();
+    AABB result;
+    for (size_t row = 0;row<3;++row) {
+      const float tc = e[row*4+0]*c.x + e[row*4+1]*c.y + e[row*4+2]*c.z + e[row*4+3];
+      const float te = std::fabs(e[row*4+0])*x.x + std::fabs(e[row*4+1])*x.y + std::fabs(e[row*4+2])*x.z;
+      result.minPos[row] = tc - te;
+      result.maxPos[row] = tc + te;
+    }
+    return result;
+  }
+
+  /** @brief Box enclosing all @p points. */
+  static AABB fromPoints(const std::vector<Vec3>& points) {
+    AABB result;
+    for (const Vec3& p : points) result.add(p);
+    return result;
+  }
+
+  /**
+   * @brief Box enclosing tightly packed xyz float triples.
+   * @param xyz   Pointer to @p count*3 floats (e.g. the static mesh arrays).
+   * @param count Number of points.
+   */
+  static AABB fromPoints(const float xyz[], size_t count) {
+    AABB result;
+    for (size_t i = 0;i<count;++i) result.add(Vec3{xyz[i*3+0],xyz[i*3+1],xyz[i*3+2]});
+    return result;
+  }
+};
+
+/**
+ * @brief Bounding sphere given by center and radius.
+ */
+struct BoundingSphere {
+  Vec3 center{0,0,0}; ///< Sphere center.
+  float radius{0};    ///< Sphere radius.
+
+  /**
+   * @brief Sphere centered at the AABB center enclosing all @p points.
+   * @note Not the minimal sphere, but tight for typical meshes and O(n).
+   */
+  static BoundingSphere fromPoints(const std::vector<Vec3>& points) {
+    BoundingSphere result;
+    result.center = AABB::fromPoints(points).center();
+    float r2 = 0;
+    for (const Vec3& p : points) {
+      const Vec3 d = p - result.center;
+      r2 = std::max(r2, Vec3::dot(d,d));
+    }
+    result.radius = std::sqrt(r2);
+    return result;
+  }
+
+  /** @brief Sphere enclosing the AABB @p box. */
+  static BoundingSphere fromAABB(const AABB& box) {
+    const Vec3 e = box.extent();
+    return {box.center(), std::sqrt(Vec3::dot(e,e))};
+  }
+};
+
+/**
+ * @brief Structure-of-arrays list of boxes in center/extent form.
+ *
+ * Each component lives in its own contiguous float vector so culling loops can
+ * load several boxes per SIMD register.
+ */
+struct AABBArray {
+  std::vector<float> cx, cy, cz; ///< Box centers.
+  std::vector<float> ex, ey, ez; ///< Box half sizes.
+
+  /** @brief Number of boxes. */
+  size_t size() const {return cx.size();}
+
+  /** @brief Resize all component arrays. */
+  void resize(size_t count) {
+    cx.resize(count); cy.resize(count); cz.resize(count);
+    ex.resize(count); ey.resize(count); ez.resize(count);
+  }
+
+  /** @brief Remove all boxes. */
+  void clear() {resize(0);}
+
+  /** @brief Store @p box at @p index. */
+  void set(size_t index, const AABB& box) {
+    const Vec3 c = box.center();
+    const Vec3 e = box.extent();
+    cx[index] = c.x; cy[index] = c.y; cz[index] = c.z;
+    ex[index] = e.x; ey[index] = e.y; ez[index] = e.z;
+  }
+
+  /** @brief Append @p box. */
+  void push_back(const AABB& box) {
+    resize(size()+1);
+    set(size()-1, box);
+  }
+
+  /** @brief Reconstruct the box at @p index. */
+  AABB get(size_t index) const {
+    const Vec3 c{cx[index],cy[index],cz[index]};
+    const Vec3 e{ex[index],ey[index],ez[index]};
+    return {c-e, c+e};
+  }
+};
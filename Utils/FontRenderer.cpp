@@ -1,6 +1,9 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
 
 #include "FontRenderer.h"
 
@@ -105,30 +108,77 @@ std::string FontRenderer::toCode(const std::string& varName) const {
 
 std::shared_ptr<FontEngine> FontRenderer::generateFontEngine() const {
   std::shared_ptr<FontEngine> fe = std::make_shared<FontEngine>();
-  
+  if (positions.empty()) return fe;
+
+  const uint32_t padding = 1;
+
   uint32_t maxWidth  = 0;
   uint32_t maxHeight = 0;
-  
+  size_t area = 0;
   for (const CharPosition& c : positions) {
     const uint32_t width  = c.bottomRight.x-c.topLeft.x;
     const uint32_t height = c.bottomRight.y-c.topLeft.y;
     maxWidth = std::max(maxWidth, width);
     maxHeight = std::max(maxHeight, height);
+    area += size_t(width+2*padding)*size_t(height+2*padding);
   }
-  
-  for (const CharPosition& c : positions) {
-    const Image i = render(std::string(1,c.c));
-    const float w=i.width/float(maxWidth);
-    const float h=i.height/float(maxHeight);
-    
-    const Mat4 s = Mat4::scaling(w,h,1.0f);
-    const Mat4 t = Mat4::translation(w,h,0.0f);
-    fe->chars[c.c] = CharTex{GLTexture2D(i),s,t,w,h};
-    fe->chars[c.c].tex.setFilter(GL_LINEAR, GL_LINEAR);
 
-    fe->sdChars[c.c] = CharTex{Grid2D(i).toSignedDistance(0.9f).toTexture(),s,t,w,h};
-    fe->sdChars[c.c].tex.setFilter(GL_LINEAR, GL_LINEAR);
+  // shelf packing, tallest glyphs first, into a roughly square atlas
+  std::vector<size_t> order(positions.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return positions[a].bottomRight.y-positions[a].topLeft.y >
+           positions[b].bottomRight.y-positions[b].topLeft.y;
+  });
+
+  const uint32_t atlasWidth = std::max(maxWidth+2*padding, uint32_t(std::ceil(std::sqrt(double(area)))));
+  std::vector<Vec2ui> origins(positions.size());
+  uint32_t x = 0, y = 0, rowHeight = 0;
+  for (size_t i : order) {
+    const Vec2ui size = positions[i].bottomRight-positions[i].topLeft;
+    if (x+size.x+2*padding > atlasWidth) {
+      x = 0;
+      y += rowHeight;
+      rowHeight = 0;
+    }
+    origins[i] = Vec2ui{x+padding, y+padding};
+    x += size.x+2*padding;
+    rowHeight = std::max(rowHeight, size.y+2*padding);
+  }
+  const uint32_t atlasHeight = y+rowHeight;
+
+  const uint8_t components = fontImage.componentCount;
+  Image atlas{atlasWidth, atlasHeight, components,
+              std::vector<uint8_t>(size_t(atlasWidth)*atlasHeight*components)};
+  Grid2Dh distanceAtlas{atlasWidth, atlasHeight};
+  std::vector<std::pair<char,Glyph>> glyphs;
+
+  for (size_t i = 0;i<positions.size();++i) {
+    const CharPosition& c = positions[i];
+    const Image glyph = render(std::string(1,c.c));
+    const Grid2D distance = Grid2Du8(glyph).toSignedDistance(0.9f);
+    const Vec2ui& o = origins[i];
+
+    // copy including the padding border, replicating the edge texels
+    for (int64_t gy = -int64_t(padding);glyph.width>0 && gy<int64_t(glyph.height+padding);++gy) {
+      const uint32_t sy = uint32_t(std::clamp<int64_t>(gy, 0, int64_t(glyph.height)-1));
+      for (int64_t gx = -int64_t(padding);gx<int64_t(glyph.width+padding);++gx) {
+        const uint32_t sx = uint32_t(std::clamp<int64_t>(gx, 0, int64_t(glyph.width)-1));
+        const size_t ax = size_t(int64_t(o.x)+gx);
+        const size_t ay = size_t(int64_t(o.y)+gy);
+        for (uint8_t k = 0;k<components;++k) {
+          atlas.data[(ay*atlasWidth+ax)*components+k] = glyph.data[(size_t(sy)*glyph.width+sx)*components+k];
+        }
+        distanceAtlas.setValue(ax, ay, distance.getValue(sx, sy));
+      }
+    }
+
+    const Vec2 texMin{o.x/float(atlasWidth), o.y/float(atlasHeight)};
+    const Vec2 texMax{(o.x+glyph.width)/float(atlasWidth), (o.y+glyph.height)/float(atlasHeight)};
+    glyphs.push_back({c.c, Glyph{texMin, texMax, glyph.width/float(maxWidth), glyph.height/float(maxHeight)}});
   }
+
+  fe->setGlyphs(atlas, distanceAtlas, glyphs);
   return fe;
 }
 
@@ -136,158 +186,217 @@ std::shared_ptr<FontEngine> FontRenderer::generateFontEngine() const {
 FontEngine::FontEngine() :
 #ifdef __EMSCRIPTEN__
 simpleProg{GLProgram::createFromString(R"(#version 300 es
-uniform mat4 MVP;
-in vec3 vPos;
+in vec2 vPos;
 in vec2 vTexCoords;
+in vec4 vColor;
 out vec4 color;
 out vec2 texCoords;
 void main() {
-    gl_Position = MVP * vec4(vPos, 1.0);
+    gl_Position = vec4(vPos, 0.0, 1.0);
     texCoords = vTexCoords;
+    color = vColor;
 })",R"(#version 300 es
 precision mediump float;
 uniform sampler2D raster;
-uniform vec4 globalColor;
+in vec4 color;
 in vec2 texCoords;
 out vec4 FragColor;
 void main() {
-    FragColor = globalColor*texture(raster, texCoords);
+    FragColor = color*texture(raster, texCoords);
 })")},
 simpleDistProg{GLProgram::createFromString(R"(#version 300 es
-uniform mat4 MVP;
-in vec3 vPos;
+in vec2 vPos;
 in vec2 vTexCoords;
+in vec4 vColor;
 out vec4 color;
 out vec2 texCoords;
 void main() {
-    gl_Position = MVP * vec4(vPos, 1.0);
+    gl_Position = vec4(vPos, 0.0, 1.0);
     texCoords = vTexCoords;
+    color = vColor;
 })",R"(#version 300 es
 precision mediump float;
 uniform sampler2D raster;
-uniform vec4 globalColor;
+in vec4 color;
 in vec2 texCoords;
 out vec4 FragColor;
 void main() {
     float dist = texture(raster, texCoords).r;
     float val  = smoothstep(-3.0,1.0,dist);
-    FragColor  = globalColor*val;
+    FragColor  = color*val;
 })")},
 #else
   simpleProg{GLProgram::createFromString(
    "#version 410\n"
-   "uniform mat4 MVP;\n"
-   "layout (location = 0) in vec3 vPos;\n"
+   "layout (location = 0) in vec2 vPos;\n"
    "layout (location = 1) in vec2 vTexCoords;\n"
+   "layout (location = 2) in vec4 vColor;\n"
    "out vec4 color;\n"
    "out vec2 texCoords;\n"
    "void main() {\n"
-   "    gl_Position = MVP * vec4(vPos, 1.0);\n"
+   "    gl_Position = vec4(vPos, 0.0, 1.0);\n"
    "    texCoords = vTexCoords;\n"
+   "    color = vColor;\n"
    "}\n",
    "#version 410\n"
    "uniform sampler2D raster;\n"
-   "uniform vec4 globalColor;\n"
+   "in vec4 color;\n"
    "in vec2 texCoords;\n"
    "out vec4 FragColor;\n"
    "void main() {\n"
-   "    FragColor = globalColor*texture(raster, texCoords);\n"
+   "    FragColor = color*texture(raster, texCoords);\n"
    "}\n")},
   simpleDistProg{GLProgram::createFromString(
    "#version 410\n"
-   "uniform mat4 MVP;\n"
-   "layout (location = 0) in vec3 vPos;\n"
+   "layout (location = 0) in vec2 vPos;\n"
    "layout (location = 1) in vec2 vTexCoords;\n"
+   "layout (location = 2) in vec4 vColor;\n"
    "out vec4 color;\n"
    "out vec2 texCoords;\n"
    "void main() {\n"
-   "    gl_Position = MVP * vec4(vPos, 1.0);\n"
+   "    gl_Position = vec4(vPos, 0.0, 1.0);\n"
    "    texCoords = vTexCoords;\n"
+   "    color = vColor;\n"
    "}\n",
    "#version 410\n"
    "uniform sampler2D raster;\n"
-   "uniform vec4 globalColor;\n"
+   "in vec4 color;\n"
    "in vec2 texCoords;\n"
    "out vec4 FragColor;\n"
    "void main() {\n"
    "    float dist = texture(raster, texCoords).r;\n"
    "    float val  = smoothstep(-3.0,1.0,dist);\n"
-   "    FragColor  = globalColor*val;\n"
+   "    FragColor  = color*val;\n"
    "}\n")},
 #endif
-  simpleArray{},
   simpleVb{GL_ARRAY_BUFFER},
+  simpleArray{},
+  simpleDistArray{},
+  atlas{GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE},
+  distanceAtlas{GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE},
+  glyphs{Glyph{}},
+  batching{false},
   renderAsSignedDistanceField{false}
 {
-  simpleArray.bind();
-  std::vector<float> data = {
-    -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-     1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
-     1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
-
-    -1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
-    -1.0f, -1.0f, 0.0f, 0.0f, 0.0f,
-     1.0f, -1.0f, 0.0f, 1.0f, 0.0f
-  };
-  simpleVb.setData(data,5,GL_STATIC_DRAW);
+  glyphTable.fill(0);
+  const VertexFormat format{{"vPos", GLAttribType::FLOAT, 2},
+                            {"vTexCoords", GLAttribType::FLOAT, 2},
+                            {"vColor", GLAttribType::FLOAT, 4}};
+  simpleArray.configure(simpleVb, format, simpleProg);
+  simpleDistArray.configure(simpleVb, format, simpleDistProg);
 }
 
-void FontEngine::render(const std::string& text, float winAspect,
-                        float height, const Vec2& pos, Alignment a, const Vec4& color) {
+void FontEngine::setGlyphs(const Image& atlas, const Grid2Dh& distanceAtlas,
+                           const std::vector<std::pair<char,Glyph>>& glyphs) {
+  this->atlas.setData(atlas);
+  distanceAtlas.toTexture(this->distanceAtlas);
+
+  this->glyphs.clear();
+  glyphTable.fill(0);
+  std::array<bool,256> defined{};
+  for (const auto& g : glyphs) {
+    glyphTable[uint8_t(g.first)] = uint16_t(this->glyphs.size());
+    defined[uint8_t(g.first)] = true;
+    this->glyphs.push_back(g.second);
+  }
+  if (this->glyphs.empty()) this->glyphs.push_back(Glyph{});
+
+  // unknown characters are drawn with the fallback glyph
+  const uint16_t fallback = defined[uint8_t('_')] ? glyphTable[uint8_t('_')] : 0;
+  charset.clear();
+  for (size_t c = 0;c<256;++c) {
+    if (defined[c])
+      charset += char(c);
+    else
+      glyphTable[c] = fallback;
+  }
+}
+
+float FontEngine::textWidth(const std::string& text) const {
+  float totalWidth = 0;
+  for (char c : text) totalWidth += getGlyph(c).width;
+  return totalWidth;
+}
+
+void FontEngine::layout(const std::string& text, float left, const Vec2& pos,
+                        float sx, float sy, const Vec4& color) {
+  vertices.reserve(vertices.size() + text.size()*6*8);
+  float x = left;
+  for (char c : text) {
+    const Glyph& g = getGlyph(c);
+    const float x0 = x;
+    const float x1 = x + 2.0f*sx*g.width;
+    const float y0 = pos.y - sy;
+    const float y1 = pos.y + sy*(2.0f*g.height-1.0f);
+    const float quad[6][4] = {
+      {x0, y1, g.texMin.x, g.texMax.y},
+      {x1, y0, g.texMax.x, g.texMin.y},
+      {x1, y1, g.texMax.x, g.texMax.y},
+      {x0, y1, g.texMin.x, g.texMax.y},
+      {x0, y0, g.texMin.x, g.texMin.y},
+      {x1, y0, g.texMax.x, g.texMin.y}
+    };
+    for (const auto& v : quad) {
+      vertices.insert(vertices.end(), {v[0], v[1], v[2], v[3], color.r, color.g, color.b, color.a});
+    }
+    x = x1;
+  }
+}
+
+void FontEngine::beginBatch() {
+  batching = true;
+}
+
+void FontEngine::flush() {
+  batching = false;
+  if (vertices.empty()) return;
 
   GL(glEnable(GL_BLEND));
   GL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
   GL(glBlendEquation(GL_FUNC_ADD));
 
-  GLProgram& activeShader = (renderAsSignedDistanceField) ? simpleDistProg : simpleProg;
-  std::map<char,CharTex>& activeFontMap = (renderAsSignedDistanceField) ? sdChars : chars;
-  
+  const GLProgram& activeShader = (renderAsSignedDistanceField) ? simpleDistProg : simpleProg;
   activeShader.enable();
-  activeShader.setUniform("globalColor", color);
-  simpleArray.bind();
-  simpleArray.connectVertexAttrib(simpleVb, activeShader, "vPos", 3);
-  simpleArray.connectVertexAttrib(simpleVb, activeShader, "vTexCoords", 2, 3);
-  
-  float totalWidth = 0;
-  for (char c : text) {
-    if (activeFontMap.find(c) == activeFontMap.end()) c = '_';
-    totalWidth += activeFontMap.at(c).width;
+  activeShader.setTexture("raster", renderAsSignedDistanceField ? distanceAtlas : atlas, 0);
+
+  (renderAsSignedDistanceField ? simpleDistArray : simpleArray).bind();
+  simpleVb.setData(vertices, 8, GL_DYNAMIC_DRAW);
+  GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()/8)));
+  vertices.clear();
+}
+
+void FontEngine::setRenderAsSignedDistanceField(bool renderAsSignedDistanceField) {
+  if (this->renderAsSignedDistanceField == renderAsSignedDistanceField) return;
+  // a batch is drawn with one program, finish the strings collected so far
+  if (batching) {
+    flush();
+    batching = true;
   }
-  
-  Mat4 scale = Mat4::scaling(height/winAspect, height, 1.0f);
-  Mat4 trans;
+  this->renderAsSignedDistanceField = renderAsSignedDistanceField;
+}
+
+void FontEngine::render(const std::string& text, float winAspect,
+                        float height, const Vec2& pos, Alignment a, const Vec4& color) {
+  const float totalWidth = textWidth(text);
+  const float sx = height/winAspect;
+  float left;
   switch (a) {
     case Alignment::Center :
-      trans = Mat4::translation(pos.x-height*totalWidth/winAspect, pos.y, 0.0f);
+      left = pos.x-sx*totalWidth;
       break;
     case Alignment::Right :
-      trans = Mat4::translation(pos.x-2.0f*height*totalWidth/winAspect, pos.y, 0.0f);
+      left = pos.x-2.0f*sx*totalWidth;
       break;
     default :
-      trans = Mat4::translation(pos.x, pos.y, 0.0f);
+      left = pos.x;
       break;
   }
-  
-  for (char c : text) {
-    if (activeFontMap.find(c) == activeFontMap.end()) c = '_';
-    activeShader.setUniform("MVP",
-                            trans *
-                            Mat4::translation(height*activeFontMap[c].width/winAspect,height*(activeFontMap[c].height-1.0f),0.0f) *
-                            activeFontMap[c].scale *
-                            scale);
-    activeShader.setTexture("raster",activeFontMap[c].tex,0);
-    GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(6)));
-    trans = Mat4::translation(2.0f*height*activeFontMap[c].width/winAspect,0.0f,0.0f) * trans;
-  }
+  layout(text, left, pos, sx, height, color);
+  if (!batching) flush();
 }
 
 Vec2 FontEngine::getSize(const std::string& text, float winAspect, float height) const {
-  float totalWidth = 0;
-  for (char c : text) {
-    if (chars.find(c) == chars.end()) c = '_';
-    totalWidth += chars.at(c).width;
-  }
-  return {height*totalWidth/winAspect, height};
+  return {height*textWidth(text)/winAspect, height};
 }
 
 void FontEngine::render(uint32_t number, float winAspect, float height, const Vec2& pos,
@@ -309,60 +418,28 @@ Vec2 FontEngine::getSizeFixedWidth(uint32_t number, float winAspect, float width
 }
 
 Vec2 FontEngine::getSizeFixedWidth(const std::string& text, float winAspect, float width) const {
-  float totalWidth = 0;
-  for (char c : text) {
-    if (chars.find(c) == chars.end()) c = '_';
-    totalWidth += chars.at(c).width;
-  }
-  return {width, width*winAspect/totalWidth};
+  return {width, width*winAspect/textWidth(text)};
 }
 
-
 void FontEngine::renderFixedWidth(const std::string& text, float winAspect, float width, const Vec2& pos, Alignment a, const Vec4& color) {
-  simpleProg.enable();
-  simpleProg.setUniform("globalColor", color);
-  simpleArray.bind();
-  simpleArray.connectVertexAttrib(simpleVb, simpleProg, "vPos", 3);
-  simpleArray.connectVertexAttrib(simpleVb, simpleProg, "vTexCoords", 2, 3);
-  
-  float totalWidth = 0;
-  for (char c : text) {
-    if (chars.find(c) == chars.end()) c = '_';
-    totalWidth += chars.at(c).width;
-  }
-  
-  Mat4 scale = Mat4::scaling(width/totalWidth, width/totalWidth*winAspect, 1.0f);
-  Mat4 trans;
+  const float sx = width/textWidth(text);
+  float left;
   switch (a) {
     case Alignment::Center :
-      trans = Mat4::translation(pos.x-width, pos.y, 0.0f);
+      left = pos.x-width;
       break;
     case Alignment::Right :
-      trans = Mat4::translation(pos.x-2.0f*width, pos.y, 0.0f);
+      left = pos.x-2.0f*width;
       break;
     default :
-      trans = Mat4::translation(pos.x, pos.y, 0.0f);
+      left = pos.x;
       break;
   }
-  
-  for (char c : text) {
-    if (chars.find(c) == chars.end()) c = '_';
-    simpleProg.setUniform("MVP", trans *
-                          Mat4::translation(width*chars[c].width/totalWidth, width/totalWidth*winAspect*(chars[c].height-1.0f),0.0f) *
-                          chars[c].scale *
-                          scale);
-
-    simpleProg.setTexture("raster",chars[c].tex,0);
-    GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(6)));
-    trans = Mat4::translation(2.0f* width*chars[c].width/totalWidth,0.0f,0.0f) * trans;
-  }
+  layout(text, left, pos, sx, sx*winAspect, color);
+  if (!batching) flush();
 }
 
 
 std::string FontEngine::getAllCharsString() const {
-  std::stringstream ss;
-  for (const auto& c : chars) {
-    ss << c.first;
-  }
-  return ss.str();
+  return charset;
 }
@@ -2,7 +2,7 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <array>
 #include <utility>
 #include <memory>
 
@@ -20,8 +20,9 @@
  * Declares two related components:
  *  - @ref FontRenderer: CPU-only blitter that composes strings into an @ref Image
  *    using a bitmap atlas and character box positions read from a text file.
- *  - @ref FontEngine: runtime OpenGL renderer that draws strings as quads using
- *    per-character textures; optionally renders from a signed-distance field.
+ *  - @ref FontEngine: runtime OpenGL renderer that lays strings out on the CPU
+ *    into one vertex stream over a glyph atlas and draws them with a single
+ *    call; optionally renders from a signed-distance field atlas.
  */
 
 /**
@@ -38,14 +39,13 @@ struct CharPosition {
 };
 
 /**
- * @brief Texture + transform bundle for a single glyph used by @ref FontEngine.
+ * @brief Placement of a single glyph in the atlas of a @ref FontEngine.
  */
-struct CharTex {
-  GLTexture2D tex; ///< Glyph texture (RGBA or single-channel).
-  Mat4 scale;      ///< Per-glyph scale to normalize to [0,1] quad space.
-  Mat4 trans;      ///< Per-glyph translation used by the renderer.
-  float width;     ///< Glyph width normalized by the maximum glyph width in the set.
-  float height;    ///< Glyph height normalized by the maximum glyph height in the set.
+struct Glyph {
+  Vec2 texMin;  ///< Atlas coordinates of the glyph's bottom-left corner on screen.
+  Vec2 texMax;  ///< Atlas coordinates of the glyph's top-right corner on screen.
+  float width;  ///< Glyph width normalized by the maximum glyph width in the set.
+  float height; ///< Glyph height normalized by the maximum glyph height in the set.
 };
 
 /**
@@ -58,18 +58,37 @@ enum class Alignment {
 };
 
 /**
- * @brief OpenGL-based text drawer using per-character textures (or SDFs).
+ * @brief OpenGL-based text drawer using a glyph atlas (bitmap and SDF).
  *
- * Builds a simple pipeline to render strings as textured quads. The map
- * @ref chars holds per-glyph textures; @ref sdChars stores signed-distance
- * variants for crisp scaling when @ref renderAsSignedDistanceField is enabled.
+ * All glyphs live in one atlas texture (plus a signed-distance variant for
+ * crisp scaling when @ref renderAsSignedDistanceField is enabled) and are
+ * looked up through a 256-entry table indexed by the character code. Strings
+ * are laid out on the CPU into an interleaved position/texcoord/color stream.
+ * By default every call to @ref render() draws its string immediately with
+ * one glDrawArrays; between @ref beginBatch() and @ref flush() all strings
+ * are accumulated and drawn together, so a whole HUD costs a single draw.
  */
 class FontEngine {
 public:
-  /** @brief Create an empty engine and initialize shaders, quad geometry, and VBOs. */
+  /** @brief Create an empty engine and initialize shaders and buffers. */
   FontEngine();
   virtual ~FontEngine() {}
 
+  /**
+   * @brief Install the glyph atlases and the glyph table.
+   * @param atlas         Bitmap atlas containing all glyphs.
+   * @param distanceAtlas Signed distance field of the same layout, in half floats.
+   * @param glyphs        Character and atlas placement of every glyph;
+   *                      characters without an entry are drawn as '_'.
+   */
+  void setGlyphs(const Image& atlas, const Grid2Dh& distanceAtlas,
+                 const std::vector<std::pair<char,Glyph>>& glyphs);
+
+  /** @brief Atlas placement of @p c (or of the fallback glyph '_'). */
+  const Glyph& getGlyph(char c) const {
+    return glyphs[glyphTable[uint8_t(c)]];
+  }
+
   /**
    * @name Draw text
    */
@@ -94,6 +113,15 @@ public:
               const Vec2& pos, Alignment a = Alignment::Center, const Vec4& color=Vec4{1.0f,1.0f,1.0f,1.0f});
   void renderFixedWidth(uint32_t number, float winAspect, float width,
                         const Vec2& pos, Alignment a = Alignment::Center, const Vec4& color=Vec4{1.0f,1.0f,1.0f,1.0f});
+
+  /**
+   * @brief Start collecting strings instead of drawing each one immediately.
+   */
+  void beginBatch();
+  /**
+   * @brief Draw all collected strings with a single call and end the batch.
+   */
+  void flush();
   ///@}
 
   /** @name Layout helpers */
@@ -110,13 +138,11 @@ public:
   /** @brief Return the available characters as a single concatenated string. */
   std::string getAllCharsString() const;
 
-  std::map<char,CharTex> chars;  ///< Per-character textures + transforms.
-  std::map<char,CharTex> sdChars;///< Per-character SDF textures + transforms.
-
-  /** @brief Enable/disable signed distance field rendering. */
-  void setRenderAsSignedDistanceField(bool renderAsSignedDistanceField) {
-    this->renderAsSignedDistanceField = renderAsSignedDistanceField;
-  }
+  /**
+   * @brief Enable/disable signed distance field rendering.
+   * @note Strings collected so far in a batch are flushed first.
+   */
+  void setRenderAsSignedDistanceField(bool renderAsSignedDistanceField);
 
   /** @brief Current SDF rendering flag. */
   bool getRenderAsSignedDistanceField() const {
@@ -126,9 +152,28 @@ public:
 private:
   GLProgram simpleProg;   ///< Shader for alpha-blended bitmap glyphs.
   GLProgram simpleDistProg; ///< Shader for signed-distance glyph rendering.
-  GLArray   simpleArray;  ///< VAO for a unit quad.
-  GLBuffer  simpleVb;     ///< VBO with quad positions/UVs.
-  bool renderAsSignedDistanceField; ///< If true, use @ref sdChars and distance shader.
+  GLBuffer  simpleVb;     ///< VBO with interleaved position/texcoord/color.
+  GLArray   simpleArray;  ///< VAO of @ref simpleProg for the glyph quads.
+  GLArray   simpleDistArray; ///< VAO of @ref simpleDistProg for the glyph quads.
+  GLTexture2D atlas;      ///< Bitmap glyph atlas.
+  GLTexture2D distanceAtlas; ///< Signed distance glyph atlas.
+  std::vector<Glyph> glyphs;  ///< Glyph placements, indexed by @ref glyphTable.
+  std::array<uint16_t,256> glyphTable; ///< Character code to index into @ref glyphs.
+  std::string charset;    ///< All characters with an own glyph, sorted.
+  std::vector<float> vertices; ///< Quads laid out since the last draw.
+  bool batching;          ///< Inside @ref beginBatch() / @ref flush().
+  bool renderAsSignedDistanceField; ///< If true, use @ref distanceAtlas and the distance shader.
+
+  /** @brief Sum of the normalized glyph widths of @p text. */
+  float textWidth(const std::string& text) const;
+  /**
+   * @brief Append the quads of @p text to @ref vertices.
+   * @param left  NDC x of the left edge of the string.
+   * @param pos   Anchor; its y is the baseline center of the line.
+   * @param sx,sy NDC size of a glyph with normalized width/height 1 (half extents).
+   */
+  void layout(const std::string& text, float left, const Vec2& pos,
+              float sx, float sy, const Vec4& color);
 };
 
 /**
@@ -182,7 +227,8 @@ public:
 
   /**
    * @brief Create a GPU font engine initialized from this bitmap font.
-   * @return Shared pointer to a @ref FontEngine with per-character textures.
+   * @return Shared pointer to a @ref FontEngine whose atlas holds all glyphs
+   *         (each padded by one replicated texel to avoid filtering bleed).
    */
   std::shared_ptr<FontEngine> generateFontEngine() const;
 
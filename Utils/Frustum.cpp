@@ -0,0 +1,122 @@
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_USE_SSE
+#include <emmintrin.h>
+#endif
+
+#include "Frustum.h"
+
+Frustum::Frustum() {
+  planes.fill(Vec4{0,0,0,1});
+}
+
+Frustum::Frustum(const Mat4& viewProjection) {
+  // rows of the matrix, see Mat4::operator*(Vec4)
+  const float* m = viewProjection;
+  const Vec4 r0{m[0], m[1], m[2], m[3]};
+  const Vec4 r1{m[4], m[5], m[6], m[7]};
+  const Vec4 r2{m[8], m[9], m[10],m[11]};
+  const Vec4 r3{m[12],m[13],m[14],m[15]};
+
+  planes[0] = r3 + r0; // left   -w <= x
+  planes[1] = r3 - r0; // right   x <= w
+  planes[2] = r3 + r1; // bottom -w <= y
+  planes[3] = r3 - r1; // top     y <= w
+  planes[4] = r3 + r2; // near   -w <= z
+  planes[5] = r3 - r2; // far     z <= w
+
+  for (Vec4& p : planes) {
+    const float l = std::sqrt(p.x*p.x + p.y*p.y + p.z*p.z);
+    if (l > 0) p = p / l;
+  }
+}
+
+bool Frustum::contains(const Vec3& p) const {
+  for (const Vec4& plane : planes) {
+    if (plane.x*p.x + plane.y*p.y + plane.z*p.z + plane.w < 0) return false;
+  }
+  return true;
+}
+
+bool Frustum::intersects(const AABB& box) const {
+  if (box.isEmpty()) return false;
+  const Vec3 c = box.center();
+  const Vec3 e = box.extent();
+  for (const Vec4& plane : planes) {
+    const float d = plane.x*c.x + plane.y*c.y + plane.z*c.z + plane.w;
+    const float r = std::fabs(plane.x)*e.x + std::fabs(plane.y)*e.y + std::fabs(plane.z)*e.z;
+    if (d + r < 0) return false;
+  }
+  return true;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const {
+  const Vec3& c = sphere.center;
+  for (const Vec4& plane : planes) {
+    if (plane.x*c.x + plane.y*c.y + plane.z*c.z + plane.w < -sphere.radius) return false;
+  }
+  return true;
+}
+
+size_t Frustum::cull(const AABBArray& boxes, std::vector<uint8_t>& visible) const {
+  const size_t count = boxes.size();
+  visible.resize(count);
+
+  size_t i = 0;
+  size_t visibleCount = 0;
+
+#ifdef FRUSTUM_USE_SSE
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  __m128 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+  for (size_t p = 0;p<6;++p) {
+    px[p] = _mm_set1_ps(planes[p].x);
+    py[p] = _mm_set1_ps(planes[p].y);
+    pz[p] = _mm_set1_ps(planes[p].z);
+    pw[p] = _mm_set1_ps(planes[p].w);
+    ax[p] = _mm_andnot_ps(signMask, px[p]);
+    ay[p] = _mm_andnot_ps(signMask, py[p]);
+    az[p] = _mm_andnot_ps(signMask, pz[p]);
+  }
+
+  for (;i+4<=count;i+=4) {
+    const __m128 cx = _mm_loadu_ps(&boxes.cx[i]);
+    const __m128 cy = _mm_loadu_ps(&boxes.cy[i]);
+    const __m128 cz = _mm_loadu_ps(&boxes.cz[i]);
+    const __m128 ex = _mm_loadu_ps(&boxes.ex[i]);
+    const __m128 ey = _mm_loadu_ps(&boxes.ey[i]);
+    const __m128 ez = _mm_loadu_ps(&boxes.ez[i]);
+
+    // a box is outside if center distance + projected radius < 0 for any plane
+    __m128 outside = _mm_setzero_ps();
+    for (size_t p = 0;p<6;++p) {
+      __m128 d = _mm_add_ps(_mm_mul_ps(px[p], cx), pw[p]);
+      d = _mm_add_ps(d, _mm_mul_ps(py[p], cy));
+      d = _mm_add_ps(d, _mm_mul_ps(pz[p], cz));
+      d = _mm_add_ps(d, _mm_mul_ps(ax[p], ex));
+      d = _mm_add_ps(d, _mm_mul_ps(ay[p], ey));
+      d = _mm_add_ps(d, _mm_mul_ps(az[p], ez));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(d, _mm_setzero_ps()));
+    }
+
+    const int mask = _mm_movemask_ps(outside);
+    for (size_t j = 0;j<4;++j) {
+      visible[i+j] = ((mask >> j) & 1) ? 0 : 1;
+      visibleCount += visible[i+j];
+    }
+  }
+#endif
+
+  for (;i<count;++i) {
+    uint8_t inside = 1;
+    for (const Vec4& plane : planes) {
+      const float d = plane.x*boxes.cx[i] + plane.y*boxes.cy[i] + plane.z*boxes.cz[i] + plane.w +
+                      std::fabs(plane.x)*boxes.ex[i] + std::fabs(plane.y)*boxes.ey[i] + std::fabs(plane.z)*boxes.ez[i];
+      if (d < 0) {inside = 0; break;}
+    }
+    visible[i] = inside;
+    visibleCount += inside;
+  }
+
+  return visibleCount;
+}
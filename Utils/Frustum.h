@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+#include "Vec3.h"
+#include "Vec4.h"
+#include "Mat4.h"
+#include "Bounds.h"
+
+/**
+ * @file Frustum.h
+ * @brief View-frustum planes extracted from a view-projection matrix, with culling tests.
+ *
+ * A @ref Frustum holds the six clip planes (left, right, bottom, top, near,
+ * far) of a view-projection matrix, extracted with the Gribb/Hartmann method.
+ * Planes are normalized and point inwards, so a point is inside when all six
+ * signed distances are non-negative. Passing a projection*view matrix yields
+ * world-space planes, projection*view*model yields object-space planes.
+ *
+ * Besides single box/sphere tests, @ref Frustum::cull() tests a whole
+ * @ref AABBArray at once, four boxes per iteration with SSE where available.
+ *
+ * @note Tests are conservative: boxes that straddle a plane corner may be
+ *       reported visible even though they are outside.
+ */
+class Frustum {
+public:
+  /** @brief Construct an all-accepting frustum (every plane is 0,0,0,1). */
+  Frustum();
+
+  /**
+   * @brief Extract the planes of @p viewProjection.
+   * @param viewProjection Projection * view (optionally * model) matrix in the
+   *                       conventions of @ref Mat4 (OpenGL clip space).
+   */
+  Frustum(const Mat4& viewProjection);
+
+  /**
+   * @brief Plane @p i as (nx, ny, nz, d) with inward-pointing unit normal.
+   * @param i Plane index: 0 left, 1 right, 2 bottom, 3 top, 4 near, 5 far.
+   */
+  const Vec4& getPlane(size_t i) const {return planes[i];}
+
+  /** @brief True if @p p lies inside or on the frustum. */
+  bool contains(const Vec3& p) const;
+  /** @brief True if @p box is (possibly) visible. */
+  bool intersects(const AABB& box) const;
+  /** @brief True if @p sphere is (possibly) visible. */
+  bool intersects(const BoundingSphere& sphere) const;
+
+  /**
+   * @brief Test all boxes of @p boxes against the frustum.
+   * @param boxes   Boxes in SoA center/extent form.
+   * @param visible Output mask, resized to boxes.size(); 1 = visible, 0 = culled.
+   * @return Number of visible boxes.
+   */
+  size_t cull(const AABBArray& boxes, std::vector<uint8_t>& visible) const;
+
+private:
+  std::array<Vec4, 6> planes; ///< Inward-facing planes (nx, ny, nz, d).
+};
@@ -4,6 +4,15 @@
 GLApp* GLApp::staticAppPtr = nullptr;
 #endif
 
+// vertex layouts of the stock shaders; every draw refills simpleVb in one of them
+static const VertexFormat posColorFormat{{"vPos", GLAttribType::FLOAT, 3},
+                                         {"vColor", GLAttribType::FLOAT, 4}};
+static const VertexFormat posColorNormalFormat{{"vPos", GLAttribType::FLOAT, 3},
+                                               {"vColor", GLAttribType::FLOAT, 4},
+                                               {"vNormal", GLAttribType::FLOAT, 3}};
+static const VertexFormat posTexFormat{{"vPos", GLAttribType::FLOAT, 3},
+                                       {"vTexCoords", GLAttribType::FLOAT, 2}};
+
 GLApp::GLApp(uint32_t w, uint32_t h, uint32_t s,
              const std::string& title,
              bool fpsCounter, bool sync) :
@@ -253,9 +262,15 @@ GLApp::GLApp(uint32_t w, uint32_t h, uint32_t s,
      "    FragColor = color*abs(dot(nlightDir,nnormal));\n"
      "}\n")},
 #endif
-  simpleArray{},
   simpleVb{GL_ARRAY_BUFFER},
+  simpleArray{},
+  simplePointArray{},
+  simpleSpriteArray{},
+  simpleHLSpriteArray{},
+  simpleTexArray{},
+  simpleLightArray{},
   raster{GL_LINEAR, GL_LINEAR,GL_CLAMP_TO_EDGE,GL_CLAMP_TO_EDGE},
+  solidColor{GL_NEAREST, GL_NEAREST,GL_CLAMP_TO_EDGE,GL_CLAMP_TO_EDGE},
   pointSprite{GL_LINEAR, GL_LINEAR,GL_CLAMP_TO_EDGE,GL_CLAMP_TO_EDGE},
   pointSpriteHighlight{GL_LINEAR, GL_LINEAR,GL_CLAMP_TO_EDGE,GL_CLAMP_TO_EDGE},
   resumeTime{0},
@@ -275,7 +290,18 @@ GLApp::GLApp(uint32_t w, uint32_t h, uint32_t s,
 #endif
 
   resetPointTexture();
+
+  // drawImage(Image) typically re-uploads every frame
+  raster.setStreaming(true);
   
+  // the VAOs only reference simpleVb, so they stay valid when it is refilled
+  simpleArray.configure(simpleVb, posColorFormat, simpleProg);
+  simplePointArray.configure(simpleVb, posColorFormat, simplePointProg);
+  simpleSpriteArray.configure(simpleVb, posColorFormat, simpleSpriteProg);
+  simpleHLSpriteArray.configure(simpleVb, posColorFormat, simpleHLSpriteProg);
+  simpleTexArray.configure(simpleVb, posTexFormat, simpleTexProg);
+  simpleLightArray.configure(simpleVb, posColorNormalFormat, simpleLightProg);
+
   // setup a minimal shader and buffer
   shaderUpdate();
 
@@ -292,10 +318,18 @@ GLApp::~GLApp() {
 }
 
 void GLApp::setPointTexture(const Image& shape) {
+  if (shape.layout != MemoryLayout::Linear) {
+    setPointTexture(shape.toLayout(MemoryLayout::Linear));
+    return;
+  }
   setPointTexture(shape.data, shape.width, shape.height, shape.componentCount);
 }
 
 void GLApp::setPointHighlightTexture(const Image& shape) {
+  if (shape.layout != MemoryLayout::Linear) {
+    setPointHighlightTexture(shape.toLayout(MemoryLayout::Linear));
+    return;
+  }
   pointSpriteHighlight.setData(shape.data, shape.width, shape.height, shape.componentCount);
 }
 
@@ -330,6 +364,8 @@ void GLApp::mainLoop() {
   if (animationActive) {
     animate(emscripten_performance_now()/1000.0-startTime);
   }
+  shaderWatcher.poll();
+  textureLoader.update();
   draw();
   glEnv.endOfFrame();
 #else
@@ -337,6 +373,8 @@ void GLApp::mainLoop() {
     if (animationActive) {
       animate(glfwGetTime()-startTime);
     }
+    shaderWatcher.poll();
+    textureLoader.update();
     draw();
     glEnv.endOfFrame();
   } while (!glEnv.shouldClose());
@@ -486,14 +524,10 @@ void GLApp::drawLines(const std::vector<float>& data, LineDrawType t, float line
     GL(glPolygonMode( GL_FRONT_AND_BACK, GL_FILL ));
 #endif
     simpleVb.setData(trisData,7,GL_DYNAMIC_DRAW);
-    simpleArray.connectVertexAttrib(simpleVb, simpleProg, "vPos", 3);
-    simpleArray.connectVertexAttrib(simpleVb, simpleProg, "vColor", 4, 3);
 
     GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(trisData.size()/7)));
   } else {
     simpleVb.setData(data,7,GL_DYNAMIC_DRAW);
-    simpleArray.connectVertexAttrib(simpleVb, simpleProg, "vPos", 3);
-    simpleArray.connectVertexAttrib(simpleVb, simpleProg, "vColor", 4, 3);
     switch (t) {
       case LineDrawType::LIST :
         GL(glDrawArrays(GL_LINES, 0, GLsizei(data.size()/7)));
@@ -520,9 +554,7 @@ void GLApp::drawPoints(const std::vector<float>& data, float pointSize, bool use
       simpleHLSpriteProg.setTexture("pointSprite", pointSprite, 0);
       simpleHLSpriteProg.setTexture("pointSpriteHighlight", pointSpriteHighlight, 1);
       simpleVb.setData(data,7,GL_DYNAMIC_DRAW);
-      simpleArray.bind();
-      simpleArray.connectVertexAttrib(simpleVb, simpleHLSpriteProg, "vPos", 3);
-      simpleArray.connectVertexAttrib(simpleVb, simpleHLSpriteProg, "vColor", 4, 3);
+      simpleHLSpriteArray.bind();
     } else {
       simpleSpriteProg.enable();
 #ifdef __EMSCRIPTEN__
@@ -532,9 +564,7 @@ void GLApp::drawPoints(const std::vector<float>& data, float pointSize, bool use
 #endif
       simpleSpriteProg.setTexture("pointSprite", pointSprite, 0);
       simpleVb.setData(data,7,GL_DYNAMIC_DRAW);
-      simpleArray.bind();
-      simpleArray.connectVertexAttrib(simpleVb, simpleSpriteProg, "vPos", 3);
-      simpleArray.connectVertexAttrib(simpleVb, simpleSpriteProg, "vColor", 4, 3);
+      simpleSpriteArray.bind();
     }
     
   } else {
@@ -545,9 +575,7 @@ void GLApp::drawPoints(const std::vector<float>& data, float pointSize, bool use
     GL(glPointSize(pointSize));
 #endif
     simpleVb.setData(data,7,GL_DYNAMIC_DRAW);
-    simpleArray.bind();
-    simpleArray.connectVertexAttrib(simpleVb, simplePointProg, "vPos", 3);
-    simpleArray.connectVertexAttrib(simpleVb, simplePointProg, "vColor", 4, 3);
+    simplePointArray.bind();
   }
 
   GL(glDrawArrays(GL_POINTS, 0, GLsizei(data.size()/7)));
@@ -558,15 +586,10 @@ void GLApp::redrawTriangles(bool wireframe) {
 
   if (lastLighting) {
     simpleLightProg.enable();
-    simpleArray.bind();
-    simpleArray.connectVertexAttrib(simpleVb, simpleLightProg, "vPos", 3);
-    simpleArray.connectVertexAttrib(simpleVb, simpleLightProg, "vColor", 4, 3);
-    simpleArray.connectVertexAttrib(simpleVb, simpleLightProg, "vNormal", 3, 7);
+    simpleLightArray.bind();
   } else {
     simpleProg.enable();
     simpleArray.bind();
-    simpleArray.connectVertexAttrib(simpleVb, simpleProg, "vPos", 3);
-    simpleArray.connectVertexAttrib(simpleVb, simpleProg, "vColor", 4, 3);
   }
 
 
@@ -805,9 +828,7 @@ void GLApp::drawImage(const GLTexture2D& image, const Vec3& bl,
   
   simpleVb.setData(data,5,GL_DYNAMIC_DRAW);
   
-  simpleArray.bind();
-  simpleArray.connectVertexAttrib(simpleVb, simpleTexProg, "vPos", 3);
-  simpleArray.connectVertexAttrib(simpleVb, simpleTexProg, "vTexCoords", 2, 3);
+  simpleTexArray.bind();
   simpleTexProg.setTexture("raster",image,0);
 
   GL(glDrawArrays(GL_TRIANGLES, 0, GLsizei(data.size()/5)));
@@ -816,6 +837,10 @@ void GLApp::drawImage(const GLTexture2D& image, const Vec3& bl,
 void GLApp::drawImage(const Image& image, const Vec3& bl,
                       const Vec3& br, const Vec3& tl,
                       const Vec3& tr) {
+  if (image.layout != MemoryLayout::Linear) {
+    drawImage(image.toLayout(MemoryLayout::Linear), bl, br, tl, tr);
+    return;
+  }
 
   raster.setData(image.data, image.width, image.height, image.componentCount);
   drawImage(raster, bl, br, tl, tr);
@@ -831,7 +856,9 @@ void GLApp::drawRect(const Vec4& color, const Vec2& bl, const Vec2& tr) {
 
 void GLApp::drawRect(const Vec4& color, const Vec3& bl, const Vec3& br,
                      const Vec3& tl, const Vec3& tr) {
-  drawImage(Image{color}, bl, br, tl, tr);
+  // separate 1x1 texture, so rects do not reallocate the raster between images
+  solidColor.setData(Image{color});
+  drawImage(solidColor, bl, br, tl, tr);
 }
 
 Mat4 GLApp::computeImageTransform(const Vec2ui& imageSize) const {
@@ -4,6 +4,8 @@
 
 #include "GLEnv.h"
 #include "GLProgram.h"
+#include "ShaderWatcher.h"
+#include "TextureLoader.h"
 #include "GLArray.h"
 #include "GLBuffer.h"
 #include "GLTexture2D.h"
@@ -279,11 +281,19 @@ protected:
   GLProgram simpleHLSpriteProg;///< Point sprite + highlight overlay.
   GLProgram simpleTexProg;     ///< Textured quad shader (pos+uv).
   GLProgram simpleLightProg;   ///< Lit shader (pos+color+normal).
-  GLArray simpleArray;         ///< VAO used by helpers.
   GLBuffer simpleVb;           ///< VBO used by helpers.
+  GLArray simpleArray;         ///< VAO of @ref simpleProg on @ref simpleVb.
+  GLArray simplePointArray;    ///< VAO of @ref simplePointProg.
+  GLArray simpleSpriteArray;   ///< VAO of @ref simpleSpriteProg.
+  GLArray simpleHLSpriteArray; ///< VAO of @ref simpleHLSpriteProg.
+  GLArray simpleTexArray;      ///< VAO of @ref simpleTexProg.
+  GLArray simpleLightArray;    ///< VAO of @ref simpleLightProg.
   GLTexture2D raster;          ///< Temporary texture for @ref drawImage(Image).
+  GLTexture2D solidColor;      ///< 1x1 texture for @ref drawRect().
   GLTexture2D pointSprite;     ///< Point‑sprite base texture.
   GLTexture2D pointSpriteHighlight; ///< Optional highlight overlay sprite.
+  ShaderWatcher shaderWatcher; ///< Hot reload of file based programs, polled every frame.
+  TextureLoader textureLoader; ///< Asynchronous texture loads, uploaded every frame.
   double resumeTime;           ///< Timestamp used to keep animation time continuous on resume.
 #ifdef __EMSCRIPTEN__
   float xMousePos;             ///< Last mouse X (Emscripten).
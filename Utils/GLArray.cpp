@@ -1,3 +1,5 @@
+#include <utility>
+
 #include "GLArray.h"
 
 GLArray::GLArray() {
@@ -9,6 +11,16 @@ GLArray::~GLArray() {
 	GL(glDeleteVertexArrays(1, &glId));
 }
 
+GLArray::GLArray(GLArray&& other) noexcept :
+	glId(std::exchange(other.glId, 0))
+{
+}
+
+GLArray& GLArray::operator=(GLArray&& other) noexcept {
+	std::swap(glId, other.glId);
+	return *this;
+}
+
 void GLArray::bind() const {
 	GL(glBindVertexArray(glId));
 }
@@ -24,6 +36,16 @@ void GLArray::connectVertexAttrib(const GLBuffer& buffer,
 	buffer.connectVertexAttrib(GLuint(location), elemCount, offset, divisor);
 }
 
+void GLArray::configure(const GLBuffer& buffer, const VertexFormat& format,
+                        const GLProgram& program, GLuint divisor) const {
+  bind();
+  for (const VertexAttribute& attribute : format.getAttributes()) {
+    const GLint location = program.findAttributeLocation(attribute.name);
+    if (location < 0) continue;
+    buffer.connectVertexAttrib(GLuint(location), attribute, format.getStride(), divisor);
+  }
+}
+
 void GLArray::connectIndexBuffer(const GLBuffer& buffer) const {
 	bind();
 	buffer.bind();	
@@ -7,6 +7,7 @@
 
 #include "GLBuffer.h"
 #include "GLProgram.h"
+#include "VertexFormat.h"
 
 /**
  * @file GLArray.h
@@ -15,7 +16,12 @@
  * Encapsulates creation/binding/destruction of a VAO and provides helpers to
  * associate buffer contents with shader attributes as well as to bind an index
  * (element) buffer. Attribute specification uses the stride/format previously
- * established on the @ref GLBuffer via its setData() calls.
+ * established on the @ref GLBuffer via its setData() calls, or, with
+ * @ref configure(), on a @ref VertexFormat describing an interleaved layout.
+ *
+ * A VAO records the buffer name, offsets and types, not the contents, so it
+ * is configured once and then only bound per draw, also when the buffer is
+ * refilled with the same layout.
  *
  * @note All GL calls in the implementation are wrapped via a GL() macro
  *       (see GLDebug/GLEnv). The class does not assume ownership of the
@@ -28,6 +34,13 @@ public:
   /** @brief Destroy and delete the VAO name. */
   ~GLArray();
 
+  GLArray(const GLArray&) = delete;
+  GLArray& operator=(const GLArray&) = delete;
+  /** @brief Move-construct, taking over the VAO of @p other. */
+  GLArray(GLArray&& other) noexcept;
+  /** @brief Move-assign; the previous VAO is released together with @p other. */
+  GLArray& operator=(GLArray&& other) noexcept;
+
   /**
    * @brief Bind this VAO for subsequent vertex specification/draws.
    */
@@ -50,6 +63,19 @@ public:
                            const std::string& variable, size_t elemCount,
                            size_t offset=0, GLuint divisor = 0) const;
 
+  /**
+   * @brief Connect every attribute of @p format from @p buffer in one call.
+   * @param buffer  Buffer holding (or later receiving) vertices of @p format.
+   * @param format  Interleaved vertex layout.
+   * @param program Program from which the attribute locations are queried.
+   * @param divisor Instance divisor for all attributes (0 = per-vertex).
+   *
+   * Attributes the program does not use are skipped, so one format can serve
+   * several programs (e.g. a depth-only pass reading positions only).
+   */
+  void configure(const GLBuffer& buffer, const VertexFormat& format,
+                 const GLProgram& program, GLuint divisor = 0) const;
+
   /**
    * @brief Bind @p buffer as the index (element) buffer for this VAO.
    * @param buffer Buffer previously filled with indices (GLuint).
@@ -1,7 +1,28 @@
 #include <sstream>
+#include <utility>
+#include <limits>
+#include <algorithm>
 
 #include "GLBuffer.h"
 #include "GLEnv.h"
+#include "VertexFormat.h"
+
+GLenum attribTypeToGL(GLAttribType type) {
+  switch (type) {
+    case GLAttribType::FLOAT : return GL_FLOAT;
+    case GLAttribType::HALF : return GL_HALF_FLOAT;
+    case GLAttribType::BYTE_NORM : return GL_BYTE;
+    case GLAttribType::UBYTE_NORM : return GL_UNSIGNED_BYTE;
+    case GLAttribType::SHORT_NORM : return GL_SHORT;
+    case GLAttribType::USHORT_NORM : return GL_UNSIGNED_SHORT;
+    case GLAttribType::INT_2_10_10_10_REV : return GL_INT_2_10_10_10_REV;
+  }
+  return GL_NONE;
+}
+
+GLboolean attribTypeNormalized(GLAttribType type) {
+  return (type == GLAttribType::FLOAT || type == GLAttribType::HALF) ? GL_FALSE : GL_TRUE;
+}
 
 
 GLBuffer::GLBuffer(GLenum target) :
@@ -15,44 +36,161 @@ GLBuffer::GLBuffer(GLenum target) :
 }
 
 GLBuffer::~GLBuffer()  {
+	if (bufferID == 0) return; // moved from
 	GL(glBindBuffer(target, 0));
 	GL(glDeleteBuffers(1, &bufferID));
 }
 
+GLBuffer::GLBuffer(GLBuffer&& other) noexcept :
+	target(other.target),
+	bufferID(std::exchange(other.bufferID, 0)),
+	elemSize(other.elemSize),
+	stride(other.stride),
+	type(other.type),
+	normalized(other.normalized),
+	count(std::exchange(other.count, 0)),
+	capacity(std::exchange(other.capacity, 0)),
+	usage(other.usage)
+{
+}
+
+GLBuffer& GLBuffer::operator=(GLBuffer&& other) noexcept {
+	std::swap(target, other.target);
+	std::swap(bufferID, other.bufferID);
+	std::swap(elemSize, other.elemSize);
+	std::swap(stride, other.stride);
+	std::swap(type, other.type);
+	std::swap(normalized, other.normalized);
+	std::swap(count, other.count);
+	std::swap(capacity, other.capacity);
+	std::swap(usage, other.usage);
+	return *this;
+}
+
+void GLBuffer::upload(const void* data, size_t count, size_t elemSize, GLenum usage) {
+  const size_t bytes = count*elemSize;
+  GL(glBindBuffer(target, bufferID));
+  if (bytes > capacity || usage != this->usage || bytes < capacity/4) {
+    // grow geometrically for buffers that are refilled, fit exactly otherwise
+    capacity = (count > 0 && this->count > 0 && bytes > capacity) ? std::max(bytes, capacity*2) : bytes;
+    this->usage = usage;
+    GL(glBufferData(target, GLsizeiptr(capacity), capacity == bytes ? data : nullptr, usage));
+    if (capacity != bytes) GL(glBufferSubData(target, 0, GLsizeiptr(bytes), data));
+  } else if (bytes > 0) {
+    // buffers refilled every frame get fresh storage, so the GPU may keep
+    // reading the old one while we write; others are written in place
+    if (usage == GL_STREAM_DRAW || usage == GL_DYNAMIC_DRAW)
+      GL(glBufferData(target, GLsizeiptr(capacity), nullptr, usage));
+    GL(glBufferSubData(target, 0, GLsizeiptr(bytes), data));
+  }
+  this->count = count;
+}
+
 void GLBuffer::setData(const std::vector<float>& data, size_t valuesPerElement, GLenum usage) {
-	elemSize = sizeof(data[0]);
-	stride = valuesPerElement*elemSize;
-	type = GL_FLOAT;
-	GL(glBindBuffer(target, bufferID));
-	GL(glBufferData(target, GLsizeiptr(elemSize*data.size()), data.data(), usage));
+  setData(data.data(), data.size(), valuesPerElement, usage);
 }
 
-void GLBuffer::setData(const std::vector<GLuint>& data) {
-	elemSize = sizeof(data[0]);
-	stride = 1*elemSize;
-	type = GL_UNSIGNED_INT;
-	GL(glBindBuffer(target, bufferID));
-	GL(glBufferData(target, GLsizeiptr(elemSize*data.size()), data.data(),
-                  GL_STATIC_DRAW));
+void GLBuffer::setData(const std::vector<GLuint>& data, GLenum usage, bool allowByteIndices) {
+  uploadIndices(data.data(), data.size(), usage, allowByteIndices);
 }
 
 void GLBuffer::setData(const float data[], size_t elemCount,
                        size_t valuesPerElement,GLenum usage) {
-  elemSize = sizeof(data[0]);
+  setData(data, elemCount, valuesPerElement, GLAttribType::FLOAT, usage);
+}
+
+void GLBuffer::setData(const GLuint data[], size_t elemCount, GLenum usage, bool allowByteIndices) {
+  uploadIndices(data, elemCount, usage, allowByteIndices);
+}
+
+void GLBuffer::setData(const void* data, size_t valueCount, size_t valuesPerElement,
+                       GLAttribType type, GLenum usage) {
+  this->type = attribTypeToGL(type);
+  normalized = attribTypeNormalized(type);
+  elemSize = VertexFormat::typeSize(type);
   stride = valuesPerElement*elemSize;
-  type = GL_FLOAT;
-  GL(glBindBuffer(target, bufferID));
-  GL(glBufferData(target, GLsizeiptr(elemSize*elemCount), data, usage));
+  upload(data, valueCount, elemSize, usage);
+}
+
+void GLBuffer::setData(const std::vector<uint8_t>& vertices, const VertexFormat& format, GLenum usage) {
+  setData(vertices.data(), vertices.size()/format.getStride(), format, usage);
+}
+
+void GLBuffer::setData(const void* vertices, size_t vertexCount, const VertexFormat& format, GLenum usage) {
+  // one value is one vertex, the attribute types live in the format
+  type = GL_NONE;
+  normalized = GL_FALSE;
+  elemSize = format.getStride();
+  stride = elemSize;
+  upload(vertices, vertexCount, elemSize, usage);
+}
+
+void GLBuffer::uploadIndices(const GLuint data[], size_t count, GLenum usage, bool allowByteIndices) {
+  const GLuint maxIndex = count > 0 ? *std::max_element(data, data+count) : 0;
+  normalized = GL_FALSE;
+  if (allowByteIndices && maxIndex <= std::numeric_limits<GLubyte>::max()) {
+    const std::vector<GLubyte> narrow(data, data+count);
+    type = GL_UNSIGNED_BYTE;
+    elemSize = sizeof(GLubyte);
+    stride = elemSize;
+    upload(narrow.data(), count, elemSize, usage);
+  } else if (maxIndex <= std::numeric_limits<GLushort>::max()) {
+    const std::vector<GLushort> narrow(data, data+count);
+    type = GL_UNSIGNED_SHORT;
+    elemSize = sizeof(GLushort);
+    stride = elemSize;
+    upload(narrow.data(), count, elemSize, usage);
+  } else {
+    type = GL_UNSIGNED_INT;
+    elemSize = sizeof(GLuint);
+    stride = elemSize;
+    upload(data, count, elemSize, usage);
+  }
 }
 
-void GLBuffer::setData(const GLuint data[], size_t elemCount) {
-  elemSize = sizeof(data[0]);
-  stride = 1*elemSize;
-  type = GL_UNSIGNED_INT;
+void GLBuffer::setSubData(const void* data, size_t offset, size_t valueCount) {
+  if (offset+valueCount > count) {
+    std::stringstream ss;
+    ss << "Sub-range " << offset << "+" << valueCount << " exceeds the buffer contents (" << count << " values).";
+    throw GLException{ss.str()};
+  }
+  if (valueCount == 0) return;
   GL(glBindBuffer(target, bufferID));
-  GL(glBufferData(target, GLsizeiptr(elemSize*elemCount), data, GL_STATIC_DRAW));
+  GL(glBufferSubData(target, GLintptr(offset*elemSize), GLsizeiptr(valueCount*elemSize), data));
+}
+
+void GLBuffer::setSubData(const std::vector<GLfloat>& data, size_t offset) {
+  if (type != GL_FLOAT) {
+    throw GLException{"setSubData with floats requires a float buffer."};
+  }
+  setSubData(data.data(), offset, data.size());
 }
 
+void GLBuffer::setSubData(const std::vector<GLuint>& data, size_t offset) {
+  switch (type) {
+    case GL_UNSIGNED_INT :
+      setSubData(data.data(), offset, data.size());
+      return;
+    case GL_UNSIGNED_SHORT :
+    case GL_UNSIGNED_BYTE : {
+      const GLuint limit = type == GL_UNSIGNED_SHORT ? std::numeric_limits<GLushort>::max()
+                                                     : std::numeric_limits<GLubyte>::max();
+      if (!data.empty() && *std::max_element(data.begin(), data.end()) > limit) {
+        throw GLException{"Index does not fit the buffer's index type, use setData instead."};
+      }
+      if (type == GL_UNSIGNED_SHORT) {
+        const std::vector<GLushort> narrow(data.begin(), data.end());
+        setSubData(narrow.data(), offset, narrow.size());
+      } else {
+        const std::vector<GLubyte> narrow(data.begin(), data.end());
+        setSubData(narrow.data(), offset, narrow.size());
+      }
+      return;
+    }
+    default :
+      throw GLException{"setSubData with indices requires an index buffer."};
+  }
+}
 
 void GLBuffer::connectVertexAttrib(GLuint location, size_t elemCount,
                                    size_t offset, GLuint divisor) const {
@@ -62,7 +200,7 @@ void GLBuffer::connectVertexAttrib(GLuint location, size_t elemCount,
     
 	GL(glBindBuffer(target, bufferID));
 	GL(glEnableVertexAttribArray(location));
-	GL(glVertexAttribPointer(location, GLsizei(elemCount), type, GL_FALSE, GLsizei(stride), (void*)(offset*elemSize)));
+	GL(glVertexAttribPointer(location, GLsizei(elemCount), type, normalized, GLsizei(stride), (void*)(offset*elemSize)));
   if (divisor != 0) GL(glVertexAttribDivisor(location, divisor));
 }
 
@@ -70,3 +208,13 @@ void GLBuffer::bind() const {
 	GL(glBindBuffer(target, bufferID));
 }
 
+void GLBuffer::connectVertexAttrib(GLuint location, const VertexAttribute& attribute,
+                                   size_t stride, GLuint divisor) const {
+  const GLint size = attribute.type == GLAttribType::INT_2_10_10_10_REV ? 4 : GLint(attribute.components);
+  GL(glBindBuffer(target, bufferID));
+  GL(glEnableVertexAttribArray(location));
+  GL(glVertexAttribPointer(location, size, attribTypeToGL(attribute.type),
+                           attribTypeNormalized(attribute.type), GLsizei(stride),
+                           (void*)attribute.offset));
+  if (divisor != 0) GL(glVertexAttribDivisor(location, divisor));
+}
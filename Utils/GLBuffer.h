@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstdint>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -10,10 +11,45 @@
  * @brief Thin RAII wrapper for an OpenGL buffer object with upload/binding helpers.
  *
  * Encapsulates creation/destruction of a generic GL buffer (e.g., VBO/EBO/SSBO)
- * and provides utilities to upload data (floats or unsigned ints), bind it,
- * and describe vertex attributes. The buffer target is chosen at construction
+ * and provides utilities to upload data, bind it, and describe vertex
+ * attributes. The buffer target is chosen at construction
  * (e.g., `GL_ARRAY_BUFFER`, `GL_ELEMENT_ARRAY_BUFFER`).
+ *
+ * Vertex data can be floats or one of the compact types of ::GLAttribType.
+ * Indices are stored in the narrowest type that holds the largest index
+ * (see @ref getType() for glDrawElements).
+ *
+ * The buffer keeps its allocation between uploads: data that fits is written
+ * with glBufferSubData, larger data grows the capacity geometrically, and
+ * @ref setSubData() replaces a range in place. For `GL_STREAM_DRAW` and
+ * `GL_DYNAMIC_DRAW` the storage is orphaned before the write, so the GPU can
+ * keep reading the previous contents; other usages are written in place.
+ *
+ * Interleaved vertices described by a @ref VertexFormat are uploaded as raw
+ * bytes; their attributes are connected through GLArray::configure().
+ */
+
+class VertexFormat;
+struct VertexAttribute;
+
+/**
+ * @brief Component type of vertex attribute data.
  */
+enum class GLAttribType {
+  FLOAT,       ///< 32-bit float.
+  HALF,        ///< 16-bit float (GLhalf bit patterns).
+  BYTE_NORM,   ///< Signed 8-bit, normalized to [-1,1].
+  UBYTE_NORM,  ///< Unsigned 8-bit, normalized to [0,1].
+  SHORT_NORM,  ///< Signed 16-bit, normalized to [-1,1].
+  USHORT_NORM, ///< Unsigned 16-bit, normalized to [0,1].
+  INT_2_10_10_10_REV ///< Signed normalized 10/10/10/2 bits packed in one 32-bit value (4 components).
+};
+
+/** @brief GL component type of @p type (e.g. `GL_HALF_FLOAT`). */
+GLenum attribTypeToGL(GLAttribType type);
+/** @brief True for the integer types, which are normalized when read by the shader. */
+GLboolean attribTypeNormalized(GLAttribType type);
+
 class GLBuffer {
 public:
   /**
@@ -26,6 +62,13 @@ public:
   /** @brief Destroy and delete the GL buffer name. */
   ~GLBuffer();
 
+  GLBuffer(const GLBuffer&) = delete;
+  GLBuffer& operator=(const GLBuffer&) = delete;
+  /** @brief Move-construct, taking over the buffer object of @p other. */
+  GLBuffer(GLBuffer&& other) noexcept;
+  /** @brief Move-assign; the previous buffer is released together with @p other. */
+  GLBuffer& operator=(GLBuffer&& other) noexcept;
+
   /**
    * @brief Upload interleaved float data and define element stride.
    * @param data              Flat vector of floats.
@@ -37,10 +80,16 @@ public:
 
   /**
    * @brief Upload unsigned-int data (e.g., element indices).
-   * @param data Flat vector of `GLuint` values.
-   * @post Element size/stride/type are set for index-style data (stride = 1, type = `GL_UNSIGNED_INT`).
+   * @param data            Flat vector of `GLuint` values.
+   * @param usage           GL usage hint.
+   * @param allowByteIndices Narrow to 8 bits if all indices are below 256;
+   *                        several desktop drivers emulate 8-bit indices, so
+   *                        by default narrowing stops at 16 bits.
+   * @post Element size/stride/type are set for index-style data; the type is
+   *       `GL_UNSIGNED_SHORT` if all indices fit, `GL_UNSIGNED_INT` otherwise.
    */
-  void setData(const std::vector<GLuint>& data);
+  void setData(const std::vector<GLuint>& data, GLenum usage=GL_STATIC_DRAW,
+               bool allowByteIndices=false);
 
   /**
    * @brief Upload interleaved float data from a raw pointer.
@@ -53,11 +102,67 @@ public:
                size_t valuesPerElement,GLenum usage=GL_STATIC_DRAW);
 
   /**
-   * @brief Upload unsigned-int data from a raw pointer.
+   * @brief Upload unsigned-int data from a raw pointer (narrowed like the vector overload).
    * @param data      Pointer to `elemCount` indices.
    * @param elemCount Number of indices.
+   * @param usage     GL usage hint.
+   * @param allowByteIndices Allow narrowing to 8-bit indices.
+   */
+  void setData(const GLuint data[], size_t elemCount, GLenum usage=GL_STATIC_DRAW,
+               bool allowByteIndices=false);
+
+  /**
+   * @brief Upload vertex data of a compact attribute type.
+   * @param data             Pointer to `valueCount` values of @p type (for
+   *                         INT_2_10_10_10_REV one value is a packed uint32).
+   * @param valueCount       Number of values.
+   * @param valuesPerElement Values per logical element (stride in values).
+   * @param type             Component type.
+   * @param usage            GL usage hint.
+   */
+  void setData(const void* data, size_t valueCount, size_t valuesPerElement,
+               GLAttribType type, GLenum usage=GL_STATIC_DRAW);
+
+  /**
+   * @brief Upload interleaved vertices packed by VertexFormat::pack().
+   * @param vertices Packed bytes, a multiple of format.getStride().
+   * @param format   Layout of one vertex.
+   * @param usage    GL usage hint.
+   * @post getCount() is the number of vertices and getType() is `GL_NONE`;
+   *       attributes are connected with GLArray::configure(), and
+   *       @ref setSubData(const void*, size_t, size_t) replaces whole vertices.
+   */
+  void setData(const std::vector<uint8_t>& vertices, const VertexFormat& format,
+               GLenum usage=GL_STATIC_DRAW);
+
+  /**
+   * @brief Upload @p vertexCount interleaved vertices of @p format from a raw pointer.
    */
-  void setData(const GLuint data[], size_t elemCount);
+  void setData(const void* vertices, size_t vertexCount, const VertexFormat& format,
+               GLenum usage=GL_STATIC_DRAW);
+
+  /**
+   * @brief Replace floats starting at value @p offset without reallocating.
+   * @param data   New values.
+   * @param offset Offset in values from the start of the buffer.
+   * @throw GLException If the buffer does not hold floats or the range exceeds its contents.
+   */
+  void setSubData(const std::vector<GLfloat>& data, size_t offset);
+
+  /**
+   * @brief Replace indices starting at index @p offset without reallocating.
+   * @param data   New indices, converted to the buffer's index type.
+   * @param offset Offset in indices from the start of the buffer.
+   * @throw GLException If the buffer does not hold indices, an index does not
+   *        fit the current index type or the range exceeds the contents.
+   */
+  void setSubData(const std::vector<GLuint>& data, size_t offset);
+
+  /**
+   * @brief Replace @p valueCount values of the current type starting at value @p offset.
+   * @throw GLException If the range exceeds the buffer contents.
+   */
+  void setSubData(const void* data, size_t offset, size_t valueCount);
 
   /**
    * @brief Describe a vertex attribute array for the current buffer contents.
@@ -74,13 +179,52 @@ public:
   void connectVertexAttrib(GLuint location, size_t elemCount,
                            size_t offset=0, GLuint divisor = 0) const;
 
+  /**
+   * @brief Describe one attribute of an interleaved layout.
+   * @param location  Attribute location as retrieved from the shader.
+   * @param attribute Attribute of a @ref VertexFormat (type, components, byte offset).
+   * @param stride    Bytes per vertex (VertexFormat::getStride()).
+   * @param divisor   Instance divisor (0 = per-vertex).
+   *
+   * Unlike the overload above this does not depend on the buffer contents, so
+   * a VAO can be configured before the first upload and stays valid when the
+   * data is replaced.
+   */
+  void connectVertexAttrib(GLuint location, const VertexAttribute& attribute,
+                           size_t stride, GLuint divisor = 0) const;
+
   /** @brief Bind the buffer to its target with `glBindBuffer(target, id)`. */
   void bind() const;
 
+  /** @name Introspection */
+  ///@{
+  /** @brief GL component type, e.g. the index type to pass to glDrawElements. */
+  GLenum getType() const {return type;}
+  /** @brief Number of values (e.g. indices) uploaded by the last setData(). */
+  size_t getCount() const {return count;}
+  /** @brief Allocated size in bytes (at least getCount() values). */
+  size_t getCapacity() const {return capacity;}
+  ///@}
+
 private:
   GLenum target;   ///< Buffer binding target passed at construction.
   GLuint bufferID; ///< GL name of the buffer object.
   size_t elemSize; ///< Size in bytes of one component (e.g., sizeof(float)).
   size_t stride;   ///< Stride in bytes between consecutive logical elements.
-  GLenum type;     ///< Component type (`GL_FLOAT` or `GL_UNSIGNED_INT`).
+  GLenum type;     ///< Component type (e.g. `GL_FLOAT`, `GL_UNSIGNED_SHORT`).
+  GLboolean normalized{GL_FALSE}; ///< Integer attributes are normalized to [0,1]/[-1,1].
+  size_t count{0};    ///< Number of values uploaded.
+  size_t capacity{0}; ///< Allocated bytes.
+  GLenum usage{GL_STATIC_DRAW}; ///< Usage hint of the current allocation.
+
+  /**
+   * @brief Upload @p count values of @p elemSize bytes, reusing or growing the allocation.
+   * @param data  Source values.
+   * @param count Number of values.
+   * @param usage GL usage hint.
+   */
+  void upload(const void* data, size_t count, size_t elemSize, GLenum usage);
+
+  /** @brief Narrow @p data to the smallest index type and upload it. */
+  void uploadIndices(const GLuint data[], size_t count, GLenum usage, bool allowByteIndices);
 };
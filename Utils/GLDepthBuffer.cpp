@@ -1,3 +1,5 @@
+#include <utility>
+
 #include "GLDepthBuffer.h"
 
 
@@ -16,6 +18,20 @@ GLDepthBuffer::~GLDepthBuffer() {
 	GL(glDeleteRenderbuffers(1, &id));
 }
 
+GLDepthBuffer::GLDepthBuffer(GLDepthBuffer&& other) noexcept :
+  id(std::exchange(other.id, 0)),
+  width(std::exchange(other.width, 0)),
+  height(std::exchange(other.height, 0))
+{
+}
+
+GLDepthBuffer& GLDepthBuffer::operator=(GLDepthBuffer&& other) noexcept {
+  std::swap(id, other.id);
+  std::swap(width, other.width);
+  std::swap(height, other.height);
+  return *this;
+}
+
 const GLuint GLDepthBuffer::getId() const {
 	return id;
 }
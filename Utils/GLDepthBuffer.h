@@ -29,6 +29,13 @@ public:
   /** @brief Destroy and delete the GL renderbuffer name. */
   ~GLDepthBuffer();
 
+  GLDepthBuffer(const GLDepthBuffer&) = delete;
+  GLDepthBuffer& operator=(const GLDepthBuffer&) = delete;
+  /** @brief Move-construct, taking over the renderbuffer of @p other. */
+  GLDepthBuffer(GLDepthBuffer&& other) noexcept;
+  /** @brief Move-assign; the previous renderbuffer is released together with @p other. */
+  GLDepthBuffer& operator=(GLDepthBuffer&& other) noexcept;
+
   /**
    * @brief Retrieve the OpenGL renderbuffer object name.
    * @return GLuint of the managed depth renderbuffer.
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 
 #include "GLEnv.h"
 
@@ -49,6 +50,27 @@ public:
     GL(glDeleteTextures(1, &id));
   }
 
+  GLDepthTexture(const GLDepthTexture&) = delete;
+  GLDepthTexture& operator=(const GLDepthTexture&) = delete;
+
+  /** @brief Move-construct, taking over the GL texture of @p other. */
+  GLDepthTexture(GLDepthTexture&& other) noexcept :
+  id{ std::exchange(other.id, 0) },
+  width{ std::exchange(other.width, 0) },
+  height{ std::exchange(other.height, 0) },
+  dataType{ other.dataType }
+  {
+  }
+
+  /** @brief Move-assign; the previous texture is released together with @p other. */
+  GLDepthTexture& operator=(GLDepthTexture&& other) noexcept {
+    std::swap(id, other.id);
+    std::swap(width, other.width);
+    std::swap(height, other.height);
+    std::swap(dataType, other.dataType);
+    return *this;
+  }
+
   /**
    * @brief Retrieve the OpenGL texture object name.
    * @return GLuint of the managed depth texture.
@@ -42,6 +42,16 @@
  */
 enum class GLDataType {BYTE, HALF, FLOAT};
 
+/**
+ * @brief CPU shadow-copy policy of a texture.
+ *
+ * With @c NONE the pixels only live in GPU memory: copies are made GPU-to-GPU
+ * and read-back helpers fetch the data on demand. @c KEEP retains the last
+ * upload in host memory, e.g. for formats that cannot be copied on the GPU
+ * of the target platform (unrenderable formats under WebGL).
+ */
+enum class GLShadowPolicy {NONE, KEEP};
+
 /**
  * @brief Depth storage selection for depth textures.
  */
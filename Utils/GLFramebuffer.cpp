@@ -1,3 +1,5 @@
+#include <utility>
+
 #include "GLFramebuffer.h"
 
 
@@ -11,131 +13,169 @@ GLFramebuffer::~GLFramebuffer() {
     GL(glDeleteFramebuffers(1, &id));
 }
 
-void GLFramebuffer::bind(const GLTexture2D& t, const GLDepthBuffer& d) {
+GLFramebuffer::GLFramebuffer(GLFramebuffer&& other) noexcept :
+  id(std::exchange(other.id, 0)),
+  colorTextures(std::exchange(other.colorTextures, {})),
+  colorIds(std::exchange(other.colorIds, {}))
+{
+}
+
+GLFramebuffer& GLFramebuffer::operator=(GLFramebuffer&& other) noexcept {
+  std::swap(id, other.id);
+  std::swap(colorTextures, other.colorTextures);
+  std::swap(colorIds, other.colorIds);
+  return *this;
+}
+
+void GLFramebuffer::begin() {
   GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  colorTextures.fill(nullptr);
+  colorIds.fill(0);
+}
+
+void GLFramebuffer::attach(size_t index, const GLTexture2D& t) {
+  GL(glFramebufferTexture(GL_FRAMEBUFFER, GLenum(GL_COLOR_ATTACHMENT0+index), t.getId(), 0));
+  colorTextures[index] = &t;
+  colorIds[index] = t.getId();
+}
+
+bool GLFramebuffer::reattach() {
+  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  bool changed = false;
+  for (size_t i = 0;i<colorTextures.size();++i) {
+    if (!colorTextures[i] || colorTextures[i]->getId() == colorIds[i]) continue;
+    attach(i, *colorTextures[i]);
+    changed = true;
+  }
+  if (changed) GL(glViewport(0, 0, GLint(colorTextures[0]->getWidth()), GLint(colorTextures[0]->getHeight())));
+  return changed;
+}
+
+void GLFramebuffer::bind(const GLTexture2D& t, const GLDepthBuffer& d) {
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.getId()));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t.getId(), 0));
+  attach(0, t);
   setBuffers(1, t.getWidth(), t.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1, const GLDepthBuffer& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.getId()));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
   setBuffers(2, t0.getWidth(), t0.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1, const GLTexture2D& t2, const GLDepthBuffer& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.getId()));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, t2.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
+  attach(2, t2);
   setBuffers(3, t0.getWidth(), t0.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1, const GLTexture2D& t2, const GLTexture2D& t3, const GLDepthBuffer& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.getId()));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, t2.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, t3.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
+  attach(2, t2);
+  attach(3, t3);
   setBuffers(4, t0.getWidth(), t0.getHeight());
 }
 
 
 void GLFramebuffer::bind(const GLDepthTexture& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, d.getId(),0));
   setBuffers(0, d.getWidth(), d.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t, const GLDepthTexture& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, d.getId(),0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t.getId(), 0));
+  attach(0, t);
   setBuffers(1, t.getWidth(), t.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1, const GLDepthTexture& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, d.getId(),0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
   setBuffers(2, t0.getWidth(), t0.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1, const GLTexture2D& t2, const GLDepthTexture& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, d.getId(),0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, t2.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
+  attach(2, t2);
   setBuffers(3, t0.getWidth(), t0.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1, const GLTexture2D& t2, const GLTexture2D& t3, const GLDepthTexture& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, d.getId(),0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, t2.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, t3.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
+  attach(2, t2);
+  attach(3, t3);
   setBuffers(4, t0.getWidth(), t0.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t.getId(), 0));
+  attach(0, t);
   setBuffers(1, t.getWidth(), t.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
   setBuffers(2, t0.getWidth(), t0.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1, const GLTexture2D& t2) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, t2.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
+  attach(2, t2);
   setBuffers(3, t0.getWidth(), t0.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture2D& t0, const GLTexture2D& t1, const GLTexture2D& t2, const GLTexture2D& t3) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, t0.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, t1.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, t2.getId(), 0));
-  GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, t3.getId(), 0));
+  attach(0, t0);
+  attach(1, t1);
+  attach(2, t2);
+  attach(3, t3);
   setBuffers(4, t0.getWidth(), t0.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture3D& t, size_t slice, const GLDepthBuffer& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.getId()));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, t.getId(), 0, GLint(slice)));
   setBuffers(1,t.getWidth(), t.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D& t1, size_t slice1, const GLDepthBuffer& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.getId()));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, t0.getId(), 0, GLint(slice0)));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_3D, t1.getId(), 0, GLint(slice1)));
   setBuffers(2, t0.getWidth(), t0.getHeight());
 }
 void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D& t1, size_t slice1, const GLTexture3D& t2, size_t slice2, const GLDepthBuffer& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.getId()));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, t0.getId(), 0, GLint(slice0)));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_3D, t1.getId(), 0, GLint(slice1)));
@@ -145,7 +185,7 @@ void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D
 
 void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D& t1, size_t slice1, const GLTexture3D& t2, size_t slice2,
                          const GLTexture3D& t3, size_t slice3, const GLDepthBuffer& d) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, d.getId()));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, t0.getId(), 0, GLint(slice0)));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_3D, t1.getId(), 0, GLint(slice1)));
@@ -155,21 +195,21 @@ void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D
 }
 
 void GLFramebuffer::bind(const GLTexture3D& t, size_t slice) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, t.getId(), 0, GLint(slice)));
   setBuffers(1,t.getWidth(), t.getHeight());
 }
 
 void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D& t1, size_t slice1) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, t0.getId(), 0, GLint(slice0)));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_3D, t1.getId(), 0, GLint(slice1)));
   setBuffers(2, t0.getWidth(), t0.getHeight());
 }
 void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D& t1, size_t slice1, const GLTexture3D& t2, size_t slice2) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, t0.getId(), 0, GLint(slice0)));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_3D, t1.getId(), 0, GLint(slice1)));
@@ -178,7 +218,7 @@ void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D
 }
 
 void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D& t1, size_t slice1, const GLTexture3D& t2, size_t slice2, const GLTexture3D& t3, size_t slice3) {
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, t0.getId(), 0, GLint(slice0)));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_3D, t1.getId(), 0, GLint(slice1)));
@@ -189,7 +229,7 @@ void GLFramebuffer::bind(const GLTexture3D& t0, size_t slice0, const GLTexture3D
 
 void GLFramebuffer::unbind2D() {
   GL(glDrawBuffer(GL_NONE));
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_3D, 0, 0, 0));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_3D, 0, 0, 0));
   GL(glFramebufferTexture3D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_3D, 0, 0, 0));
@@ -199,7 +239,7 @@ void GLFramebuffer::unbind2D() {
 
 void GLFramebuffer::unbind3D() {
   GL(glDrawBuffer(GL_NONE));
-  GL(glBindFramebuffer(GL_FRAMEBUFFER, id));
+  begin();
   GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, 0, 0));
   GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0));
   GL(glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, 0, 0));
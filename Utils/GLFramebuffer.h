@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <array>
 
 #include "GLEnv.h"
 
@@ -23,6 +24,11 @@
  * from @c GLEnv.h. Overloads cover 0–4 color attachments for both 2D textures
  * and 3D texture slices. Use @ref checkBinding() to verify completeness after
  * binding, and @ref unbind2D()/@ref unbind3D() to detach attachments.
+ *
+ * Every bind attaches the textures' current GL names. GLTexture2D replaces
+ * its texture object when its storage is respecified (size or format
+ * change), so after resizing attached 2D textures either bind them again or
+ * call @ref reattach().
  */
 class GLFramebuffer {
 public:
@@ -31,6 +37,13 @@ public:
   /** @brief Destroy the framebuffer (glDeleteFramebuffers). */
   ~GLFramebuffer();
 
+  GLFramebuffer(const GLFramebuffer&) = delete;
+  GLFramebuffer& operator=(const GLFramebuffer&) = delete;
+  /** @brief Move-construct, taking over the FBO of @p other. */
+  GLFramebuffer(GLFramebuffer&& other) noexcept;
+  /** @brief Move-assign; the previous FBO is released together with @p other. */
+  GLFramebuffer& operator=(GLFramebuffer&& other) noexcept;
+
   /**
    * @brief Retrieve the OpenGL framebuffer object name.
    * @return GLuint name of the managed FBO.
@@ -97,6 +110,16 @@ public:
   /** @brief Detach 3D color/depth attachments and unbind the FBO. */
   void unbind3D();
 
+  /**
+   * @brief Bind the FBO and re-attach 2D color textures whose GL name changed.
+   *
+   * Keeps a framebuffer valid across GLTexture2D resizes without repeating
+   * the bind call; the viewport follows the new size of the first attachment.
+   * The textures of the last 2D bind must still exist.
+   * @return True if an attachment was replaced.
+   */
+  bool reattach();
+
   /**
    * @brief Check whether the currently bound FBO is complete.
    * @return true if glCheckFramebufferStatus(...) == GL_FRAMEBUFFER_COMPLETE.
@@ -105,6 +128,14 @@ public:
 
 private:
   GLuint id; ///< OpenGL framebuffer object name.
+  std::array<const GLTexture2D*, 4> colorTextures{}; ///< 2D color attachments of the last bind.
+  std::array<GLuint, 4> colorIds{};                   ///< Their GL names when they were attached.
+
+  /** @brief Bind the FBO and forget the recorded 2D attachments. */
+  void begin();
+
+  /** @brief Attach @p t as color attachment @p index and record it for @ref reattach(). */
+  void attach(size_t index, const GLTexture2D& t);
 
   /**
    * @brief Set glDrawBuffers according to @p count and update viewport.
@@ -1,29 +1,65 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <utility>
+#ifndef __EMSCRIPTEN__
+#include <filesystem>
+#endif
 
 #include "GLProgram.h"
 #include "GLDebug.h"
+#include "Hash.h"
+
+bool GLProgram::deferredLinking{true};
 
 GLProgram::GLProgram(const GLProgram& other) :
   GLProgram(other.vertexShaderStrings, other.fragmentShaderStrings, other.geometryShaderStrings)
 {
+  vertexShaderFiles   = other.vertexShaderFiles;
+  fragmentShaderFiles = other.fragmentShaderFiles;
+  geometryShaderFiles = other.geometryShaderFiles;
 }
 
-GLProgram& GLProgram::operator=(const GLProgram& other) {
-  GL(glDeleteShader(glVertexShader));
-  GL(glDeleteShader(glFragmentShader));
-  GL(glDeleteShader(glGeometryShader));
-  GL(glDeleteProgram(glProgram));
-  programFromVectors(other.vertexShaderStrings, other.fragmentShaderStrings, other.geometryShaderStrings);
+GLProgram::GLProgram(GLProgram&& other) noexcept :
+  glVertexShader(0),
+  glFragmentShader(0),
+  glGeometryShader(0),
+  glProgram(0)
+{
+  swap(other);
+}
+
+GLProgram& GLProgram::operator=(GLProgram&& other) noexcept {
+  swap(other);
   return *this;
 }
 
+void GLProgram::swap(GLProgram& other) noexcept {
+  std::swap(glVertexShader, other.glVertexShader);
+  std::swap(glFragmentShader, other.glFragmentShader);
+  std::swap(glGeometryShader, other.glGeometryShader);
+  std::swap(glProgram, other.glProgram);
+  std::swap(vertexShaderStrings, other.vertexShaderStrings);
+  std::swap(fragmentShaderStrings, other.fragmentShaderStrings);
+  std::swap(geometryShaderStrings, other.geometryShaderStrings);
+  std::swap(vertexShaderFiles, other.vertexShaderFiles);
+  std::swap(fragmentShaderFiles, other.fragmentShaderFiles);
+  std::swap(geometryShaderFiles, other.geometryShaderFiles);
+  std::swap(linkPending, other.linkPending);
+  std::swap(binaryCacheKey, other.binaryCacheKey);
+  std::swap(pendingReload, other.pendingReload);
+  std::swap(reloadWaited, other.reloadWaited);
+}
+
+GLProgram GLProgram::clone() const {
+  return GLProgram(*this);
+}
+
 GLuint GLProgram::createShader(GLenum type, const GLchar** src, GLsizei count) {
 	if (count==0) return 0;
 	GLuint s = glCreateShader(type); checkAndThrow();
 	glShaderSource(s, count, src, NULL); checkAndThrow();
-	glCompileShader(s); checkAndThrowShader(s);
+	glCompileShader(s); checkAndThrow();
 	return s;
 }
 
@@ -47,20 +83,11 @@ GLProgram::~GLProgram() {
 }
 
 GLProgram GLProgram::createFromFiles(const std::vector<std::string>& vs, const std::vector<std::string>& fs, const std::vector<std::string>& gs) {
-	std::vector<std::string> vsTexts;
-	for (const std::string& f : vs) {
-		vsTexts.push_back(loadFile(f));
-	}
-	std::vector<std::string> fsTexts;
-	for (const std::string& f : fs) {
-		fsTexts.push_back(loadFile(f));
-	}
-	std::vector<std::string> gsTexts;
-	for (const std::string& f : gs) {
-		if (!f.empty())		
-			gsTexts.push_back(loadFile(f));
-	}
-	return createFromStrings(vsTexts,fsTexts,gsTexts);
+	GLProgram program{loadFiles(vs), loadFiles(fs), loadFiles(gs)};
+	program.vertexShaderFiles   = vs;
+	program.fragmentShaderFiles = fs;
+	program.geometryShaderFiles = gs;
+	return program;
 }
 
 GLProgram GLProgram::createFromStrings(const std::vector<std::string>& vs, const std::vector<std::string>& fs, const std::vector<std::string>& gs) {
@@ -88,7 +115,17 @@ std::string GLProgram::loadFile(const std::string& filename) {
 	return fileContents;
 }
 
+std::vector<std::string> GLProgram::loadFiles(const std::vector<std::string>& files) {
+	std::vector<std::string> texts;
+	for (const std::string& f : files) {
+		if (!f.empty())
+			texts.push_back(loadFile(f));
+	}
+	return texts;
+}
+
 GLint GLProgram::getAttributeLocation(const std::string& id) const {
+  finishLink();
   const GLint l = glGetAttribLocation(glProgram, id.c_str());
 	checkAndThrow();	
 	if(l == -1)
@@ -96,7 +133,15 @@ GLint GLProgram::getAttributeLocation(const std::string& id) const {
 	return l;
 }
 
+GLint GLProgram::findAttributeLocation(const std::string& id) const {
+  finishLink();
+  const GLint l = glGetAttribLocation(glProgram, id.c_str());
+  checkAndThrow();
+  return l;
+}
+
 GLint GLProgram::getUniformLocation(const std::string& id) const {
+	finishLink();
 	const GLint l = glGetUniformLocation(glProgram, id.c_str());
 	checkAndThrow();
 	if(l == -1)
@@ -105,6 +150,7 @@ GLint GLProgram::getUniformLocation(const std::string& id) const {
 }
 
 void GLProgram::enable() const {
+	finishLink();
 	GL(glUseProgram(glProgram));
 }
 
@@ -236,10 +282,246 @@ void GLProgram::unsetTexture3D(GLenum unit) const {
   GL(glBindTexture(GL_TEXTURE_3D, 0));
 }
 
+std::string GLProgram::binaryCacheDirectory{};
+GLProgram::BinaryCacheStats GLProgram::binaryCacheStats{};
+
+void GLProgram::setBinaryCacheDirectory(const std::string& dir) {
+  binaryCacheDirectory = dir;
+}
+
+const std::string& GLProgram::getBinaryCacheDirectory() {
+  return binaryCacheDirectory;
+}
+
+GLProgram::BinaryCacheStats GLProgram::getBinaryCacheStats() {
+  return binaryCacheStats;
+}
+
+uint64_t GLProgram::computeCacheKey() const {
+  uint64_t hash = Hash::FNV_OFFSET;
+  for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    const GLubyte* str = glGetString(name);
+    Hash::add(hash, str ? std::string(reinterpret_cast<const char*>(str)) : std::string());
+  }
+  for (const std::vector<std::string>* stage : {&vertexShaderStrings, &fragmentShaderStrings, &geometryShaderStrings}) {
+    const uint64_t count = stage->size();
+    Hash::add(hash, &count, sizeof(count));
+    for (const std::string& s : *stage) Hash::add(hash, s);
+  }
+  return hash;
+}
+
+std::string GLProgram::cacheFilename(uint64_t key) {
+  return binaryCacheDirectory + "/" + Hash::toHex(key) + ".glbin";
+}
+
+static const uint32_t cacheMagic = 0x42504C47; // "GLPB"
+
+bool GLProgram::loadProgramBinary(uint64_t key) {
+#ifdef __EMSCRIPTEN__
+  return false;
+#else
+  std::ifstream file{cacheFilename(key), std::ios::binary};
+  if (!file) return false;
+
+  uint32_t magic{0};
+  uint64_t storedKey{0};
+  uint32_t format{0};
+  uint32_t length{0};
+  file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+  file.read(reinterpret_cast<char*>(&storedKey), sizeof(storedKey));
+  file.read(reinterpret_cast<char*>(&format), sizeof(format));
+  file.read(reinterpret_cast<char*>(&length), sizeof(length));
+  if (!file || magic != cacheMagic || storedKey != key || length == 0) return false;
+
+  std::vector<char> binary(length);
+  file.read(binary.data(), length);
+  if (!file) return false;
+
+  glProgram = glCreateProgram(); checkAndThrow();
+  glProgramBinary(glProgram, GLenum(format), binary.data(), GLsizei(length));
+  // a driver update may reject the binary, this is not an error
+  while (glGetError() != GL_NO_ERROR) {}
+
+  GLint linked{GL_FALSE};
+  glGetProgramiv(glProgram, GL_LINK_STATUS, &linked);
+  if (linked != GL_TRUE) {
+    GL(glDeleteProgram(glProgram));
+    glProgram = 0;
+    return false;
+  }
+  return true;
+#endif
+}
+
+void GLProgram::storeProgramBinary(uint64_t key) const {
+#ifndef __EMSCRIPTEN__
+  GLint formatCount{0};
+  GL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount));
+  if (formatCount == 0) return;
+
+  GLint length{0};
+  GL(glGetProgramiv(glProgram, GL_PROGRAM_BINARY_LENGTH, &length));
+  if (length <= 0) return;
+
+  std::vector<char> binary(static_cast<size_t>(length));
+  GLenum format{0};
+  GLsizei written{0};
+  GL(glGetProgramBinary(glProgram, length, &written, &format, binary.data()));
+  if (written <= 0) return;
+
+  std::error_code ec;
+  std::filesystem::create_directories(binaryCacheDirectory, ec);
+  std::ofstream file{cacheFilename(key), std::ios::binary | std::ios::trunc};
+  if (!file) return;
+
+  const uint32_t format32 = uint32_t(format);
+  const uint32_t length32 = uint32_t(written);
+  file.write(reinterpret_cast<const char*>(&cacheMagic), sizeof(cacheMagic));
+  file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+  file.write(reinterpret_cast<const char*>(&format32), sizeof(format32));
+  file.write(reinterpret_cast<const char*>(&length32), sizeof(length32));
+  file.write(binary.data(), written);
+  if (file) binaryCacheStats.stores++;
+#endif
+}
+
+static bool hasParallelCompile() {
+#ifdef __EMSCRIPTEN__
+  return false;
+#else
+  return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+#endif
+}
+
+static void requestCompilerThreads() {
+#ifndef __EMSCRIPTEN__
+  static bool requested = false;
+  if (requested) return;
+  requested = true;
+  // let the driver pick as many threads as it likes
+  if (GLEW_KHR_parallel_shader_compile)
+    GL(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+  else if (GLEW_ARB_parallel_shader_compile)
+    GL(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
+#endif
+}
+
+void GLProgram::setDeferredLinking(bool deferred) {
+  deferredLinking = deferred;
+}
+
+bool GLProgram::getDeferredLinking() {
+  return deferredLinking;
+}
+
+bool GLProgram::isReady() const {
+  if (!linkPending) return true;
+#ifndef __EMSCRIPTEN__
+  if (hasParallelCompile()) {
+    GLint completed{GL_TRUE};
+    GL(glGetProgramiv(glProgram, GL_COMPLETION_STATUS_KHR, &completed));
+    return completed == GL_TRUE;
+  }
+#endif
+  return true;
+}
+
+void GLProgram::finishLink() const {
+  if (!linkPending) return;
+  // a failed program stays pending, so every later use throws again
+  if (glVertexShader) checkAndThrowShader(glVertexShader);
+  if (glFragmentShader) checkAndThrowShader(glFragmentShader);
+  if (glGeometryShader) checkAndThrowShader(glGeometryShader);
+  checkAndThrowProgram(glProgram);
+  linkPending = false;
+  if (binaryCacheKey) storeProgramBinary(binaryCacheKey);
+}
+
+std::vector<std::string> GLProgram::getSourceFiles() const {
+  std::vector<std::string> files;
+  for (const std::vector<std::string>* stage : {&vertexShaderFiles, &fragmentShaderFiles, &geometryShaderFiles}) {
+    for (const std::string& f : *stage) {
+      if (!f.empty()) files.push_back(f);
+    }
+  }
+  return files;
+}
+
+bool GLProgram::reloadFromFiles() {
+  if (vertexShaderFiles.empty() && fragmentShaderFiles.empty()) return false;
+  // the replacement never queries its status in the constructor, whatever
+  // setDeferredLinking() says, otherwise this call would wait for the driver
+  const bool deferred = deferredLinking;
+  deferredLinking = true;
+  try {
+    pendingReload.reset(new GLProgram{loadFiles(vertexShaderFiles),
+                                      loadFiles(fragmentShaderFiles),
+                                      loadFiles(geometryShaderFiles)});
+  } catch (const std::exception& e) {
+    deferredLinking = deferred;
+    std::cerr << "Shader reload failed: " << e.what() << std::endl;
+    return false;
+  }
+  deferredLinking = deferred;
+  reloadWaited = false;
+  return true;
+}
+
+bool GLProgram::isReloadDue() {
+  // with a completion status poll it; without one the status query in
+  // finishLink() blocks, so give the driver at least until the next call
+  if (hasParallelCompile()) return pendingReload->isReady();
+  if (reloadWaited) return true;
+  reloadWaited = true;
+  return false;
+}
+
+bool GLProgram::updateReload() {
+  if (!pendingReload || !isReloadDue()) return false;
+
+  std::unique_ptr<GLProgram> program = std::move(pendingReload);
+  try {
+    program->finishLink();
+  } catch (const std::exception& e) {
+    std::cerr << "Shader reload failed, keeping the previous program:" << std::endl << e.what() << std::endl;
+    return false;
+  }
+
+  // the old objects end up in program and are deleted with it
+  std::swap(glVertexShader, program->glVertexShader);
+  std::swap(glFragmentShader, program->glFragmentShader);
+  std::swap(glGeometryShader, program->glGeometryShader);
+  std::swap(glProgram, program->glProgram);
+  std::swap(vertexShaderStrings, program->vertexShaderStrings);
+  std::swap(fragmentShaderStrings, program->fragmentShaderStrings);
+  std::swap(geometryShaderStrings, program->geometryShaderStrings);
+  std::swap(linkPending, program->linkPending);
+  return true;
+}
+
 void GLProgram::programFromVectors(std::vector<std::string> vs, std::vector<std::string> fs, std::vector<std::string> gs) {
   vertexShaderStrings   = vs;
   fragmentShaderStrings = fs;
   geometryShaderStrings = gs;
+  glVertexShader = 0;
+  glFragmentShader = 0;
+  glGeometryShader = 0;
+  glProgram = 0;
+  binaryCacheKey = 0;
+  linkPending = false;
+
+  const bool useCache = !binaryCacheDirectory.empty();
+  const uint64_t cacheKey = useCache ? computeCacheKey() : 0;
+  if (useCache) {
+    if (loadProgramBinary(cacheKey)) {
+      binaryCacheStats.hits++;
+      return;
+    }
+    binaryCacheStats.misses++;
+  }
+
+  requestCompilerThreads();
 
   std::vector<const GLchar*> vertexShaderTexts;
   for (const std::string& s : vertexShaderStrings)
@@ -262,7 +544,15 @@ void GLProgram::programFromVectors(std::vector<std::string> vs, std::vector<std:
   if (glVertexShader) {glAttachShader(glProgram, glVertexShader); checkAndThrow();}
   if (glFragmentShader) {glAttachShader(glProgram, glFragmentShader); checkAndThrow();}
   if (glGeometryShader) {glAttachShader(glProgram, glGeometryShader); checkAndThrow();}
-  glLinkProgram(glProgram); checkAndThrowProgram(glProgram);
+#ifndef __EMSCRIPTEN__
+  if (useCache) GL(glProgramParameteri(glProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+#endif
+  glLinkProgram(glProgram); checkAndThrow();
+
+  // status queries block until the driver is done, postpone them to first use
+  binaryCacheKey = cacheKey;
+  linkPending = true;
+  if (!deferredLinking) finishLink();
 }
 
 
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <memory>
 #include <exception>
 
 #include <GL/glew.h>
@@ -31,6 +32,13 @@
  * @note All GL calls in the implementation are routed through a \c GL() macro
  *       (see \c GLDebug.h). Matrix uploads invert the transpose flag to account
  *       for the row/column-major differences in this code base.
+ *
+ * @note Linked programs can be cached on disk via \c glGetProgramBinary once
+ *       the application sets a directory with
+ *       @ref GLProgram::setBinaryCacheDirectory() (off by default). The cache
+ *       key hashes all shader sources together with the GL vendor, renderer and
+ *       version strings; entries that the driver rejects fall back to compiling
+ *       from source and are rewritten.
  */
 
 /**
@@ -94,10 +102,119 @@ public:
   static GLProgram createFromString(const std::string& vs, const std::string& fs, const std::string& gs="");
   ///@}
 
-  /** @brief Copy‑construct a new program with duplicated shaders and linkage. */
-  GLProgram(const GLProgram& other);
-  /** @brief Copy‑assign, releasing current GL objects and recreating from other. */
-  GLProgram& operator=(const GLProgram& other);
+  /**
+   * @brief Hit/miss counters of the program binary cache.
+   */
+  struct BinaryCacheStats {
+    size_t hits{0};   ///< Programs restored from a cached binary.
+    size_t misses{0}; ///< Programs compiled from source (no, stale or rejected entry).
+    size_t stores{0}; ///< Binaries written to the cache after a miss.
+  };
+
+  /**
+   * @name Program binary cache
+   */
+  ///@{
+  /**
+   * @brief Set the directory for cached program binaries.
+   * @param dir Directory (created on first store); an empty string disables the
+   *            cache. Empty by default, so nothing is written unless an
+   *            application opts in, e.g. with "shadercache".
+   * @note Set it before the first program is created, e.g. before GLApp's
+   *       constructor builds its internal programs.
+   */
+  static void setBinaryCacheDirectory(const std::string& dir);
+  /** @brief Current cache directory (empty if disabled). */
+  static const std::string& getBinaryCacheDirectory();
+  /** @brief Cache hits/misses since program start. */
+  static BinaryCacheStats getBinaryCacheStats();
+  ///@}
+
+  /**
+   * @name Deferred compilation
+   *
+   * Constructors only submit compile and link jobs; the status queries that
+   * would block until the driver is done are postponed until the program is
+   * first used. Creating several programs back to back therefore lets the
+   * driver compile them in parallel (with \c KHR_parallel_shader_compile on
+   * its own worker threads). Compile and link errors are still reported as
+   * GLException, just on first use instead of on construction.
+   */
+  ///@{
+  /**
+   * @brief Enable or disable deferred status queries (enabled by default).
+   * @param deferred If false, constructors block and throw immediately.
+   */
+  static void setDeferredLinking(bool deferred);
+  /** @brief Whether constructors defer their status queries. */
+  static bool getDeferredLinking();
+  /**
+   * @brief Non-blocking completion test.
+   * @return True if the program can be used without waiting for the driver.
+   *         Without \c KHR_parallel_shader_compile the state is unknown and
+   *         true is returned.
+   */
+  bool isReady() const;
+  /**
+   * @brief Wait for compilation and linking and check the result.
+   * @throw GLException with the info log if compiling or linking failed,
+   *        again on every later call for a program that failed.
+   * @note Called implicitly by @ref enable() and the location queries.
+   */
+  void finishLink() const;
+  ///@}
+
+  /**
+   * @name Hot reload
+   *
+   * Programs created from files remember their file names and can be rebuilt
+   * in the background: @ref reloadFromFiles() submits a new program, and
+   * @ref updateReload() swaps it in once the driver has finished, so the
+   * frame that triggered the reload never waits for the compiler. With
+   * \c KHR_parallel_shader_compile the swap happens as soon as the driver
+   * reports completion; without it the result can only be waited for, which
+   * @ref updateReload() does no earlier than on its second call after the
+   * submission (one frame later when polled per frame). A program that fails
+   * to compile is reported on std::cerr and the old one stays active. See
+   * ShaderWatcher for automatic reloads on file changes.
+   *
+   * @note Uniform and attribute locations may change with the new program;
+   *       query them again after @ref updateReload() returned true. VAOs
+   *       set up with GLArray::configure() keep the old attribute locations:
+   *       either fix them in the shaders with layout(location = …) or
+   *       configure the arrays again after a swap.
+   */
+  ///@{
+  /** @brief All shader files this program was created from (empty if from strings). */
+  std::vector<std::string> getSourceFiles() const;
+  /**
+   * @brief Re-read the source files and submit a replacement program.
+   * @return False if the program was not created from files or a file could
+   *         not be read.
+   */
+  bool reloadFromFiles();
+  /** @brief True while a replacement program is being compiled. */
+  bool isReloading() const {return bool(pendingReload);}
+  /**
+   * @brief Swap in a finished replacement program (non-blocking).
+   * @return True if the program was replaced.
+   */
+  bool updateReload();
+  ///@}
+
+  /**
+   * @brief Move-construct, taking over the GL objects of @p other.
+   * @note A @ref ShaderWatcher keeps watching the moved-from object; register
+   *       programs only once they reached their final location.
+   */
+  GLProgram(GLProgram&& other) noexcept;
+  /** @brief Move-assign; the previous GL objects are released together with @p other. */
+  GLProgram& operator=(GLProgram&& other) noexcept;
+  /** @brief Programs are not copy-assignable, use `a = b.clone()`. */
+  GLProgram& operator=(const GLProgram& other) = delete;
+
+  /** @brief Compile and link a new program from the same sources (and source files). */
+  GLProgram clone() const;
 
   /**
    * @name Introspection
@@ -110,6 +227,12 @@ public:
    * @throw ProgramException when the attribute cannot be located.
    */
   GLint getAttributeLocation(const std::string& id) const;
+  /**
+   * @brief Query an attribute location by name without throwing.
+   * @param id Attribute identifier in the shader.
+   * @return Location index, or -1 if the program has no active attribute @p id.
+   */
+  GLint findAttributeLocation(const std::string& id) const;
   /**
    * @brief Query a uniform location by name.
    * @param id Uniform identifier in the shader.
@@ -211,15 +334,54 @@ private:
   std::vector<std::string> fragmentShaderStrings; ///< Source strings used to build the fragment shader.
   std::vector<std::string> geometryShaderStrings; ///< Source strings used to build the geometry shader.
 
+  std::vector<std::string> vertexShaderFiles;   ///< Files the vertex sources were loaded from.
+  std::vector<std::string> fragmentShaderFiles; ///< Files the fragment sources were loaded from.
+  std::vector<std::string> geometryShaderFiles; ///< Files the geometry sources were loaded from.
+
+  mutable bool linkPending{false};  ///< Status of the last link has not been queried yet.
+  uint64_t binaryCacheKey{0};       ///< Cache key to store after linking (0 = do not store).
+  std::unique_ptr<GLProgram> pendingReload; ///< Replacement being compiled by a hot reload.
+  bool reloadWaited{false};         ///< updateReload() already skipped one call for @ref pendingReload.
+
+  static bool deferredLinking;      ///< Constructors postpone status queries.
+
+  /**
+   * @brief Whether @ref updateReload() may finish @ref pendingReload now.
+   *
+   * Polls the completion status if the driver has one, otherwise true from
+   * the second call after the submission on.
+   */
+  bool isReloadDue();
+
+  /** @brief Copy constructor behind @ref clone(). */
+  GLProgram(const GLProgram& other);
+
+  /** @brief Exchange all state (including the GL names) with @p other. */
+  void swap(GLProgram& other) noexcept;
+
   /** @brief Load a text file completely into a string (throws on failure). */
   static std::string loadFile(const std::string& filename);
 
-  /** @brief Create and compile a shader of \p type from \p count strings. */
+  /** @brief Create a shader of \p type from \p count strings and submit its compilation. */
   static GLuint createShader(GLenum type, const GLchar** src, GLsizei count);
 
   /** @brief Private ctor used by the factory helpers. */
   GLProgram(std::vector<std::string> vertexShaderStrings, std::vector<std::string> fragmentShaderStrings, std::vector<std::string> geometryShaderStrings);
 
-  /** @brief Build and link GL objects from source vectors. */
+  /** @brief Build GL objects from source vectors and submit the link. */
   void programFromVectors(std::vector<std::string> vs, std::vector<std::string> fs, std::vector<std::string> gs);
+
+  static std::string binaryCacheDirectory;   ///< Directory of cached binaries ("" = disabled).
+  static BinaryCacheStats binaryCacheStats;  ///< Global cache counters.
+
+  /** @brief Hash of all stage sources plus the GL driver identification. */
+  uint64_t computeCacheKey() const;
+  /** @brief Path of the cache entry for @p key. */
+  static std::string cacheFilename(uint64_t key);
+  /** @brief Try to create @ref glProgram from a cached binary; false on miss. */
+  bool loadProgramBinary(uint64_t key);
+  /** @brief Load the sources of all files, skipping empty names. */
+  static std::vector<std::string> loadFiles(const std::vector<std::string>& files);
+  /** @brief Write the binary of the linked @ref glProgram to the cache. */
+  void storeProgramBinary(uint64_t key) const;
 };
@@ -1,6 +1,7 @@
 #ifndef __EMSCRIPTEN__
 
 #include <iostream>
+#include <utility>
 
 #include "GLTexture1D.h"
 
@@ -29,20 +30,38 @@ GLTexture1D::GLTexture1D(const GLTexture1D& other) :
     setData(other.data, other.size, other.componentCount);
 }
 
-GLTexture1D& GLTexture1D::operator=(GLTexture1D other) {
-    magFilter = other.magFilter;
-    minFilter = other.minFilter;
-    wrapX = other.wrapX;
-    
-    GL(glBindTexture(GL_TEXTURE_1D, id));
-    GL(glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, wrapX));
-    GL(glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, magFilter));
-    GL(glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, minFilter));
-    
-    setData(other.data, other.size, other.componentCount);
+GLTexture1D::GLTexture1D(GLTexture1D&& other) noexcept :
+    id(std::exchange(other.id, 0)),
+    internalformat(other.internalformat),
+    format(other.format),
+    type(other.type),
+    magFilter(other.magFilter),
+    minFilter(other.minFilter),
+    wrapX(other.wrapX),
+    data(std::move(other.data)),
+    size(std::exchange(other.size, 0)),
+    componentCount(std::exchange(other.componentCount, 0))
+{
+}
+
+GLTexture1D& GLTexture1D::operator=(GLTexture1D&& other) noexcept {
+    std::swap(id, other.id);
+    std::swap(internalformat, other.internalformat);
+    std::swap(format, other.format);
+    std::swap(type, other.type);
+    std::swap(magFilter, other.magFilter);
+    std::swap(minFilter, other.minFilter);
+    std::swap(wrapX, other.wrapX);
+    std::swap(data, other.data);
+    std::swap(size, other.size);
+    std::swap(componentCount, other.componentCount);
     return *this;
 }
 
+GLTexture1D GLTexture1D::clone() const {
+    return GLTexture1D(*this);
+}
+
 GLTexture1D::~GLTexture1D() {
 	GL(glDeleteTextures(1, &id));
 }
@@ -25,10 +25,15 @@ public:
   GLTexture1D(GLint magFilter=GL_NEAREST, GLint minFilter=GL_NEAREST,
               GLint wrapX=GL_REPEAT);
 
-  /** @brief Copy‑construct and duplicate texture contents and parameters. */
-  GLTexture1D(const GLTexture1D& other);
-  /** @brief Copy‑assign and duplicate texture contents and parameters. */
-  GLTexture1D& operator=(GLTexture1D other);
+  /** @brief Move-construct, taking over the GL texture of @p other (left empty). */
+  GLTexture1D(GLTexture1D&& other) noexcept;
+  /** @brief Move-assign; the previous texture is released together with @p other. */
+  GLTexture1D& operator=(GLTexture1D&& other) noexcept;
+  /** @brief Textures are not copy-assignable, use `a = b.clone()`. */
+  GLTexture1D& operator=(const GLTexture1D& other) = delete;
+
+  /** @brief Create a new texture with duplicated contents and parameters. */
+  GLTexture1D clone() const;
 
   /** @brief Destroy and delete the GL texture name. */
   ~GLTexture1D();
@@ -63,5 +68,8 @@ private:
   std::vector<GLubyte> data; ///< Last uploaded pixel bytes (kept for copies).
   uint32_t size;             ///< Texture width in texels.
   uint8_t componentCount;    ///< Components per texel (1..4).
+
+  /** @brief Copy constructor behind @ref clone(). */
+  GLTexture1D(const GLTexture1D& other);
 };
 #endif
@@ -1,7 +1,12 @@
 #include <array>
+#include <algorithm>
 #include <sstream>
+#include <utility>
+#include <cstring>
 
 #include "GLTexture2D.h"
+#include "BCEncoder.h"
+#include "GLTextureCopy.h"
 
 GLTexture2D::GLTexture2D(GLint magFilter, GLint minFilter, GLint wrapX, GLint wrapY) :
   id(0),
@@ -17,6 +22,10 @@ GLTexture2D::GLTexture2D(GLint magFilter, GLint minFilter, GLint wrapX, GLint wr
   componentCount(0),
   dataType(GLDataType::BYTE)
 {
+  createTexture();
+}
+
+void GLTexture2D::createTexture() {
   GL(glGenTextures(1, &id));
   GL(glBindTexture(GL_TEXTURE_2D, id));
   GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapX));
@@ -25,6 +34,13 @@ GLTexture2D::GLTexture2D(GLint magFilter, GLint minFilter, GLint wrapX, GLint wr
   GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter));
 }
 
+void GLTexture2D::recreate() {
+  GL(glDeleteTextures(1, &id));
+  createTexture();
+  immutable = false;
+  levelCount = 0;
+}
+
 GLTexture2D::GLTexture2D(const Image& image,
                          GLint magFilter, GLint minFilter, GLint wrapX, GLint wrapY) :
 GLTexture2D(magFilter, minFilter, wrapX, wrapY)
@@ -43,55 +59,66 @@ void GLTexture2D::setFilter(GLint magFilter, GLint minFilter) {
 }
 
 GLTexture2D::~GLTexture2D() {
+  if (streaming) GL(glDeleteBuffers(GLsizei(pbos.size()), pbos.data()));
   GL(glDeleteTextures(1, &id));
 }
 
 GLTexture2D::GLTexture2D(const GLTexture2D& other) :
   GLTexture2D(other.magFilter, other.minFilter, other.wrapX, other.wrapY)
 {
-  if (other.height > 0 && other.width > 0) {
-    switch (other.dataType) {
-      case GLDataType::BYTE  :
-        setData(other.data, other.width, other.height, other.componentCount);
-        break;
-      case GLDataType::HALF  :
-        setData(other.hdata, other.width, other.height, other.componentCount);
-        break;
-      case GLDataType::FLOAT :
-        setData(other.fdata, other.width, other.height, other.componentCount);
-        break;
-    }
-  }
+  copyFrom(other);
+  if (mipmaps && !compressedFormat && width > 0 && height > 0) generateMipmap();
 }
 
-GLTexture2D& GLTexture2D::operator=(const GLTexture2D& other) {
-  magFilter = other.magFilter;
-  minFilter = other.minFilter;
-  wrapX = other.wrapX;
-  wrapY = other.wrapY;
+GLTexture2D::GLTexture2D(GLTexture2D&& other) noexcept :
+  id(0),
+  internalformat(0),
+  format(0),
+  type(0),
+  magFilter(GL_NEAREST),
+  minFilter(GL_NEAREST),
+  wrapX(GL_REPEAT),
+  wrapY(GL_REPEAT)
+{
+  swap(other);
+}
 
-  GL(glBindTexture(GL_TEXTURE_2D, id));
-  GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapX));
-  GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapY));
-  GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter));
-  GL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter));
-  
-  if (other.height > 0 && other.width > 0) {
-    switch (other.dataType) {
-      case GLDataType::BYTE  :
-        setData(other.data, other.width, other.height, other.componentCount);
-        break;
-      case GLDataType::HALF  :
-        setData(other.hdata, other.width, other.height, other.componentCount);
-        break;
-      case GLDataType::FLOAT :
-        setData(other.fdata, other.width, other.height, other.componentCount);
-        break;
-    }
-  }
+GLTexture2D& GLTexture2D::operator=(GLTexture2D&& other) noexcept {
+  swap(other);
   return *this;
 }
 
+void GLTexture2D::swap(GLTexture2D& other) noexcept {
+  std::swap(id, other.id);
+  std::swap(internalformat, other.internalformat);
+  std::swap(format, other.format);
+  std::swap(type, other.type);
+  std::swap(magFilter, other.magFilter);
+  std::swap(minFilter, other.minFilter);
+  std::swap(wrapX, other.wrapX);
+  std::swap(wrapY, other.wrapY);
+  std::swap(shadowPolicy, other.shadowPolicy);
+  std::swap(data, other.data);
+  std::swap(hdata, other.hdata);
+  std::swap(fdata, other.fdata);
+  std::swap(cdata, other.cdata);
+  std::swap(width, other.width);
+  std::swap(height, other.height);
+  std::swap(componentCount, other.componentCount);
+  std::swap(dataType, other.dataType);
+  std::swap(compressedFormat, other.compressedFormat);
+  std::swap(levelCount, other.levelCount);
+  std::swap(immutable, other.immutable);
+  std::swap(mipmaps, other.mipmaps);
+  std::swap(streaming, other.streaming);
+  std::swap(pbos, other.pbos);
+  std::swap(nextPbo, other.nextPbo);
+}
+
+GLTexture2D GLTexture2D::clone() const {
+  return GLTexture2D(*this);
+}
+
 const GLuint GLTexture2D::getId() const {
   return id;
 }
@@ -101,7 +128,12 @@ void GLTexture2D::clear() {
 }
 
 void GLTexture2D::setData(const Image& image) {
-  this->data = image.data;
+  if (image.layout != MemoryLayout::Linear) {
+    setData(image.toLayout(MemoryLayout::Linear));
+    return;
+  }
+  releaseShadow();
+  if (shadowPolicy == GLShadowPolicy::KEEP) this->data = image.data;
   setData((GLvoid*)(image.data.data()), image.width, image.height, image.componentCount, GLDataType::BYTE);
 }
 
@@ -128,16 +160,24 @@ void GLTexture2D::setData(const std::vector<GLubyte>& data, uint32_t width, uint
     throw GLException{"Data size and texure dimensions do not match."};
   }
   
-  this->data = data;
+  releaseShadow();
+  if (shadowPolicy == GLShadowPolicy::KEEP) this->data = data;
   setData((GLvoid*)data.data(), width, height, componentCount, GLDataType::BYTE);
 }
 
+void GLTexture2D::setData(const GLubyte* data, uint32_t width, uint32_t height, uint8_t componentCount) {
+  releaseShadow();
+  if (shadowPolicy == GLShadowPolicy::KEEP) this->data.assign(data, data + size_t(componentCount)*width*height);
+  setData((GLvoid*)data, width, height, componentCount, GLDataType::BYTE);
+}
+
 void GLTexture2D::setData(const std::vector<GLhalf>& data, uint32_t width, uint32_t height, uint8_t componentCount) {
   if (data.size() != componentCount*width*height) {
     throw GLException{"Data size and texure dimensions do not match."};
   }
   
-  this->hdata = data;
+  releaseShadow();
+  if (shadowPolicy == GLShadowPolicy::KEEP) this->hdata = data;
   setData((GLvoid*)data.data(), width, height, componentCount, GLDataType::HALF);
 }
 
@@ -149,8 +189,9 @@ void GLTexture2D::setData(const std::vector<GLfloat>& data, uint32_t width, uint
     throw GLException{ss.str()};
   }
   
-  this->fdata = data;
-  setData((GLvoid*)this->fdata.data(), width, height, componentCount, GLDataType::FLOAT);
+  releaseShadow();
+  if (shadowPolicy == GLShadowPolicy::KEEP) this->fdata = data;
+  setData((GLvoid*)data.data(), width, height, componentCount, GLDataType::FLOAT);
 }
 
 struct GLTexInfo {
@@ -231,35 +272,313 @@ static GLTexInfo dataTypeToGL(GLDataType dataType, uint8_t componentCount) {
   return result;
 }
 
+static size_t elementSize(GLDataType dataType) {
+  switch (dataType) {
+    case GLDataType::HALF  : return sizeof(GLhalf);
+    case GLDataType::FLOAT : return sizeof(GLfloat);
+    default                : return sizeof(GLubyte);
+  }
+}
+
+static bool hasTexStorage() {
+#ifdef __EMSCRIPTEN__
+  return true;
+#else
+  return GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+#endif
+}
+
+static bool usesMipmaps(GLint minFilter) {
+  return minFilter == GL_NEAREST_MIPMAP_NEAREST || minFilter == GL_LINEAR_MIPMAP_NEAREST ||
+         minFilter == GL_NEAREST_MIPMAP_LINEAR || minFilter == GL_LINEAR_MIPMAP_LINEAR;
+}
+
+static GLsizei mipLevels(uint32_t width, uint32_t height) {
+  GLsizei levels = 1;
+  for (uint32_t size = std::max(width, height);size > 1;size /= 2) ++levels;
+  return levels;
+}
+
+void GLTexture2D::setCompressedData(const CompressedImage& image) {
+  setCompressedData(image.data, image.width, image.height,
+                    GLenum(BCEncoder::glInternalFormat(image.format)),
+                    BCEncoder::componentCount(image.format));
+}
+
+void GLTexture2D::setCompressedData(const std::vector<GLubyte>& data, uint32_t width, uint32_t height,
+                                    GLenum internalformat, uint8_t componentCount) {
+  releaseShadow();
+  if (shadowPolicy == GLShadowPolicy::KEEP) this->cdata = data;
+  setCompressedData(data.data(), data.size(), width, height, internalformat, componentCount);
+}
+
+void GLTexture2D::setCompressedData(const GLubyte* data, size_t size, uint32_t width, uint32_t height,
+                                    GLenum internalformat, uint8_t componentCount) {
+  this->dataType = GLDataType::BYTE;
+  this->compressedFormat = internalformat;
+  this->width = width;
+  this->height = height;
+  this->componentCount = componentCount;
+
+  // compressed data uses mutable storage, which an immutable texture cannot switch to
+  if (immutable) recreate();
+  levelCount = 1;
+
+  GL(glBindTexture(GL_TEXTURE_2D, id));
+  GL(glPixelStorei(GL_UNPACK_ALIGNMENT ,1));
+  GL(glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalformat, GLsizei(width), GLsizei(height), 0,
+                            GLsizei(size), data));
+}
+
 void GLTexture2D::setData(GLvoid* data, uint32_t width, uint32_t height, uint8_t componentCount, GLDataType dataType) {
+  const bool sameStorage = levelCount >= storageLevels(width, height) && compressedFormat == 0 &&
+                           this->width == width && this->height == height &&
+                           this->componentCount == componentCount && this->dataType == dataType;
+
   this->dataType = dataType;
+  this->compressedFormat = 0;
   this->width = width;
   this->height = height;
   this->componentCount = componentCount;
 
+  const GLTexInfo texInfo = dataTypeToGL(dataType, componentCount);
+  internalformat = texInfo.internalformat;
+  format = texInfo.format;
+  type = texInfo.type;
+
+  if (!sameStorage) allocate();
+  if (data && width > 0 && height > 0) {
+    upload(data, 0, 0, width, height, format, type, size_t(getSize())*elementSize(dataType));
+  }
+}
+
+void GLTexture2D::allocate() {
+  // immutable storage cannot be respecified, start over with a new texture name
+  if (immutable) recreate();
+
+  const GLsizei levels = storageLevels(width, height);
   GL(glBindTexture(GL_TEXTURE_2D, id));
+  if (hasTexStorage() && width > 0 && height > 0) {
+    GL(glTexStorage2D(GL_TEXTURE_2D, levels, GLenum(internalformat), GLsizei(width), GLsizei(height)));
+    immutable = true;
+  } else {
+    GL(glTexImage2D(GL_TEXTURE_2D, 0, internalformat, GLsizei(width), GLsizei(height), 0, format, type, nullptr));
+  }
+  levelCount = levels;
+}
 
-  GL(glPixelStorei(GL_PACK_ALIGNMENT ,1));
+void GLTexture2D::upload(const GLvoid* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                         GLenum format, GLenum type, size_t size) {
+  GL(glBindTexture(GL_TEXTURE_2D, id));
   GL(glPixelStorei(GL_UNPACK_ALIGNMENT ,1));
 
-  const GLTexInfo texInfo = dataTypeToGL(dataType, componentCount);
+  if (!streaming) {
+    GL(glTexSubImage2D(GL_TEXTURE_2D, 0, GLint(x), GLint(y), GLsizei(width), GLsizei(height),
+                       format, type, data));
+    return;
+  }
 
-  GL(glTexImage2D(GL_TEXTURE_2D, 0, texInfo.internalformat, GLsizei(width), GLsizei(height), 0, texInfo.format, texInfo.type, data));
+  // orphan the buffer, so writing does not wait for the transfer of an earlier frame
+  GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[nextPbo]));
+  nextPbo = (nextPbo+1) % pbos.size();
+  GL(glBufferData(GL_PIXEL_UNPACK_BUFFER, GLsizeiptr(size), nullptr, GL_STREAM_DRAW));
+#ifdef __EMSCRIPTEN__
+  GL(glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(size), data));
+#else
+  void* mapped = nullptr;
+  GL(mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(size),
+                               GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+  if (mapped) {
+    std::memcpy(mapped, data, size);
+    GL(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+  } else {
+    GL(glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, GLsizeiptr(size), data));
+  }
+#endif
+  GL(glTexSubImage2D(GL_TEXTURE_2D, 0, GLint(x), GLint(y), GLsizei(width), GLsizei(height),
+                     format, type, nullptr));
+  GL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
 }
 
+void GLTexture2D::setSubData(const GLvoid* data, size_t count, GLDataType dataType,
+                             uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+  if (compressedFormat) {
+    throw GLException{"Sub-image updates of compressed textures are not supported."};
+  }
+  if (x+width > this->width || y+height > this->height) {
+    throw GLException{"Sub-image exceeds the texture dimensions."};
+  }
+  if (count != size_t(componentCount)*width*height) {
+    throw GLException{"Data size and sub-image dimensions do not match."};
+  }
+  if (width == 0 || height == 0) return;
 
-void GLTexture2D::setPixel(const std::vector<GLubyte>& data, uint32_t x, uint32_t y) {  
   const GLTexInfo texInfo = dataTypeToGL(dataType, componentCount);
-  GL(glBindTexture(GL_TEXTURE_2D, id));
-  glTexSubImage2D(GL_TEXTURE_2D,0,GLint(x),GLint(y),1,1, texInfo.format,
-                  texInfo.type, data.data());
+  upload(data, x, y, width, height, texInfo.format, texInfo.type, count*elementSize(dataType));
+}
+
+template <typename T>
+static void copyRect(std::vector<T>& shadow, const std::vector<T>& rect, uint32_t x, uint32_t y,
+                     uint32_t width, uint32_t height, uint32_t textureWidth, uint8_t componentCount) {
+  if (shadow.empty()) return;
+  const size_t rowSize = size_t(width)*componentCount;
+  for (uint32_t row = 0;row<height;++row) {
+    std::copy(rect.begin() + std::ptrdiff_t(row*rowSize), rect.begin() + std::ptrdiff_t((row+1)*rowSize),
+              shadow.begin() + std::ptrdiff_t((size_t(y+row)*textureWidth+x)*componentCount));
+  }
+}
+
+void GLTexture2D::setSubData(const std::vector<GLubyte>& data, uint32_t x, uint32_t y,
+                             uint32_t width, uint32_t height) {
+  setSubData(data.data(), data.size(), GLDataType::BYTE, x, y, width, height);
+  if (shadowPolicy == GLShadowPolicy::KEEP) copyRect(this->data, data, x, y, width, height, this->width, componentCount);
+}
+
+void GLTexture2D::setSubData(const std::vector<GLhalf>& data, uint32_t x, uint32_t y,
+                             uint32_t width, uint32_t height) {
+  setSubData(data.data(), data.size(), GLDataType::HALF, x, y, width, height);
+  if (shadowPolicy == GLShadowPolicy::KEEP) copyRect(hdata, data, x, y, width, height, this->width, componentCount);
+}
+
+void GLTexture2D::setSubData(const std::vector<GLfloat>& data, uint32_t x, uint32_t y,
+                             uint32_t width, uint32_t height) {
+  setSubData(data.data(), data.size(), GLDataType::FLOAT, x, y, width, height);
+  if (shadowPolicy == GLShadowPolicy::KEEP) copyRect(fdata, data, x, y, width, height, this->width, componentCount);
+}
+
+void GLTexture2D::setPixel(const std::vector<GLubyte>& data, uint32_t x, uint32_t y) {
+  setSubData(data, x, y, 1, 1);
+}
+
+void GLTexture2D::setStreaming(bool streaming) {
+  if (streaming == this->streaming) return;
+  this->streaming = streaming;
+  if (streaming) {
+    GL(glGenBuffers(GLsizei(pbos.size()), pbos.data()));
+  } else {
+    GL(glDeleteBuffers(GLsizei(pbos.size()), pbos.data()));
+    pbos.fill(0);
+  }
+}
+
+GLsizei GLTexture2D::storageLevels(uint32_t width, uint32_t height) const {
+  return (mipmaps || usesMipmaps(minFilter)) ? mipLevels(width, height) : 1;
+}
+
+void GLTexture2D::setMipmaps(bool mipmaps) {
+  this->mipmaps = mipmaps;
 }
 
 void GLTexture2D::generateMipmap() {
+  if (!compressedFormat && immutable && levelCount < mipLevels(width, height)) {
+    // storage was allocated without a mip chain, move the contents into one that has it
+    GLTexture2D mipmapped(magFilter, minFilter, wrapX, wrapY);
+    mipmapped.mipmaps = true;
+    mipmapped.copyFrom(*this);
+    // keep the streaming buffers with this texture
+    std::swap(mipmapped.streaming, streaming);
+    std::swap(mipmapped.pbos, pbos);
+    swap(mipmapped);
+  }
+  mipmaps = true;
   GL(glBindTexture(GL_TEXTURE_2D, id));
   GL(glGenerateMipmap(GL_TEXTURE_2D));
 }
 
+void GLTexture2D::setShadowPolicy(GLShadowPolicy policy) {
+  if (policy == shadowPolicy) return;
+  shadowPolicy = policy;
+  if (policy == GLShadowPolicy::NONE) {
+    releaseShadow();
+    return;
+  }
+#ifndef __EMSCRIPTEN__
+  if (width == 0 || height == 0) return;
+  if (compressedFormat) {
+    GL(glBindTexture(GL_TEXTURE_2D, id));
+    GLint size = 0;
+    GL(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size));
+    cdata.resize(size_t(size));
+    GL(glGetCompressedTexImage(GL_TEXTURE_2D, 0, cdata.data()));
+    return;
+  }
+  switch (dataType) {
+    case GLDataType::BYTE  : getDataByte(); break;
+    case GLDataType::HALF  : getDataHalf(); break;
+    case GLDataType::FLOAT : getDataFloat(); break;
+  }
+#endif
+}
+
+void GLTexture2D::releaseShadow() {
+  std::vector<GLubyte>().swap(data);
+  std::vector<GLhalf>().swap(hdata);
+  std::vector<GLfloat>().swap(fdata);
+  std::vector<GLubyte>().swap(cdata);
+}
+
+void GLTexture2D::copyFrom(const GLTexture2D& other) {
+  shadowPolicy = other.shadowPolicy;
+  mipmaps = mipmaps || other.mipmaps;
+  releaseShadow();
+  if (other.width == 0 || other.height == 0) return;
+
+  if (other.compressedFormat) {
+    // blocks are not color-renderable, so no blit fallback
+    std::vector<GLubyte> blocks = other.cdata;
+#ifndef __EMSCRIPTEN__
+    if (blocks.empty() || GLTextureCopy::hasCopyImage()) {
+      GL(glBindTexture(GL_TEXTURE_2D, other.id));
+      GLint size = 0;
+      GL(glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size));
+      blocks.resize(size_t(size));
+      if (!GLTextureCopy::hasCopyImage()) GL(glGetCompressedTexImage(GL_TEXTURE_2D, 0, blocks.data()));
+    }
+#endif
+    if (blocks.empty()) {
+      throw GLException{"Compressed texture without shadow copy cannot be duplicated, use GLShadowPolicy::KEEP."};
+    }
+    setCompressedData(blocks.data(), blocks.size(), other.width, other.height,
+                      other.compressedFormat, other.componentCount);
+    if (GLTextureCopy::hasCopyImage()) {
+      GLTextureCopy::copy(GL_TEXTURE_2D, other.id, id, width, height);
+    }
+  } else {
+    setData(nullptr, other.width, other.height, other.componentCount, other.dataType);
+    if (!GLTextureCopy::copy(GL_TEXTURE_2D, other.id, id, width, height)) {
+      // format is not renderable here, go through host memory
+      const GLvoid* pixels = nullptr;
+      if (other.shadowPolicy == GLShadowPolicy::KEEP) switch (other.dataType) {
+        case GLDataType::BYTE  : if (!other.data.empty()) pixels = other.data.data(); break;
+        case GLDataType::HALF  : if (!other.hdata.empty()) pixels = other.hdata.data(); break;
+        case GLDataType::FLOAT : if (!other.fdata.empty()) pixels = other.fdata.data(); break;
+      }
+      std::vector<uint8_t> readback;
+#ifndef __EMSCRIPTEN__
+      if (!pixels) {
+        const GLTexInfo texInfo = dataTypeToGL(other.dataType, other.componentCount);
+        readback.resize(size_t(other.getSize())*elementSize(other.dataType));
+        GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+        GL(glBindTexture(GL_TEXTURE_2D, other.id));
+        GL(glGetTexImage(GL_TEXTURE_2D, 0, texInfo.format, texInfo.type, readback.data()));
+        pixels = readback.data();
+      }
+#endif
+      if (!pixels) {
+        throw GLException{"Texture format cannot be copied on the GPU, use GLShadowPolicy::KEEP."};
+      }
+      setData((GLvoid*)pixels, other.width, other.height, other.componentCount, other.dataType);
+    }
+  }
+
+  if (shadowPolicy == GLShadowPolicy::KEEP) {
+    data = other.data;
+    hdata = other.hdata;
+    fdata = other.fdata;
+    cdata = other.cdata;
+  }
+}
+
 #ifndef __EMSCRIPTEN__
 
 Image GLTexture2D::getImage() {
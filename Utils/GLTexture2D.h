@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "GLEnv.h"
 #include "Image.h"
 
+struct CompressedImage;
+
 /**
  * @file GLTexture2D.h
  * @brief RAII wrapper for an OpenGL 2D texture with byte/half/float upload helpers.
@@ -12,7 +15,25 @@
  * Encapsulates creation/destruction of a GL_TEXTURE_2D object, provides data
  * upload from interleaved vectors or an @ref Image, supports multiple data
  * types (see ::GLDataType), basic parameter control (filters, wrap), and
- * mipmap generation. Read-back helpers are available on non-Emscripten builds.
+ * mipmap generation. Block-compressed data (see @ref BCEncoder) is uploaded
+ * with glCompressedTexImage2D. Read-back helpers are available on
+ * non-Emscripten builds.
+ *
+ * By default no CPU copy of the uploaded pixels is kept (see ::GLShadowPolicy):
+ * copies duplicate the texture on the GPU (see @ref GLTextureCopy) and the
+ * read-back helpers fetch the pixels on demand.
+ *
+ * Storage is allocated with glTexStorage2D (GL 4.2/ARB_texture_storage,
+ * WebGL 2) only when the size or format changes; uploads with unchanged
+ * dimensions and @ref setSubData() update it with glTexSubImage2D. Because
+ * immutable storage cannot be respecified, a size/format change, a switch to
+ * compressed data or adding a mip chain replaces the GL texture and
+ * @ref getId() returns a new name. Query the name when binding instead of
+ * keeping it; GLFramebuffer does so on every bind and in
+ * GLFramebuffer::reattach(). Call @ref setMipmaps() before the first upload of
+ * a texture that will be mipmapped, so its storage is allocated with the mip
+ * chain once. Textures rewritten every frame can stream their uploads through
+ * pixel buffer objects (@ref setStreaming()).
  *
  * @note All GL calls are wrapped with the @c GL() macro provided by @c GLEnv.h.
  */
@@ -44,15 +65,39 @@ public:
               GLint magFilter=GL_NEAREST, GLint minFilter=GL_NEAREST,
               GLint wrapX=GL_REPEAT, GLint wrapY=GL_REPEAT);
 
-  /** @brief Copy-construct and duplicate texture contents and parameters. */
-  GLTexture2D(const GLTexture2D& other);
+  /** @brief Move-construct, taking over the GL texture of @p other (left empty). */
+  GLTexture2D(GLTexture2D&& other) noexcept;
+  /** @brief Move-assign; the previous texture is released together with @p other. */
+  GLTexture2D& operator=(GLTexture2D&& other) noexcept;
+  /** @brief Textures are not copy-assignable, use `a = b.clone()`. */
+  GLTexture2D& operator=(const GLTexture2D& other) = delete;
 
-  /** @brief Copy-assign and duplicate texture contents and parameters. */
-  GLTexture2D& operator=(const GLTexture2D& other);
+  /**
+   * @brief Create a new texture with duplicated contents and parameters.
+   *
+   * The contents are copied GPU-to-GPU, falling back to the shadow copy or a
+   * read-back for formats that can neither be copied nor blitted.
+   * @throw GLException If the contents cannot be transferred (Emscripten
+   *        without shadow copy).
+   */
+  GLTexture2D clone() const;
+
+  /**
+   * @brief Choose whether the last upload is retained in host memory.
+   *
+   * Switching to GLShadowPolicy::NONE frees the copy. Switching to
+   * GLShadowPolicy::KEEP reads the current contents back (on Emscripten the
+   * copy starts with the next upload).
+   */
+  void setShadowPolicy(GLShadowPolicy policy);
+  /** @brief Current shadow-copy policy (default GLShadowPolicy::NONE). */
+  GLShadowPolicy getShadowPolicy() const {return shadowPolicy;}
 
   /**
    * @brief Retrieve the OpenGL texture object name.
    * @return GLuint of the managed GL_TEXTURE_2D.
+   * @note The name changes when the storage is respecified (see the class
+   *       notes), do not keep it across uploads.
    */
   const GLuint getId() const;
 
@@ -91,6 +136,15 @@ public:
    */
   void setData(const std::vector<GLubyte>& data);
 
+  /**
+   * @brief Upload unsigned-byte pixels from a raw buffer (e.g. a decoder's output).
+   * @param data           Interleaved pixels of size componentCount*width*height.
+   * @param width          Width in texels.
+   * @param height         Height in texels.
+   * @param componentCount Components per texel (default 4 = RGBA).
+   */
+  void setData(const GLubyte* data, uint32_t width, uint32_t height, uint8_t componentCount=4);
+
   /**
    * @brief Upload float data with explicit dimensions.
    * @param data           Interleaved float pixels of size componentCount*width*height.
@@ -123,6 +177,57 @@ public:
    */
   void setData(const std::vector<GLhalf>& data);
 
+  /**
+   * @brief Upload block-compressed data produced by @ref BCEncoder.
+   * @param image Compressed blocks, dimensions and format.
+   * @note Compressed textures cannot use generateMipmap(); use a non-mipmap
+   *       minification filter.
+   */
+  void setCompressedData(const CompressedImage& image);
+
+  /**
+   * @brief Upload block-compressed data in any GL compressed format.
+   * @param data           Compressed blocks.
+   * @param width          Width in texels.
+   * @param height         Height in texels.
+   * @param internalformat GL compressed format (e.g. GL_COMPRESSED_RED_RGTC1).
+   * @param componentCount Channels represented by the format.
+   */
+  void setCompressedData(const std::vector<GLubyte>& data, uint32_t width, uint32_t height,
+                         GLenum internalformat, uint8_t componentCount);
+
+  /**
+   * @brief Update a rectangle with unsigned-byte data.
+   * @param data   Interleaved pixels of size getComponentCount()*width*height.
+   * @param x      Left column of the rectangle.
+   * @param y      Bottom row of the rectangle.
+   * @param width  Width of the rectangle in texels.
+   * @param height Height of the rectangle in texels.
+   * @throw GLException If the rectangle exceeds the texture, the sizes do not
+   *        match or the texture is compressed.
+   */
+  void setSubData(const std::vector<GLubyte>& data, uint32_t x, uint32_t y,
+                  uint32_t width, uint32_t height);
+
+  /** @brief Update a rectangle with half-float data (see the GLubyte overload). */
+  void setSubData(const std::vector<GLhalf>& data, uint32_t x, uint32_t y,
+                  uint32_t width, uint32_t height);
+
+  /** @brief Update a rectangle with float data (see the GLubyte overload). */
+  void setSubData(const std::vector<GLfloat>& data, uint32_t x, uint32_t y,
+                  uint32_t width, uint32_t height);
+
+  /**
+   * @brief Route uploads through two alternating pixel buffer objects.
+   *
+   * Meant for textures rewritten every frame: the pixels are copied into an
+   * orphaned PBO and transferred asynchronously instead of stalling the
+   * calling thread until the driver consumed the client memory.
+   */
+  void setStreaming(bool streaming);
+  /** @brief True if uploads are streamed through PBOs. */
+  bool getStreaming() const {return streaming;}
+
   /**
    * @brief Update filtering parameters on the bound texture.
    * @param magFilter GL magnification filter.
@@ -138,9 +243,25 @@ public:
    */
   void setPixel(const std::vector<GLubyte>& data, uint32_t x, uint32_t y);
 
-  /** @brief Generate mipmaps for the texture. */
+  /**
+   * @brief Generate mipmaps for the texture.
+   * @note If the storage was allocated without a mip chain (non-mipmap
+   *       minification filter and no @ref setMipmaps()), it is reallocated
+   *       with one first, which copies the texture and changes @ref getId().
+   */
   void generateMipmap();
 
+  /**
+   * @brief Allocate storage with a full mip chain from the next upload on.
+   *
+   * Set it before uploading a texture that @ref generateMipmap() is called
+   * on, so the level 0 upload goes straight into the final storage.
+   * Enabled implicitly by @ref generateMipmap().
+   */
+  void setMipmaps(bool mipmaps);
+  /** @brief True if storage is allocated with a full mip chain. */
+  bool getMipmaps() const {return mipmaps;}
+
   /** @name Introspection */
   ///@{
   uint32_t getHeight() const {return height;}
@@ -148,12 +269,18 @@ public:
   uint32_t getComponentCount() const {return componentCount;}
   uint32_t getSize() const {return height*width*componentCount;}
   GLDataType getType() const {return dataType;}
+  /** @brief True if the texture holds block-compressed data. */
+  bool isCompressed() const {return compressedFormat != 0;}
   ///@}
 
 #ifndef __EMSCRIPTEN__
   /** @brief Read back texture as an @ref Image (BYTE). */
   Image getImage();
-  /** @brief Read back raw unsigned bytes via glGetTexImage. */
+  /**
+   * @brief Read back raw unsigned bytes via glGetTexImage.
+   * @note The returned buffer is owned by the texture and released by the
+   *       next upload unless GLShadowPolicy::KEEP is set.
+   */
   const std::vector<GLubyte>& getDataByte();
   /** @brief Read back raw half floats via glGetTexImage. */
   const std::vector<GLhalf>& getDataHalf();
@@ -172,13 +299,22 @@ private:
   GLint wrapX;            ///< Wrap mode for S.
   GLint wrapY;            ///< Wrap mode for T.
 
-  std::vector<GLubyte> data; ///< Last uploaded BYTE pixels (kept for copies/readback).
-  std::vector<GLhalf>  hdata; ///< Last uploaded HALF pixels.
-  std::vector<GLfloat> fdata; ///< Last uploaded FLOAT pixels.
+  GLShadowPolicy shadowPolicy{GLShadowPolicy::NONE}; ///< Whether uploads are retained in host memory.
+  std::vector<GLubyte> data;  ///< Shadow copy / read-back buffer of BYTE pixels.
+  std::vector<GLhalf>  hdata; ///< Shadow copy / read-back buffer of HALF pixels.
+  std::vector<GLfloat> fdata; ///< Shadow copy / read-back buffer of FLOAT pixels.
+  std::vector<GLubyte> cdata; ///< Shadow copy of compressed blocks.
   uint32_t width{0};     ///< Texture width in texels.
   uint32_t height{0};    ///< Texture height in texels.
   uint8_t componentCount{0}; ///< Components per texel (1..4).
   GLDataType dataType{GLDataType::BYTE}; ///< Element type of the texture storage.
+  GLenum compressedFormat{0}; ///< GL compressed format of @ref data (0 if uncompressed).
+  GLsizei levelCount{0};     ///< Mip levels of the allocated storage (0 = none).
+  bool immutable{false};     ///< Storage was allocated with glTexStorage2D.
+  bool mipmaps{false};       ///< Allocate full mip chains (setMipmaps(), generateMipmap()).
+  bool streaming{false};     ///< Uploads go through @ref pbos.
+  std::array<GLuint, 2> pbos{{0, 0}}; ///< Pixel unpack buffers, used alternately.
+  size_t nextPbo{0};         ///< Index of the PBO used by the next upload.
 
   /**
    * @brief Core upload routine used by all typed setData() overloads.
@@ -190,4 +326,40 @@ private:
    */
   void setData(GLvoid* data, uint32_t width, uint32_t height,
                uint8_t componentCount, GLDataType dataType);
+
+  /** @brief Generate the texture name and apply the sampler parameters. */
+  void createTexture();
+
+  /** @brief Replace the texture name by a new one without storage. */
+  void recreate();
+
+  /** @brief Allocate storage for the current size and format. */
+  void allocate();
+
+  /** @brief Mip levels that storage of @p width × @p height gets allocated with. */
+  GLsizei storageLevels(uint32_t width, uint32_t height) const;
+
+  /** @brief Transfer a rectangle of @p size bytes into level 0 (directly or via PBO). */
+  void upload(const GLvoid* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+              GLenum format, GLenum type, size_t size);
+
+  /** @brief Validate and upload a rectangle of @p count elements of @p dataType. */
+  void setSubData(const GLvoid* data, size_t count, GLDataType dataType,
+                  uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+
+  /** @brief Core compressed upload routine (does not touch the shadow copy). */
+  void setCompressedData(const GLubyte* data, size_t size, uint32_t width, uint32_t height,
+                         GLenum internalformat, uint8_t componentCount);
+
+  /** @brief Free all shadow/read-back buffers. */
+  void releaseShadow();
+
+  /** @brief Copy constructor behind @ref clone(). */
+  GLTexture2D(const GLTexture2D& other);
+
+  /** @brief Duplicate the contents and shadow policy of @p other into this texture. */
+  void copyFrom(const GLTexture2D& other);
+
+  /** @brief Exchange all state (including the GL name) with @p other. */
+  void swap(GLTexture2D& other) noexcept;
 };
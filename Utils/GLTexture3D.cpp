@@ -1,4 +1,7 @@
+#include <utility>
+
 #include "GLTexture3D.h"
+#include "GLTextureCopy.h"
 
 GLTexture3D::GLTexture3D(GLint magFilter, GLint minFilter, GLint wrapX, GLint wrapY, GLint wrapZ) :
   id(0),
@@ -32,30 +35,111 @@ GLTexture3D::~GLTexture3D() {
 GLTexture3D::GLTexture3D(const GLTexture3D& other) :
   GLTexture3D(other.magFilter, other.minFilter, other.wrapX, other.wrapY, other.wrapZ)
 {
-  if (other.height > 0 && other.width > 0 && other.depth > 0) {
-    if (other.isFloat)
-      setData(other.fdata, other.height, other.width, other.depth, other.componentCount);
-    else
-      setData(other.data, other.height, other.width, other.depth, other.componentCount);
+  copyFrom(other);
+}
+
+void GLTexture3D::copyFrom(const GLTexture3D& other) {
+  shadowPolicy = other.shadowPolicy;
+  releaseShadow();
+  if (other.height == 0 || other.width == 0 || other.depth == 0) return;
+
+  setData(nullptr, other.width, other.height, other.depth, other.componentCount, other.isFloat);
+  if (!GLTextureCopy::copy(GL_TEXTURE_3D, other.id, id, width, height, depth)) {
+    // format is not renderable here, go through host memory
+    const GLvoid* pixels = nullptr;
+    if (other.shadowPolicy == GLShadowPolicy::KEEP) {
+      if (other.isFloat && !other.fdata.empty()) pixels = other.fdata.data();
+      if (!other.isFloat && !other.data.empty()) pixels = other.data.data();
+    }
+    std::vector<uint8_t> readback;
+#ifndef __EMSCRIPTEN__
+    if (!pixels) {
+      readback.resize(size_t(other.getSize())*(other.isFloat ? sizeof(GLfloat) : sizeof(GLubyte)));
+      GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+      GL(glBindTexture(GL_TEXTURE_3D, other.id));
+      GL(glGetTexImage(GL_TEXTURE_3D, 0, other.format, other.type, readback.data()));
+      pixels = readback.data();
+    }
+#endif
+    if (!pixels) {
+      throw GLException{"Texture format cannot be copied on the GPU, use GLShadowPolicy::KEEP."};
+    }
+    setData((GLvoid*)pixels, other.width, other.height, other.depth, other.componentCount, other.isFloat);
+  }
+
+  if (shadowPolicy == GLShadowPolicy::KEEP) {
+    data = other.data;
+    fdata = other.fdata;
+  }
+}
+
+void GLTexture3D::setShadowPolicy(GLShadowPolicy policy) {
+  if (policy == shadowPolicy) return;
+  shadowPolicy = policy;
+  if (policy == GLShadowPolicy::NONE) {
+    releaseShadow();
+    return;
   }
+#ifndef __EMSCRIPTEN__
+  if (width == 0 || height == 0 || depth == 0) return;
+  if (isFloat)
+    getDataFloat();
+  else
+    getDataByte();
+#endif
+}
+
+void GLTexture3D::releaseShadow() {
+  std::vector<GLubyte>().swap(data);
+  std::vector<GLfloat>().swap(fdata);
 }
 
-GLTexture3D& GLTexture3D::operator=(GLTexture3D other) {
-    magFilter = other.magFilter;
-    minFilter = other.minFilter;
-    wrapX = other.wrapX;
-    wrapY = other.wrapY;
-    wrapZ = other.wrapZ;
+GLTexture3D::GLTexture3D(GLTexture3D&& other) noexcept :
+  id(0),
+  internalformat(0),
+  format(0),
+  type(0),
+  magFilter(GL_NEAREST),
+  minFilter(GL_NEAREST),
+  wrapX(GL_REPEAT),
+  wrapY(GL_REPEAT),
+  wrapZ(GL_REPEAT),
+  width(0),
+  height(0),
+  depth(0),
+  componentCount(0),
+  isFloat(false)
+{
+  swap(other);
+}
+
+GLTexture3D& GLTexture3D::operator=(GLTexture3D&& other) noexcept {
+  swap(other);
+  return *this;
+}
+
+void GLTexture3D::swap(GLTexture3D& other) noexcept {
+  std::swap(id, other.id);
+  std::swap(internalformat, other.internalformat);
+  std::swap(format, other.format);
+  std::swap(type, other.type);
+  std::swap(magFilter, other.magFilter);
+  std::swap(minFilter, other.minFilter);
+  std::swap(wrapX, other.wrapX);
+  std::swap(wrapY, other.wrapY);
+  std::swap(wrapZ, other.wrapZ);
+  std::swap(shadowPolicy, other.shadowPolicy);
+  std::swap(data, other.data);
+  std::swap(fdata, other.fdata);
+  std::swap(width, other.width);
+  std::swap(height, other.height);
+  std::swap(depth, other.depth);
+  std::swap(componentCount, other.componentCount);
+  std::swap(isFloat, other.isFloat);
+}
 
-    GL(glBindTexture(GL_TEXTURE_3D, id));
-    GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, wrapX));
-    GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, wrapY));
-    GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, magFilter));
-    GL(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, minFilter));
-    
-    if (other.height > 0 && other.width > 0 && other.depth > 0)
-      setData(other.data, other.height, other.width, other.depth, other.componentCount);
-    return *this;
+GLTexture3D GLTexture3D::clone() const {
+  return GLTexture3D(*this);
 }
 
 const GLuint GLTexture3D::getId() const {
@@ -82,7 +166,8 @@ void GLTexture3D::setData(const std::vector<GLubyte>& data, uint32_t width, uint
     throw GLException{"Data size and texure dimensions do not match."};
   }
   
-  this->data = data;
+  releaseShadow();
+  if (shadowPolicy == GLShadowPolicy::KEEP) this->data = data;
   setData((GLvoid*)data.data(), width, height, depth, componentCount, false);
 }
 
@@ -91,10 +176,11 @@ void GLTexture3D::setData(const std::vector<GLfloat>& data) {
 }
 
 void GLTexture3D::setData(const std::vector<GLfloat>& data, uint32_t width, uint32_t height, uint32_t depth, uint8_t componentCount) {
-  if (data.size() != componentCount*width*height*depth*4) {
+  if (data.size() != componentCount*width*height*depth) {
     throw GLException{"Data size and texure dimensions do not match."};
   }
-  this->fdata = data;
+  releaseShadow();
+  if (shadowPolicy == GLShadowPolicy::KEEP) this->fdata = data;
   setData((GLvoid*)data.data(), width, height, depth, componentCount, true);
 }
 
@@ -140,7 +226,8 @@ const std::vector<GLubyte>& GLTexture3D::getDataByte() {
   GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
   GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
   GL(glBindTexture(GL_TEXTURE_3D, id));
-  GL(glGetTexImage(GL_TEXTURE_3D, 0, format, type, data.data()));
+  data.resize(getSize());
+  GL(glGetTexImage(GL_TEXTURE_3D, 0, format, GL_UNSIGNED_BYTE, data.data()));
   return data;
 }
 
@@ -148,7 +235,8 @@ const std::vector<GLfloat>& GLTexture3D::getDataFloat() {
   GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
   GL(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
   GL(glBindTexture(GL_TEXTURE_3D, id));
-  GL(glGetTexImage(GL_TEXTURE_3D, 0, format, type, fdata.data()));
+  fdata.resize(getSize());
+  GL(glGetTexImage(GL_TEXTURE_3D, 0, format, GL_FLOAT, fdata.data()));
   return fdata;
 }
 #endif
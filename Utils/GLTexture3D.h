@@ -13,6 +13,9 @@
  * parameter control (filters, wrap per axis), and optional read-back helpers on
  * non-Emscripten builds.
  *
+ * By default no CPU copy of the uploaded voxels is kept (see ::GLShadowPolicy);
+ * copies duplicate the texture on the GPU (see @ref GLTextureCopy).
+ *
  * @note All GL calls are wrapped with the @c GL() macro provided by @c GLEnv.h.
  */
 class GLTexture3D {
@@ -32,10 +35,32 @@ public:
   /** @brief Destroy and delete the GL texture name. */
   ~GLTexture3D();
 
-  /** @brief Copy-construct and duplicate texture contents and parameters. */
-  GLTexture3D(const GLTexture3D& other);
-  /** @brief Copy-assign and duplicate texture contents and parameters. */
-  GLTexture3D& operator=(GLTexture3D other);
+  /** @brief Move-construct, taking over the GL texture of @p other (left empty). */
+  GLTexture3D(GLTexture3D&& other) noexcept;
+  /** @brief Move-assign; the previous texture is released together with @p other. */
+  GLTexture3D& operator=(GLTexture3D&& other) noexcept;
+  /** @brief Textures are not copy-assignable, use `a = b.clone()`. */
+  GLTexture3D& operator=(const GLTexture3D& other) = delete;
+
+  /**
+   * @brief Create a new texture with duplicated contents and parameters.
+   *
+   * The contents are copied GPU-to-GPU, falling back to the shadow copy or a
+   * read-back for formats that can neither be copied nor blitted.
+   * @throw GLException If the contents cannot be transferred (Emscripten
+   *        without shadow copy).
+   */
+  GLTexture3D clone() const;
+
+  /**
+   * @brief Choose whether the last upload is retained in host memory.
+   *
+   * Switching to GLShadowPolicy::KEEP reads the current contents back (on
+   * Emscripten the copy starts with the next upload).
+   */
+  void setShadowPolicy(GLShadowPolicy policy);
+  /** @brief Current shadow-copy policy (default GLShadowPolicy::NONE). */
+  GLShadowPolicy getShadowPolicy() const {return shadowPolicy;}
 
   /**
    * @brief Retrieve the OpenGL texture object name.
@@ -76,7 +101,7 @@ public:
 
   /**
    * @brief Upload 32-bit float data with explicit dimensions.
-   * @param data           Interleaved float pixels of size componentCount*width*height*depth*4 bytes.
+   * @param data           Interleaved float pixels of size componentCount*width*height*depth.
    * @param width          Width in texels.
    * @param height         Height in texels.
    * @param depth          Depth in texels.
@@ -87,7 +112,7 @@ public:
 
   /**
    * @brief Upload 32-bit float data using previously set dimensions.
-   * @param data Interleaved float pixels of size getSize()*sizeof(GLfloat).
+   * @param data Interleaved float pixels of size getSize().
    */
   void setData(const std::vector<GLfloat>& data);
 
@@ -125,8 +150,9 @@ private:
   GLint wrapX;             ///< Wrap mode for S.
   GLint wrapY;             ///< Wrap mode for T.
   GLint wrapZ;             ///< Wrap mode for R.
-  std::vector<GLubyte> data; ///< Last uploaded BYTE pixels (kept for copies/readback).
-  std::vector<GLfloat> fdata; ///< Last uploaded FLOAT pixels.
+  GLShadowPolicy shadowPolicy{GLShadowPolicy::NONE}; ///< Whether uploads are retained in host memory.
+  std::vector<GLubyte> data; ///< Shadow copy / read-back buffer of BYTE voxels.
+  std::vector<GLfloat> fdata; ///< Shadow copy / read-back buffer of FLOAT voxels.
   uint32_t width;          ///< Texture width in texels.
   uint32_t height;         ///< Texture height in texels.
   uint32_t depth;          ///< Texture depth in texels.
@@ -144,4 +170,16 @@ private:
    */
   void setData(GLvoid* data, uint32_t width, uint32_t height, uint32_t depth,
                uint8_t componentCount, bool isFloat);
+
+  /** @brief Free the shadow/read-back buffers. */
+  void releaseShadow();
+
+  /** @brief Copy constructor behind @ref clone(). */
+  GLTexture3D(const GLTexture3D& other);
+
+  /** @brief Duplicate the contents and shadow policy of @p other into this texture. */
+  void copyFrom(const GLTexture3D& other);
+
+  /** @brief Exchange all state (including the GL name) with @p other. */
+  void swap(GLTexture3D& other) noexcept;
 };
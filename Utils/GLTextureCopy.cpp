@@ -0,0 +1,65 @@
+#include "GLTextureCopy.h"
+
+bool GLTextureCopy::hasCopyImage() {
+#ifdef __EMSCRIPTEN__
+  return false;
+#else
+  return GLEW_VERSION_4_3 || GLEW_ARB_copy_image;
+#endif
+}
+
+static void attach(GLenum framebuffer, GLenum target, GLuint texture, uint32_t layer) {
+  switch (target) {
+    case GL_TEXTURE_3D :
+      GL(glFramebufferTextureLayer(framebuffer, GL_COLOR_ATTACHMENT0, texture, 0, GLint(layer)));
+      break;
+    case GL_TEXTURE_CUBE_MAP :
+      GL(glFramebufferTexture2D(framebuffer, GL_COLOR_ATTACHMENT0,
+                                GL_TEXTURE_CUBE_MAP_POSITIVE_X+layer, texture, 0));
+      break;
+    default :
+      GL(glFramebufferTexture2D(framebuffer, GL_COLOR_ATTACHMENT0, target, texture, 0));
+      break;
+  }
+}
+
+bool GLTextureCopy::copy(GLenum target, GLuint src, GLuint dst,
+                         uint32_t width, uint32_t height, uint32_t depth) {
+  const uint32_t layers = target == GL_TEXTURE_CUBE_MAP ? 6 : depth;
+
+#ifndef __EMSCRIPTEN__
+  if (hasCopyImage()) {
+    // cube maps are addressed as six layers
+    GL(glCopyImageSubData(src, target, 0, 0, 0, 0,
+                          dst, target, 0, 0, 0, 0,
+                          GLsizei(width), GLsizei(height), GLsizei(layers)));
+    return true;
+  }
+#endif
+
+  GLint previousRead, previousDraw;
+  GL(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead));
+  GL(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw));
+
+  GLuint framebuffers[2];
+  GL(glGenFramebuffers(2, framebuffers));
+  GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[0]));
+  GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[1]));
+
+  bool success = true;
+  for (uint32_t layer = 0;layer<layers && success;++layer) {
+    attach(GL_READ_FRAMEBUFFER, target, src, layer);
+    attach(GL_DRAW_FRAMEBUFFER, target, dst, layer);
+    success = glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE &&
+              glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (success) {
+      GL(glBlitFramebuffer(0, 0, GLint(width), GLint(height), 0, 0, GLint(width), GLint(height),
+                           GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    }
+  }
+
+  GL(glBindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(previousRead)));
+  GL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, GLuint(previousDraw)));
+  GL(glDeleteFramebuffers(2, framebuffers));
+  return success;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include "GLEnv.h"
+
+/**
+ * @file GLTextureCopy.h
+ * @brief GPU-to-GPU copies of texture level 0 used to duplicate GL textures.
+ *
+ * Copies use glCopyImageSubData when GL 4.3 or ARB_copy_image is available
+ * (any format, including block-compressed ones). Otherwise every layer/face
+ * is attached to a pair of temporary framebuffers and blitted, which requires
+ * a color-renderable format. The destination must already have storage of
+ * the same size and format.
+ */
+namespace GLTextureCopy {
+  /** @brief True if glCopyImageSubData can be used in the current context. */
+  bool hasCopyImage();
+
+  /**
+   * @brief Copy level 0 of texture @p src into @p dst.
+   * @param target GL_TEXTURE_2D, GL_TEXTURE_3D or GL_TEXTURE_CUBE_MAP.
+   * @param src    Source texture name.
+   * @param dst    Destination texture name (storage allocated).
+   * @param width  Width in texels.
+   * @param height Height in texels.
+   * @param depth  Depth in texels (1 for 2D and cube map textures).
+   * @return False if neither copy path supports the texture's format; the
+   *         caller then has to transfer the pixels through host memory.
+   */
+  bool copy(GLenum target, GLuint src, GLuint dst,
+            uint32_t width, uint32_t height, uint32_t depth=1);
+}
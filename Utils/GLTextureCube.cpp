@@ -1,7 +1,10 @@
 #include <array>
+#include <algorithm>
 #include <sstream>
+#include <utility>
 
 #include "GLTextureCube.h"
+#include "GLTextureCopy.h"
 
 GLTextureCube::GLTextureCube(GLint magFilter, GLint minFilter, GLint wrapX, GLint wrapY, GLint wrapZ) :
   id(0),
@@ -40,9 +43,9 @@ GLTextureCube(magFilter, minFilter, wrapX, wrapY)
   setData(image0,Face::POSX);
   setData(image1,Face::NEGX);
   setData(image2,Face::POSY);
-  setData(image3,Face::POSY);
+  setData(image3,Face::NEGY);
   setData(image4,Face::POSZ);
-  setData(image5,Face::POSZ);
+  setData(image5,Face::NEGZ);
 }
 
 
@@ -62,55 +65,53 @@ GLTextureCube::~GLTextureCube() {
 GLTextureCube::GLTextureCube(const GLTextureCube& other) :
   GLTextureCube(other.magFilter, other.minFilter, other.wrapX, other.wrapY, other.wrapZ)
 {
-  if (other.height > 0 && other.width > 0) {
-    for (size_t face = 0;face<6;++face) {
-      switch (other.dataType) {
-        case GLDataType::BYTE  :
-          setData(other.data, other.width, other.height, Face(face), other.componentCount);
-          break;
-        case GLDataType::HALF  :
-          setData(other.hdata, other.width, other.height, Face(face), other.componentCount);
-          break;
-        case GLDataType::FLOAT :
-          setData(other.fdata, other.width, other.height, Face(face), other.componentCount);
-          break;
-      }
-    }
-  }
+  copyFrom(other);
 }
 
-GLTextureCube& GLTextureCube::operator=(const GLTextureCube& other) {
-  magFilter = other.magFilter;
-  minFilter = other.minFilter;
-  wrapX = other.wrapX;
-  wrapY = other.wrapY;
-  wrapZ = other.wrapZ;
+GLTextureCube::GLTextureCube(GLTextureCube&& other) noexcept :
+  id(0),
+  internalformat(0),
+  format(0),
+  type(0),
+  magFilter(GL_NEAREST),
+  minFilter(GL_NEAREST),
+  wrapX(GL_CLAMP_TO_EDGE),
+  wrapY(GL_CLAMP_TO_EDGE),
+  wrapZ(GL_CLAMP_TO_EDGE),
+  dataType(GLDataType::BYTE)
+{
+  swap(other);
+}
 
-  GL(glBindTexture(GL_TEXTURE_CUBE_MAP, id));
-  GL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, wrapX));
-  GL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, wrapY));
-  GL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, wrapZ));
-  GL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, magFilter));
-  GL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, minFilter));
-  
-  if (other.height > 0 && other.width > 0) {
-    for (size_t face = 0;face<6;++face) {
-      switch (other.dataType) {
-        case GLDataType::BYTE  :
-          setData(other.data, other.width, other.height, Face(face), other.componentCount);
-          break;
-        case GLDataType::HALF  :
-          setData(other.hdata, other.width, other.height, Face(face), other.componentCount);
-          break;
-        case GLDataType::FLOAT :
-          setData(other.fdata, other.width, other.height, Face(face), other.componentCount);
-          break;
-      }
-    }
-  }
+GLTextureCube& GLTextureCube::operator=(GLTextureCube&& other) noexcept {
+  swap(other);
   return *this;
 }
 
+void GLTextureCube::swap(GLTextureCube& other) noexcept {
+  std::swap(id, other.id);
+  std::swap(internalformat, other.internalformat);
+  std::swap(format, other.format);
+  std::swap(type, other.type);
+  std::swap(magFilter, other.magFilter);
+  std::swap(minFilter, other.minFilter);
+  std::swap(wrapX, other.wrapX);
+  std::swap(wrapY, other.wrapY);
+  std::swap(wrapZ, other.wrapZ);
+  std::swap(shadowPolicy, other.shadowPolicy);
+  std::swap(data, other.data);
+  std::swap(hdata, other.hdata);
+  std::swap(fdata, other.fdata);
+  std::swap(width, other.width);
+  std::swap(height, other.height);
+  std::swap(componentCount, other.componentCount);
+  std::swap(dataType, other.dataType);
+}
+
+GLTextureCube GLTextureCube::clone() const {
+  return GLTextureCube(*this);
+}
+
 const GLuint GLTextureCube::getId() const {
   return id;
 }
@@ -120,8 +121,12 @@ void GLTextureCube::clear() {
 }
 
 void GLTextureCube::setData(const Image& image, Face face) {
-  this->data = image.data;
+  if (image.layout != MemoryLayout::Linear) {
+    setData(image.toLayout(MemoryLayout::Linear), face);
+    return;
+  }
   setData((GLvoid*)(image.data.data()), image.width, image.height, face, image.componentCount, GLDataType::BYTE);
+  storeShadow(this->data, image.data.data(), face);
 }
 
 void GLTextureCube::setData(const std::vector<GLubyte>& data, Face face) {
@@ -147,8 +152,8 @@ void GLTextureCube::setData(const std::vector<GLubyte>& data, uint32_t width, ui
     throw GLException{"Data size and texure dimensions do not match."};
   }
   
-  this->data = data;
   setData((GLvoid*)data.data(), width, height, face, componentCount, GLDataType::BYTE);
+  storeShadow(this->data, data.data(), face);
 }
 
 void GLTextureCube::setData(const std::vector<GLhalf>& data, uint32_t width, uint32_t height, Face face, uint8_t componentCount) {
@@ -156,8 +161,8 @@ void GLTextureCube::setData(const std::vector<GLhalf>& data, uint32_t width, uin
     throw GLException{"Data size and texure dimensions do not match."};
   }
   
-  this->hdata = data;
   setData((GLvoid*)data.data(), width, height, face, componentCount, GLDataType::HALF);
+  storeShadow(this->hdata, data.data(), face);
 }
 
 void GLTextureCube::setData(const std::vector<GLfloat>& data, uint32_t width, uint32_t height, Face face, uint8_t componentCount) {
@@ -168,8 +173,8 @@ void GLTextureCube::setData(const std::vector<GLfloat>& data, uint32_t width, ui
     throw GLException{ss.str()};
   }
   
-  this->fdata = data;
-  setData((GLvoid*)this->fdata.data(), width, height, face, componentCount, GLDataType::FLOAT);
+  setData((GLvoid*)data.data(), width, height, face, componentCount, GLDataType::FLOAT);
+  storeShadow(this->fdata, data.data(), face);
 }
 
 struct GLTexInfo {
@@ -286,3 +291,115 @@ void GLTextureCube::generateMipmap() {
   GL(glBindTexture(GL_TEXTURE_CUBE_MAP, id));
   GL(glGenerateMipmap(GL_TEXTURE_CUBE_MAP));
 }
+
+template <typename T>
+void GLTextureCube::storeShadow(std::vector<T>& shadow, const T* pixels, Face face) {
+  if (shadowPolicy == GLShadowPolicy::NONE) {
+    releaseShadow();
+    return;
+  }
+  const size_t faceSize = getSize();
+  if (shadow.size() != 6*faceSize) shadow.assign(6*faceSize, T(0));
+  std::copy(pixels, pixels+faceSize, shadow.begin()+std::ptrdiff_t(size_t(face)*faceSize));
+}
+
+void GLTextureCube::releaseShadow() {
+  std::vector<GLubyte>().swap(data);
+  std::vector<GLhalf>().swap(hdata);
+  std::vector<GLfloat>().swap(fdata);
+}
+
+static size_t elementSize(GLDataType dataType) {
+  switch (dataType) {
+    case GLDataType::HALF  : return sizeof(GLhalf);
+    case GLDataType::FLOAT : return sizeof(GLfloat);
+    default                : return sizeof(GLubyte);
+  }
+}
+
+void GLTextureCube::setShadowPolicy(GLShadowPolicy policy) {
+  if (policy == shadowPolicy) return;
+  shadowPolicy = policy;
+  releaseShadow();
+#ifndef __EMSCRIPTEN__
+  if (policy == GLShadowPolicy::NONE || width == 0 || height == 0) return;
+  const size_t count = 6*size_t(getSize());
+  void* pixels = nullptr;
+  switch (dataType) {
+    case GLDataType::BYTE  : data.resize(count); pixels = data.data(); break;
+    case GLDataType::HALF  : hdata.resize(count); pixels = hdata.data(); break;
+    case GLDataType::FLOAT : fdata.resize(count); pixels = fdata.data(); break;
+  }
+  const GLTexInfo texInfo = dataTypeToGL(dataType, componentCount);
+  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+  GL(glBindTexture(GL_TEXTURE_CUBE_MAP, id));
+  for (size_t face = 0;face<6;++face) {
+    GL(glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + GLenum(face), 0, texInfo.format, texInfo.type,
+                     (uint8_t*)pixels + face*getSize()*elementSize(dataType)));
+  }
+#endif
+}
+
+void GLTextureCube::copyFrom(const GLTextureCube& other) {
+  shadowPolicy = other.shadowPolicy;
+  releaseShadow();
+  if (other.height == 0 || other.width == 0) return;
+
+  // reallocate even if the dimensions change
+  width = 0;
+  height = 0;
+  for (size_t face = 0;face<6;++face) {
+    setData(nullptr, other.width, other.height, Face(face), other.componentCount, other.dataType);
+  }
+
+  if (!GLTextureCopy::copy(GL_TEXTURE_CUBE_MAP, other.id, id, width, height)) {
+    // format is not renderable here, go through host memory
+    const size_t faceBytes = size_t(getSize())*elementSize(dataType);
+    const uint8_t* pixels = nullptr;
+    if (other.shadowPolicy == GLShadowPolicy::KEEP) switch (dataType) {
+      case GLDataType::BYTE  : if (!other.data.empty()) pixels = (const uint8_t*)other.data.data(); break;
+      case GLDataType::HALF  : if (!other.hdata.empty()) pixels = (const uint8_t*)other.hdata.data(); break;
+      case GLDataType::FLOAT : if (!other.fdata.empty()) pixels = (const uint8_t*)other.fdata.data(); break;
+    }
+    std::vector<uint8_t> readback;
+#ifndef __EMSCRIPTEN__
+    if (!pixels) {
+      const GLTexInfo texInfo = dataTypeToGL(dataType, componentCount);
+      readback.resize(6*faceBytes);
+      GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+      GL(glBindTexture(GL_TEXTURE_CUBE_MAP, other.id));
+      for (size_t face = 0;face<6;++face) {
+        GL(glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + GLenum(face), 0, texInfo.format, texInfo.type,
+                         readback.data() + face*faceBytes));
+      }
+      pixels = readback.data();
+    }
+#endif
+    if (!pixels) {
+      throw GLException{"Texture format cannot be copied on the GPU, use GLShadowPolicy::KEEP."};
+    }
+    for (size_t face = 0;face<6;++face) {
+      setData((GLvoid*)(pixels + face*faceBytes), width, height, Face(face), componentCount, dataType);
+    }
+  }
+
+  if (shadowPolicy == GLShadowPolicy::KEEP) {
+    data = other.data;
+    hdata = other.hdata;
+    fdata = other.fdata;
+  }
+}
+
+#ifndef __EMSCRIPTEN__
+
+Image GLTextureCube::getImage(Face face) const {
+  Image image{width, height, componentCount};
+  const GLTexInfo texInfo = dataTypeToGL(GLDataType::BYTE, componentCount);
+  GL(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+  GL(glBindTexture(GL_TEXTURE_CUBE_MAP, id));
+  GL(glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + GLenum(face), 0, texInfo.format, texInfo.type,
+                   image.data.data()));
+  return image;
+}
+
+#endif
@@ -13,6 +13,9 @@
  * uploads for each face from @ref Image or raw interleaved vectors, basic
  * sampler parameter control (filters, wrap S/T/R), and mipmap generation.
  *
+ * By default no CPU copy of the faces is kept (see ::GLShadowPolicy); copies
+ * duplicate all six faces on the GPU (see @ref GLTextureCopy).
+ *
  * @note All GL calls are wrapped with the @c GL() macro provided by @c GLEnv.h.
  */
 
@@ -59,10 +62,32 @@ public:
                 GLint magFilter=GL_NEAREST, GLint minFilter=GL_NEAREST,
                 GLint wrapX=GL_REPEAT, GLint wrapY=GL_REPEAT);
 
-  /** @brief Copy‑construct and duplicate texture contents and parameters. */
-  GLTextureCube(const GLTextureCube& other);
-  /** @brief Copy‑assign and duplicate texture contents and parameters. */
-  GLTextureCube& operator=(const GLTextureCube& other);
+  /** @brief Move-construct, taking over the GL texture of @p other (left empty). */
+  GLTextureCube(GLTextureCube&& other) noexcept;
+  /** @brief Move-assign; the previous texture is released together with @p other. */
+  GLTextureCube& operator=(GLTextureCube&& other) noexcept;
+  /** @brief Textures are not copy-assignable, use `a = b.clone()`. */
+  GLTextureCube& operator=(const GLTextureCube& other) = delete;
+
+  /**
+   * @brief Create a new texture with duplicated contents and parameters.
+   *
+   * All faces are copied GPU-to-GPU, falling back to the shadow copy or a
+   * read-back for formats that can neither be copied nor blitted.
+   * @throw GLException If the contents cannot be transferred (Emscripten
+   *        without shadow copy).
+   */
+  GLTextureCube clone() const;
+
+  /**
+   * @brief Choose whether uploaded faces are retained in host memory.
+   *
+   * Switching to GLShadowPolicy::KEEP reads all faces back (on Emscripten the
+   * copy starts with the next upload).
+   */
+  void setShadowPolicy(GLShadowPolicy policy);
+  /** @brief Current shadow-copy policy (default GLShadowPolicy::NONE). */
+  GLShadowPolicy getShadowPolicy() const {return shadowPolicy;}
 
   /**
    * @brief Retrieve the OpenGL texture object name.
@@ -167,6 +192,11 @@ public:
   /** @brief Generate mipmaps for the cube map. */
   void generateMipmap();
 
+#ifndef __EMSCRIPTEN__
+  /** @brief Read back one face as an @ref Image (BYTE) via glGetTexImage. */
+  Image getImage(Face face) const;
+#endif
+
 private:
   GLuint id;               ///< GL name of the texture object.
   GLint internalformat;    ///< Internal storage format (e.g., GL_RGBA8/GL_RGBA16F/GL_RGBA32F).
@@ -178,9 +208,10 @@ private:
   GLint wrapX;             ///< Wrap mode for S.
   GLint wrapY;             ///< Wrap mode for T.
   GLint wrapZ;             ///< Wrap mode for R.
-  std::vector<GLubyte> data; ///< Last uploaded BYTE pixels (kept for copies/readback).
-  std::vector<GLhalf> hdata; ///< Last uploaded HALF pixels.
-  std::vector<GLfloat> fdata; ///< Last uploaded FLOAT pixels.
+  GLShadowPolicy shadowPolicy{GLShadowPolicy::NONE}; ///< Whether uploads are retained in host memory.
+  std::vector<GLubyte> data; ///< Shadow copy of all six BYTE faces (face-major).
+  std::vector<GLhalf> hdata; ///< Shadow copy of all six HALF faces.
+  std::vector<GLfloat> fdata; ///< Shadow copy of all six FLOAT faces.
   uint32_t width{0};       ///< Face width in texels.
   uint32_t height{0};      ///< Face height in texels.
   uint8_t componentCount{0}; ///< Components per texel (1..4).
@@ -197,4 +228,20 @@ private:
    */
   void setData(GLvoid* data, uint32_t width, uint32_t height, Face face,
                uint8_t componentCount, GLDataType dataType);
+
+  /** @brief Record an uploaded face in @p shadow if the policy keeps one. */
+  template <typename T>
+  void storeShadow(std::vector<T>& shadow, const T* pixels, Face face);
+
+  /** @brief Free the shadow buffers. */
+  void releaseShadow();
+
+  /** @brief Copy constructor behind @ref clone(). */
+  GLTextureCube(const GLTextureCube& other);
+
+  /** @brief Duplicate the contents and shadow policy of @p other into this texture. */
+  void copyFrom(const GLTextureCube& other);
+
+  /** @brief Exchange all state (including the GL name) with @p other. */
+  void swap(GLTextureCube& other) noexcept;
 };
@@ -1,137 +1,333 @@
 #include <limits>
 #include <cmath>
+#include <cstring>
 #include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRID2D_USE_SSE
+#include <emmintrin.h>
+#endif
 
 #include "Rand.h"
 #include "Vec2.h"
 #include "bmp.h"
+#include "Parallel.h"
+#include "SummedAreaTable.h"
 
 #include "Grid2D.h"
 
-Grid2D::Grid2D(size_t width, size_t height) :
+// ===== Bulk cell conversions =====
+
+void GridCell<uint8_t>::toFloats(const uint8_t* in, float* out, size_t count) {
+  size_t i = 0;
+#ifdef GRID2D_USE_SSE
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(1.0f/255.0f);
+  for (;i+16<=count;i+=16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_ps(out+i+0,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+    _mm_storeu_ps(out+i+4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+    _mm_storeu_ps(out+i+8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+    _mm_storeu_ps(out+i+12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+  }
+#endif
+  for (;i<count;++i) out[i] = toValue(in[i]);
+}
+
+void GridCell<uint8_t>::fromFloats(const float* in, uint8_t* out, size_t count) {
+  size_t i = 0;
+#ifdef GRID2D_USE_SSE
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(255.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  for (;i+16<=count;i+=16) {
+    __m128i v[4];
+    for (size_t k = 0;k<4;++k) {
+      const __m128 f = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in+i+k*4), zero), one);
+      // truncating the non-negative f*255+0.5 matches fromValue()
+      v[k] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(f, scale), half));
+    }
+    const __m128i lo = _mm_packs_epi32(v[0], v[1]);
+    const __m128i hi = _mm_packs_epi32(v[2], v[3]);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm_packus_epi16(lo, hi));
+  }
+#endif
+  for (;i<count;++i) out[i] = fromValue(in[i]);
+}
+
+void GridCell<uint16_t>::toFloats(const uint16_t* in, float* out, size_t count) {
+  size_t i = 0;
+#ifdef GRID2D_USE_SSE
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(1.0f/65535.0f);
+  for (;i+8<=count;i+=8) {
+    const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in+i));
+    _mm_storeu_ps(out+i+0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)), scale));
+    _mm_storeu_ps(out+i+4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero)), scale));
+  }
+#endif
+  for (;i<count;++i) out[i] = toValue(in[i]);
+}
+
+void GridCell<uint16_t>::fromFloats(const float* in, uint16_t* out, size_t count) {
+  size_t i = 0;
+#ifdef GRID2D_USE_SSE
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(65535.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128i bias = _mm_set1_epi32(32768);
+  const __m128i flip = _mm_set1_epi16(int16_t(0x8000));
+  for (;i+8<=count;i+=8) {
+    __m128i v[2];
+    for (size_t k = 0;k<2;++k) {
+      const __m128 f = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in+i+k*4), zero), one);
+      // SSE2 only packs signed words: shift into the signed range and back
+      v[k] = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(f, scale), half)), bias);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out+i), _mm_xor_si128(_mm_packs_epi32(v[0], v[1]), flip));
+  }
+#endif
+  for (;i<count;++i) out[i] = fromValue(in[i]);
+}
+
+void GridCell<Half>::toFloats(const Half* in, float* out, size_t count) {
+  Half::toFloats(in, out, count);
+}
+
+void GridCell<Half>::fromFloats(const float* in, Half* out, size_t count) {
+  Half::fromFloats(in, out, count);
+}
+
+void GridCell<float>::toFloats(const float* in, float* out, size_t count) {
+  std::memcpy(out, in, count*sizeof(float));
+}
+
+void GridCell<float>::fromFloats(const float* in, float* out, size_t count) {
+  std::memcpy(out, in, count*sizeof(float));
+}
+
+static_assert(sizeof(Vec2) == 2*sizeof(float), "Vec2 cells must be two packed floats");
+static_assert(sizeof(Vec3) == 3*sizeof(float), "Vec3 cells must be three packed floats");
+
+void GridCell<Vec2>::toFloats(const Vec2* in, float* out, size_t count) {
+  std::memcpy(out, in, count*sizeof(Vec2));
+}
+
+void GridCell<Vec2>::fromFloats(const float* in, Vec2* out, size_t count) {
+  for (size_t i = 0;i<count;++i) out[i] = Vec2{in[i*2], in[i*2+1]};
+}
+
+void GridCell<Vec3>::toFloats(const Vec3* in, float* out, size_t count) {
+  std::memcpy(out, in, count*sizeof(Vec3));
+}
+
+void GridCell<Vec3>::fromFloats(const float* in, Vec3* out, size_t count) {
+  for (size_t i = 0;i<count;++i) out[i] = Vec3{in[i*3], in[i*3+1], in[i*3+2]};
+}
+
+// ===== Grid2Dt =====
+
+template <typename T>
+Grid2Dt<T>::Grid2Dt(size_t width, size_t height, MemoryLayout layout) :
   width(width),
   height(height),
-  data(width*height)
+  layout(width, height, layout),
+  data(this->layout.size())
 {
 }
 
-Grid2D::Grid2D(size_t width, size_t height, const std::vector<float> data) :
+template <typename T>
+Grid2Dt<T>::Grid2Dt(size_t width, size_t height, const std::vector<T> data) :
 width(width),
 height(height),
+layout(width, height),
 data(data)
 {
   if (width*height != data.size())
     throw std::runtime_error("size mismatch");
 }
 
-Grid2D::Grid2D(const Grid2D& other) :
+template <typename T>
+Grid2Dt<T>::Grid2Dt(const Grid2Dt& other) :
   width(other.width),
   height(other.height),
+  layout(other.layout),
   data(other.data)
 {
 }
 
-Grid2D::Grid2D(const Image& image) :
+template <typename T>
+Grid2Dt<T>::Grid2Dt(const Image& image) :
   width(image.width),
   height(image.height),
+  layout(image.width, image.height, image.layout),
   data(image.data.size()/image.componentCount)
 {
-  for (size_t i = 0;i<data.size();++i) {
-    data[i] = image.data[i*image.componentCount] / 255.0f;
+  constexpr uint8_t components = GridCell<T>::components;
+  if constexpr (std::is_same_v<T, uint8_t>) {
+    for (size_t i = 0;i<data.size();++i) {
+      data[i] = image.data[i*image.componentCount];
+    }
+    return;
+  }
+
+  // pick the channels, then widen in chunks
+  const uint8_t* bytes = image.data.data();
+  std::vector<uint8_t> channels;
+  if (image.componentCount != components) {
+    channels.resize(data.size()*components, 0);
+    const uint8_t used = std::min(components, image.componentCount);
+    for (size_t i = 0;i<data.size();++i) {
+      for (uint8_t c = 0;c<used;++c) {
+        channels[i*components+c] = image.data[i*image.componentCount+c];
+      }
+    }
+    bytes = channels.data();
+  }
+  constexpr size_t chunk = 1024;
+  float buffer[chunk*components];
+  for (size_t i = 0;i<data.size();i+=chunk) {
+    const size_t count = std::min(chunk, data.size()-i);
+    GridCell<uint8_t>::toFloats(bytes+i*components, buffer, count*components);
+    GridCell<T>::fromFloats(buffer, data.data()+i, count);
   }
 }
-    
-size_t Grid2D::getWidth() const {
+
+template <typename T>
+size_t Grid2Dt<T>::getWidth() const {
   return width;
 }
 
-size_t Grid2D::getHeight() const {
+template <typename T>
+size_t Grid2Dt<T>::getHeight() const {
   return height;
 }
 
-std::string Grid2D::toString() const {
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::toLayout(MemoryLayout layout) const {
+  if (layout == this->layout.getLayout()) return *this;
+  Grid2Dt result(width, height, layout);
+  GridLayout::convert(this->layout, data.data(), result.layout, result.data.data());
+  return result;
+}
+
+template <typename T>
+std::string Grid2Dt<T>::toString() const {
   std::stringstream s;
-  for (size_t i = 0;i<data.size();++i) {
-    s << data[i];
-    if (i%width == width-1 && i != 0)
-      s << std::endl;
-    else
-      s << ", ";
+  for (size_t y = 0;y<height;++y) {
+    for (size_t x = 0;x<width;++x) {
+      s << getValue(x,y);
+      if (x == width-1 && (x != 0 || y != 0))
+        s << std::endl;
+      else
+        s << ", ";
+    }
   }
   return s.str();
 }
 
-std::vector<uint8_t> Grid2D::toByteArray() const {
+template <typename T>
+std::vector<uint8_t> Grid2Dt<T>::toByteArray() const {
+  if (layout.getLayout() != MemoryLayout::Linear)
+    return toLayout(MemoryLayout::Linear).toByteArray();
+
+  constexpr uint8_t components = GridCell<T>::components;
   std::vector<uint8_t> uidata(data.size()*3);
-  for (size_t i = 0;i<data.size();++i) {
-    uidata[i*3+0] = uint8_t(data[i]*255);
-    uidata[i*3+1] = uint8_t(data[i]*255);
-    uidata[i*3+2] = uint8_t(data[i]*255);
+  if constexpr (std::is_same_v<T, uint8_t>) {
+    for (size_t i = 0;i<data.size();++i) {
+      uidata[i*3+0] = data[i];
+      uidata[i*3+1] = data[i];
+      uidata[i*3+2] = data[i];
+    }
+    return uidata;
+  }
+
+  constexpr size_t chunk = 1024;
+  float buffer[chunk*components];
+  for (size_t i = 0;i<data.size();i+=chunk) {
+    const size_t count = std::min(chunk, data.size()-i);
+    GridCell<T>::toFloats(data.data()+i, buffer, count);
+    for (size_t j = 0;j<count;++j) {
+      for (size_t c = 0;c<3;++c) {
+        const float v = components == 1 ? buffer[j] : (c < components ? buffer[j*components+c] : 0.0f);
+        uidata[(i+j)*3+c] = uint8_t(std::clamp(v, 0.0f, 1.0f)*255);
+      }
+    }
   }
   return uidata;
 }
 
-void Grid2D::setValue(size_t x, size_t y, float value) {
-  data[index(x,y)] = value;
+template <typename T>
+void Grid2Dt<T>::setValue(size_t x, size_t y, const Value& value) {
+  data[index(x,y)] = GridCell<T>::fromValue(value);
 }
 
-
-float Grid2D::getValueNormalized(float x, float y) const {
-  return data[index(size_t(x*width),size_t(y*height))];
+template <typename T>
+typename Grid2Dt<T>::Value Grid2Dt<T>::getValueNormalized(float x, float y) const {
+  return GridCell<T>::toValue(data[index(size_t(x*width),size_t(y*height))]);
 }
 
-float Grid2D::getValue(size_t x, size_t y) const {
-  return data[index(x,y)];
+template <typename T>
+typename Grid2Dt<T>::Value Grid2Dt<T>::getValue(size_t x, size_t y) const {
+  return GridCell<T>::toValue(data[index(x,y)]);
 }
 
-
-float Grid2D::sample(const Vec2& pos) const  {
+template <typename T>
+typename Grid2Dt<T>::Value Grid2Dt<T>::sample(const Vec2& pos) const  {
   return sample(pos.x, pos.y);
 }
 
-float Grid2D::sample(float x, float y) const {
+template <typename T>
+typename Grid2Dt<T>::Value Grid2Dt<T>::sample(float x, float y) const {
   x = std::max(std::min(x,1.0f), 0.0f);
   y = std::max(std::min(y,1.0f), 0.0f);
-  
+
   float sx = x*(width-1);
   float sy = y*(height-1);
-  
+
   float alpha = sx - floorf(sx);
   float beta  = sy - floorf(sy);
-  
+
   Vec2ui a{uint32_t(floorf(sx)),uint32_t(floorf(sy))};
   Vec2ui b{uint32_t(ceilf(sx)),uint32_t(floorf(sy))};
   Vec2ui c{uint32_t(floorf(sx)),uint32_t(ceilf(sy))};
   Vec2ui d{uint32_t(ceilf(sx)),uint32_t(ceilf(sy))};
-  
-  float va = getValue(a.x, a.y);
-  float vb = getValue(b.x, b.y);
-  float vc = getValue(c.x, c.y);
-  float vd = getValue(d.x, d.y);
-  
+
+  Value va = getValue(a.x, a.y);
+  Value vb = getValue(b.x, b.y);
+  Value vc = getValue(c.x, c.y);
+  Value vd = getValue(d.x, d.y);
+
   return (va * (1.0f-alpha) + vb * alpha) * (1.0f-beta) + (vc * (1.0f-alpha) + vd * alpha) * beta;
 }
 
-Vec3 Grid2D::normal(const Vec2& pos) const {
+template <typename T>
+Vec3 Grid2Dt<T>::normal(const Vec2& pos) const {
   return normal(pos.x, pos.y);
 }
 
-Vec3 Grid2D::normal(float x, float y) const {
+template <typename T>
+Vec3 Grid2Dt<T>::normal(float x, float y) const {
   x = std::max(std::min(x, 1.0f), 0.0f);
   y = std::max(std::min(y, 1.0f), 0.0f);
 
   float sx = x * (width - 1);
   float sy = y * (height - 1);
-  
+
   Vec2ui a{ uint32_t(floorf(sx)),uint32_t(floorf(sy)) };
   Vec2ui b{ uint32_t(ceilf(sx)),uint32_t(floorf(sy)) };
   Vec2ui c{ uint32_t(floorf(sx)),uint32_t(ceilf(sy)) };
   Vec2ui d{ uint32_t(ceilf(sx)),uint32_t(ceilf(sy)) };
 
-  float va = getValue(a.x, a.y);
-  float vb = getValue(b.x, b.y);
-  float vc = getValue(c.x, c.y);
-  float vd = getValue(d.x, d.y);
+  float va = GridCell<T>::magnitude(getValue(a.x, a.y));
+  float vb = GridCell<T>::magnitude(getValue(b.x, b.y));
+  float vc = GridCell<T>::magnitude(getValue(c.x, c.y));
+  float vd = GridCell<T>::magnitude(getValue(d.x, d.y));
 
   Vec3 n1 = Vec3::cross(Vec3(1.0f/width,(vb-va), 0.0f), Vec3(0.0f,(vc-va), 1.0f/height ));
   Vec3 n2 = Vec3::cross(Vec3(-1.0f/width,(vc - vd), 0.0f), Vec3(0.0f, (vb - vd), -1.0f/height));
@@ -139,329 +335,264 @@ Vec3 Grid2D::normal(float x, float y) const {
   return Vec3::normalize((n1 + n2) / 2.0f);
 }
 
-Grid2D Grid2D::genRandom(size_t x, size_t y, uint32_t seed) {
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::genRandom(size_t x, size_t y, uint32_t seed) {
   Random myrandom{seed};
-  Grid2D result{x,y};
-  for (size_t i = 0;i<result.data.size();++i) {
-    result.data[i] = myrandom.rand01();
-  }
+  Grid2Dt result{x,y};
+  std::vector<float> values(result.data.size()*GridCell<T>::components);
+  myrandom.fill01(values);
+  GridCell<T>::fromFloats(values.data(), result.data.data(), result.data.size());
   return result;
 }
 
-Grid2D Grid2D::genRandom(size_t x, size_t y) {
-  Grid2D result{x,y};
-  for (size_t i = 0;i<result.data.size();++i) {
-    result.data[i] = staticRand.rand01();
-  }
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::genRandom(size_t x, size_t y) {
+  Grid2Dt result{x,y};
+  std::vector<float> values(result.data.size()*GridCell<T>::components);
+  staticRand.fill01(values);
+  GridCell<T>::fromFloats(values.data(), result.data.data(), result.data.size());
   return result;
 }
 
-Grid2D Grid2D::operator*(const float& value) const {
-  Grid2D result{width,height};
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::operator*(const float& value) const {
+  Grid2Dt result{width,height,layout.getLayout()};
   for (size_t i = 0;i<result.data.size();++i) {
-    result.data[i] = data[i]*value;
+    result.data[i] = GridCell<T>::fromValue(GridCell<T>::toValue(data[i])*value);
   }
   return result;
 }
 
-Grid2D Grid2D::operator+(const float& value) const {
-  Grid2D result{width,height};
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::operator+(const float& value) const {
+  Grid2Dt result{width,height,layout.getLayout()};
   for (size_t i = 0;i<result.data.size();++i) {
-    result.data[i] = data[i]+value;
+    result.data[i] = GridCell<T>::fromValue(GridCell<T>::toValue(data[i])+value);
   }
   return result;
 }
 
-Grid2D Grid2D::operator-(const float& value) const {
-  Grid2D result{width,height};
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::operator-(const float& value) const {
+  Grid2Dt result{width,height,layout.getLayout()};
   for (size_t i = 0;i<result.data.size();++i) {
-    result.data[i] = data[i]-value;
+    result.data[i] = GridCell<T>::fromValue(GridCell<T>::toValue(data[i])-value);
   }
   return result;
 }
 
-Grid2D Grid2D::operator/(const float& value) const {
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::operator/(const float& value) const {
   return *this * (1.0f/value);
 }
 
-std::pair<size_t,size_t> Grid2D::findMaxSize(const Grid2D& other) const {
+template <typename T>
+std::pair<size_t,size_t> Grid2Dt<T>::findMaxSize(const Grid2Dt& other) const {
   return std::make_pair(std::max(width, other.width),
                         std::max(height, other.height));
 }
 
-
-Grid2D Grid2D::operator-(const Grid2D& other) const {
+template <typename T>
+template <typename F>
+Grid2Dt<T> Grid2Dt<T>::combine(const Grid2Dt& other, F op) const {
   std::pair<size_t,size_t> maxDims = findMaxSize(other);
-  Grid2D result{maxDims.first,maxDims.second};
-  
-  if (other.width == width && other.height == height) {
+  Grid2Dt result{maxDims.first,maxDims.second,layout.getLayout()};
+
+  if (other.width == width && other.height == height &&
+      other.layout.getLayout() == layout.getLayout()) {
     for (size_t i = 0;i<result.data.size();++i) {
-      result.data[i] = data[i] - other.data[i];
+      result.data[i] = GridCell<T>::fromValue(op(GridCell<T>::toValue(data[i]),
+                                                 GridCell<T>::toValue(other.data[i])));
     }
     return result;
   }
-    
-  size_t i=0;
 
-  if (maxDims.first == width && maxDims.second == height) {
-    for (size_t y = 0;y<maxDims.second;++y) {
+  // a grid of the result size is read directly, the other one resampled
+  const bool ownSize = maxDims.first == width && maxDims.second == height;
+  const bool otherSize = maxDims.first == other.width && maxDims.second == other.height;
+  result.layout.forEachTile([&](size_t x0, size_t y0, size_t x1, size_t y1) {
+    for (size_t y = y0;y<y1;++y) {
       const float normY = y/float(maxDims.second-1.0f);
-      for (size_t x = 0;x<maxDims.first;++x) {
+      for (size_t x = x0;x<x1;++x) {
         const float normX = x/float(maxDims.first-1.0f);
-        result.data[i] = data[i] - other.sample(normX,normY);
-        i++;
+        const Value a = ownSize ? getValue(x,y) : sample(normX,normY);
+        const Value b = otherSize ? other.getValue(x,y) : other.sample(normX,normY);
+        result.data[result.index(x,y)] = GridCell<T>::fromValue(op(a, b));
       }
     }
-    return result;
-  }
-  
-  if (maxDims.first == other.width && maxDims.second == other.height) {
-    for (size_t y = 0;y<maxDims.second;++y) {
-      const float normY = y/float(maxDims.second-1.0f);
-      for (size_t x = 0;x<maxDims.first;++x) {
-        const float normX = x/float(maxDims.first-1.0f);
-        result.data[i] = other.data[i] - sample(normX,normY);
-        i++;
-      }
-    }
-    return result;
-  }
-
-  for (size_t y = 0;y<maxDims.second;++y) {
-    const float normY = y/float(maxDims.second-1.0f);
-    for (size_t x = 0;x<maxDims.first;++x) {
-      const float normX = x/float(maxDims.first-1.0f);
-      result.data[i] = other.sample(normX, normY) - sample(normX,normY);
-      i++;
-    }
-  }
+  });
   return result;
 }
 
-Grid2D Grid2D::operator*(const Grid2D& other) const {
-  std::pair<size_t,size_t> maxDims = findMaxSize(other);
-  Grid2D result{maxDims.first,maxDims.second};
-  
-  if (other.width == width && other.height == height) {
-    for (size_t i = 0;i<result.data.size();++i) {
-      result.data[i] = data[i] * other.data[i];
-    }
-    return result;
-  }
-    
-  size_t i=0;
-
-  if (maxDims.first == width && maxDims.second == height) {
-    for (size_t y = 0;y<maxDims.second;++y) {
-      const float normY = y/float(maxDims.second-1.0f);
-      for (size_t x = 0;x<maxDims.first;++x) {
-        const float normX = x/float(maxDims.first-1.0f);
-        result.data[i] = data[i] * other.sample(normX,normY);
-        i++;
-      }
-    }
-    return result;
-  }
-  
-  if (maxDims.first == other.width && maxDims.second == other.height) {
-    for (size_t y = 0;y<maxDims.second;++y) {
-      const float normY = y/float(maxDims.second-1.0f);
-      for (size_t x = 0;x<maxDims.first;++x) {
-        const float normX = x/float(maxDims.first-1.0f);
-        result.data[i] = other.data[i] * sample(normX,normY);
-        i++;
-      }
-    }
-    return result;
-  }
-
-  for (size_t y = 0;y<maxDims.second;++y) {
-    const float normY = y/float(maxDims.second-1.0f);
-    for (size_t x = 0;x<maxDims.first;++x) {
-      const float normX = x/float(maxDims.first-1.0f);
-      result.data[i] = other.sample(normX, normY) * sample(normX,normY);
-      i++;
-    }
-  }
-  return result;
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::operator-(const Grid2Dt& other) const {
+  return combine(other, [](const Value& a, const Value& b) {return a - b;});
 }
 
-Grid2D Grid2D::operator/(const Grid2D& other) const {
-  std::pair<size_t,size_t> maxDims = findMaxSize(other);
-  Grid2D result{maxDims.first,maxDims.second};
-  
-  if (other.width == width && other.height == height) {
-    for (size_t i = 0;i<result.data.size();++i) {
-      result.data[i] = data[i] / other.data[i];
-    }
-    return result;
-  }
-    
-  size_t i=0;
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::operator*(const Grid2Dt& other) const {
+  return combine(other, [](const Value& a, const Value& b) {return a * b;});
+}
 
-  if (maxDims.first == width && maxDims.second == height) {
-    for (size_t y = 0;y<maxDims.second;++y) {
-      const float normY = y/float(maxDims.second-1.0f);
-      for (size_t x = 0;x<maxDims.first;++x) {
-        const float normX = x/float(maxDims.first-1.0f);
-        result.data[i] = data[i] / other.sample(normX,normY);
-        i++;
-      }
-    }
-    return result;
-  }
-  
-  if (maxDims.first == other.width && maxDims.second == other.height) {
-    for (size_t y = 0;y<maxDims.second;++y) {
-      const float normY = y/float(maxDims.second-1.0f);
-      for (size_t x = 0;x<maxDims.first;++x) {
-        const float normX = x/float(maxDims.first-1.0f);
-        result.data[i] = other.data[i] / sample(normX,normY);
-        i++;
-      }
-    }
-    return result;
-  }
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::operator/(const Grid2Dt& other) const {
+  return combine(other, [](const Value& a, const Value& b) {return a / b;});
+}
 
-  for (size_t y = 0;y<maxDims.second;++y) {
-    const float normY = y/float(maxDims.second-1.0f);
-    for (size_t x = 0;x<maxDims.first;++x) {
-      const float normX = x/float(maxDims.first-1.0f);
-      result.data[i] = other.sample(normX, normY) / sample(normX,normY);
-      i++;
-    }
-  }
-  return result;
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::operator+(const Grid2Dt& other) const {
+  return combine(other, [](const Value& a, const Value& b) {return a + b;});
 }
 
-Grid2D Grid2D::operator+(const Grid2D& other) const {
-  std::pair<size_t,size_t> maxDims = findMaxSize(other);
-  Grid2D result{maxDims.first,maxDims.second};
-  
-  if (other.width == width && other.height == height) {
-    for (size_t i = 0;i<result.data.size();++i) {
-      result.data[i] = data[i] + other.data[i];
-    }
-    return result;
-  }
-    
-  size_t i=0;
-  if (maxDims.first == width && maxDims.second == height) {
-    for (size_t y = 0;y<maxDims.second;++y) {
-      const float normY = y/float(maxDims.second-1.0f);
-      for (size_t x = 0;x<maxDims.first;++x) {
-        const float normX = x/float(maxDims.first-1.0f);
-        result.data[i] = data[i] + other.sample(normX,normY);
-        i++;
-      }
-    }
-    return result;
-  }
-  
-  if (maxDims.first == other.width && maxDims.second == other.height) {
-    for (size_t y = 0;y<maxDims.second;++y) {
-      const float normY = y/float(maxDims.second-1.0f);
-      for (size_t x = 0;x<maxDims.first;++x) {
-        const float normX = x/float(maxDims.first-1.0f);
-        result.data[i] = other.data[i] + sample(normX,normY);
-        i++;
+template <typename T>
+void Grid2Dt<T>::normalize(const float maxVal) {
+  if (data.empty()) return;
+
+  constexpr uint8_t components = GridCell<T>::components;
+  std::vector<float> values(data.size()*components);
+  GridCell<T>::toFloats(data.data(), values.data(), data.size());
+  float minValue = std::numeric_limits<float>::max();
+  float maxValue = std::numeric_limits<float>::lowest();
+  if (data.size() == width*height) {
+    const auto range = std::minmax_element(values.begin(), values.end());
+    minValue = *range.first;
+    maxValue = *range.second;
+  } else {
+    // the padding of partial tiles must not take part
+    layout.forEachCell([&](size_t, size_t, size_t i) {
+      for (size_t c = 0;c<components;++c) {
+        minValue = std::min(minValue, values[i*components+c]);
+        maxValue = std::max(maxValue, values[i*components+c]);
       }
-    }
-    return result;
+    });
   }
 
-  for (size_t y = 0;y<maxDims.second;++y) {
-    const float normY = y/float(maxDims.second-1.0f);
-    for (size_t x = 0;x<maxDims.first;++x) {
-      const float normX = x/float(maxDims.first-1.0f);
-      result.data[i] = other.sample(normX, normY) + sample(normX,normY);
-      i++;
-    }
-  }
-  return result;
-}
-    
-void Grid2D::normalize(const float maxVal) {
-  if (data.empty()) return;
-  
-  float minValue = data[0];
-  float maxValue = data[0];
-  for (size_t i = 0;i<data.size();++i) {
-    minValue = std::min(minValue, data[i]);
-    maxValue = std::max(maxValue, data[i]);
-  }
-  
   const float scale = maxVal/(maxValue-minValue);
-  for (size_t i = 0;i<data.size();++i) {
-    data[i] = (data[i]-minValue) * scale;
+  for (size_t i = 0;i<values.size();++i) {
+    values[i] = (values[i]-minValue) * scale;
   }
+  GridCell<T>::fromFloats(values.data(), data.data(), data.size());
 }
 
-Vec2t<size_t> Grid2D::maxValue() const {
-  float maxVal = std::numeric_limits<float>::min();
+template <typename T>
+Vec2t<size_t> Grid2Dt<T>::maxValue() const {
+  float maxVal = std::numeric_limits<float>::lowest();
   Vec2t<size_t> maxV{0,0};
-  for (size_t i = 0;i<data.size();++i) {
-    if (maxVal < data[i]) {
-      maxVal = data[i];
-      maxV = Vec2t<size_t>{size_t(i % width), size_t(i / width)};
+  layout.forEachCell([&](size_t x, size_t y, size_t i) {
+    const float v = GridCell<T>::magnitude(GridCell<T>::toValue(data[i]));
+    if (maxVal < v) {
+      maxVal = v;
+      maxV = Vec2t<size_t>{x, y};
     }
-  }
+  });
   return maxV;
 }
 
-Vec2t<size_t> Grid2D::minValue() const {
+template <typename T>
+Vec2t<size_t> Grid2Dt<T>::minValue() const {
   float minVal = std::numeric_limits<float>::max();
   Vec2t<size_t> minV{0,0};
-  for (size_t i = 0;i<data.size();++i) {
-    if (minVal > data[i]){
-      minVal = data[i];
-      minV = Vec2t<size_t>{size_t(i % width), size_t(i / width)};
+  layout.forEachCell([&](size_t x, size_t y, size_t i) {
+    const float v = GridCell<T>::magnitude(GridCell<T>::toValue(data[i]));
+    if (minVal > v){
+      minVal = v;
+      minV = Vec2t<size_t>{x, y};
     }
-  }
+  });
   return minV;
 }
 
-size_t Grid2D::index(size_t x, size_t y) const {
-  return x + y * width;
-}
-
-std::ostream& operator<<(std::ostream &os, const Grid2D& v) {
+template <typename T>
+std::ostream& operator<<(std::ostream &os, const Grid2Dt<T>& v) {
   os << v.toString() ; return os;
 }
 
-Grid2D Grid2D::fromBMP(const std::string& filename) {
-  Image bmp = BMP::load(filename);
-  
-  Grid2D g{bmp.width, bmp.height};
-  
-  size_t i = 0;
-  for (size_t y = 0;y<g.height;++y) {
-    for (size_t x = 0;x<g.width;++x) {
-      g.data[i] = bmp.getValue(uint32_t(x),uint32_t(y),0)/255.0f;
-      i++;
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::fromBMP(const std::string& filename) {
+  return Grid2Dt{BMP::load(filename)};
+}
+
+template <typename T>
+template <typename F>
+Grid2Dt<T> Grid2Dt<T>::areaMeans(size_t newWidth, size_t newHeight, F region) const {
+  constexpr uint8_t components = GridCell<T>::components;
+  const SummedAreaTable table(*this);
+  Grid2Dt result(newWidth, newHeight, layout.getLayout());
+  Parallel::forRange(0, newHeight, [&](size_t begin, size_t end) {
+    float means[components];
+    double r[4];
+    for (size_t y = begin;y<end;++y) {
+      for (size_t x = 0;x<newWidth;++x) {
+        region(x, y, r);
+        for (uint8_t c = 0;c<components;++c) {
+          means[c] = float(table.mean(r[0], r[1], r[2], r[3], c));
+        }
+        GridCell<T>::fromFloats(means, &result.data[result.index(x,y)], 1);
+      }
     }
-  }
+  }, 16);
+  return result;
+}
+
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::boxFilter(size_t radius) const {
+  return areaMeans(width, height, [&](size_t x, size_t y, double* r) {
+    r[0] = double(x > radius ? x-radius : 0);
+    r[1] = double(y > radius ? y-radius : 0);
+    r[2] = double(x+radius+1);
+    r[3] = double(y+radius+1);
+  });
+}
+
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::downsample(size_t factor) const {
+  factor = std::max<size_t>(factor, 1);
+  return areaMeans((width+factor-1)/factor, (height+factor-1)/factor,
+                   [&](size_t x, size_t y, double* r) {
+    r[0] = double(x*factor);
+    r[1] = double(y*factor);
+    r[2] = double((x+1)*factor);
+    r[3] = double((y+1)*factor);
+  });
+}
 
-  return g;
+template <typename T>
+Grid2Dt<T> Grid2Dt<T>::resampleArea(size_t newWidth, size_t newHeight) const {
+  const double scaleX = double(width)/newWidth;
+  const double scaleY = double(height)/newHeight;
+  return areaMeans(newWidth, newHeight, [&](size_t x, size_t y, double* r) {
+    r[0] = x*scaleX;
+    r[1] = y*scaleY;
+    r[2] = (x+1)*scaleX;
+    r[3] = (y+1)*scaleY;
+  });
 }
 
-void Grid2D::fill(float value) {
-  std::fill(data.begin(), data.end(), value);
+template <typename T>
+void Grid2Dt<T>::fill(const Value& value) {
+  std::fill(data.begin(), data.end(), GridCell<T>::fromValue(value));
 }
 
-Grid2D::Grid2D(std::istream &is) {
+template <typename T>
+Grid2Dt<T>::Grid2Dt(std::istream &is) {
   is.read((char*)&width, sizeof (width));
   is.read((char*)&height, sizeof (height));
-  
+
+  layout = GridLayout(width, height);
   data.resize(width*height);
-  is.read((char*)data.data(), sizeof(float) * uint32_t(width) *
+  is.read((char*)data.data(), sizeof(T) * uint32_t(width) *
           uint32_t(height));
 }
 
-void Grid2D::save(std::ostream &os) const {
+template <typename T>
+void Grid2Dt<T>::save(std::ostream &os) const {
+  if (layout.getLayout() != MemoryLayout::Linear) {
+    toLayout(MemoryLayout::Linear).save(os);
+    return;
+  }
   os.write((char*)&width, sizeof (width));
   os.write((char*)&height, sizeof (height));
-  os.write((char*)data.data(), sizeof(float) * uint32_t(width) *
+  os.write((char*)data.data(), sizeof(T) * uint32_t(width) *
            uint32_t(height));
 }
 
@@ -476,21 +607,24 @@ static float dist(size_t x, size_t y, const Vec2ui& p) {
                 (y-float(p.y))*(y-float(p.y)));
 }
 
-Grid2D Grid2D::toSignedDistance(float threshold) const {
-  Grid2D r(width, height);
-  
-  std::vector<bool> I(width*height);
-  std::vector<Vec2ui> p(width*height);
-  
+template <typename T>
+Grid2Dt<float> Grid2Dt<T>::toSignedDistance(float threshold) const {
+  // the scans address cells through index(), so tiled grids keep the
+  // vertical neighbours of a row in cache
+  Grid2Dt<float> r(width, height, layout.getLayout());
+
+  std::vector<bool> I(data.size());
+  std::vector<Vec2ui> p(data.size());
+
   for (size_t i = 0;i<I.size();++i) {
-    I[i] = data[i] >= threshold;
+    I[i] = GridCell<T>::magnitude(GridCell<T>::toValue(data[i])) >= threshold;
   }
 
   for (size_t i = 0;i<I.size();++i) {
     r.data[i] = INV;
     p[i] = NO_POS;
   }
-  
+
   for (size_t y = 1; y<height-1; y++ ) {
     for (size_t x = 1; x<width-1; x++ ) {
       const size_t i = index(x,y);
@@ -503,7 +637,7 @@ Grid2D Grid2D::toSignedDistance(float threshold) const {
       }
     }
   }
- 
+
   for (size_t y = 1; y<height-1; y++ ) {
     for (size_t x = 1; x<width-1; x++ ) {
       const size_t i = index(x,y);
@@ -525,7 +659,7 @@ Grid2D Grid2D::toSignedDistance(float threshold) const {
       }
     }
   }
-  
+
   for (size_t y = height-2; y>=1; y-- ) {
     for (size_t x = width-2; x>=1; x--) {
       const size_t i = index(x,y);
@@ -547,16 +681,52 @@ Grid2D Grid2D::toSignedDistance(float threshold) const {
       }
     }
   }
-  
+
   for (size_t i = 0;i<I.size();++i) {
     if (!I[i]) r.data[i] = -r.data[i];
   }
-  
+
   return r;
 }
 
-GLTexture2D Grid2D::toTexture() const {
+template <typename T>
+GLTexture2D Grid2Dt<T>::toTexture() const {
   GLTexture2D result;
-  result.setData(data, uint32_t(width), uint32_t(height), 1);
+  toTexture(result);
   return result;
 }
+
+template <typename T>
+void Grid2Dt<T>::toTexture(GLTexture2D& texture) const {
+  if (layout.getLayout() != MemoryLayout::Linear) {
+    toLayout(MemoryLayout::Linear).toTexture(texture);
+    return;
+  }
+  const uint32_t w = uint32_t(width);
+  const uint32_t h = uint32_t(height);
+  if constexpr (std::is_same_v<T, uint8_t> || std::is_same_v<T, float>) {
+    texture.setData(data, w, h, 1);
+  } else if constexpr (std::is_same_v<T, Half>) {
+    std::vector<GLhalf> bits(data.size());
+    std::memcpy(bits.data(), data.data(), data.size()*sizeof(Half));
+    texture.setData(bits, w, h, 1);
+  } else {
+    std::vector<GLfloat> values(data.size()*GridCell<T>::components);
+    GridCell<T>::toFloats(data.data(), values.data(), data.size());
+    texture.setData(values, w, h, GridCell<T>::components);
+  }
+}
+
+template class Grid2Dt<uint8_t>;
+template class Grid2Dt<uint16_t>;
+template class Grid2Dt<Half>;
+template class Grid2Dt<float>;
+template class Grid2Dt<Vec2>;
+template class Grid2Dt<Vec3>;
+
+template std::ostream& operator<<(std::ostream&, const Grid2Dt<uint8_t>&);
+template std::ostream& operator<<(std::ostream&, const Grid2Dt<uint16_t>&);
+template std::ostream& operator<<(std::ostream&, const Grid2Dt<Half>&);
+template std::ostream& operator<<(std::ostream&, const Grid2Dt<float>&);
+template std::ostream& operator<<(std::ostream&, const Grid2Dt<Vec2>&);
+template std::ostream& operator<<(std::ostream&, const Grid2Dt<Vec3>&);
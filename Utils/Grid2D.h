@@ -3,67 +3,173 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <algorithm>
 
 #include "Vec2.h"
 #include "Vec3.h"
+#include "Half.h"
 #include "Image.h"
 #include "GLTexture2D.h"
 
 /**
  * @file Grid2D.h
- * @brief 2D scalar grid (float) with sampling, arithmetic, SDF, and I/O helpers.
+ * @brief 2D grid of scalar or vector cells with sampling, arithmetic, SDF, and I/O helpers.
  *
- * Represents a width×height grid of single‑precision values stored in row‑major
- * order. Provides bilinear sampling in normalized coordinates, gradient‑based
- * normal estimation, per‑element arithmetic (with scalars and other grids, with
- * automatic size reconciliation), conversion to images / textures, and simple
- * binary streaming.
+ * Represents a width×height grid stored in row‑major order, or in 64×64
+ * tiles for neighbourhood‑heavy work on large grids (see @ref GridLayout).
+ * The cell type
+ * \c T only decides the storage; all accessors work on values (see
+ * @ref GridCell):
+ * - \c uint8_t and \c uint16_t are normalized integers, stored 0..max and
+ *   read as floats in [0,1] (1 and 2 bytes per cell),
+ * - @ref Half and \c float are read as floats (2 and 4 bytes per cell),
+ * - @ref Vec2 and @ref Vec3 are read as vectors.
+ *
+ * So masks and glyphs fit in bytes, heightfields in 16 bits, and the same
+ * code samples all of them. Provides bilinear sampling in normalized
+ * coordinates, gradient‑based normal estimation, per‑element arithmetic (with
+ * scalars and other grids, with automatic size reconciliation), conversion to
+ * images / textures (uploading the native type), and simple binary streaming.
  *
  * @details Unless stated otherwise, functions interpret normalized positions
  * (x,y) with 0 at the left/bottom and 1 at the right/top, and clamp to
  * [0,1]. When combining two grids of different sizes, operations resample the
  * smaller grid to the larger grid's resolution using bilinear sampling.
+ * Conversions between cell types (@ref Grid2Dt::convert()) run in SIMD
+ * chunks. Sampling, normals, arithmetic and the distance transform work on
+ * any layout; only save(), toByteArray() and toTexture() linearize.
+ *
+ * @code
+ * Grid2Du8 mask(image);                       // 1 byte per cell, no float copy
+ * Grid2D sdf = mask.toSignedDistance(0.5f);   // float grid
+ * Grid2Dh compact = sdf.convert<Half>();      // half the memory of sdf
+ * GLTexture2D texture = compact.toTexture();  // uploaded as GL_HALF_FLOAT
+ * @endcode
  */
-class Grid2D {
+
+/**
+ * @brief Storage traits of a grid cell type.
+ *
+ * Specialized for \c uint8_t, \c uint16_t, @ref Half, \c float, @ref Vec2 and
+ * @ref Vec3. Provides the value type, value conversions, and bulk conversions
+ * to and from interleaved floats.
+ */
+template <typename T> struct GridCell;
+
+template <> struct GridCell<uint8_t> {
+  typedef float Value;
+  static constexpr uint8_t components = 1;
+  static float toValue(uint8_t cell) {return float(cell)*(1.0f/255.0f);}
+  static uint8_t fromValue(float value) {return uint8_t(std::clamp(value, 0.0f, 1.0f)*255.0f + 0.5f);}
+  static float magnitude(float value) {return value;}
+  static void toFloats(const uint8_t* in, float* out, size_t count);
+  static void fromFloats(const float* in, uint8_t* out, size_t count);
+};
+
+template <> struct GridCell<uint16_t> {
+  typedef float Value;
+  static constexpr uint8_t components = 1;
+  static float toValue(uint16_t cell) {return float(cell)*(1.0f/65535.0f);}
+  static uint16_t fromValue(float value) {return uint16_t(std::clamp(value, 0.0f, 1.0f)*65535.0f + 0.5f);}
+  static float magnitude(float value) {return value;}
+  static void toFloats(const uint16_t* in, float* out, size_t count);
+  static void fromFloats(const float* in, uint16_t* out, size_t count);
+};
+
+template <> struct GridCell<Half> {
+  typedef float Value;
+  static constexpr uint8_t components = 1;
+  static float toValue(Half cell) {return float(cell);}
+  static Half fromValue(float value) {return Half(value);}
+  static float magnitude(float value) {return value;}
+  static void toFloats(const Half* in, float* out, size_t count);
+  static void fromFloats(const float* in, Half* out, size_t count);
+};
+
+template <> struct GridCell<float> {
+  typedef float Value;
+  static constexpr uint8_t components = 1;
+  static float toValue(float cell) {return cell;}
+  static float fromValue(float value) {return value;}
+  static float magnitude(float value) {return value;}
+  static void toFloats(const float* in, float* out, size_t count);
+  static void fromFloats(const float* in, float* out, size_t count);
+};
+
+template <> struct GridCell<Vec2> {
+  typedef Vec2 Value;
+  static constexpr uint8_t components = 2;
+  static Vec2 toValue(const Vec2& cell) {return cell;}
+  static Vec2 fromValue(const Vec2& value) {return value;}
+  static float magnitude(const Vec2& value) {return value.length();}
+  static void toFloats(const Vec2* in, float* out, size_t count);
+  static void fromFloats(const float* in, Vec2* out, size_t count);
+};
+
+template <> struct GridCell<Vec3> {
+  typedef Vec3 Value;
+  static constexpr uint8_t components = 3;
+  static Vec3 toValue(const Vec3& cell) {return cell;}
+  static Vec3 fromValue(const Vec3& value) {return value;}
+  static float magnitude(const Vec3& value) {return value.length();}
+  static void toFloats(const Vec3* in, float* out, size_t count);
+  static void fromFloats(const float* in, Vec3* out, size_t count);
+};
+
+template <typename T>
+class Grid2Dt {
 public:
+  /** @brief Value type returned by getValue() and sample(): float or a vector. */
+  typedef typename GridCell<T>::Value Value;
+
   /**
    * @brief Construct an empty grid initialized to zeros.
    * @param width  Number of columns.
    * @param height Number of rows.
+   * @param layout Storage order of the cells.
    */
-  Grid2D(size_t width, size_t height);
+  Grid2Dt(size_t width, size_t height, MemoryLayout layout=MemoryLayout::Linear);
 
   /**
-   * @brief Construct from raw data (size must equal width*height).
+   * @brief Construct from raw cells (size must equal width*height).
    * @param width  Number of columns.
    * @param height Number of rows.
-   * @param data   Row‑major values copied into the grid.
+   * @param data   Row‑major cells copied into the grid.
    * @throw std::runtime_error If @p data.size() != width*height.
    */
-  Grid2D(size_t width, size_t height, const std::vector<float> data);
+  Grid2Dt(size_t width, size_t height, const std::vector<T> data);
 
   /**
    * @brief Copy‑construct from another grid.
    * @param other Source grid.
    */
-  Grid2D(const Grid2D& other);
+  Grid2Dt(const Grid2Dt& other);
+
+  /** @brief Move‑construct, taking over the cells of @p other. */
+  Grid2Dt(Grid2Dt&& other) = default;
+  Grid2Dt& operator=(const Grid2Dt& other) = default;
+  Grid2Dt& operator=(Grid2Dt&& other) = default;
 
   /**
-   * @brief Construct from the luminance of an @ref Image.
-   * @param image Source image; the first channel is sampled and normalized to
-   *              [0,1]. Width/height match the image.
+   * @brief Construct from the channels of an @ref Image.
+   * @param image Source image; scalar grids take the first channel, vector
+   *              grids the first two/three. Byte grids copy the bytes,
+   *              other types are normalized to [0,1]. Width/height and
+   *              memory layout match the image.
    */
-  Grid2D(const Image& image);
+  Grid2Dt(const Image& image);
 
   /**
    * @brief Read grid from a binary stream written by @ref save().
-   * @param is Input stream; reads width, height, then width*height floats.
+   * @param is Input stream; reads width, height, then width*height cells.
    */
-  Grid2D(std::istream &is);
+  Grid2Dt(std::istream &is);
 
   /**
    * @brief Write grid to a binary stream.
-   * @param os Output stream; writes width, height, then width*height floats.
+   * @param os Output stream; writes width, height, then width*height cells
+   *           in row‑major order.
    */
   void save(std::ostream &os) const;
 
@@ -75,6 +181,18 @@ public:
   size_t getHeight() const;
   ///@}
 
+  /** @brief Cells in their storage type, ordered by @ref getLayout(). */
+  const std::vector<T>& getData() const {return data;}
+
+  /** @brief Memory layout of the cells, use it to address and traverse @ref getData(). */
+  const GridLayout& getLayout() const {return layout;}
+
+  /**
+   * @brief Copy of the grid with the cells stored in another order.
+   * @param layout Target memory layout.
+   */
+  Grid2Dt toLayout(MemoryLayout layout) const;
+
   /**
    * @brief String dump of values in row‑major order.
    * @return CSV‑like multiline representation.
@@ -82,32 +200,63 @@ public:
   std::string toString() const;
 
   /**
-   * @brief Convert to an 8‑bit RGB byte array (grayscale replicated to RGB).
+   * @brief Convert to an 8‑bit RGB byte array (scalars replicated to RGB,
+   *        vectors mapped to the first channels).
    * @return Vector of size width*height*3 with bytes in 0..255.
    */
   std::vector<uint8_t> toByteArray() const;
 
   /**
    * @brief Compute a signed distance field from a binary threshold.
-   * @param threshold Values ≥ threshold are considered inside.
+   * @param threshold Values ≥ threshold are considered inside (vectors compare
+   *                  their length).
    * @return Grid whose values are distances to the nearest boundary, positive
    *         inside and negative outside.
    */
-  Grid2D toSignedDistance(float threshold) const;
+  Grid2Dt<float> toSignedDistance(float threshold) const;
 
   /**
-   * @brief Upload to an OpenGL texture (1 channel).
+   * @brief Upload to an OpenGL texture (1 to 3 channels).
+   *
+   * Bytes, halfs and floats are uploaded as they are stored; 16 bit cells are
+   * widened to float, since GLES/WebGL lack 16 bit normalized textures.
    * @return GLTexture2D with dimensions width×height.
    */
   GLTexture2D toTexture() const;
 
+  /**
+   * @brief Upload into an existing texture, keeping its sampler parameters.
+   * @param texture Target texture, resized to width×height.
+   */
+  void toTexture(GLTexture2D& texture) const;
+
+  /**
+   * @brief Convert to another cell type with the same number of components.
+   *
+   * Values are kept; converting to a normalized integer type clamps to [0,1].
+   * @tparam U Target cell type.
+   */
+  template <typename U> Grid2Dt<U> convert() const {
+    static_assert(GridCell<U>::components == GridCell<T>::components,
+                  "conversion needs the same number of components");
+    constexpr size_t chunk = 1024;
+    Grid2Dt<U> result(width, height, layout.getLayout());
+    float buffer[chunk*GridCell<T>::components];
+    for (size_t i = 0;i<data.size();i+=chunk) {
+      const size_t count = std::min(chunk, data.size()-i);
+      GridCell<T>::toFloats(data.data()+i, buffer, count);
+      GridCell<U>::fromFloats(buffer, result.data.data()+i, count);
+    }
+    return result;
+  }
+
   /**
    * @brief Set one value.
    * @param x Column index in [0,width).
    * @param y Row index in [0,height).
-   * @param value New value.
+   * @param value New value, converted to the cell type.
    */
-  void setValue(size_t x, size_t y, float value);
+  void setValue(size_t x, size_t y, const Value& value);
 
   /**
    * @brief Fetch value using normalized [0,1] coordinates (nearest‑neighbor via index mapping).
@@ -115,7 +264,7 @@ public:
    * @param y Normalized y.
    * @return Value at floor(x*(width−1)), floor(y*(height−1)).
    */
-  float getValueNormalized(float x, float y) const;
+  Value getValueNormalized(float x, float y) const;
 
   /**
    * @brief Fetch value by integer coordinates.
@@ -123,7 +272,12 @@ public:
    * @param y Row index.
    * @return Stored value.
    */
-  float getValue(size_t x, size_t y) const;
+  Value getValue(size_t x, size_t y) const;
+
+  /** @brief Raw cell at integer coordinates. */
+  const T& getCell(size_t x, size_t y) const {return data[index(x,y)];}
+  /** @brief Overwrite the raw cell at integer coordinates. */
+  void setCell(size_t x, size_t y, const T& cell) {data[index(x,y)] = cell;}
 
   /**
    * @brief Bilinear sample at normalized coordinates in [0,1].
@@ -131,18 +285,18 @@ public:
    * @param y Normalized y.
    * @return Interpolated value.
    */
-  float sample(float x, float y) const ;
+  Value sample(float x, float y) const ;
 
   /**
    * @brief Bilinear sample at normalized coordinates in [0,1].
    * @param pos (x,y) normalized position.
    */
-  float sample(const Vec2& pos) const ;
+  Value sample(const Vec2& pos) const ;
 
   /**
    * @brief Estimate a normal from local height differences at normalized coords.
    * @param x,y Normalized coordinates.
-   * @return Unit normal approximating ∇height.
+   * @return Unit normal approximating ∇height (vectors use their length as height).
    */
   Vec3 normal(float x, float y) const;
 
@@ -158,88 +312,149 @@ public:
    * @param y Height.
    * @param seed Seed for the RNG.
    */
-  static Grid2D genRandom(size_t x, size_t y, uint32_t seed);
+  static Grid2Dt genRandom(size_t x, size_t y, uint32_t seed);
 
   /**
    * @brief Generate a grid of random values in [0,1) using a global RNG.
    * @param x Width.
    * @param y Height.
    */
-  static Grid2D genRandom(size_t x, size_t y);
+  static Grid2Dt genRandom(size_t x, size_t y);
 
   // ===== Scalar arithmetic =====
   /** @brief Per‑element multiply by scalar. */
-  Grid2D operator*(const float& value) const;
+  Grid2Dt operator*(const float& value) const;
   /** @brief Per‑element divide by scalar. */
-  Grid2D operator/(const float& value) const;
+  Grid2Dt operator/(const float& value) const;
   /** @brief Per‑element add scalar. */
-  Grid2D operator+(const float& value) const;
+  Grid2Dt operator+(const float& value) const;
   /** @brief Per‑element subtract scalar. */
-  Grid2D operator-(const float& value) const;
+  Grid2Dt operator-(const float& value) const;
 
   // ===== Grid‑wise arithmetic (size reconciliation by resampling) =====
   /** @brief Per‑element addition with resampling if needed. */
-  Grid2D operator+(const Grid2D& other) const;
+  Grid2Dt operator+(const Grid2Dt& other) const;
   /** @brief Per‑element division with resampling if needed. */
-  Grid2D operator/(const Grid2D& other) const;
+  Grid2Dt operator/(const Grid2Dt& other) const;
   /** @brief Per‑element multiplication with resampling if needed. */
-  Grid2D operator*(const Grid2D& other) const;
+  Grid2Dt operator*(const Grid2Dt& other) const;
   /** @brief Per‑element subtraction with resampling if needed. */
-  Grid2D operator-(const Grid2D& other) const;
+  Grid2Dt operator-(const Grid2Dt& other) const;
 
   /**
    * @brief Normalize values to [0,maxVal] by affine remapping.
+   *
+   * Vector grids use the minimum and maximum over all components.
    * @param maxVal Upper bound after normalization (default 1).
    */
   void normalize(const float maxVal = 1);
 
   /**
-   * @brief Location of the maximum value.
-   * @return Integer coordinates (x,y) of the first maximum encountered.
+   * @brief Location of the maximum value (vectors compare their length).
+   * @return Integer coordinates (x,y) of the first maximum in storage order.
    */
   Vec2t<size_t> maxValue() const;
 
   /**
-   * @brief Location of the minimum value.
-   * @return Integer coordinates (x,y) of the first minimum encountered.
+   * @brief Location of the minimum value (vectors compare their length).
+   * @return Integer coordinates (x,y) of the first minimum in storage order.
    */
   Vec2t<size_t> minValue() const;
 
   /**
-   * @brief Fill all elements with a constant.
-   * @param value Value to assign.
+   * @brief Mean over a (2·radius+1)² window, clipped at the borders.
+   *
+   * Built on a @ref SummedAreaTable, so the cost does not depend on
+   * @p radius.
+   * @return Filtered grid in the same layout.
+   */
+  Grid2Dt boxFilter(size_t radius) const;
+
+  /**
+   * @brief Average factor×factor blocks (summed‑area table, O(1) per cell).
+   * @param factor Reduction factor ≥ 1.
+   * @return Grid of ⌈width/factor⌉×⌈height/factor⌉ cells; partial blocks are
+   *         averaged over their covered cells.
+   */
+  Grid2Dt downsample(size_t factor) const;
+
+  /**
+   * @brief Area‑average resample to an arbitrary size.
+   *
+   * Each target cell is the exact area‑weighted mean of the source cells it
+   * covers.
+   * @param newWidth  Target width.
+   * @param newHeight Target height.
    */
-  void fill(float value);
+  Grid2Dt resampleArea(size_t newWidth, size_t newHeight) const;
 
   /**
-   * @brief Stream insertion (delegates to @ref toString()).
+   * @brief Fill all elements with a constant.
+   * @param value Value to assign.
    */
-  friend std::ostream& operator<<(std::ostream &os, const Grid2D& v);
+  void fill(const Value& value);
 
   /**
-   * @brief Create a grid from the luminance of a BMP file.
+   * @brief Create a grid from the channels of a BMP file.
    * @param filename Path to the BMP image.
    * @return Grid with width/height of the image; values in [0,1].
    */
-  static Grid2D fromBMP(const std::string& filename);
+  static Grid2Dt fromBMP(const std::string& filename);
 
 private:
-  size_t width;               ///< Number of columns.
-  size_t height;              ///< Number of rows.
-  std::vector<float> data{};  ///< Row‑major storage of size width*height.
+  size_t width;           ///< Number of columns.
+  size_t height;          ///< Number of rows.
+  GridLayout layout;      ///< Cell order of @ref data.
+  std::vector<T> data{};  ///< Storage of size layout.size().
+
+  template <typename U> friend class Grid2Dt;
 
   /**
-   * @brief Convert (x,y) to a flat index (row‑major).
+   * @brief Convert (x,y) to a flat index in the grid's layout.
    * @param x Column index.
    * @param y Row index.
-   * @return x + y*width.
+   * @return x + y*width for linear grids.
    */
-  size_t index(size_t x, size_t y) const;
+  size_t index(size_t x, size_t y) const {return layout.index(x,y);}
 
   /**
    * @brief Determine the per‑dimension max(width,height) between two grids.
    * @param other Grid to compare against.
    * @return Pair (maxWidth,maxHeight).
    */
-  std::pair<size_t,size_t> findMaxSize(const Grid2D& other) const;
+  std::pair<size_t,size_t> findMaxSize(const Grid2Dt& other) const;
+
+  /**
+   * @brief Per‑element op(this, other), resampling the smaller grid.
+   * @param other Second operand.
+   * @param op    Callable op(Value, Value) -> Value.
+   */
+  template <typename F> Grid2Dt combine(const Grid2Dt& other, F op) const;
+
+  /**
+   * @brief Fill a newWidth×newHeight grid with area means of this grid.
+   * @param region Callable region(x, y, double* r) that writes the source
+   *               rectangle of target cell (x,y) to r[0..3] as x0, y0, x1, y1
+   *               (half-open, in source cells, see SummedAreaTable::mean()).
+   */
+  template <typename F> Grid2Dt areaMeans(size_t newWidth, size_t newHeight, F region) const;
 };
+
+/**
+ * @brief Stream insertion (delegates to @ref Grid2Dt::toString()).
+ */
+template <typename T>
+std::ostream& operator<<(std::ostream &os, const Grid2Dt<T>& v);
+
+/** @brief Float grid, the default. */
+typedef Grid2Dt<float> Grid2D;
+/** @brief Grid of normalized bytes, e.g. masks and glyphs. */
+typedef Grid2Dt<uint8_t> Grid2Du8;
+/** @brief Grid of normalized 16 bit values, e.g. heightfields. */
+typedef Grid2Dt<uint16_t> Grid2Du16;
+/** @brief Grid of half floats, e.g. distance fields. */
+typedef Grid2Dt<Half> Grid2Dh;
+/** @brief Grid of 2D vectors, e.g. flow fields. */
+typedef Grid2Dt<Vec2> Grid2DVec2;
+/** @brief Grid of 3D vectors, e.g. normal maps. */
+typedef Grid2Dt<Vec3> Grid2DVec3;
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+/**
+ * @file GridLayout.h
+ * @brief Memory layouts for 2D cell arrays (grids and images).
+ *
+ * Row‑major storage keeps horizontal neighbours together, but vertical
+ * neighbours are a full row apart: on large grids every vertical step of a
+ * neighbourhood kernel is a cache miss. The blocked layouts store the grid
+ * in 64×64 tiles, tiles in row‑major order:
+ * - \c Linear: plain row‑major, what files and OpenGL expect,
+ * - \c Tiled:  row‑major cells inside each tile,
+ * - \c Morton: Z‑order cells inside each tile, so any 2×2, 4×4, … block is
+ *   contiguous as well.
+ *
+ * Blocked layouts round the storage up to whole tiles; the padding cells
+ * are never visited by @ref GridLayout::forEachCell(). Kernels address cells
+ * through @ref GridLayout::index() and walk the grid with
+ * @ref GridLayout::forEachTile(), so they run on every layout; conversion to
+ * \c Linear (@ref GridLayout::convert()) is only needed for upload and save.
+ *
+ * @code
+ * const GridLayout layout(4096, 4096, MemoryLayout::Tiled);
+ * std::vector<float> cells(layout.size());
+ * layout.forEachTile([&](size_t x0, size_t y0, size_t x1, size_t y1) {
+ *   for (size_t y = y0;y<y1;++y)
+ *     for (size_t x = x0;x<x1;++x) cells[layout.index(x,y)] = f(x,y);
+ * });
+ * @endcode
+ */
+
+/** @brief Order of the cells of a 2D array in memory. */
+enum class MemoryLayout {
+  Linear,  ///< Row‑major.
+  Tiled,   ///< 64×64 tiles, row‑major inside each tile.
+  Morton   ///< 64×64 tiles, Z‑order inside each tile.
+};
+
+class GridLayout {
+public:
+  static constexpr size_t tileBits = 6;                ///< log2 of the tile edge.
+  static constexpr size_t tileSize = 1 << tileBits;    ///< Tile edge in cells.
+  static constexpr size_t tileCells = tileSize*tileSize;
+
+  /**
+   * @brief Describe a width×height array in the given layout.
+   * @param width  Number of columns.
+   * @param height Number of rows.
+   * @param layout Cell order.
+   */
+  GridLayout(size_t width=0, size_t height=0, MemoryLayout layout=MemoryLayout::Linear) :
+    width(width),
+    height(height),
+    tilesX((width+tileSize-1) >> tileBits),
+    tilesY((height+tileSize-1) >> tileBits),
+    layout(layout)
+  {}
+
+  size_t getWidth() const {return width;}
+  size_t getHeight() const {return height;}
+  MemoryLayout getLayout() const {return layout;}
+
+  /** @brief Number of cells to allocate, including the padding of partial tiles. */
+  size_t size() const {
+    return layout == MemoryLayout::Linear ? width*height : tilesX*tilesY*tileCells;
+  }
+
+  /**
+   * @brief Storage index of the cell at column @p x and row @p y.
+   * @return Offset in cells, multiply by the component count for interleaved data.
+   */
+  size_t index(size_t x, size_t y) const {
+    if (layout == MemoryLayout::Linear) return x + y*width;
+    const size_t tile = ((y >> tileBits)*tilesX + (x >> tileBits)) << (2*tileBits);
+    const size_t lx = x & (tileSize-1);
+    const size_t ly = y & (tileSize-1);
+    if (layout == MemoryLayout::Tiled) return tile | (ly << tileBits) | lx;
+    return tile | spread(lx) | (spread(ly) << 1);
+  }
+
+  /**
+   * @brief Visit the grid in 64×64 blocks, in storage order.
+   * @param f Callable f(x0, y0, x1, y1) receiving the half‑open cell range of
+   *          one block, clipped to the grid. Linear grids are visited in the
+   *          same blocks, so blocked traversals also help there.
+   */
+  template <typename F> void forEachTile(F f) const {
+    for (size_t ty = 0;ty<tilesY;++ty) {
+      for (size_t tx = 0;tx<tilesX;++tx) {
+        const size_t x0 = tx << tileBits;
+        const size_t y0 = ty << tileBits;
+        f(x0, y0, std::min(x0+tileSize, width), std::min(y0+tileSize, height));
+      }
+    }
+  }
+
+  /**
+   * @brief Visit every cell in storage order, skipping padding.
+   * @param f Callable f(x, y, index).
+   */
+  template <typename F> void forEachCell(F f) const {
+    if (layout == MemoryLayout::Linear) {
+      size_t i = 0;
+      for (size_t y = 0;y<height;++y) {
+        for (size_t x = 0;x<width;++x) f(x, y, i++);
+      }
+      return;
+    }
+    size_t base = 0;
+    forEachTile([&](size_t x0, size_t y0, size_t x1, size_t y1) {
+      if (layout == MemoryLayout::Tiled) {
+        for (size_t y = y0;y<y1;++y) {
+          for (size_t x = x0;x<x1;++x) {
+            f(x, y, base + ((y-y0) << tileBits) + (x-x0));
+          }
+        }
+      } else {
+        for (size_t k = 0;k<tileCells;++k) {
+          const size_t x = x0 + compact(k);
+          const size_t y = y0 + compact(k >> 1);
+          if (x < x1 && y < y1) f(x, y, base + k);
+        }
+      }
+      base += tileCells;
+    });
+  }
+
+  /**
+   * @brief Copy interleaved cells between two layouts of the same size.
+   * @param from       Layout of @p in.
+   * @param in         Source cells.
+   * @param to         Layout of @p out, must have the same width and height.
+   * @param out        Destination, at least to.size()*components elements.
+   * @param components Interleaved elements per cell.
+   */
+  template <typename T>
+  static void convert(const GridLayout& from, const T* in,
+                      const GridLayout& to, T* out, size_t components=1) {
+    from.forEachTile([&](size_t x0, size_t y0, size_t x1, size_t y1) {
+      for (size_t y = y0;y<y1;++y) {
+        for (size_t x = x0;x<x1;++x) {
+          const T* src = in + from.index(x,y)*components;
+          T* dst = out + to.index(x,y)*components;
+          for (size_t c = 0;c<components;++c) dst[c] = src[c];
+        }
+      }
+    });
+  }
+
+private:
+  size_t width;
+  size_t height;
+  size_t tilesX;
+  size_t tilesY;
+  MemoryLayout layout;
+
+  /** @brief Move the 6 bits of @p v to the even bit positions. */
+  static size_t spread(size_t v) {
+    v = (v | (v << 4)) & 0x0F0F;
+    v = (v | (v << 2)) & 0x3333;
+    return (v | (v << 1)) & 0x5555;
+  }
+
+  /** @brief Inverse of @ref spread(), gathers the even bits of @p v. */
+  static size_t compact(size_t v) {
+    v &= 0x5555;
+    v = (v | (v >> 1)) & 0x3333;
+    v = (v | (v >> 2)) & 0x0F0F;
+    return (v | (v >> 4)) & 0x003F;
+  }
+};
@@ -0,0 +1,92 @@
+#include <cstring>
+
+// GCC and Clang need -mf16c (AVX2 alone does not imply it), MSVC has no
+// F16C macro but every AVX2 target supports it
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define HALF_USE_F16C
+#include <immintrin.h>
+#endif
+
+#include "Half.h"
+
+static_assert(sizeof(Half) == sizeof(uint16_t), "Half must have the layout of GLhalf");
+
+uint16_t Half::fromFloat(float value) {
+  uint32_t f;
+  std::memcpy(&f, &value, sizeof(f));
+  const uint32_t sign = (f >> 16) & 0x8000;
+  const uint32_t absF = f & 0x7FFFFFFF;
+
+  if (absF >= 0x7F800000) {
+    // inf stays inf, NaN stays a (quiet) NaN
+    return uint16_t(sign | 0x7C00 | (absF > 0x7F800000 ? 0x200 : 0));
+  }
+  if (absF >= 0x477FF000) {
+    // rounds to a value beyond the half range
+    return uint16_t(sign | 0x7C00);
+  }
+  if (absF < 0x38800000) {
+    // subnormal half (or zero): shift the mantissa with the implicit one
+    if (absF < 0x33000000) return uint16_t(sign);
+    const uint32_t exponent = absF >> 23;
+    const uint32_t mantissa = (absF & 0x7FFFFF) | 0x800000;
+    const uint32_t shift = 126 - exponent;
+    uint32_t h = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+    if (remainder > halfway || (remainder == halfway && (h & 1))) ++h;
+    return uint16_t(sign | h);
+  }
+  // normal: rebias the exponent and round the mantissa to nearest even
+  uint32_t h = ((absF - 0x38000000) >> 13);
+  const uint32_t remainder = absF & 0x1FFF;
+  if (remainder > 0x1000 || (remainder == 0x1000 && (h & 1))) ++h;
+  return uint16_t(sign | h);
+}
+
+float Half::toFloat(uint16_t bits) {
+  const uint32_t sign = uint32_t(bits & 0x8000) << 16;
+  const uint32_t exponent = (bits >> 10) & 0x1F;
+  uint32_t mantissa = bits & 0x3FF;
+  uint32_t f;
+  if (exponent == 0x1F) {
+    f = sign | 0x7F800000 | (mantissa << 13);
+  } else if (exponent != 0) {
+    f = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  } else if (mantissa == 0) {
+    f = sign;
+  } else {
+    // subnormal half: normalize the mantissa
+    uint32_t e = 113;
+    while (!(mantissa & 0x400)) {
+      mantissa <<= 1;
+      --e;
+    }
+    f = sign | (e << 23) | ((mantissa & 0x3FF) << 13);
+  }
+  float value;
+  std::memcpy(&value, &f, sizeof(value));
+  return value;
+}
+
+void Half::toFloats(const Half* in, float* out, size_t count) {
+  size_t i = 0;
+#ifdef HALF_USE_F16C
+  for (;i+4<=count;i+=4) {
+    const __m128i h = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in+i));
+    _mm_storeu_ps(out+i, _mm_cvtph_ps(h));
+  }
+#endif
+  for (;i<count;++i) out[i] = toFloat(in[i].bits);
+}
+
+void Half::fromFloats(const float* in, Half* out, size_t count) {
+  size_t i = 0;
+#ifdef HALF_USE_F16C
+  for (;i+4<=count;i+=4) {
+    const __m128i h = _mm_cvtps_ph(_mm_loadu_ps(in+i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out+i), h);
+  }
+#endif
+  for (;i<count;++i) out[i].bits = fromFloat(in[i]);
+}
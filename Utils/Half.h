@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @file Half.h
+ * @brief IEEE 754 half precision (binary16) storage type.
+ *
+ * \c GLhalf is a plain 16 bit integer typedef, so templates cannot tell it
+ * apart from \c uint16_t. @ref Half wraps the bits in a distinct type that
+ * converts to and from float, e.g. for @ref Grid2Dt cells and vertex
+ * attributes. Conversions round to nearest even and keep inf and NaN.
+ *
+ * The bulk conversions use the F16C instructions when the compiler targets
+ * them (\c -mf16c, or /arch:AVX2 on MSVC) and a bit-exact scalar path
+ * otherwise.
+ */
+struct Half {
+  uint16_t bits{0};  ///< Raw binary16 representation, layout compatible with \c GLhalf.
+
+  Half() = default;
+
+  /** @brief Round @p value to the nearest half. */
+  explicit Half(float value) : bits(fromFloat(value)) {}
+
+  /** @brief Widen to float (exact). */
+  operator float() const {return toFloat(bits);}
+
+  /** @brief Half bits nearest to @p value (round to nearest even). */
+  static uint16_t fromFloat(float value);
+  /** @brief Float value of the half with bits @p bits. */
+  static float toFloat(uint16_t bits);
+
+  /** @brief Widen @p count halfs from @p in to @p out. */
+  static void toFloats(const Half* in, float* out, size_t count);
+  /** @brief Round @p count floats from @p in to @p out. */
+  static void fromFloats(const float* in, Half* out, size_t count);
+};
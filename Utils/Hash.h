@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * @file Hash.h
+ * @brief 64-bit FNV-1a hashing for cache keys.
+ *
+ * Used to derive on-disk cache file names from their inputs (shader sources,
+ * image files, encoder settings). Not a cryptographic hash.
+ *
+ * Usage:
+ * @code
+ * uint64_t h = Hash::FNV_OFFSET;
+ * Hash::add(h, someString);
+ * Hash::add(h, &value, sizeof(value));
+ * std::string name = Hash::toHex(h);
+ * @endcode
+ */
+namespace Hash {
+  /** @brief Initial value of an FNV-1a hash. */
+  constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+
+  /** @brief Mix @p size bytes at @p data into @p hash. */
+  inline void add(uint64_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0;i<size;++i) {
+      hash ^= bytes[i];
+      hash *= 0x100000001b3ull;
+    }
+  }
+
+  /**
+   * @brief Mix the length and contents of @p str into @p hash.
+   * @note Including the length keeps {"ab","c"} and {"a","bc"} apart.
+   */
+  inline void add(uint64_t& hash, const std::string& str) {
+    const uint64_t length = str.size();
+    add(hash, &length, sizeof(length));
+    add(hash, str.data(), str.size());
+  }
+
+  /** @brief Fixed-width lowercase hex representation of @p hash. */
+  inline std::string toHex(uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string result(16, '0');
+    for (size_t i = 0;i<16;++i) {
+      result[15-i] = digits[hash & 0xF];
+      hash >>= 4;
+    }
+    return result;
+  }
+}
@@ -3,6 +3,8 @@
 
 #include "Image.h"
 #include "Grid2D.h"
+#include "Parallel.h"
+#include "SummedAreaTable.h"
 
 Image::Image(const Vec4& color) :
   Image(1,1,4,{uint8_t(color.x*255),
@@ -22,6 +24,18 @@ Image::Image(uint32_t width,
 {
 }
 
+Image::Image(uint32_t width,
+             uint32_t height,
+             uint8_t componentCount,
+             MemoryLayout layout) :
+  width{width},
+  height{height},
+  componentCount{componentCount},
+  data(GridLayout(width, height, layout).size()*size_t(componentCount)),
+  layout{layout}
+{
+}
+
 Image::Image(uint32_t width,
       uint32_t height,
       uint8_t componentCount,
@@ -77,7 +91,21 @@ void Image::generateAlphaFromLuminance() {
 }
 
 size_t Image::computeIndex(uint32_t x, uint32_t y, uint8_t component) const {
-  return size_t(component)+(size_t(x)+size_t(y)* size_t(width))* size_t(componentCount);
+  if (layout == MemoryLayout::Linear)
+    return size_t(component)+(size_t(x)+size_t(y)* size_t(width))* size_t(componentCount);
+  return size_t(component)+getGridLayout().index(x,y)* size_t(componentCount);
+}
+
+GridLayout Image::getGridLayout() const {
+  return GridLayout(width, height, layout);
+}
+
+Image Image::toLayout(MemoryLayout layout) const {
+  if (layout == this->layout) return *this;
+  Image result{width, height, componentCount, layout};
+  GridLayout::convert(getGridLayout(), data.data(),
+                      result.getGridLayout(), result.data.data(), componentCount);
+  return result;
 }
 
 uint8_t Image::getValue(uint32_t x, uint32_t y, uint8_t component) const {
@@ -109,6 +137,9 @@ void Image::setNormalizedValue(uint32_t x, uint32_t y, uint8_t component, float
 }
 
 std::string Image::toCode(const std::string& varName, bool padding) const {
+  if (layout != MemoryLayout::Linear)
+    return toLayout(MemoryLayout::Linear).toCode(varName, padding);
+
   std::stringstream ss;
 
   ss << "Image " << varName << " {"<< width << "," << height << ","<< componentCount << ",\n";
@@ -159,31 +190,38 @@ uint8_t Image::getLumiValue(uint32_t x, uint32_t y) const {
 }
 
 Image Image::filter(const Grid2D& filter) const {
-  Image filteredImage{width, height, componentCount};
+  Image filteredImage{width, height, componentCount, layout};
   
   const uint32_t hw = uint32_t(filter.getWidth()/2);
   const uint32_t hh = uint32_t(filter.getHeight()/2);
+  const GridLayout grid = getGridLayout();
   
-  for (uint32_t y = hh;y<height-hh;y+=1) {
-    for (uint32_t x = hw;x<width-hw;x+=1) {
-      for (uint8_t c = 0;c<componentCount;c+=1) {
-        float conv = 0.0f;
-        for (uint32_t u = 0;u<filter.getHeight();u+=1) {
-          for (uint32_t v = 0;v<filter.getWidth();v+=1) {
-            conv += float(getValue((x+u-hw),(y+v-hh),c)) * filter.getValue(u, v);
+  grid.forEachTile([&](size_t x0, size_t y0, size_t x1, size_t y1) {
+    const uint32_t yBegin = std::max(uint32_t(y0), hh);
+    const uint32_t yEnd   = std::min(uint32_t(y1), height-hh);
+    const uint32_t xBegin = std::max(uint32_t(x0), hw);
+    const uint32_t xEnd   = std::min(uint32_t(x1), width-hw);
+    for (uint32_t y = yBegin;y<yEnd;y+=1) {
+      for (uint32_t x = xBegin;x<xEnd;x+=1) {
+        for (uint8_t c = 0;c<componentCount;c+=1) {
+          float conv = 0.0f;
+          for (uint32_t u = 0;u<filter.getHeight();u+=1) {
+            for (uint32_t v = 0;v<filter.getWidth();v+=1) {
+              conv += float(data[grid.index(x+u-hw, y+v-hh)*componentCount+c]) * filter.getValue(u, v);
+            }
           }
+          conv = std::clamp(conv, 0.0f, 255.0f);
+          filteredImage.data[grid.index(x,y)*componentCount+c] = uint8_t(fabs(conv));
         }
-        conv = std::clamp(conv, 0.0f, 255.0f);
-        filteredImage.setValue(x,y,c,uint8_t(fabs(conv)));
       }
     }
-  }
+  });
   
   return filteredImage;
 }
 
 Image Image::toGrayscale() const {
-  Image grayScaleImage{width,height,1};
+  Image grayScaleImage{width,height,1,layout};
   for (uint32_t y = 0;y<height;++y) {
     for (uint32_t x = 0;x<width;++x) {
       grayScaleImage.setValue(x,y,0,getLumiValue(x,y));
@@ -270,7 +308,7 @@ Image Image::resample(uint32_t newWidth) const {
 
 Image Image::cropToAspectAndResample(uint32_t newWidth, uint32_t newHeight) const {
   if (newWidth == width && newHeight == height)
-    return Image(width, height, componentCount, data);
+    return *this;
 
   const float aspect    = float(width)/float(height);
   const float newAspect = float(newWidth)/float(newHeight);
@@ -281,6 +319,8 @@ Image Image::cropToAspectAndResample(uint32_t newWidth, uint32_t newHeight) cons
   const uint32_t startY = (aspect < newAspect) ? uint32_t(height*((1.0f-aspect/(newAspect))/2.0)) : 0;
 
   const uint32_t reduction = (width-2*startX)/newWidth;
+  if (reduction == 0)
+    return crop(startX, startY, width-startX, height-startY).resampleArea(newWidth, newHeight);
 
   std::vector<uint64_t> values(componentCount);
   for (uint32_t y = 0;y<newHeight;++y) {
@@ -305,6 +345,63 @@ Image Image::cropToAspectAndResample(uint32_t newWidth, uint32_t newHeight) cons
   return result;
 }
 
+static uint8_t toByte(double value) {
+  return uint8_t(std::clamp(value + 0.5, 0.0, 255.0));
+}
+
+Image Image::boxFilter(uint32_t radius) const {
+  const SummedAreaTable table(*this);
+  Image result{width, height, componentCount, layout};
+  Parallel::forRange(0, height, [&](size_t begin, size_t end) {
+    for (size_t y = begin;y<end;++y) {
+      const size_t y0 = y > radius ? y-radius : 0;
+      for (size_t x = 0;x<width;++x) {
+        const size_t x0 = x > radius ? x-radius : 0;
+        for (uint8_t c = 0;c<componentCount;++c) {
+          result.setValue(uint32_t(x), uint32_t(y), c,
+                          toByte(table.mean(x0, y0, x+radius+1, y+radius+1, c)));
+        }
+      }
+    }
+  }, 16);
+  return result;
+}
+
+Image Image::downsample(uint32_t factor) const {
+  factor = std::max(factor, 1u);
+  const SummedAreaTable table(*this);
+  Image result{(width+factor-1)/factor, (height+factor-1)/factor, componentCount, layout};
+  Parallel::forRange(0, result.height, [&](size_t begin, size_t end) {
+    for (size_t y = begin;y<end;++y) {
+      for (size_t x = 0;x<result.width;++x) {
+        for (uint8_t c = 0;c<componentCount;++c) {
+          result.setValue(uint32_t(x), uint32_t(y), c,
+                          toByte(table.mean(x*factor, y*factor, (x+1)*factor, (y+1)*factor, c)));
+        }
+      }
+    }
+  }, 16);
+  return result;
+}
+
+Image Image::resampleArea(uint32_t newWidth, uint32_t newHeight) const {
+  const SummedAreaTable table(*this);
+  Image result{newWidth, newHeight, componentCount, layout};
+  const double scaleX = double(width)/newWidth;
+  const double scaleY = double(height)/newHeight;
+  Parallel::forRange(0, newHeight, [&](size_t begin, size_t end) {
+    for (size_t y = begin;y<end;++y) {
+      for (size_t x = 0;x<newWidth;++x) {
+        for (uint8_t c = 0;c<componentCount;++c) {
+          result.setValue(uint32_t(x), uint32_t(y), c,
+                          toByte(table.mean(x*scaleX, y*scaleY, (x+1)*scaleX, (y+1)*scaleY, c)));
+        }
+      }
+    }
+  }, 16);
+  return result;
+}
+
 Image Image::crop(uint32_t blX, uint32_t blY, uint32_t trX, uint32_t trY) const {
   size_t i = 0;
   Image result{trX-blX, trY-blY, componentCount};
@@ -320,7 +417,7 @@ Image Image::crop(uint32_t blX, uint32_t blY, uint32_t trX, uint32_t trY) const
 
 
 Image Image::flipHorizontal() const {
-  Image result{width, height, componentCount};
+  Image result{width, height, componentCount, layout};
   for (uint32_t y = 0;y<height;++y) {
     for (uint32_t x = 0;x<width;++x) {
       for (uint8_t c = 0;c<componentCount;++c) {
@@ -332,7 +429,7 @@ Image Image::flipHorizontal() const {
 }
 
 Image Image::flipVertical() const {
-  Image result{width, height, componentCount};
+  Image result{width, height, componentCount, layout};
   for (uint32_t y = 0;y<height;++y) {
     for (uint32_t x = 0;x<width;++x) {
       for (uint8_t c = 0;c<componentCount;++c) {
@@ -5,8 +5,10 @@
 #include <string>
 
 #include "Vec4.h"
+#include "GridLayout.h"
 
-class Grid2D;
+template <typename T> class Grid2Dt;
+typedef Grid2Dt<float> Grid2D;
 
 /**
  * @file Image.h
@@ -18,6 +20,10 @@ class Grid2D;
  *
  * Pixels are stored in row‑major order with contiguous interleaved components
  * per pixel. Component semantics follow RGB(A) when \c componentCount ≥ 3.
+ * Large images that are filtered can be stored in 64×64 tiles instead (see
+ * @ref GridLayout); all accessors and processing functions honor @ref layout,
+ * code reading @ref data directly must check it. Saving and uploading
+ * convert to row‑major order.
  */
 class Image {
 public:
@@ -27,6 +33,7 @@ public:
   uint32_t height;         ///< Image height in pixels.
   uint8_t  componentCount; ///< Number of components per pixel (1–4).
   std::vector<uint8_t> data; ///< Interleaved pixel data of size width*height*componentCount.
+  MemoryLayout layout{MemoryLayout::Linear}; ///< Pixel order of @ref data.
   ///@}
 
   /**
@@ -46,6 +53,18 @@ public:
         uint32_t height = 100,
         uint8_t componentCount = 4);
 
+  /**
+   * @brief Construct an empty image with the given pixel order.
+   * @param width  Width in pixels.
+   * @param height Height in pixels.
+   * @param componentCount Components per pixel.
+   * @param layout Pixel order; tiled layouts pad @ref data to whole tiles.
+   */
+  Image(uint32_t width,
+        uint32_t height,
+        uint8_t componentCount,
+        MemoryLayout layout);
+
   /**
    * @brief Construct from raw data (moves or copies \p data).
    * @param width  Width in pixels.
@@ -90,6 +109,15 @@ public:
    */
   size_t computeIndex(uint32_t x, uint32_t y, uint8_t component) const;
 
+  /** @brief Layout of @ref data, for addressing and blockwise traversal. */
+  GridLayout getGridLayout() const;
+
+  /**
+   * @brief Copy of the image with the pixels stored in another order.
+   * @param layout Target pixel order.
+   */
+  Image toLayout(MemoryLayout layout) const;
+
   /**
    * @brief Read a component value at (x,y).
    * @param x Zero‑based x.
@@ -162,8 +190,10 @@ public:
 
   /**
    * @brief Convolve image with a small 2D filter kernel (no borders).
+   *
+   * Runs tile by tile, so tiled images keep the kernel footprint in cache.
    * @param filter Convolution kernel (must expose size and getValue()).
-   * @return Filtered image (borders untouched / not written).
+   * @return Filtered image in the same layout (borders untouched / not written).
    */
   Image filter(const Grid2D& filter) const;
 
@@ -205,6 +235,35 @@ public:
    */
   Image cropToAspectAndResample(uint32_t newWidth, uint32_t newHeight) const;
 
+  /**
+   * @brief Mean over a (2·radius+1)² window, clipped at the borders.
+   *
+   * Built on a @ref SummedAreaTable, so the cost does not depend on
+   * @p radius.
+   * @param radius Half window size in pixels.
+   * @return Blurred image in the same layout.
+   */
+  Image boxFilter(uint32_t radius) const;
+
+  /**
+   * @brief Average factor×factor blocks (summed‑area table, O(1) per pixel).
+   * @param factor Reduction factor ≥ 1.
+   * @return Image of ⌈width/factor⌉×⌈height/factor⌉ pixels; partial blocks
+   *         at the right and top are averaged over their covered pixels.
+   */
+  Image downsample(uint32_t factor) const;
+
+  /**
+   * @brief Area‑average resample to an arbitrary size.
+   *
+   * Every target pixel is the exact area‑weighted mean of the source pixels
+   * it covers, so downscaling does not alias; upscaling is nearest‑like.
+   * @param newWidth  Target width.
+   * @param newHeight Target height.
+   * @return Resampled image in the same layout.
+   */
+  Image resampleArea(uint32_t newWidth, uint32_t newHeight) const;
+
   /**
    * @brief Flip rows (vertical mirror around horizontal axis).
    * @return Flipped image with same dimensions.
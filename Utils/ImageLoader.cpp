@@ -3,23 +3,29 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "ImageLoader.h"
+#include "ThreadPool.h"
 
 namespace ImageLoader {
   Image load(const std::string& filename, bool flipY) {
-    stbi_set_flip_vertically_on_load(flipY);
+    return decode(filename, flipY).toImage();
+  }
+
+  Image DecodedImage::toImage() const {
+    Image image(width, height, componentCount);
+    std::copy(pixels.get(), pixels.get() + size(), image.data.begin());
+    return image;
+  }
+
+  DecodedImage decode(const std::string& filename, bool flipY) {
+    stbi_set_flip_vertically_on_load_thread(flipY);
     int width, height, nrComponents;
     stbi_uc* image_data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (image_data) {
-      const uint32_t uw = uint32_t(width);
-      const uint32_t uh = uint32_t(height);
-      const uint8_t uc = uint8_t(nrComponents);
-      Image image(uw, uh, uc);
-
-      std::copy(image_data,
-                image_data + (width * height * nrComponents),
-                image.data.begin());
-      stbi_image_free(image_data);
-
+      DecodedImage image;
+      image.width = uint32_t(width);
+      image.height = uint32_t(height);
+      image.componentCount = uint8_t(nrComponents);
+      image.pixels = std::unique_ptr<uint8_t, void(*)(void*)>(image_data, stbi_image_free);
       return image;
     } else {
       std::stringstream s;
@@ -27,4 +33,8 @@ namespace ImageLoader {
       throw Exception(s.str());
     }
   }
+
+  std::future<DecodedImage> loadAsync(const std::string& filename, bool flipY) {
+    return ThreadPool::shared().submit([filename, flipY]() {return decode(filename, flipY);});
+  }
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <future>
+
 #include "Vec2.h"
 #include "Image.h"
 
@@ -11,6 +14,11 @@
  * loader fills an @ref Image with interleaved 8-bit components and supports an
  * optional vertical flip to match a top-left origin.
  *
+ * Besides the synchronous @ref ImageLoader::load(), @ref ImageLoader::decode()
+ * returns a @ref ImageLoader::DecodedImage that adopts the decoder's buffer
+ * instead of copying it, and @ref ImageLoader::loadAsync() decodes on the
+ * shared @ref ThreadPool. See @ref TextureLoader for staged GL uploads.
+ *
  * @note Implementation is provided in the corresponding translation unit and
  *       uses `stbi_load`/`stbi_image_free`. See the `.cpp` for details.
  */
@@ -52,4 +60,36 @@ namespace ImageLoader {
    *          returned @ref Image and the temporary buffer is freed.
    */
   Image load(const std::string& filename, bool flipY=true);
+
+  /**
+   * @brief Decoded pixels that still live in the buffer allocated by stb_image.
+   *
+   * Move-only; the buffer is released with `stbi_image_free` on destruction.
+   */
+  struct DecodedImage {
+    uint32_t width{0};         ///< Width in pixels.
+    uint32_t height{0};        ///< Height in pixels.
+    uint8_t componentCount{0}; ///< Components per pixel (1..4).
+    std::unique_ptr<uint8_t, void(*)(void*)> pixels{nullptr, nullptr}; ///< Interleaved 8-bit pixels.
+
+    /** @brief Size of @ref pixels in bytes. */
+    size_t size() const {return size_t(width)*height*componentCount;}
+    /** @brief Copy the pixels into a new @ref Image. */
+    Image toImage() const;
+  };
+
+  /**
+   * @brief Decode an image file without copying the decoder's output.
+   * @param filename Path to the image file.
+   * @param flipY    If true, flip rows vertically on load.
+   * @throw Exception If the file cannot be read/decoded.
+   * @note Thread-safe; the flip setting is per thread.
+   */
+  DecodedImage decode(const std::string& filename, bool flipY=true);
+
+  /**
+   * @brief Decode an image file on the shared @ref ThreadPool.
+   * @return Future of the decoded image; decoding errors are rethrown by get().
+   */
+  std::future<DecodedImage> loadAsync(const std::string& filename, bool flipY=true);
 }
@@ -0,0 +1,133 @@
+#include <cmath>
+#include <algorithm>
+
+#include "MeshCompression.h"
+#include "Parallel.h"
+
+static float signNotZero(float v) {
+  return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+Vec2 MeshCompression::octEncode(const Vec3& n) {
+  const float l1 = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+  if (l1 == 0.0f) return {0.0f, 0.0f};
+  Vec2 e{n.x / l1, n.y / l1};
+  if (n.z < 0.0f) {
+    // fold the lower hemisphere over the diagonals
+    e = Vec2{(1.0f - std::fabs(e.y)) * signNotZero(e.x),
+             (1.0f - std::fabs(e.x)) * signNotZero(e.y)};
+  }
+  return e;
+}
+
+Vec3 MeshCompression::octDecode(const Vec2& e) {
+  Vec3 n{e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y)};
+  const float t = std::max(-n.z, 0.0f);
+  n.x += n.x >= 0.0f ? -t : t;
+  n.y += n.y >= 0.0f ? -t : t;
+  return Vec3::normalize(n);
+}
+
+static Vec3 load(const float* data, size_t index) {
+  return {data[index*3+0], data[index*3+1], data[index*3+2]};
+}
+
+QuantizedMesh MeshCompression::compress(const MeshStreams& streams) {
+  if (streams.positions == nullptr) {
+    throw GLException{"Mesh compression requires positions."};
+  }
+  if (streams.tangents != nullptr && streams.normals == nullptr) {
+    throw GLException{"Mesh compression of tangents requires normals."};
+  }
+
+  QuantizedMesh mesh;
+  mesh.vertexCount = streams.vertexCount;
+  for (size_t i = 0;i<streams.vertexCount;++i) {
+    mesh.bounds.add(load(streams.positions, i));
+  }
+
+  mesh.format.add(streams.positionName, GLAttribType::USHORT_NORM, 3);
+  if (streams.normals) mesh.format.add(streams.normalName, GLAttribType::SHORT_NORM, 2);
+  if (streams.tangents) mesh.format.add(streams.tangentName, GLAttribType::INT_2_10_10_10_REV, 4);
+  if (streams.texCoords) mesh.format.add(streams.texCoordName, GLAttribType::HALF, 2);
+
+  const Vec3 offset = mesh.positionOffset();
+  const Vec3 scale = mesh.positionScale();
+  const Vec3 invScale{scale.x > 0.0f ? 1.0f / scale.x : 0.0f,
+                      scale.y > 0.0f ? 1.0f / scale.y : 0.0f,
+                      scale.z > 0.0f ? 1.0f / scale.z : 0.0f};
+
+  const size_t stride = mesh.format.getStride();
+  mesh.vertices.assign(stride*streams.vertexCount, 0);
+  Parallel::forRange(0, streams.vertexCount, [&](size_t begin, size_t end) {
+    for (size_t i = begin;i<end;++i) {
+      uint8_t* vertex = mesh.vertices.data() + i*stride;
+      size_t attribute = 0;
+
+      const Vec3 p = (load(streams.positions, i) - offset) * invScale;
+      mesh.format.packAttribute(vertex, attribute++, p.e.data());
+
+      if (streams.normals) {
+        const Vec3 n = load(streams.normals, i);
+        const Vec2 e = octEncode(n);
+        mesh.format.packAttribute(vertex, attribute++, e.e.data());
+
+        if (streams.tangents) {
+          const Vec3 t = load(streams.tangents, i);
+          const Vec2 et = octEncode(t);
+          float handedness = 1.0f;
+          if (streams.binormals) {
+            handedness = signNotZero(Vec3::dot(Vec3::cross(n, t), load(streams.binormals, i)));
+          }
+          const float packed[4] = {et.x, et.y, 0.0f, handedness};
+          mesh.format.packAttribute(vertex, attribute++, packed);
+        }
+      }
+
+      if (streams.texCoords) {
+        mesh.format.packAttribute(vertex, attribute++, streams.texCoords + i*streams.texCoordStride);
+      }
+    }
+  });
+  return mesh;
+}
+
+QuantizedMesh MeshCompression::compress(const std::vector<Vec3>& positions, const std::vector<Vec3>& normals) {
+  MeshStreams streams;
+  streams.vertexCount = positions.size();
+  streams.positions = positions.empty() ? nullptr : positions.front().e.data();
+  if (normals.size() == positions.size() && !normals.empty()) streams.normals = normals.front().e.data();
+  return compress(streams);
+}
+
+void QuantizedMesh::setDecodeUniforms(const GLProgram& program, const std::string& scaleName,
+                                      const std::string& offsetName) const {
+  program.setUniform(scaleName, positionScale());
+  program.setUniform(offsetName, positionOffset());
+}
+
+const std::string& MeshCompression::glslDecode() {
+  // signed normalized values are decoded differently before GL 4.2, so the
+  // handedness is taken by sign and the octahedral vector is renormalized
+  static const std::string source = R"(
+vec3 octDecode(vec2 e) {
+  vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
+vec3 decodePosition(vec3 quantized, vec3 scale, vec3 offset) {
+  return offset + quantized * scale;
+}
+
+void decodeTangentFrame(vec2 octNormal, vec4 packedTangent,
+                        out vec3 normal, out vec3 tangent, out vec3 binormal) {
+  normal = octDecode(octNormal);
+  tangent = octDecode(packedTangent.xy);
+  binormal = cross(normal, tangent) * (packedTangent.w < 0.0 ? -1.0 : 1.0);
+}
+)";
+  return source;
+}
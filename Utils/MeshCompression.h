@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "Vec2.h"
+#include "Vec3.h"
+#include "Bounds.h"
+#include "VertexFormat.h"
+#include "GLProgram.h"
+
+/**
+ * @file MeshCompression.h
+ * @brief Quantization of float vertex streams into compact interleaved vertices.
+ *
+ * @ref MeshCompression::compress() turns separate float streams (as in the
+ * Teapot/UnitPlane arrays or OBJFile) into one interleaved buffer:
+ *  - positions: 3 x 16-bit unsigned normalized, relative to the mesh AABB
+ *    (8 bytes with padding instead of 12),
+ *  - normals: octahedral encoding in 2 x 16-bit signed normalized (4 bytes),
+ *  - tangent frames: octahedral tangent in the x/y of a 10_10_10_2 value and
+ *    the binormal handedness in w (4 bytes instead of 24); the binormal is
+ *    reconstructed as cross(normal, tangent) * w,
+ *  - texture coordinates: 2 x half float (4 bytes).
+ * Position, normal, tangent frame and uv thus take 20 instead of 56 bytes.
+ *
+ * The result is uploaded with GLBuffer::setData(const std::vector<uint8_t>&,
+ * const VertexFormat&, GLenum) and connected with GLArray::configure(). The
+ * vertex shader decodes the attributes with the functions in
+ * @ref MeshCompression::glslDecode(), passed as an extra source string:
+ * @code
+ * QuantizedMesh mesh = MeshCompression::compress(streams);
+ * buffer.setData(mesh.vertices, mesh.format);
+ * array.configure(buffer, mesh.format, program);
+ * mesh.setDecodeUniforms(program);
+ * // vertex shader: vec3 p = decodePosition(vertexPosition, positionScale, positionOffset);
+ * //                vec3 n, t, b; decodeTangentFrame(vertexNormal, vertexTangent, n, t, b);
+ * @endcode
+ */
+
+/**
+ * @brief Float vertex streams to compress; optional streams may be null.
+ */
+struct MeshStreams {
+  size_t vertexCount{0};              ///< Number of vertices.
+  const float* positions{nullptr};    ///< xyz per vertex (required).
+  const float* normals{nullptr};      ///< xyz per vertex, unit length.
+  const float* tangents{nullptr};     ///< xyz per vertex, requires normals.
+  const float* binormals{nullptr};    ///< xyz per vertex, only the handedness is kept.
+  const float* texCoords{nullptr};    ///< uv per vertex.
+  size_t texCoordStride{2};           ///< Floats between consecutive uvs.
+
+  std::string positionName{"vertexPosition"};  ///< Shader attribute of the positions.
+  std::string normalName{"vertexNormal"};      ///< Shader attribute of the normals.
+  std::string tangentName{"vertexTangent"};    ///< Shader attribute of the tangent frames.
+  std::string texCoordName{"vertexTexCoords"}; ///< Shader attribute of the uvs.
+};
+
+/**
+ * @brief Compressed interleaved vertices and the parameters to decode them.
+ */
+struct QuantizedMesh {
+  VertexFormat format;            ///< Layout of @ref vertices.
+  std::vector<uint8_t> vertices;  ///< Interleaved quantized vertices.
+  size_t vertexCount{0};          ///< Number of vertices.
+  AABB bounds;                    ///< Box the positions are quantized to.
+
+  /** @brief Per-axis factor from normalized [0,1] positions to object space. */
+  Vec3 positionScale() const {return bounds.maxPos - bounds.minPos;}
+  /** @brief Object space position of a normalized position of 0. */
+  Vec3 positionOffset() const {return bounds.minPos;}
+
+  /**
+   * @brief Set the position decode uniforms of @p program (which must be enabled).
+   * @throw ProgramException If the program does not use the uniforms.
+   */
+  void setDecodeUniforms(const GLProgram& program,
+                         const std::string& scaleName="positionScale",
+                         const std::string& offsetName="positionOffset") const;
+};
+
+namespace MeshCompression {
+  /**
+   * @brief Quantize @p streams into one interleaved buffer.
+   * @throw GLException If no positions are given or tangents lack normals.
+   */
+  QuantizedMesh compress(const MeshStreams& streams);
+
+  /**
+   * @brief Quantize OBJ positions and normals (OBJFile::vertices/normals).
+   */
+  QuantizedMesh compress(const std::vector<Vec3>& positions, const std::vector<Vec3>& normals);
+
+  /** @brief Octahedral encoding of the unit vector @p n into [-1,1]^2. */
+  Vec2 octEncode(const Vec3& n);
+  /** @brief Inverse of @ref octEncode(), returns a unit vector. */
+  Vec3 octDecode(const Vec2& e);
+
+  /**
+   * @brief GLSL functions decoding the compressed attributes (no #version line).
+   *
+   * Declares `vec3 octDecode(vec2)`, `vec3 decodePosition(vec3, vec3, vec3)` and
+   * `void decodeTangentFrame(vec2, vec4, out vec3, out vec3, out vec3)`.
+   */
+  const std::string& glslDecode();
+}
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+
+#include "MeshOptimizer.h"
+#include "Hash.h"
+
+namespace {
+  /** @brief FIFO post-transform cache, entries expire after cacheSize misses. */
+  class FifoCache {
+  public:
+    FifoCache(size_t vertexCount, size_t cacheSize) :
+      stamps(vertexCount, NEVER),
+      cacheSize(cacheSize)
+    {}
+
+    /** @brief Access @p v, returns true on a miss. */
+    bool access(uint32_t v) {
+      if (stamps[v] != NEVER && misses - stamps[v] < cacheSize) return false;
+      stamps[v] = misses++;
+      return true;
+    }
+
+    void reset() {
+      // advancing the clock expires every entry without touching the stamps
+      misses += cacheSize;
+    }
+
+  private:
+    static constexpr size_t NEVER = std::numeric_limits<size_t>::max();
+    std::vector<size_t> stamps;
+    size_t cacheSize;
+    size_t misses{0};
+  };
+
+  struct VertexHash {
+    const float* vertices;
+    size_t floatsPerVertex;
+    size_t operator()(uint32_t v) const {
+      uint64_t h = Hash::FNV_OFFSET;
+      Hash::add(h, vertices + size_t(v)*floatsPerVertex, floatsPerVertex*sizeof(float));
+      return size_t(h);
+    }
+  };
+
+  struct VertexEqual {
+    const float* vertices;
+    size_t floatsPerVertex;
+    bool operator()(uint32_t a, uint32_t b) const {
+      return std::memcmp(vertices + size_t(a)*floatsPerVertex, vertices + size_t(b)*floatsPerVertex,
+                         floatsPerVertex*sizeof(float)) == 0;
+    }
+  };
+
+  Vec3 position(const float* positions, size_t stride, uint32_t v) {
+    const float* p = positions + size_t(v)*stride;
+    return {p[0], p[1], p[2]};
+  }
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices,
+                                                            size_t vertexCount, size_t cacheSize) {
+  FifoCache cache(vertexCount, cacheSize);
+  std::vector<uint8_t> used(vertexCount, 0);
+  size_t misses = 0;
+  size_t usedCount = 0;
+  for (const uint32_t v : indices) {
+    if (cache.access(v)) ++misses;
+    if (!used[v]) {
+      used[v] = 1;
+      ++usedCount;
+    }
+  }
+  CacheStats stats;
+  if (indices.size() >= 3) stats.acmr = float(misses) / float(indices.size()/3);
+  if (usedCount > 0) stats.atvr = float(misses) / float(usedCount);
+  return stats;
+}
+
+size_t MeshOptimizer::deduplicate(std::vector<float>& vertices, size_t floatsPerVertex,
+                                  std::vector<uint32_t>& indices) {
+  const size_t vertexCount = vertices.size()/floatsPerVertex;
+  std::unordered_map<uint32_t, uint32_t, VertexHash, VertexEqual>
+    unique(vertexCount, VertexHash{vertices.data(), floatsPerVertex},
+           VertexEqual{vertices.data(), floatsPerVertex});
+
+  std::vector<uint32_t> remap(vertexCount);
+  std::vector<uint32_t> kept;
+  for (uint32_t v = 0;v<vertexCount;++v) {
+    const auto entry = unique.emplace(v, uint32_t(kept.size()));
+    if (entry.second) kept.push_back(v);
+    remap[v] = entry.first->second;
+  }
+
+  // kept is ascending, so compacting in place never overwrites a pending source
+  for (size_t i = 0;i<kept.size();++i) {
+    std::copy_n(vertices.begin() + std::ptrdiff_t(kept[i]*floatsPerVertex), floatsPerVertex,
+                vertices.begin() + std::ptrdiff_t(i*floatsPerVertex));
+  }
+  vertices.resize(kept.size()*floatsPerVertex);
+  for (uint32_t& index : indices) index = remap[index];
+  return kept.size();
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount,
+                                        size_t cacheSize) {
+  const size_t triangleCount = indices.size()/3;
+  if (triangleCount == 0) return;
+
+  // vertex -> triangle adjacency in compressed rows, liveCount = triangles not emitted yet
+  std::vector<uint32_t> liveCount(vertexCount, 0);
+  for (const uint32_t v : indices) ++liveCount[v];
+  std::vector<size_t> offsets(vertexCount+1, 0);
+  for (size_t v = 0;v<vertexCount;++v) offsets[v+1] = offsets[v] + liveCount[v];
+  std::vector<uint32_t> adjacency(indices.size());
+  {
+    std::vector<size_t> fill(offsets.begin(), offsets.end()-1);
+    for (size_t i = 0;i<indices.size();++i) adjacency[fill[indices[i]]++] = uint32_t(i/3);
+  }
+
+  std::vector<size_t> cacheTime(vertexCount, 0);
+  size_t time = cacheSize+1;
+  std::vector<uint8_t> emitted(triangleCount, 0);
+  std::vector<uint32_t> deadEnd;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+
+  int64_t fanning = indices[0];
+  size_t cursor = 0;
+  while (fanning >= 0) {
+    // emit all remaining triangles around the fanning vertex
+    candidates.clear();
+    for (size_t a = offsets[size_t(fanning)];a<offsets[size_t(fanning)+1];++a) {
+      const uint32_t t = adjacency[a];
+      if (emitted[t]) continue;
+      emitted[t] = 1;
+      for (size_t k = 0;k<3;++k) {
+        const uint32_t v = indices[t*3+k];
+        output.push_back(v);
+        deadEnd.push_back(v);
+        candidates.push_back(v);
+        --liveCount[v];
+        if (time - cacheTime[v] > cacheSize) cacheTime[v] = time++;
+      }
+    }
+
+    // prefer the oldest candidate that stays in the cache while its fan is
+    // emitted; as in Sander et al. any live candidate beats none (priority 0
+    // included), the dead-end stack is only used when all candidates are done
+    int64_t best = -1;
+    size_t bestPriority = 0;
+    for (const uint32_t v : candidates) {
+      if (liveCount[v] == 0) continue;
+      size_t priority = 0;
+      if (time - cacheTime[v] + 2*liveCount[v] <= cacheSize) priority = time - cacheTime[v];
+      if (best < 0 || priority > bestPriority) {
+        best = v;
+        bestPriority = priority;
+      }
+    }
+
+    if (best < 0) {
+      // dead end: fall back to recently used vertices, then to any live vertex
+      while (!deadEnd.empty() && best < 0) {
+        const uint32_t v = deadEnd.back();
+        deadEnd.pop_back();
+        if (liveCount[v] > 0) best = v;
+      }
+      while (best < 0 && cursor < vertexCount) {
+        if (liveCount[cursor] > 0) best = int64_t(cursor);
+        else ++cursor;
+      }
+    }
+    fanning = best;
+  }
+  indices.swap(output);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const float* positions,
+                                     size_t positionStride, size_t vertexCount,
+                                     size_t cacheSize, float threshold) {
+  const size_t triangleCount = indices.size()/3;
+  if (triangleCount == 0) return;
+
+  // hard boundaries: triangles whose three vertices all miss start a new fan
+  std::vector<size_t> hard;
+  {
+    FifoCache cache(vertexCount, cacheSize);
+    for (size_t t = 0;t<triangleCount;++t) {
+      size_t misses = 0;
+      for (size_t k = 0;k<3;++k) misses += cache.access(indices[t*3+k]) ? 1 : 0;
+      if (t == 0 || misses == 3) hard.push_back(t);
+    }
+    hard.push_back(triangleCount);
+  }
+
+  // soft boundaries: split a hard cluster where its running ACMR is already
+  // close to the ACMR of the whole cluster, the cache restarts at every split
+  std::vector<size_t> clusters;
+  FifoCache cache(vertexCount, cacheSize);
+  for (size_t c = 0;c+1<hard.size();++c) {
+    const size_t begin = hard[c];
+    const size_t end = hard[c+1];
+
+    cache.reset();
+    size_t clusterMisses = 0;
+    for (size_t t = begin;t<end;++t) {
+      for (size_t k = 0;k<3;++k) clusterMisses += cache.access(indices[t*3+k]) ? 1 : 0;
+    }
+    const float clusterAcmr = float(clusterMisses) / float(end-begin);
+
+    cache.reset();
+    clusters.push_back(begin);
+    size_t start = begin;
+    size_t misses = 0;
+    for (size_t t = begin;t<end;++t) {
+      for (size_t k = 0;k<3;++k) misses += cache.access(indices[t*3+k]) ? 1 : 0;
+      if (t+1 < end && float(misses) / float(t+1-start) <= threshold*clusterAcmr) {
+        start = t+1;
+        misses = 0;
+        clusters.push_back(start);
+        cache.reset();
+      }
+    }
+  }
+  clusters.push_back(triangleCount);
+
+  // sort clusters outside-in: clusters facing away from the mesh center come first
+  const size_t clusterCount = clusters.size()-1;
+  std::vector<Vec3> centroids(clusterCount, Vec3{0,0,0});
+  std::vector<Vec3> normals(clusterCount, Vec3{0,0,0});
+  std::vector<float> areas(clusterCount, 0.0f);
+  Vec3 meshCentroid{0,0,0};
+  float meshArea = 0.0f;
+  for (size_t c = 0;c<clusterCount;++c) {
+    for (size_t t = clusters[c];t<clusters[c+1];++t) {
+      const Vec3 p0 = position(positions, positionStride, indices[t*3+0]);
+      const Vec3 p1 = position(positions, positionStride, indices[t*3+1]);
+      const Vec3 p2 = position(positions, positionStride, indices[t*3+2]);
+      const Vec3 n = Vec3::cross(p1-p0, p2-p0);
+      const float area = n.length();
+      centroids[c] = centroids[c] + (p0+p1+p2) * (area/3.0f);
+      normals[c] = normals[c] + n;
+      areas[c] += area;
+    }
+    meshCentroid = meshCentroid + centroids[c];
+    meshArea += areas[c];
+    if (areas[c] > 0.0f) centroids[c] = centroids[c] / areas[c];
+  }
+  if (meshArea > 0.0f) meshCentroid = meshCentroid / meshArea;
+
+  std::vector<float> keys(clusterCount);
+  for (size_t c = 0;c<clusterCount;++c) {
+    keys[c] = Vec3::dot(centroids[c] - meshCentroid, normals[c]);
+  }
+  std::vector<size_t> order(clusterCount);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {return keys[a] > keys[b];});
+
+  std::vector<uint32_t> output;
+  output.reserve(indices.size());
+  for (const size_t c : order) {
+    output.insert(output.end(), indices.begin() + std::ptrdiff_t(clusters[c]*3),
+                  indices.begin() + std::ptrdiff_t(clusters[c+1]*3));
+  }
+  indices.swap(output);
+}
+
+size_t MeshOptimizer::optimizeVertexFetch(std::vector<float>& vertices, size_t floatsPerVertex,
+                                          std::vector<uint32_t>& indices) {
+  constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+  const size_t vertexCount = vertices.size()/floatsPerVertex;
+  std::vector<uint32_t> remap(vertexCount, UNUSED);
+  std::vector<float> reordered;
+  reordered.reserve(vertices.size());
+  uint32_t next = 0;
+  for (uint32_t& index : indices) {
+    if (remap[index] == UNUSED) {
+      remap[index] = next++;
+      reordered.insert(reordered.end(), vertices.begin() + std::ptrdiff_t(index*floatsPerVertex),
+                       vertices.begin() + std::ptrdiff_t((index+1)*floatsPerVertex));
+    }
+    index = remap[index];
+  }
+  vertices.swap(reordered);
+  return next;
+}
+
+MeshOptimizer::Report MeshOptimizer::optimize(std::vector<float>& vertices, size_t floatsPerVertex,
+                                              std::vector<uint32_t>& indices, size_t cacheSize) {
+  Report report;
+  report.vertexCountBefore = vertices.size()/floatsPerVertex;
+  report.before = analyzeVertexCache(indices, report.vertexCountBefore, cacheSize);
+
+  size_t vertexCount = deduplicate(vertices, floatsPerVertex, indices);
+  optimizeVertexCache(indices, vertexCount, cacheSize);
+  optimizeOverdraw(indices, vertices.data(), floatsPerVertex, vertexCount, cacheSize);
+  vertexCount = optimizeVertexFetch(vertices, floatsPerVertex, indices);
+
+  report.vertexCountAfter = vertexCount;
+  report.after = analyzeVertexCache(indices, vertexCount, cacheSize);
+  return report;
+}
+
+MeshOptimizer::Report MeshOptimizer::optimize(OBJFile& mesh, size_t cacheSize) {
+  const bool hasNormals = mesh.normals.size() == mesh.vertices.size();
+  const size_t floatsPerVertex = hasNormals ? 6 : 3;
+
+  std::vector<float> vertices;
+  vertices.reserve(mesh.vertices.size()*floatsPerVertex);
+  for (size_t i = 0;i<mesh.vertices.size();++i) {
+    vertices.insert(vertices.end(), mesh.vertices[i].e.begin(), mesh.vertices[i].e.end());
+    if (hasNormals) vertices.insert(vertices.end(), mesh.normals[i].e.begin(), mesh.normals[i].e.end());
+  }
+  std::vector<uint32_t> indices;
+  indices.reserve(mesh.indices.size()*3);
+  for (const OBJFile::IndexType& triangle : mesh.indices) {
+    for (const size_t v : triangle) indices.push_back(uint32_t(v));
+  }
+
+  const Report report = optimize(vertices, floatsPerVertex, indices, cacheSize);
+
+  mesh.vertices.resize(report.vertexCountAfter);
+  if (hasNormals) mesh.normals.resize(report.vertexCountAfter);
+  for (size_t i = 0;i<report.vertexCountAfter;++i) {
+    const float* v = vertices.data() + i*floatsPerVertex;
+    mesh.vertices[i] = Vec3{v[0], v[1], v[2]};
+    if (hasNormals) mesh.normals[i] = Vec3{v[3], v[4], v[5]};
+  }
+  for (size_t t = 0;t<mesh.indices.size();++t) {
+    mesh.indices[t] = {indices[t*3+0], indices[t*3+1], indices[t*3+2]};
+  }
+  return report;
+}
+
+std::string MeshOptimizer::Report::toString() const {
+  std::stringstream ss;
+  ss << "vertices " << vertexCountBefore << " -> " << vertexCountAfter
+     << ", ACMR " << before.acmr << " -> " << after.acmr
+     << ", ATVR " << before.atvr << " -> " << after.atvr;
+  return ss.str();
+}
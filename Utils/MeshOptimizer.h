@@ -0,0 +1,112 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "OBJFile.h"
+
+/**
+ * @file MeshOptimizer.h
+ * @brief Reordering of indexed triangle meshes for the GPU vertex pipeline.
+ *
+ * The passes are meant to run in this order (see @ref MeshOptimizer::optimize()):
+ *  1. @ref MeshOptimizer::deduplicate() merges bitwise identical vertices.
+ *  2. @ref MeshOptimizer::optimizeVertexCache() reorders triangles with
+ *     Tipsify (Sander et al. 2007) so the post-transform cache is reused.
+ *  3. @ref MeshOptimizer::optimizeOverdraw() splits that order into clusters
+ *     and sorts the clusters outside-in, so occluders tend to be drawn first
+ *     without giving up much cache locality.
+ *  4. @ref MeshOptimizer::optimizeVertexFetch() renumbers the vertices in
+ *     first-use order, so vertex fetches walk the buffer linearly.
+ *
+ * Vertices are flat float arrays with a fixed number of floats per vertex;
+ * indices are triangle lists. Cache efficiency is measured with a FIFO cache
+ * simulation: ACMR (average cache miss ratio) is transformed vertices per
+ * triangle (0.5 is the ideal for large regular meshes, 3 the worst), ATVR
+ * (average transform to vertex ratio) is transformed vertices per vertex
+ * (1 is ideal).
+ */
+namespace MeshOptimizer {
+  /** @brief Result of a vertex cache simulation. */
+  struct CacheStats {
+    float acmr{0.0f}; ///< Cache misses per triangle.
+    float atvr{0.0f}; ///< Cache misses per referenced vertex.
+  };
+
+  /** @brief Statistics before and after @ref optimize(). */
+  struct Report {
+    size_t vertexCountBefore{0}; ///< Vertices before de-duplication.
+    size_t vertexCountAfter{0};  ///< Vertices after de-duplication.
+    CacheStats before;           ///< Cache statistics of the input order.
+    CacheStats after;            ///< Cache statistics of the optimized order.
+
+    /** @brief One-line summary, e.g. for the console. */
+    std::string toString() const;
+  };
+
+  /**
+   * @brief Simulate a FIFO post-transform cache of @p cacheSize entries.
+   * @param indices     Triangle list.
+   * @param vertexCount Number of vertices referenced by @p indices.
+   * @param cacheSize   Cache entries (16-32 on current GPUs).
+   */
+  CacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount,
+                                size_t cacheSize=16);
+
+  /**
+   * @brief Merge vertices whose @p floatsPerVertex floats are bitwise identical.
+   * @param vertices        Interleaved vertices, compacted in place.
+   * @param floatsPerVertex Floats per vertex.
+   * @param indices         Triangle list, remapped in place.
+   * @return Number of remaining vertices.
+   */
+  size_t deduplicate(std::vector<float>& vertices, size_t floatsPerVertex,
+                     std::vector<uint32_t>& indices);
+
+  /**
+   * @brief Reorder triangles for post-transform cache locality (Tipsify).
+   * @param indices     Triangle list, reordered in place.
+   * @param vertexCount Number of vertices.
+   * @param cacheSize   Cache entries the order is tuned for.
+   */
+  void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount,
+                           size_t cacheSize=16);
+
+  /**
+   * @brief Reorder clusters of a cache-optimized order to reduce overdraw.
+   * @param indices         Triangle list from @ref optimizeVertexCache(), reordered in place.
+   * @param positions       xyz of vertex 0, further vertices every @p positionStride floats.
+   * @param positionStride  Floats between consecutive positions.
+   * @param vertexCount     Number of vertices.
+   * @param cacheSize       Cache entries used for the cluster boundaries.
+   * @param threshold       Allowed ACMR increase of a cluster split (1.05 = 5%).
+   */
+  void optimizeOverdraw(std::vector<uint32_t>& indices, const float* positions,
+                        size_t positionStride, size_t vertexCount,
+                        size_t cacheSize=16, float threshold=1.05f);
+
+  /**
+   * @brief Renumber vertices in order of first use by @p indices.
+   *
+   * Vertices no triangle references are dropped.
+   * @return Number of remaining vertices.
+   */
+  size_t optimizeVertexFetch(std::vector<float>& vertices, size_t floatsPerVertex,
+                             std::vector<uint32_t>& indices);
+
+  /**
+   * @brief Run all passes on interleaved vertices with the position in the first three floats.
+   * @return Vertex counts and cache statistics before and after.
+   */
+  Report optimize(std::vector<float>& vertices, size_t floatsPerVertex,
+                  std::vector<uint32_t>& indices, size_t cacheSize=16);
+
+  /**
+   * @brief Run all passes on an OBJ mesh (positions and normals).
+   *
+   * Replaces OBJFile::indices, OBJFile::vertices and OBJFile::normals by the
+   * optimized versions; the bounds do not change.
+   */
+  Report optimize(OBJFile& mesh, size_t cacheSize=16);
+}
@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <queue>
+
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#ifndef M_PI
+constexpr float M_PI = 3.14159265358979323846f;
+#endif
+
+namespace {
+  constexpr size_t DIM = 6; ///< Position plus weighted normal.
+  typedef std::array<double, DIM> VecN;
+
+  /** @brief Generalized quadric of Garland and Heckbert in DIM dimensions. */
+  struct Quadric {
+    std::array<double, DIM*(DIM+1)/2> a{}; ///< Upper triangle of the symmetric matrix, row-major.
+    VecN b{};
+    double c{0.0};
+    double area{0.0}; ///< Sum of the weights, normalizes the error to a squared distance.
+
+    Quadric& operator+=(const Quadric& o) {
+      for (size_t i = 0;i<a.size();++i) a[i] += o.a[i];
+      for (size_t i = 0;i<DIM;++i) b[i] += o.b[i];
+      c += o.c;
+      area += o.area;
+      return *this;
+    }
+
+    double evaluate(const VecN& v) const {
+      double r = c;
+      size_t k = 0;
+      for (size_t i = 0;i<DIM;++i) {
+        r += a[k++]*v[i]*v[i];
+        for (size_t j = i+1;j<DIM;++j) r += 2.0*a[k++]*v[i]*v[j];
+        r += 2.0*b[i]*v[i];
+      }
+      return r;
+    }
+
+    /** @brief Mean squared distance of @p v to the accumulated planes. */
+    double error(const VecN& v) const {
+      return area > 0.0 ? std::max(evaluate(v), 0.0) / area : 0.0;
+    }
+  };
+
+  double dot(const VecN& x, const VecN& y) {
+    double r = 0.0;
+    for (size_t i = 0;i<DIM;++i) r += x[i]*y[i];
+    return r;
+  }
+
+  bool normalize(VecN& x) {
+    const double l = std::sqrt(dot(x, x));
+    if (l < 1e-12) return false;
+    for (double& v : x) v /= l;
+    return true;
+  }
+
+  /** @brief Quadric of the plane spanned by a triangle in DIM dimensions, weighted by @p weight. */
+  Quadric triangleQuadric(const VecN& p1, const VecN& p2, const VecN& p3, double weight) {
+    Quadric q;
+    VecN e1, e2;
+    for (size_t i = 0;i<DIM;++i) e1[i] = p2[i]-p1[i];
+    if (!normalize(e1)) return q;
+    for (size_t i = 0;i<DIM;++i) e2[i] = p3[i]-p1[i];
+    const double d = dot(e1, e2);
+    for (size_t i = 0;i<DIM;++i) e2[i] -= d*e1[i];
+    if (!normalize(e2)) return q;
+
+    const double p1e1 = dot(p1, e1);
+    const double p1e2 = dot(p1, e2);
+    size_t k = 0;
+    for (size_t i = 0;i<DIM;++i) {
+      for (size_t j = i;j<DIM;++j) {
+        q.a[k++] = weight*((i == j ? 1.0 : 0.0) - e1[i]*e1[j] - e2[i]*e2[j]);
+      }
+      q.b[i] = weight*(p1e1*e1[i] + p1e2*e2[i] - p1[i]);
+    }
+    q.c = weight*(dot(p1, p1) - p1e1*p1e1 - p1e2*p1e2);
+    q.area = weight;
+    return q;
+  }
+
+  /** @brief Quadric of the position-space plane with unit normal @p n through @p p. */
+  Quadric planeQuadric(const Vec3& n, const Vec3& p, double weight) {
+    Quadric q;
+    const double d = -double(Vec3::dot(n, p));
+    size_t k = 0;
+    for (size_t i = 0;i<DIM;++i) {
+      for (size_t j = i;j<DIM;++j) {
+        q.a[k++] = (i < 3 && j < 3) ? weight*n[i]*n[j] : 0.0;
+      }
+      q.b[i] = i < 3 ? weight*d*n[i] : 0.0;
+    }
+    q.c = weight*d*d;
+    q.area = weight;
+    return q;
+  }
+
+  /** @brief Point of triangle (a,b,c) closest to @p p (Ericson, Real-Time Collision Detection 5.1.5). */
+  Vec3 closestPointOnTriangle(const Vec3& p, const Vec3& a, const Vec3& b, const Vec3& c) {
+    const Vec3 ab = b-a, ac = c-a, ap = p-a;
+    const float d1 = Vec3::dot(ab, ap), d2 = Vec3::dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+    const Vec3 bp = p-b;
+    const float d3 = Vec3::dot(ab, bp), d4 = Vec3::dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3) return b;
+
+    const float vc = d1*d4 - d3*d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab*(d1/(d1-d3));
+
+    const Vec3 cp = p-c;
+    const float d5 = Vec3::dot(ab, cp), d6 = Vec3::dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6) return c;
+
+    const float vb = d5*d2 - d1*d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac*(d2/(d2-d6));
+
+    const float va = d3*d6 - d5*d4;
+    if (va <= 0.0f && (d4-d3) >= 0.0f && (d5-d6) >= 0.0f) {
+      return b + (c-b)*((d4-d3)/((d4-d3)+(d5-d6)));
+    }
+
+    const float denom = 1.0f/(va+vb+vc);
+    return a + ab*(vb*denom) + ac*(vc*denom);
+  }
+
+  struct Collapse {
+    double cost;
+    uint32_t from;
+    uint32_t to;
+    uint32_t fromStamp;
+    uint32_t toStamp;
+    bool operator>(const Collapse& o) const {return cost > o.cost;}
+  };
+
+  class Simplifier {
+  public:
+    Simplifier(const std::vector<float>& vertices, size_t floatsPerVertex,
+               const std::vector<uint32_t>& indices, const MeshSimplifier::Settings& settings) :
+      vertices(vertices),
+      floatsPerVertex(floatsPerVertex),
+      settings(settings),
+      vertexCount(vertices.size()/floatsPerVertex),
+      points(vertexCount),
+      quadrics(vertexCount),
+      vertexTriangles(vertexCount),
+      stamps(vertexCount, 0),
+      removed(vertexCount, 0),
+      collapsedInto(vertexCount)
+    {
+      for (uint32_t v = 0;v<vertexCount;++v) collapsedInto[v] = v;
+      computePoints();
+      for (size_t t = 0;t+2<indices.size();t+=3) {
+        const std::array<uint32_t,3> tri{indices[t], indices[t+1], indices[t+2]};
+        if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) continue;
+        for (const uint32_t v : tri) vertexTriangles[v].push_back(uint32_t(triangles.size()));
+        triangles.push_back(tri);
+      }
+      alive.assign(triangles.size(), 1);
+      liveCount = triangles.size();
+      computeQuadrics();
+    }
+
+    float run(size_t targetTriangles) {
+      for (uint32_t v = 0;v<vertexCount;++v) pushEdges(v);
+      bool collapsed = false;
+      while (liveCount > targetTriangles && !queue.empty()) {
+        const Collapse c = queue.top();
+        queue.pop();
+        if (removed[c.from] || removed[c.to] ||
+            stamps[c.from] != c.fromStamp || stamps[c.to] != c.toStamp) continue;
+        if (c.cost > double(settings.maxError)*double(settings.maxError)) break;
+        if (!canCollapse(c.from, c.to)) continue;
+        collapse(c.from, c.to);
+        collapsed = true;
+      }
+      return collapsed ? measureError() : 0.0f;
+    }
+
+    std::vector<uint32_t> result() const {
+      std::vector<uint32_t> indices;
+      indices.reserve(liveCount*3);
+      for (size_t t = 0;t<triangles.size();++t) {
+        if (alive[t]) indices.insert(indices.end(), triangles[t].begin(), triangles[t].end());
+      }
+      return indices;
+    }
+
+  private:
+    const std::vector<float>& vertices;
+    size_t floatsPerVertex;
+    MeshSimplifier::Settings settings;
+    size_t vertexCount;
+    std::vector<VecN> points;
+    std::vector<Quadric> quadrics;
+    std::vector<std::array<uint32_t,3>> triangles;
+    std::vector<uint8_t> alive;
+    size_t liveCount{0};
+    std::vector<std::vector<uint32_t>> vertexTriangles;
+    std::vector<uint32_t> stamps;
+    std::vector<uint8_t> removed;
+    std::vector<uint32_t> collapsedInto; ///< Target of each collapse, itself for kept vertices.
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    /**
+     * @brief Largest distance of a removed vertex to the triangles around the vertex it merged into.
+     *
+     * The quadric cost is an area-weighted mean, which underestimates the
+     * error a LOD selector has to bound, so the distance is measured directly:
+     * to the closest point of each remaining triangle at the representative,
+     * clamped to its edges and corners. Only those triangles are searched, so
+     * the result bounds each removed vertex's distance to the whole surface
+     * from above.
+     */
+    float measureError() {
+      float maxDistance = 0.0f;
+      for (uint32_t v = 0;v<vertexCount;++v) {
+        if (!removed[v]) continue;
+        uint32_t r = v;
+        while (collapsedInto[r] != r) r = collapsedInto[r];
+        compact(r);
+        const Vec3 p = position(v);
+        float distance = (p - position(r)).length();
+        for (const uint32_t t : vertexTriangles[r]) {
+          const std::array<uint32_t,3>& tri = triangles[t];
+          const Vec3 q = closestPointOnTriangle(p, position(tri[0]), position(tri[1]), position(tri[2]));
+          distance = std::min(distance, (p - q).length());
+        }
+        maxDistance = std::max(maxDistance, distance);
+      }
+      return maxDistance;
+    }
+
+    Vec3 position(uint32_t v) const {
+      const float* p = vertices.data() + size_t(v)*floatsPerVertex;
+      return {p[0], p[1], p[2]};
+    }
+
+    void computePoints() {
+      // normals are scaled relative to the mesh size, so the weight does not depend on units
+      AABB bounds;
+      for (uint32_t v = 0;v<vertexCount;++v) bounds.add(position(v));
+      const double diagonal = vertexCount > 0 ? double((bounds.maxPos - bounds.minPos).length()) : 0.0;
+      const double normalScale = double(settings.normalWeight)*diagonal;
+      for (uint32_t v = 0;v<vertexCount;++v) {
+        const float* p = vertices.data() + size_t(v)*floatsPerVertex;
+        VecN& x = points[v];
+        x.fill(0.0);
+        for (size_t i = 0;i<3;++i) x[i] = p[i];
+        if (settings.normalOffset >= 0) {
+          for (size_t i = 0;i<3;++i) x[3+i] = normalScale*p[size_t(settings.normalOffset)+i];
+        }
+      }
+    }
+
+    void computeQuadrics() {
+      for (size_t t = 0;t<triangles.size();++t) {
+        const std::array<uint32_t,3>& tri = triangles[t];
+        const Vec3 p0 = position(tri[0]), p1 = position(tri[1]), p2 = position(tri[2]);
+        const Vec3 n = Vec3::cross(p1-p0, p2-p0);
+        const double area = 0.5*double(n.length());
+        const Quadric q = triangleQuadric(points[tri[0]], points[tri[1]], points[tri[2]], area);
+        for (const uint32_t v : tri) quadrics[v] += q;
+
+        // edges used by a single triangle are boundaries, pin them with a perpendicular plane
+        for (size_t k = 0;k<3;++k) {
+          const uint32_t a = tri[k], b = tri[(k+1)%3];
+          if (countEdgeTriangles(a, b) != 1) continue;
+          const Vec3 edge = position(b) - position(a);
+          const Vec3 planeNormal = Vec3::cross(edge, n);
+          const float length = planeNormal.length();
+          if (length <= 0.0f) continue;
+          const Quadric bq = planeQuadric(planeNormal / length, position(a),
+                                          double(settings.boundaryWeight)*double(edge.sqlength()));
+          quadrics[a] += bq;
+          quadrics[b] += bq;
+        }
+      }
+    }
+
+    size_t countEdgeTriangles(uint32_t a, uint32_t b) const {
+      size_t count = 0;
+      for (const uint32_t t : vertexTriangles[a]) {
+        if (!alive.empty() && !alive[t]) continue;
+        const std::array<uint32_t,3>& tri = triangles[t];
+        if (tri[0] == b || tri[1] == b || tri[2] == b) ++count;
+      }
+      return count;
+    }
+
+    void push(uint32_t from, uint32_t to) {
+      Quadric q = quadrics[from];
+      q += quadrics[to];
+      queue.push({q.error(points[to]), from, to, stamps[from], stamps[to]});
+    }
+
+    void pushEdges(uint32_t v) {
+      for (const uint32_t t : vertexTriangles[v]) {
+        if (!alive[t]) continue;
+        for (const uint32_t n : triangles[t]) {
+          if (n == v) continue;
+          push(v, n);
+          push(n, v);
+        }
+      }
+    }
+
+    void compact(uint32_t v) {
+      std::vector<uint32_t>& list = vertexTriangles[v];
+      list.erase(std::remove_if(list.begin(), list.end(), [this](uint32_t t) {return !alive[t];}),
+                 list.end());
+    }
+
+    void neighbors(uint32_t v, std::vector<uint32_t>& result) const {
+      result.clear();
+      for (const uint32_t t : vertexTriangles[v]) {
+        for (const uint32_t n : triangles[t]) {
+          if (n != v) result.push_back(n);
+        }
+      }
+      std::sort(result.begin(), result.end());
+      result.erase(std::unique(result.begin(), result.end()), result.end());
+    }
+
+    bool canCollapse(uint32_t from, uint32_t to) {
+      compact(from);
+      compact(to);
+
+      size_t shared = 0;
+      for (const uint32_t t : vertexTriangles[from]) {
+        const std::array<uint32_t,3>& tri = triangles[t];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) ++shared;
+      }
+      if (shared == 0) return false;
+
+      // link condition: the only common neighbors are the apexes of the shared triangles
+      std::vector<uint32_t> a, b, common;
+      neighbors(from, a);
+      neighbors(to, b);
+      std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(common));
+      if (common.size() != shared) return false;
+
+      // reject collapses that flip or degenerate a remaining triangle
+      const Vec3 target = position(to);
+      for (const uint32_t t : vertexTriangles[from]) {
+        const std::array<uint32_t,3>& tri = triangles[t];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) continue;
+        std::array<Vec3,3> p{position(tri[0]), position(tri[1]), position(tri[2])};
+        const Vec3 before = Vec3::cross(p[1]-p[0], p[2]-p[0]);
+        for (size_t k = 0;k<3;++k) if (tri[k] == from) p[k] = target;
+        const Vec3 after = Vec3::cross(p[1]-p[0], p[2]-p[0]);
+        const float lengths = before.length()*after.length();
+        if (lengths <= 0.0f || Vec3::dot(before, after) < 0.2f*lengths) return false;
+      }
+      return true;
+    }
+
+    void collapse(uint32_t from, uint32_t to) {
+      quadrics[to] += quadrics[from];
+      removed[from] = 1;
+      collapsedInto[from] = to;
+      for (const uint32_t t : vertexTriangles[from]) {
+        std::array<uint32_t,3>& tri = triangles[t];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) {
+          alive[t] = 0;
+          --liveCount;
+        } else {
+          for (uint32_t& v : tri) if (v == from) v = to;
+          vertexTriangles[to].push_back(t);
+        }
+      }
+      vertexTriangles[from].clear();
+      compact(to);
+      ++stamps[to];
+      pushEdges(to);
+    }
+  };
+}
+
+float MeshSimplifier::simplify(const std::vector<float>& vertices, size_t floatsPerVertex,
+                               std::vector<uint32_t>& indices, size_t targetTriangles,
+                               const Settings& settings) {
+  Simplifier simplifier(vertices, floatsPerVertex, indices, settings);
+  const float error = simplifier.run(targetTriangles);
+  indices = simplifier.result();
+  return error;
+}
+
+LodChain MeshSimplifier::buildLodChain(std::vector<float> vertices, size_t floatsPerVertex,
+                                       std::vector<uint32_t> indices, size_t levelCount,
+                                       float ratio, const Settings& settings) {
+  LodChain chain;
+  chain.floatsPerVertex = floatsPerVertex;
+  const size_t vertexCount = vertices.size()/floatsPerVertex;
+
+  float error = 0.0f;
+  for (size_t level = 0;level<levelCount;++level) {
+    if (level > 0) {
+      const size_t triangles = indices.size()/3;
+      const size_t target = size_t(float(triangles)*ratio);
+      // errors of consecutive levels add up, each level is simplified from the previous one
+      error += simplify(vertices, floatsPerVertex, indices, target, settings);
+      if (indices.size()/3 == triangles || indices.empty()) break;
+    }
+    MeshOptimizer::optimizeVertexCache(indices, vertexCount);
+    chain.levels.push_back({chain.indices.size(), indices.size(), error});
+    chain.indices.insert(chain.indices.end(), indices.begin(), indices.end());
+  }
+  chain.vertices = std::move(vertices);
+  return chain;
+}
+
+LodChain MeshSimplifier::buildLodChain(const OBJFile& mesh, size_t levelCount, float ratio) {
+  const bool hasNormals = mesh.normals.size() == mesh.vertices.size();
+  const size_t floatsPerVertex = hasNormals ? 6 : 3;
+  std::vector<float> vertices;
+  vertices.reserve(mesh.vertices.size()*floatsPerVertex);
+  for (size_t i = 0;i<mesh.vertices.size();++i) {
+    vertices.insert(vertices.end(), mesh.vertices[i].e.begin(), mesh.vertices[i].e.end());
+    if (hasNormals) vertices.insert(vertices.end(), mesh.normals[i].e.begin(), mesh.normals[i].e.end());
+  }
+  std::vector<uint32_t> indices;
+  indices.reserve(mesh.indices.size()*3);
+  for (const OBJFile::IndexType& triangle : mesh.indices) {
+    for (const size_t v : triangle) indices.push_back(uint32_t(v));
+  }
+  Settings settings;
+  settings.normalOffset = hasNormals ? 3 : -1;
+  return buildLodChain(std::move(vertices), floatsPerVertex, std::move(indices), levelCount, ratio, settings);
+}
+
+size_t LodChain::select(float distance, float viewportHeight, float fovY,
+                        float pixelThreshold, float scale) const {
+  if (levels.empty() || distance <= 0.0f) return 0;
+  const float pixelsPerUnit = viewportHeight / (2.0f*distance*std::tan(fovY*float(M_PI)/360.0f));
+  for (size_t i = levels.size();i-->0;) {
+    if (levels[i].error*scale*pixelsPerUnit <= pixelThreshold) return i;
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "OBJFile.h"
+
+/**
+ * @file MeshSimplifier.h
+ * @brief Quadric error mesh simplification and LOD chains with screen-space selection.
+ *
+ * @ref MeshSimplifier::simplify() removes edges by half-edge collapses in
+ * order of increasing quadric error (Garland and Heckbert). The quadrics are
+ * attribute-aware: positions and, if present, normals form a 6D vector, so
+ * collapses that would smear shading across creases cost more. Boundary edges
+ * get additional perpendicular planes so open borders keep their shape, and
+ * collapses that flip a triangle are rejected.
+ *
+ * Half-edge collapses only move vertices onto existing ones, so every level
+ * of a @ref LodChain indexes the same vertex array: the chain is one vertex
+ * buffer plus one index buffer holding all levels back to back, and a level
+ * is drawn with its index range.
+ *
+ * At runtime @ref LodChain::select() picks the coarsest level whose error,
+ * projected to the screen at the object's distance, stays below a pixel
+ * threshold:
+ * @code
+ * LodChain chain = MeshSimplifier::buildLodChain(obj);
+ * const LodChain::Level& lod = chain.levels[chain.select(distance, height, fovY)];
+ * glDrawElements(GL_TRIANGLES, lod.indexCount, type, (void*)(lod.indexOffset*indexSize));
+ * @endcode
+ */
+
+/**
+ * @brief Levels of detail sharing one vertex array.
+ */
+struct LodChain {
+  /** @brief One level of detail. */
+  struct Level {
+    size_t indexOffset{0}; ///< First index of the level in @ref indices.
+    size_t indexCount{0};  ///< Number of indices (3 per triangle).
+    float error{0.0f};     ///< Largest distance of a removed vertex to the surface, summed over the steps from level 0 (object space).
+  };
+
+  std::vector<float> vertices;    ///< Interleaved vertices (position first).
+  size_t floatsPerVertex{3};      ///< Floats per vertex in @ref vertices.
+  std::vector<uint32_t> indices;  ///< Triangle lists of all levels, finest first.
+  std::vector<Level> levels;      ///< Levels, finest (the input) first.
+
+  /**
+   * @brief Coarsest level whose projected error is at most @p pixelThreshold.
+   * @param distance        Distance of the object from the camera (same units as the mesh).
+   * @param viewportHeight  Viewport height in pixels.
+   * @param fovY            Vertical field of view in degrees.
+   * @param pixelThreshold  Tolerated error in pixels.
+   * @param scale           Uniform scale of the object's model matrix.
+   * @return Index into @ref levels.
+   */
+  size_t select(float distance, float viewportHeight, float fovY,
+                float pixelThreshold=1.0f, float scale=1.0f) const;
+};
+
+namespace MeshSimplifier {
+  /** @brief Settings of @ref simplify(). */
+  struct Settings {
+    int normalOffset{-1};         ///< Float offset of the normal in a vertex, -1 if none.
+    float normalWeight{0.05f};    ///< Weight of normal deviation, relative to the mesh diagonal.
+    float boundaryWeight{10.0f};  ///< Weight of the planes that keep boundaries in place.
+    float maxError{1e30f};        ///< Stop once the cheapest collapse's RMS quadric error exceeds this.
+  };
+
+  /**
+   * @brief Collapse edges until at most @p targetTriangles remain.
+   * @param vertices        Interleaved vertices with the position in the first three floats.
+   * @param floatsPerVertex Floats per vertex.
+   * @param indices         Triangle list, replaced by the simplified one.
+   * @param targetTriangles Triangle budget.
+   * @param settings        Attribute weights and error limit.
+   * @return Largest distance of a removed vertex to the simplified triangles
+   *         around the vertex it merged into, an upper bound of its distance
+   *         to the simplified surface (0 if nothing was collapsed).
+   */
+  float simplify(const std::vector<float>& vertices, size_t floatsPerVertex,
+                 std::vector<uint32_t>& indices, size_t targetTriangles,
+                 const Settings& settings=Settings{});
+
+  /**
+   * @brief Build @p levelCount levels, each with @p ratio of the triangles of the previous one.
+   *
+   * Stops early when a level cannot be reduced any further.
+   */
+  LodChain buildLodChain(std::vector<float> vertices, size_t floatsPerVertex,
+                         std::vector<uint32_t> indices, size_t levelCount=5,
+                         float ratio=0.5f, const Settings& settings=Settings{});
+
+  /** @brief Build a LOD chain of an OBJ mesh (positions and normals). */
+  LodChain buildLodChain(const OBJFile& mesh, size_t levelCount=5, float ratio=0.5f);
+}
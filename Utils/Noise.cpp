@@ -0,0 +1,494 @@
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#define NOISE_USE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NOISE_USE_SSE
+#include <emmintrin.h>
+#endif
+
+#include "Parallel.h"
+
+#include "Noise.h"
+
+// The kernels below are templates over a float lane type F and an unsigned
+// lane type U. Scalar code uses float/uint32_t, the SIMD paths wrap registers
+// in small structs with the same operators and helper functions, so all
+// paths perform the same IEEE operations in the same order.
+
+namespace {
+
+  // ===== Scalar lanes =====
+
+  inline float vfloor(float x) {return std::floor(x);}
+  inline uint32_t vtoInt(float x) {return uint32_t(int32_t(x));}
+  inline float vtoFloat(uint32_t x) {return float(int32_t(x));}
+  inline float vmin(float a, float b) {return a < b ? a : b;}
+  inline float vmax(float a, float b) {return a > b ? a : b;}
+  inline float vsqrt(float x) {return std::sqrt(x);}
+  inline float vabs(float x) {return std::fabs(x);}
+  inline uint32_t nonzero(uint32_t x) {return x ? 0xFFFFFFFFu : 0u;}
+  inline uint32_t greater(float a, float b) {return a > b ? 0xFFFFFFFFu : 0u;}
+  inline float select(uint32_t mask, float a, float b) {return mask ? a : b;}
+  inline float flipSign(float x, uint32_t bit) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    bits ^= bit << 31;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+  }
+  inline void vstore(float* out, float x) {*out = x;}
+
+#ifdef NOISE_USE_AVX2
+  // ===== AVX2 lanes, 8 cells =====
+
+  struct F8 {
+    __m256 v;
+    F8(__m256 v) : v(v) {}
+    F8(float s) : v(_mm256_set1_ps(s)) {}
+  };
+  struct U8 {
+    __m256i v;
+    U8(__m256i v) : v(v) {}
+    U8(uint32_t s) : v(_mm256_set1_epi32(int32_t(s))) {}
+  };
+
+  inline F8 operator+(F8 a, F8 b) {return _mm256_add_ps(a.v, b.v);}
+  inline F8 operator-(F8 a, F8 b) {return _mm256_sub_ps(a.v, b.v);}
+  inline F8 operator*(F8 a, F8 b) {return _mm256_mul_ps(a.v, b.v);}
+  inline U8 operator+(U8 a, U8 b) {return _mm256_add_epi32(a.v, b.v);}
+  inline U8 operator*(U8 a, U8 b) {return _mm256_mullo_epi32(a.v, b.v);}
+  inline U8 operator^(U8 a, U8 b) {return _mm256_xor_si256(a.v, b.v);}
+  inline U8 operator&(U8 a, U8 b) {return _mm256_and_si256(a.v, b.v);}
+  inline U8 operator>>(U8 a, int s) {return _mm256_srli_epi32(a.v, s);}
+  inline U8 operator<<(U8 a, int s) {return _mm256_slli_epi32(a.v, s);}
+
+  inline F8 vfloor(F8 x) {return _mm256_floor_ps(x.v);}
+  inline U8 vtoInt(F8 x) {return _mm256_cvttps_epi32(x.v);}
+  inline F8 vtoFloat(U8 x) {return _mm256_cvtepi32_ps(x.v);}
+  inline F8 vmin(F8 a, F8 b) {return _mm256_min_ps(a.v, b.v);}
+  inline F8 vmax(F8 a, F8 b) {return _mm256_max_ps(a.v, b.v);}
+  inline F8 vsqrt(F8 x) {return _mm256_sqrt_ps(x.v);}
+  inline F8 vabs(F8 x) {return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x.v);}
+  inline U8 nonzero(U8 x) {
+    return _mm256_xor_si256(_mm256_cmpeq_epi32(x.v, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+  }
+  inline U8 greater(F8 a, F8 b) {return _mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ));}
+  inline F8 select(U8 mask, F8 a, F8 b) {return _mm256_blendv_ps(b.v, a.v, _mm256_castsi256_ps(mask.v));}
+  inline F8 flipSign(F8 x, U8 bit) {
+    return _mm256_xor_ps(x.v, _mm256_castsi256_ps(_mm256_slli_epi32(bit.v, 31)));
+  }
+  inline void vstore(float* out, F8 x) {_mm256_storeu_ps(out, x.v);}
+
+  typedef F8 FLanes;
+  typedef U8 ULanes;
+  constexpr size_t lanes = 8;
+  inline F8 ramp() {return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);}
+#elif defined(NOISE_USE_SSE)
+  // ===== SSE2 lanes, 4 cells =====
+
+  struct F4 {
+    __m128 v;
+    F4(__m128 v) : v(v) {}
+    F4(float s) : v(_mm_set1_ps(s)) {}
+  };
+  struct U4 {
+    __m128i v;
+    U4(__m128i v) : v(v) {}
+    U4(uint32_t s) : v(_mm_set1_epi32(int32_t(s))) {}
+  };
+
+  inline F4 operator+(F4 a, F4 b) {return _mm_add_ps(a.v, b.v);}
+  inline F4 operator-(F4 a, F4 b) {return _mm_sub_ps(a.v, b.v);}
+  inline F4 operator*(F4 a, F4 b) {return _mm_mul_ps(a.v, b.v);}
+  inline U4 operator+(U4 a, U4 b) {return _mm_add_epi32(a.v, b.v);}
+  inline U4 operator*(U4 a, U4 b) {
+    // SSE2 has no 32 bit low multiply: multiply even and odd lanes separately
+    const __m128i even = _mm_mul_epu32(a.v, b.v);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+  }
+  inline U4 operator^(U4 a, U4 b) {return _mm_xor_si128(a.v, b.v);}
+  inline U4 operator&(U4 a, U4 b) {return _mm_and_si128(a.v, b.v);}
+  inline U4 operator>>(U4 a, int s) {return _mm_srli_epi32(a.v, s);}
+  inline U4 operator<<(U4 a, int s) {return _mm_slli_epi32(a.v, s);}
+
+  inline F4 vfloor(F4 x) {
+    // truncate, then step down where truncation rounded up (negative inputs)
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x.v));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x.v), _mm_set1_ps(1.0f)));
+  }
+  inline U4 vtoInt(F4 x) {return _mm_cvttps_epi32(x.v);}
+  inline F4 vtoFloat(U4 x) {return _mm_cvtepi32_ps(x.v);}
+  inline F4 vmin(F4 a, F4 b) {return _mm_min_ps(a.v, b.v);}
+  inline F4 vmax(F4 a, F4 b) {return _mm_max_ps(a.v, b.v);}
+  inline F4 vsqrt(F4 x) {return _mm_sqrt_ps(x.v);}
+  inline F4 vabs(F4 x) {return _mm_andnot_ps(_mm_set1_ps(-0.0f), x.v);}
+  inline U4 nonzero(U4 x) {
+    return _mm_xor_si128(_mm_cmpeq_epi32(x.v, _mm_setzero_si128()), _mm_set1_epi32(-1));
+  }
+  inline U4 greater(F4 a, F4 b) {return _mm_castps_si128(_mm_cmpgt_ps(a.v, b.v));}
+  inline F4 select(U4 mask, F4 a, F4 b) {
+    const __m128 m = _mm_castsi128_ps(mask.v);
+    return _mm_or_ps(_mm_and_ps(m, a.v), _mm_andnot_ps(m, b.v));
+  }
+  inline F4 flipSign(F4 x, U4 bit) {
+    return _mm_xor_ps(x.v, _mm_castsi128_ps(_mm_slli_epi32(bit.v, 31)));
+  }
+  inline void vstore(float* out, F4 x) {_mm_storeu_ps(out, x.v);}
+
+  typedef F4 FLanes;
+  typedef U4 ULanes;
+  constexpr size_t lanes = 4;
+  inline F4 ramp() {return _mm_setr_ps(0, 1, 2, 3);}
+#else
+  typedef float FLanes;
+  typedef uint32_t ULanes;
+  constexpr size_t lanes = 1;
+  inline float ramp() {return 0.0f;}
+#endif
+
+  // ===== Kernels =====
+
+  /** Integer hash with good avalanche (lowbias32 by Chris Wellons). */
+  template <typename U> U hash(U x) {
+    x = x ^ (x >> 16);
+    x = x * U(0x7feb352du);
+    x = x ^ (x >> 15);
+    x = x * U(0x846ca68bu);
+    return x ^ (x >> 16);
+  }
+
+  template <typename U> U hash(U ix, U iy, uint32_t seed) {
+    return hash(ix*U(0x8da6b343u) + iy*U(0xd8163841u) + U(seed*0xcb1ab31fu));
+  }
+
+  /** Top 24 hash bits as float in [0,1). */
+  template <typename F, typename U> F toUnit(U h) {
+    return vtoFloat(h >> 8) * F(1.0f/16777216.0f);
+  }
+
+  template <typename F> F fade(F t) {
+    return t*t*t*(t*(t*F(6.0f) - F(15.0f)) + F(10.0f));
+  }
+
+  template <typename F> F mix(F a, F b, F t) {
+    return a + (b-a)*t;
+  }
+
+  /** Dot product with one of the gradients (±1,±0.5) and (±0.5,±1). */
+  template <typename F, typename U> F gradient(U h, F x, F y) {
+    const U swap = nonzero(h & U(4u));
+    const F u = select(swap, y, x);
+    const F v = select(swap, x, y);
+    return flipSign(u, h & U(1u)) + flipSign(v, (h >> 1) & U(1u)) * F(0.5f);
+  }
+
+  template <typename F, typename U> F valueNoise(F x, F y, uint32_t seed) {
+    const F fx = vfloor(x);
+    const F fy = vfloor(y);
+    const U ix = vtoInt(fx);
+    const U iy = vtoInt(fy);
+    const F u = fade(x-fx);
+    const F v = fade(y-fy);
+    const F v00 = toUnit<F>(hash(ix,       iy,       seed));
+    const F v10 = toUnit<F>(hash(ix+U(1u), iy,       seed));
+    const F v01 = toUnit<F>(hash(ix,       iy+U(1u), seed));
+    const F v11 = toUnit<F>(hash(ix+U(1u), iy+U(1u), seed));
+    return mix(mix(v00, v10, u), mix(v01, v11, u), v) * F(2.0f) - F(1.0f);
+  }
+
+  template <typename F, typename U> F perlinNoise(F x, F y, uint32_t seed) {
+    const F fx = vfloor(x);
+    const F fy = vfloor(y);
+    const U ix = vtoInt(fx);
+    const U iy = vtoInt(fy);
+    const F dx = x-fx;
+    const F dy = y-fy;
+    const F n00 = gradient(hash(ix,       iy,       seed), dx,          dy);
+    const F n10 = gradient(hash(ix+U(1u), iy,       seed), dx-F(1.0f), dy);
+    const F n01 = gradient(hash(ix,       iy+U(1u), seed), dx,          dy-F(1.0f));
+    const F n11 = gradient(hash(ix+U(1u), iy+U(1u), seed), dx-F(1.0f), dy-F(1.0f));
+    const F u = fade(dx);
+    const F v = fade(dy);
+    // normalizes the peak of this gradient set to about 1
+    const F n = mix(mix(n00, n10, u), mix(n01, n11, u), v) * F(1.0f/0.76f);
+    return vmax(vmin(n, F(1.0f)), F(-1.0f));
+  }
+
+  template <typename F, typename U> F simplexCorner(U h, F x, F y) {
+    const F t = vmax(F(0.5f) - x*x - y*y, F(0.0f));
+    const F t2 = t*t;
+    return t2*t2*gradient(h, x, y);
+  }
+
+  template <typename F, typename U> F simplexNoise(F x, F y, uint32_t seed) {
+    const float skew = 0.36602540378f;    // (sqrt(3)-1)/2
+    const float unskew = 0.21132486541f;  // (3-sqrt(3))/6
+    const F s = (x+y)*F(skew);
+    const F fi = vfloor(x+s);
+    const F fj = vfloor(y+s);
+    const F t = (fi+fj)*F(unskew);
+    const F x0 = x-(fi-t);
+    const F y0 = y-(fj-t);
+    // second corner: step along x in the lower triangle, along y in the upper
+    const U lower = greater(x0, y0);
+    const F i1 = select(lower, F(1.0f), F(0.0f));
+    const F j1 = F(1.0f) - i1;
+    const F x1 = x0 - i1 + F(unskew);
+    const F y1 = y0 - j1 + F(unskew);
+    const F x2 = x0 - F(1.0f) + F(2.0f*unskew);
+    const F y2 = y0 - F(1.0f) + F(2.0f*unskew);
+    const U i = vtoInt(fi);
+    const U j = vtoInt(fj);
+    const F n = simplexCorner(hash(i, j, seed), x0, y0) +
+                simplexCorner(hash(i+(lower & U(1u)), j+(U(1u) ^ (lower & U(1u))), seed), x1, y1) +
+                simplexCorner(hash(i+U(1u), j+U(1u), seed), x2, y2);
+    // normalizes the peak of this gradient set to about 1
+    return vmax(vmin(n * F(90.0f), F(1.0f)), F(-1.0f));
+  }
+
+  template <typename F, typename U> F worleyNoise(F x, F y, uint32_t seed) {
+    const F fx = vfloor(x);
+    const F fy = vfloor(y);
+    const U ix = vtoInt(fx);
+    const U iy = vtoInt(fy);
+    const F dx = x-fx;
+    const F dy = y-fy;
+    F best(8.0f);
+    for (int32_t j = -1;j<=1;++j) {
+      for (int32_t i = -1;i<=1;++i) {
+        const U h = hash(ix+U(uint32_t(i)), iy+U(uint32_t(j)), seed);
+        const F px = F(float(i)) + toUnit<F>(h) - dx;
+        const F py = F(float(j)) + toUnit<F>(hash(h)) - dy;
+        best = vmin(best, px*px + py*py);
+      }
+    }
+    return vmin(vsqrt(best), F(1.0f));
+  }
+
+  template <typename F, typename U> F baseNoise(Noise::Type type, F x, F y, uint32_t seed) {
+    switch (type) {
+      case Noise::Type::Value   : return valueNoise<F,U>(x, y, seed);
+      case Noise::Type::Perlin  : return perlinNoise<F,U>(x, y, seed);
+      case Noise::Type::Simplex : return simplexNoise<F,U>(x, y, seed);
+      default                   : return worleyNoise<F,U>(x, y, seed);
+    }
+  }
+
+  /** Noise at frequency-scaled position (x,y). */
+  template <typename F, typename U> F fractalNoise(const Noise::Settings& s, F x, F y) {
+    if (s.fractal == Noise::Fractal::None || s.octaves <= 1) {
+      const F n = baseNoise<F,U>(s.type, x, y, s.seed);
+      if (s.fractal != Noise::Fractal::Ridged) return n;
+      const F r = F(1.0f) - vabs(n);
+      return r*r;
+    }
+    F sum(0.0f);
+    float amplitude = 1.0f;
+    float norm = 0.0f;
+    float frequency = 1.0f;
+    for (uint32_t o = 0;o<s.octaves;++o) {
+      // a new seed per octave keeps the lattices of the octaves uncorrelated
+      const uint32_t seed = s.seed + o*0x9E3779B9u;
+      F n = baseNoise<F,U>(s.type, x*F(frequency), y*F(frequency), seed);
+      if (s.fractal == Noise::Fractal::Ridged) {
+        n = F(1.0f) - vabs(n);
+        n = n*n;
+      }
+      sum = sum + n*F(amplitude);
+      norm += amplitude;
+      amplitude *= s.gain;
+      frequency *= s.lacunarity;
+    }
+    return sum * F(1.0f/norm);
+  }
+}
+
+Noise::Noise() :
+  Noise(Settings{})
+{
+}
+
+Noise::Noise(const Settings& settings) :
+  settings(settings)
+{
+}
+
+size_t Noise::laneCount() {
+  return lanes;
+}
+
+float Noise::evaluate(float x, float y) const {
+  return fractalNoise<float,uint32_t>(settings,
+                                      (x+settings.offset.x)*settings.frequency,
+                                      (y+settings.offset.y)*settings.frequency);
+}
+
+void Noise::evaluateRow(float x, float y, float* out, size_t count) const {
+  const FLanes py((y+settings.offset.y)*settings.frequency);
+  float tail[lanes];
+  for (size_t i = 0;i<count;i+=lanes) {
+    // every batch takes the SIMD path, even the partial last one, so a cell
+    // does not depend on where a row starts or ends
+    const FLanes px = (FLanes(x+settings.offset.x+float(i)) + ramp()) * FLanes(settings.frequency);
+    const FLanes n = fractalNoise<FLanes,ULanes>(settings, px, py);
+    if (i+lanes <= count) {
+      vstore(out+i, n);
+    } else {
+      vstore(tail, n);
+      std::copy(tail, tail+(count-i), out+i);
+    }
+  }
+}
+
+Grid2D Noise::generate(size_t width, size_t height, MemoryLayout layout) const {
+  Grid2D grid(width, height, layout);
+  fill(grid);
+  return grid;
+}
+
+void Noise::fill(Grid2D& grid) const {
+  constexpr size_t tile = GridLayout::tileSize;
+  const size_t width = grid.getWidth();
+  const size_t height = grid.getHeight();
+  const size_t tilesX = (width+tile-1)/tile;
+  const size_t tilesY = (height+tile-1)/tile;
+
+  Parallel::forRange(0, tilesX*tilesY, [&](size_t begin, size_t end) {
+    float row[tile];
+    for (size_t t = begin;t<end;++t) {
+      const size_t x0 = (t % tilesX)*tile;
+      const size_t y0 = (t / tilesX)*tile;
+      const size_t count = std::min(tile, width-x0);
+      for (size_t y = y0;y<std::min(y0+tile, height);++y) {
+        evaluateRow(float(x0), float(y), row, count);
+        for (size_t i = 0;i<count;++i) grid.setCell(x0+i, y, row[i]);
+      }
+    }
+  }, 1);
+}
+
+std::string Noise::glsl() {
+  return R"(
+uint noiseHash(uint x) {
+  x ^= x >> 16u;
+  x *= 0x7feb352du;
+  x ^= x >> 15u;
+  x *= 0x846ca68bu;
+  return x ^ (x >> 16u);
+}
+
+uint noiseHash(ivec2 i, uint seed) {
+  return noiseHash(uint(i.x)*0x8da6b343u + uint(i.y)*0xd8163841u + seed*0xcb1ab31fu);
+}
+
+float noiseUnit(uint h) {
+  return float(h >> 8u) * (1.0/16777216.0);
+}
+
+vec2 noiseFade(vec2 t) {
+  return t*t*t*(t*(t*6.0 - 15.0) + 10.0);
+}
+
+float noiseGradient(uint h, vec2 p) {
+  vec2 uv = (h & 4u) != 0u ? p.yx : p;
+  return ((h & 1u) != 0u ? -uv.x : uv.x) + ((h & 2u) != 0u ? -uv.y : uv.y) * 0.5;
+}
+
+float noiseValue(vec2 p, uint seed) {
+  vec2 f = floor(p);
+  ivec2 i = ivec2(f);
+  vec2 u = noiseFade(p-f);
+  float v00 = noiseUnit(noiseHash(i,             seed));
+  float v10 = noiseUnit(noiseHash(i+ivec2(1,0), seed));
+  float v01 = noiseUnit(noiseHash(i+ivec2(0,1), seed));
+  float v11 = noiseUnit(noiseHash(i+ivec2(1,1), seed));
+  return mix(mix(v00, v10, u.x), mix(v01, v11, u.x), u.y) * 2.0 - 1.0;
+}
+
+float noisePerlin(vec2 p, uint seed) {
+  vec2 f = floor(p);
+  ivec2 i = ivec2(f);
+  vec2 d = p-f;
+  float n00 = noiseGradient(noiseHash(i,             seed), d);
+  float n10 = noiseGradient(noiseHash(i+ivec2(1,0), seed), d-vec2(1.0,0.0));
+  float n01 = noiseGradient(noiseHash(i+ivec2(0,1), seed), d-vec2(0.0,1.0));
+  float n11 = noiseGradient(noiseHash(i+ivec2(1,1), seed), d-vec2(1.0,1.0));
+  vec2 u = noiseFade(d);
+  return clamp(mix(mix(n00, n10, u.x), mix(n01, n11, u.x), u.y) * (1.0/0.76), -1.0, 1.0);
+}
+
+float noiseSimplexCorner(uint h, vec2 p) {
+  float t = max(0.5 - dot(p,p), 0.0);
+  t *= t;
+  return t*t*noiseGradient(h, p);
+}
+
+float noiseSimplex(vec2 p, uint seed) {
+  const float skew = 0.36602540378;
+  const float unskew = 0.21132486541;
+  vec2 f = floor(p + (p.x+p.y)*skew);
+  vec2 p0 = p - (f - (f.x+f.y)*unskew);
+  ivec2 i = ivec2(f);
+  ivec2 o = p0.x > p0.y ? ivec2(1,0) : ivec2(0,1);
+  vec2 p1 = p0 - vec2(o) + unskew;
+  vec2 p2 = p0 - 1.0 + 2.0*unskew;
+  float n = noiseSimplexCorner(noiseHash(i,             seed), p0) +
+            noiseSimplexCorner(noiseHash(i+o,           seed), p1) +
+            noiseSimplexCorner(noiseHash(i+ivec2(1,1), seed), p2);
+  return clamp(n*90.0, -1.0, 1.0);
+}
+
+float noiseWorley(vec2 p, uint seed) {
+  vec2 f = floor(p);
+  ivec2 i = ivec2(f);
+  vec2 d = p-f;
+  float best = 8.0;
+  for (int y = -1;y<=1;++y) {
+    for (int x = -1;x<=1;++x) {
+      uint h = noiseHash(i+ivec2(x,y), seed);
+      vec2 e = vec2(float(x) + noiseUnit(h), float(y) + noiseUnit(noiseHash(h))) - d;
+      best = min(best, dot(e,e));
+    }
+  }
+  return min(sqrt(best), 1.0);
+}
+
+float noiseBase(vec2 p, uint seed, int type) {
+  if (type == 0) return noiseValue(p, seed);
+  if (type == 1) return noisePerlin(p, seed);
+  if (type == 2) return noiseSimplex(p, seed);
+  return noiseWorley(p, seed);
+}
+
+float noiseFractal(vec2 p, uint seed, int type, int fractal, int octaves, float lacunarity, float gain) {
+  if (fractal == 0 || octaves <= 1) {
+    float n = noiseBase(p, seed, type);
+    if (fractal != 2) return n;
+    float r = 1.0 - abs(n);
+    return r*r;
+  }
+  float sum = 0.0;
+  float amplitude = 1.0;
+  float norm = 0.0;
+  float frequency = 1.0;
+  for (int o = 0;o<octaves;++o) {
+    float n = noiseBase(p*frequency, seed + uint(o)*0x9E3779B9u, type);
+    if (fractal == 2) {
+      n = 1.0 - abs(n);
+      n = n*n;
+    }
+    sum += n*amplitude;
+    norm += amplitude;
+    amplitude *= gain;
+    frequency *= lacunarity;
+  }
+  return sum / norm;
+}
+)";
+}
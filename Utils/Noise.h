@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include "Vec2.h"
+#include "Grid2D.h"
+
+/**
+ * @file Noise.h
+ * @brief Coherent procedural noise (value, Perlin, simplex, Worley, fBm,
+ *        ridged) evaluated in SIMD batches, with a matching GLSL version.
+ *
+ * Every noise value is a pure function of the position and the seed: lattice
+ * points are hashed with an integer hash instead of drawn from a generator,
+ * so fields are identical for any thread count, tile order or sub-rectangle
+ * that is generated. @ref Noise::generate() splits the grid into 64×64 tiles
+ * over all threads and evaluates each row 4 cells at a time with SSE2, or
+ * one at a time without it (chosen at compile time, like the other SIMD code
+ * in Utils). The default build is 4-wide; building Utils for AVX2
+ * (<tt>make AVX2=1</tt>, which adds <tt>-mavx2 -mf16c</tt>, or the MSBuild
+ * property <tt>UtilsAVX2=true</tt>, which sets <tt>/arch:AVX2</tt> for x64)
+ * evaluates 8 cells at a time. Such a build only runs on AVX2 processors.
+ *
+ * Ranges: \c Value, \c Perlin and \c Simplex lie in [-1,1], \c Worley (the
+ * distance to the nearest feature point) and every \c Ridged field in [0,1].
+ * \c FBm keeps the range of its base noise.
+ *
+ * @ref Noise::glsl() returns the same functions in GLSL (ES 3.00 and 4.10), so
+ * a shader reproduces CPU fields up to float rounding, e.g. to shade terrain
+ * generated on the CPU or to preview settings on the GPU.
+ *
+ * @code
+ * Noise::Settings settings;
+ * settings.type = Noise::Type::Simplex;
+ * settings.fractal = Noise::Fractal::Ridged;
+ * settings.seed = 42;
+ * Grid2D height = Noise(settings).generate(4096, 4096);
+ * @endcode
+ */
+class Noise {
+public:
+  /** @brief Base noise function. */
+  enum class Type {
+    Value,    ///< Smoothly interpolated random lattice values.
+    Perlin,   ///< Gradient noise on the square lattice.
+    Simplex,  ///< Gradient noise on the simplex lattice, fewer axis artifacts.
+    Worley    ///< Cellular noise, distance to the nearest feature point (F1).
+  };
+
+  /** @brief How octaves of the base noise are combined. */
+  enum class Fractal {
+    None,   ///< A single octave.
+    FBm,    ///< Fractional Brownian motion, sum of octaves.
+    Ridged  ///< Sum of squared, inverted absolute octaves: sharp ridges.
+  };
+
+  /** @brief Parameters of a noise field. */
+  struct Settings {
+    Type type{Type::Perlin};
+    Fractal fractal{Fractal::FBm};
+    uint32_t seed{0};
+    float frequency{1.0f/64.0f};  ///< Lattice cells per grid cell of the first octave.
+    uint32_t octaves{6};          ///< Octaves of FBm and Ridged.
+    float lacunarity{2.0f};       ///< Frequency factor between octaves.
+    float gain{0.5f};             ///< Amplitude factor between octaves.
+    Vec2 offset{0.0f, 0.0f};      ///< Added to grid coordinates before scaling.
+  };
+
+  /** @brief Default settings: six octaves of Perlin fBm. */
+  Noise();
+
+  /** @brief Noise with the given @p settings. */
+  explicit Noise(const Settings& settings);
+
+  const Settings& getSettings() const {return settings;}
+
+  /**
+   * @brief Noise value at grid coordinates (@p x, @p y).
+   *
+   * Scalar evaluation, agrees with @ref evaluateRow() up to rounding.
+   */
+  float evaluate(float x, float y) const;
+
+  /**
+   * @brief Noise values of @p count consecutive cells (x+i, y) in SIMD batches.
+   * @param out Receives @p count values.
+   */
+  void evaluateRow(float x, float y, float* out, size_t count) const;
+
+  /**
+   * @brief Generate a width×height field, cell (x,y) = evaluateRow() at (x,y).
+   * @param layout Memory layout of the result.
+   */
+  Grid2D generate(size_t width, size_t height, MemoryLayout layout=MemoryLayout::Linear) const;
+
+  /** @brief Overwrite every cell of @p grid, in parallel 64×64 tiles. */
+  void fill(Grid2D& grid) const;
+
+  /** @brief Number of cells evaluated per SIMD batch (8, 4 or 1). */
+  static size_t laneCount();
+
+  /**
+   * @brief GLSL source of the noise functions, without a version directive.
+   *
+   * Paste it after the \c #version line of a shader. Provides
+   * \c noiseValue, \c noisePerlin, \c noiseSimplex and \c noiseWorley
+   * (\c float f(vec2 p, uint seed)) and
+   * \c noiseFractal(vec2 p, uint seed, int type, int fractal, int octaves,
+   * float lacunarity, float gain), where \c type and \c fractal are the
+   * integer values of @ref Type and @ref Fractal and \c p is already scaled
+   * by the frequency.
+   */
+  static std::string glsl();
+
+private:
+  Settings settings;
+};
@@ -4,9 +4,6 @@
 #include "OBJFile.h"
 
 OBJFile::OBJFile(const std::string& filename, bool normalize) {
-  Vec3 minVal{};
-  Vec3 maxVal{};
-  
   std::ifstream f(filename);
   std::string line;
   while (std::getline(f, line)) {
@@ -27,18 +24,7 @@ OBJFile::OBJFile(const std::string& filename, bool normalize) {
           std::vector<std::string> vertex = tokenize(line,1);
           if (vertex.size() != 3) continue;
           Vec3 v{fromStr<float>(vertex[0]),fromStr<float>(vertex[1]),fromStr<float>(vertex[2])};
-          
-          if (vertices.empty()) {
-            minVal = v;
-            maxVal = v;
-          } else {
-            for (size_t i = 0;i<3;++i) {
-              minVal[i] = std::min(minVal[i], v[i]);
-              maxVal[i] = std::max(maxVal[i], v[i]);
-            }
-            
-          }
-          
+          bounds.add(v);
           vertices.push_back(v);
         }
       }
@@ -46,14 +32,18 @@ OBJFile::OBJFile(const std::string& filename, bool normalize) {
   }
   f.close();
   
-  if (normalize) {
+  if (normalize && !vertices.empty()) {
+    const Vec3& minVal = bounds.minPos;
+    const Vec3& maxVal = bounds.maxPos;
     Vec3 center = (maxVal + minVal)/2.0f;
     float maxSize = std::max(maxVal[0] - minVal[0], std::max(maxVal[1] - minVal[1], maxVal[2] - minVal[2]));
 
     for (size_t i = 0;i<vertices.size();++i) {
       vertices[i] = (vertices[i] - center) / maxSize;
     }
+    bounds = AABB{(minVal - center) / maxSize, (maxVal - center) / maxSize};
   }
+  boundingSphere = BoundingSphere::fromPoints(vertices);
   
   normals.resize(vertices.size());
   for (const OBJFile::IndexType& triangle : indices) {
@@ -6,6 +6,7 @@
 #include <sstream>
 
 #include "Vec3.h"
+#include "Bounds.h"
 
 /**
  * @file OBJFile.h
@@ -23,6 +24,8 @@
  *    ignored.
  *  - When @p normalize is true, positions are recentered to the AABB center and
  *    uniformly scaled to fit into the unit cube (longest AABB side maps to 1).
+ *  - The AABB and a bounding sphere of the (possibly normalized) positions are
+ *    kept in @ref bounds and @ref boundingSphere for culling.
  */
 class OBJFile {
 public:
@@ -53,6 +56,11 @@ public:
    */
   std::vector<Vec3> normals;
 
+  /** @brief Axis-aligned bounding box of @ref vertices. */
+  AABB bounds;
+  /** @brief Bounding sphere of @ref vertices (centered at the AABB center). */
+  BoundingSphere boundingSphere;
+
 private:
   /** @brief Remove leading ASCII whitespace from a string in-place. */
   void ltrim(std::string &s);
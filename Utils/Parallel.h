@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+/**
+ * @file Parallel.h
+ * @brief Minimal blocking parallel-for built on \c std::thread.
+ *
+ * Splits an index range into contiguous chunks and runs them on up to
+ * \c std::thread::hardware_concurrency() threads (the calling thread takes
+ * the first chunk). Small ranges run inline so callers can use the helper
+ * unconditionally without paying thread start-up cost for tiny workloads.
+ *
+ * Usage:
+ * @code
+ * Parallel::forRange(0, data.size(), [&](size_t begin, size_t end) {
+ *   for (size_t i = begin; i < end; ++i) data[i] *= 2.0f;
+ * });
+ * @endcode
+ */
+namespace Parallel {
+  /**
+   * @brief Number of worker threads used by @ref forRange().
+   * @return Hardware concurrency, at least 1.
+   */
+  inline size_t threadCount() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+  }
+
+  /**
+   * @brief Run @p body over [begin,end) split into contiguous chunks.
+   * @param begin    First index (inclusive).
+   * @param end      Last index (exclusive).
+   * @param body     Callable invoked as body(chunkBegin, chunkEnd).
+   * @param minChunk Minimum number of indices per chunk; ranges not larger than
+   *                 this run inline on the calling thread.
+   * @note Blocks until all chunks are done. @p body must be safe to run
+   *       concurrently on disjoint chunks.
+   */
+  template <typename F>
+  void forRange(size_t begin, size_t end, F&& body, size_t minChunk=1024) {
+    if (end <= begin) return;
+    const size_t count = end - begin;
+    const size_t chunks = std::min(threadCount(), (count + minChunk - 1) / std::max<size_t>(1, minChunk));
+    if (chunks <= 1) {
+      body(begin, end);
+      return;
+    }
+
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+    std::vector<std::thread> workers;
+    workers.reserve(chunks-1);
+    for (size_t c = 1; c < chunks; ++c) {
+      const size_t b = begin + c * chunkSize;
+      const size_t e = std::min(end, b + chunkSize);
+      if (b >= e) break;
+      workers.emplace_back([&body, b, e]() { body(b, e); });
+    }
+    body(begin, std::min(end, begin + chunkSize));
+    for (std::thread& t : workers) t.join();
+  }
+}
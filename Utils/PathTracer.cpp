@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#include "Parallel.h"
+#include "PathTracer.h"
+
+#ifndef M_PI
+constexpr float M_PI = 3.14159265358979323846f;
+#endif
+
+namespace {
+  constexpr uint32_t TILE_SIZE = 16;
+  constexpr uint32_t ROULETTE_DEPTH = 3;  ///< Bounces before Russian roulette may end a path.
+
+  /** @brief Express a z-up local direction around @p n. */
+  Vec3 toWorld(const Vec3& local, const Vec3& n) {
+    const Vec3 helper = std::fabs(n.x) > 0.9f ? Vec3{0.0f, 1.0f, 0.0f} : Vec3{1.0f, 0.0f, 0.0f};
+    const Vec3 t = Vec3::normalize(Vec3::cross(helper, n));
+    const Vec3 b = Vec3::cross(n, t);
+    return t*local.x + b*local.y + n*local.z;
+  }
+
+  float maxComponent(const Vec3& v) {
+    return std::max(v.x, std::max(v.y, v.z));
+  }
+}
+
+PathTracer::PathTracer(const OBJFile& mesh, const Settings& settings) :
+  bvh(mesh),
+  positions(mesh.vertices),
+  normals(mesh.normals),
+  indices(mesh.indices),
+  settings(settings),
+  sampler(settings.sequence),
+  scheduler(Parallel::threadCount()),
+  image(1, 1, 3)
+{
+  for (size_t w = 0;w<scheduler.getWorkerCount();++w) {
+    generators.push_back(std::make_unique<Random>(0x9E3779B9u, uint32_t(w)));
+  }
+}
+
+PathTracer::PathTracer(const OBJFile& mesh) :
+  PathTracer(mesh, Settings{})
+{
+}
+
+void PathTracer::setSettings(const Settings& settings) {
+  this->settings = settings;
+  sampler = Sampler(settings.sequence);
+  reset();
+}
+
+void PathTracer::resize(uint32_t width, uint32_t height) {
+  if (width == this->width && height == this->height) return;
+  this->width = width;
+  this->height = height;
+  scheduler.resize(width, height, TILE_SIZE);
+  image = Image(std::max(1u, width), std::max(1u, height), 3);
+  reset();
+}
+
+void PathTracer::setView(const Mat4& viewMatrix) {
+  const float* a = viewMatrix;
+  const float* b = view;
+  if (std::equal(a, a+16, b)) return;
+  view = viewMatrix;
+
+  const Mat4 cameraToWorld = Mat4::inverse(viewMatrix);
+  frame.eye = (cameraToWorld * Vec4{0.0f, 0.0f, 0.0f, 1.0f}).xyz;
+  frame.right = Vec3::normalize((cameraToWorld * Vec4{1.0f, 0.0f, 0.0f, 0.0f}).xyz);
+  frame.up = Vec3::normalize((cameraToWorld * Vec4{0.0f, 1.0f, 0.0f, 0.0f}).xyz);
+  frame.forward = Vec3::normalize((cameraToWorld * Vec4{0.0f, 0.0f, -1.0f, 0.0f}).xyz);
+  reset();
+}
+
+void PathTracer::reset() {
+  accumulation.assign(size_t(width)*height*3, 0.0f);
+  tileSamples.assign(scheduler.getTileCount(), 0);
+  scheduler.clear();
+  passCount = 0;
+}
+
+size_t PathTracer::advance(double budgetSeconds) {
+  if (width == 0 || height == 0) return 0;
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point deadline = Clock::now() +
+    std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(budgetSeconds));
+
+  std::atomic<size_t> rendered{0};
+  do {
+    if (scheduler.passDone()) scheduler.startPass();
+    Parallel::forRange(0, scheduler.getWorkerCount(), [&](size_t worker, size_t) {
+      TileScheduler::Tile tile;
+      while (Clock::now() < deadline && scheduler.next(worker, tile)) {
+        renderTile(tile, *generators[worker]);
+        ++rendered;
+      }
+    }, 1);
+    if (scheduler.passDone()) ++passCount;
+  } while (Clock::now() < deadline);
+  return rendered;
+}
+
+void PathTracer::renderTile(const TileScheduler::Tile& tile, Random& rng) {
+  const float halfHeight = std::tan(settings.fovY*float(M_PI)/360.0f);
+  const float halfWidth = halfHeight*float(width)/float(height);
+  const uint32_t pass = tileSamples[tile.index];
+  for (uint32_t y = tile.y0;y<tile.y1;++y) {
+    for (uint32_t x = tile.x0;x<tile.x1;++x) {
+      // dimension set 0 jitters the pixel, set 1+n samples bounce n
+      const Sampler::Stream pixel{x, y, 0, pass};
+      Vec2 jitter;
+      sampler.generate2D(&jitter, 1, pixel);
+      // row 0 is the bottom of the view
+      const float sx = (2.0f*(float(x)+jitter.x)/float(width) - 1.0f)*halfWidth;
+      const float sy = (2.0f*(float(y)+jitter.y)/float(height) - 1.0f)*halfHeight;
+      const Ray ray{frame.eye, Vec3::normalize(frame.forward + frame.right*sx + frame.up*sy)};
+      const Vec3 color = radiance(ray, rng, pixel);
+      float* sum = &accumulation[(size_t(y)*width + x)*3];
+      // drop NaN/inf paths instead of poisoning the average
+      if (std::isfinite(color.x) && std::isfinite(color.y) && std::isfinite(color.z)) {
+        sum[0] += color.x;
+        sum[1] += color.y;
+        sum[2] += color.z;
+      }
+    }
+  }
+  ++tileSamples[tile.index];
+}
+
+Vec3 PathTracer::sky(const Vec3& direction) const {
+  const float t = std::max(0.0f, direction.y);
+  return settings.skyHorizon*(1.0f-t) + settings.skyZenith*t;
+}
+
+Vec3 PathTracer::radiance(Ray ray, Random& rng, const Sampler::Stream& pixel) const {
+  const Vec3 sunDirection = Vec3::normalize(settings.sunDirection);
+  const bool sun = maxComponent(settings.sunColor) > 0.0f;
+  Vec3 throughput{1.0f, 1.0f, 1.0f};
+  Vec3 result{0.0f, 0.0f, 0.0f};
+
+  for (uint32_t bounce = 0;bounce<settings.maxBounces;++bounce) {
+    Hit hit;
+    if (!bvh.intersect(ray, hit)) {
+      result = result + throughput*sky(ray.direction);
+      break;
+    }
+
+    const OBJFile::IndexType& tri = indices[hit.triangle];
+    const Vec3 position = ray.origin + ray.direction*hit.t;
+    const Vec3 geometric = Vec3::normalize(Vec3::cross(positions[tri[1]]-positions[tri[0]],
+                                                       positions[tri[2]]-positions[tri[0]]));
+    Vec3 normal = geometric;
+    if (normals.size() == positions.size()) {
+      const float w = 1.0f-hit.u-hit.v;
+      normal = Vec3::normalize(normals[tri[0]]*w + normals[tri[1]]*hit.u + normals[tri[2]]*hit.v);
+    }
+    const float epsilon = 1e-4f*std::max(1.0f, position.length());
+
+    if (settings.material == Material::Glass) {
+      // outward normal, Vec3::refract() picks entering or leaving from its sign
+      const float cosI = Vec3::dot(ray.direction, normal);
+      const float n1 = cosI < 0.0f ? 1.0f : settings.ior;
+      const float n2 = cosI < 0.0f ? settings.ior : 1.0f;
+      const float r0 = ((n1-n2)/(n1+n2))*((n1-n2)/(n1+n2));
+      const float fresnel = r0 + (1.0f-r0)*std::pow(1.0f-std::fabs(cosI), 5.0f);
+      const std::optional<Vec3> refracted = Vec3::refract(ray.direction, normal, settings.ior);
+      const Vec3 direction = (!refracted || rng.rand01() < fresnel)
+        ? Vec3::reflect(ray.direction, normal)
+        : Vec3::normalize(*refracted);
+      const float side = Vec3::dot(direction, geometric) > 0.0f ? 1.0f : -1.0f;
+      ray = Ray{position + geometric*(side*epsilon), direction};
+      throughput = throughput*settings.albedo;
+    } else {
+      // opaque surfaces are shaded from whichever side the ray arrives
+      const Vec3 facing = Vec3::dot(geometric, ray.direction) > 0.0f ? geometric*-1.0f : geometric;
+      if (Vec3::dot(normal, facing) < 0.0f) normal = normal*-1.0f;
+      const Vec3 origin = position + facing*epsilon;
+
+      if (settings.material == Material::Mirror) {
+        ray = Ray{origin, Vec3::normalize(Vec3::reflect(ray.direction, normal))};
+        throughput = throughput*settings.albedo;
+      } else {
+        // next event estimation of the sun, brdf albedo/pi
+        const float cosSun = Vec3::dot(normal, sunDirection);
+        if (sun && cosSun > 0.0f && !bvh.occluded(Ray{origin, sunDirection})) {
+          result = result + throughput*settings.albedo*settings.sunColor*(cosSun/float(M_PI));
+        }
+
+        // uniform hemisphere sample, pdf 1/(2 pi): weight = albedo/pi * cos * 2 pi
+        Vec2 u;
+        sampler.generate2D(&u, 1, {pixel.x, pixel.y, bounce+1, pixel.first});
+        const Vec3 direction = toWorld(Sampler::squareToHemisphere(u), normal);
+        const float cosOut = Vec3::dot(direction, normal);
+        if (cosOut <= 0.0f || Vec3::dot(direction, facing) <= 0.0f) break;
+        ray = Ray{origin, direction};
+        throughput = throughput*settings.albedo*(2.0f*cosOut);
+      }
+    }
+
+    if (bounce >= ROULETTE_DEPTH) {
+      const float survive = std::clamp(maxComponent(throughput), 0.05f, 1.0f);
+      if (rng.rand01() >= survive) break;
+      throughput = throughput/survive;
+    }
+  }
+  return result;
+}
+
+const Image& PathTracer::resolve() {
+  if (width == 0 || height == 0) return image;
+  const size_t tilesX = (width+TILE_SIZE-1)/TILE_SIZE;
+  Parallel::forRange(0, height, [&](size_t begin, size_t end) {
+    for (size_t y = begin;y<end;++y) {
+      for (size_t x = 0;x<width;++x) {
+        const uint32_t samples = tileSamples[(y/TILE_SIZE)*tilesX + x/TILE_SIZE];
+        const float scale = samples > 0 ? settings.exposure/float(samples) : 0.0f;
+        const float* sum = &accumulation[(y*width + x)*3];
+        uint8_t* pixel = &image.data[(y*width + x)*3];
+        for (size_t c = 0;c<3;++c) {
+          // gamma 2.2 to approximate sRGB
+          const float v = std::pow(std::clamp(sum[c]*scale, 0.0f, 1.0f), 1.0f/2.2f);
+          pixel[c] = uint8_t(v*255.0f + 0.5f);
+        }
+      }
+    }
+  }, 16);
+  return image;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "Vec3.h"
+#include "Mat4.h"
+#include "Image.h"
+#include "OBJFile.h"
+#include "Rand.h"
+#include "Sampler.h"
+#include "BVH4.h"
+#include "TileScheduler.h"
+
+/**
+ * @file PathTracer.h
+ * @brief Progressive CPU path tracer that refines an image over many frames.
+ *
+ * Every pass adds one jittered path per pixel to a float accumulation buffer;
+ * the displayed image is the running average, so noise fades while the view
+ * stays still. Paths bounce diffusely (uniform hemisphere samples), as mirrors (Vec3::reflect()) or through
+ * glass (Vec3::refract() with Schlick's Fresnel term), are lit by a sky
+ * gradient, and diffuse hits additionally sample an optional sun directly.
+ * Pixel jitter and bounce directions come from a @ref Sampler, by default a
+ * scrambled Sobol sequence indexed by the pass, which converges noticeably
+ * faster than independent random numbers.
+ *
+ * @ref PathTracer::advance() renders tiles on all cores, handed out by a
+ * work-stealing @ref TileScheduler, until a time budget is used up; a pass
+ * that does not fit continues in the next call. Each tile tracks its own
+ * sample count, so a partially finished pass never biases the average.
+ * Changing the view, size or settings restarts the accumulation.
+ *
+ * In a @ref GLApp the running average is drawn with GLApp::drawImage():
+ * @code
+ * PathTracer tracer(obj);
+ * tracer.resize(640, 360);
+ * // in draw():
+ * tracer.setView(camera.viewMatrix());
+ * tracer.advance(0.012);  // seconds per frame spent on new samples
+ * drawImage(tracer.resolve());
+ * @endcode
+ */
+
+class PathTracer {
+public:
+  /** @brief Surface response of the mesh. */
+  enum class Material {
+    Diffuse,  ///< Lambertian reflection.
+    Mirror,   ///< Perfect specular reflection.
+    Glass     ///< Fresnel-weighted reflection and refraction.
+  };
+
+  /** @brief Material, lighting and camera parameters. */
+  struct Settings {
+    Material material{Material::Diffuse};
+    Vec3 albedo{0.8f, 0.8f, 0.8f};           ///< Reflectance or transmittance color.
+    float ior{1.5f};                         ///< Index of refraction of glass.
+    Vec3 skyZenith{0.15f, 0.3f, 0.6f};       ///< Sky radiance straight up.
+    Vec3 skyHorizon{0.5f, 0.55f, 0.6f};      ///< Sky radiance at and below the horizon.
+    Vec3 sunDirection{0.4f, 0.8f, 0.3f};     ///< Direction towards the sun.
+    Vec3 sunColor{1.8f, 1.7f, 1.5f};         ///< Sun irradiance, zero disables it.
+    uint32_t maxBounces{8};                  ///< Maximum path length.
+    float fovY{45.0f};                       ///< Vertical field of view in degrees.
+    float exposure{1.0f};                    ///< Scale applied before gamma correction.
+    Sampler::Sequence sequence{Sampler::Sequence::Sobol};  ///< Jitter and bounce samples.
+  };
+
+  /**
+   * @brief Build the acceleration structure over @p mesh.
+   * @param mesh     Triangle mesh, normals are used for smooth shading.
+   * @param settings Initial settings.
+   */
+  PathTracer(const OBJFile& mesh, const Settings& settings);
+
+  /** @brief Build over @p mesh with default settings. */
+  explicit PathTracer(const OBJFile& mesh);
+
+  /** @brief Change the settings and restart the accumulation. */
+  void setSettings(const Settings& settings);
+  /** @brief Current settings. */
+  const Settings& getSettings() const {return settings;}
+
+  /** @brief Set the image size, restarts the accumulation if it changed. */
+  void resize(uint32_t width, uint32_t height);
+
+  /**
+   * @brief Set the camera from a view matrix (e.g. Camera::viewMatrix()).
+   *
+   * Restarts the accumulation if the matrix differs from the previous one.
+   */
+  void setView(const Mat4& viewMatrix);
+
+  /** @brief Discard all samples. */
+  void reset();
+
+  /**
+   * @brief Render tiles until @p budgetSeconds have passed.
+   *
+   * Workers stop taking tiles once the budget is used up, so a call returns
+   * after the budget plus at most one tile per worker.
+   * @return Number of tiles rendered.
+   */
+  size_t advance(double budgetSeconds);
+
+  /**
+   * @brief Running average as an 8 bit RGB image, row 0 is the bottom.
+   *
+   * Rows are bottom to top as GLApp::drawImage() expects.
+   */
+  const Image& resolve();
+
+  /** @brief Completed passes, i.e. samples per pixel everywhere. */
+  uint32_t getPassCount() const {return passCount;}
+  /** @brief Tiles stolen by the scheduler since construction. */
+  size_t getStolenTiles() const {return scheduler.getStolenCount();}
+  uint32_t getWidth() const {return width;}
+  uint32_t getHeight() const {return height;}
+
+private:
+  /** @brief Camera basis derived from the view matrix. */
+  struct Frame {
+    Vec3 eye{0.0f, 0.0f, 0.0f};
+    Vec3 forward{0.0f, 0.0f, -1.0f};
+    Vec3 right{1.0f, 0.0f, 0.0f};
+    Vec3 up{0.0f, 1.0f, 0.0f};
+  };
+
+  BVH4 bvh;
+  std::vector<Vec3> positions;
+  std::vector<Vec3> normals;
+  std::vector<OBJFile::IndexType> indices;
+
+  Settings settings;
+  Sampler sampler;
+  Frame frame;
+  Mat4 view;
+  uint32_t width{0}, height{0};
+
+  TileScheduler scheduler;
+  std::vector<std::unique_ptr<Random>> generators;  ///< One per worker.
+  std::vector<float> accumulation;                  ///< RGB sums per pixel.
+  std::vector<uint32_t> tileSamples;                ///< Samples per tile.
+  uint32_t passCount{0};
+  Image image;
+
+  void renderTile(const TileScheduler::Tile& tile, Random& rng);
+  Vec3 radiance(Ray ray, Random& rng, const Sampler::Stream& pixel) const;
+  Vec3 sky(const Vec3& direction) const;
+};
@@ -1,52 +1,142 @@
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAND_USE_SSE
+#include <emmintrin.h>
+#endif
+
 #include "Rand.h"
 
 #ifndef M_PI
 constexpr float M_PI = 3.14159265358979323846f;
 #endif
 
-Random::Random() :
-rd{},
-gen{rd()},
-dis01{0.0f, 1.0f},
-dis11{-1.0f, 1.0f},
-disPi{0.0f, 2.0f * float(M_PI)},
-dis005{0.0f, 0.5f},
-dis051{0.5f, 1.0f}
-{
-  
+namespace {
+  constexpr float TO_FLOAT = 1.0f/16777216.0f;  ///< 2^-24, maps the upper 24 bits to [0,1).
+
+  uint64_t splitMix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  inline uint32_t rotl(uint32_t x, int k) {
+    return (x << k) | (x >> (32 - k));
+  }
+
+  /** @brief One xoshiro128+ step on four words s0..s3. */
+  inline uint32_t step(uint32_t& s0, uint32_t& s1, uint32_t& s2, uint32_t& s3) {
+    const uint32_t result = s0 + s3;
+    const uint32_t t = s1 << 9;
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+    s2 ^= t;
+    s3 = rotl(s3, 11);
+    return result;
+  }
+
+  /** @brief Bulk fill of scale*u + offset, u in [0,1), four streams at a time. */
+  void fillLanes(uint32_t* lanes, float* out, size_t count, float scale, float offset) {
+    size_t i = 0;
+#ifdef RAND_USE_SSE
+    __m128i s0 = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes+0));
+    __m128i s1 = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes+4));
+    __m128i s2 = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes+8));
+    __m128i s3 = _mm_load_si128(reinterpret_cast<const __m128i*>(lanes+12));
+    const __m128 scale4 = _mm_set1_ps(scale*TO_FLOAT);
+    const __m128 offset4 = _mm_set1_ps(offset);
+    for (;i+4<=count;i+=4) {
+      const __m128i result = _mm_add_epi32(s0, s3);
+      const __m128i t = _mm_slli_epi32(s1, 9);
+      s2 = _mm_xor_si128(s2, s0);
+      s3 = _mm_xor_si128(s3, s1);
+      s1 = _mm_xor_si128(s1, s2);
+      s0 = _mm_xor_si128(s0, s3);
+      s2 = _mm_xor_si128(s2, t);
+      s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+      // the upper 24 bits are exact in a float and positive as int32
+      const __m128 value = _mm_cvtepi32_ps(_mm_srli_epi32(result, 8));
+      _mm_storeu_ps(out+i, _mm_add_ps(_mm_mul_ps(value, scale4), offset4));
+    }
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes+0), s0);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes+4), s1);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes+8), s2);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes+12), s3);
+#endif
+    // scalar path, same streams and order as the SSE loop
+    for (;i<count;i+=4) {
+      for (size_t l = 0;l<4 && i+l<count;++l) {
+        const uint32_t result = step(lanes[l], lanes[4+l], lanes[8+l], lanes[12+l]);
+        out[i+l] = float(result >> 8)*(scale*TO_FLOAT) + offset;
+      }
+    }
+  }
+}
+
+Random::Random() {
+  std::random_device rd;
+  seed(uint64_t(rd()) << 32 | rd());
 }
 
-Random::Random(uint32_t seed)  :
-rd{},
-gen{seed},
-dis01{0.0f, 1.0f},
-dis11{-1.0f, 1.0f},
-disPi{0.0f, 2.0f * float(M_PI)},
-dis005{0.0f, 0.5f},
-dis051{0.5f, 1.0f}
-{
+Random::Random(uint32_t seed) {
+  this->seed(seed);
 }
 
+Random::Random(uint32_t seed, uint32_t stream) {
+  this->seed(uint64_t(stream) << 32 | seed);
+}
 
+void Random::seed(uint64_t value) {
+  // splitmix64 output is never all zero for all four words, which xoshiro forbids
+  for (size_t i = 0;i<4;i+=2) {
+    const uint64_t z = splitMix64(value);
+    state[i] = uint32_t(z);
+    state[i+1] = uint32_t(z >> 32);
+  }
+  for (size_t i = 0;i<16;i+=2) {
+    const uint64_t z = splitMix64(value);
+    lanes[i] = uint32_t(z);
+    lanes[i+1] = uint32_t(z >> 32);
+  }
+}
+
+uint32_t Random::next() {
+  return step(state[0], state[1], state[2], state[3]);
+}
 
 float Random::rand01() {
-    return dis01(gen);
+  return float(next() >> 8)*TO_FLOAT;
 }
 
 float Random::rand005() {
-    return dis005(gen);
+  return rand01()*0.5f;
 }
 
 float Random::rand051() {
-    return dis051(gen);
+  return 0.5f + rand01()*0.5f;
 }
 
 float Random::rand11() {
-    return dis11(gen);
+  return rand01()*2.0f - 1.0f;
 }
 
 float Random::rand0Pi() {
-    return disPi(gen);
+  return rand01()*(2.0f*float(M_PI));
+}
+
+void Random::fill01(float* out, size_t count) {
+  fillLanes(lanes.data(), out, count, 1.0f, 0.0f);
+}
+
+void Random::fill11(float* out, size_t count) {
+  fillLanes(lanes.data(), out, count, 2.0f, -1.0f);
+}
+
+void Random::fill(float* out, size_t count, float a, float b) {
+  fillLanes(lanes.data(), out, count, b-a, a);
 }
 
-Random staticRand;
+thread_local Random staticRand;
@@ -0,0 +1,287 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+#include "Parallel.h"
+#include "RayTracer.h"
+
+#ifndef M_PI
+constexpr float M_PI = 3.14159265358979323846f;
+#endif
+
+namespace {
+  constexpr uint32_t TILE_SIZE = 16;
+
+  uint8_t toByte(float v) {
+    return uint8_t(std::clamp(v, 0.0f, 1.0f)*255.0f + 0.5f);
+  }
+
+  uint32_t popCount(uint32_t mask) {
+    uint32_t count = 0;
+    for (;mask;mask &= mask-1) ++count;
+    return count;
+  }
+
+  double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+std::string RayTracer::Stats::toString() const {
+  std::stringstream s;
+  s << std::fixed << std::setprecision(2)
+    << double(rays())/1e6 << "M rays (" << primaryRays << " primary, " << shadowRays << " shadow, "
+    << reflectionRays << " reflection) in " << seconds << "s ("
+    << raysPerSecond()/1e6 << " Mrays/s)";
+  return s.str();
+}
+
+std::string RayTracer::TraversalBenchmark::toString() const {
+  std::stringstream s;
+  s << std::fixed << std::setprecision(2);
+  const auto line = [&](const char* name, double seconds) {
+    s << name << (seconds > 0.0 ? double(rays)/seconds/1e6 : 0.0) << " Mrays/s ("
+      << (seconds > 0.0 ? scalarSeconds/seconds : 0.0) << "x)\n";
+  };
+  line("scalar BVH:   ", scalarSeconds);
+  line("BVH4 single:  ", wideSeconds);
+  line("BVH4 packets: ", packetSeconds);
+  s << rays << " rays, " << mismatches << " mismatches" << (BVH4::usesSIMD() ? "" : " (no SIMD)");
+  return s.str();
+}
+
+RayTracer::Frame::Frame(uint32_t width, uint32_t height, const View& view) :
+  eye(view.eye),
+  forward(Vec3::normalize(view.target - view.eye)),
+  right(Vec3::normalize(Vec3::cross(forward, view.up))),
+  up(Vec3::cross(right, forward)),
+  halfWidth(0.0f),
+  halfHeight(std::tan(view.fovY*float(M_PI)/360.0f)),
+  width(width),
+  height(height)
+{
+  halfWidth = halfHeight*float(width)/float(std::max(1u, height));
+}
+
+Ray RayTracer::Frame::primary(uint32_t x, uint32_t y) const {
+  const float sx = (2.0f*(float(x)+0.5f)/float(width) - 1.0f)*halfWidth;
+  const float sy = (2.0f*(float(y)+0.5f)/float(height) - 1.0f)*halfHeight;
+  return Ray{eye, Vec3::normalize(forward + right*sx + up*sy)};
+}
+
+RayTracer::RayTracer(const OBJFile& mesh) :
+  bvh(mesh),
+  wide(bvh),
+  positions(mesh.vertices),
+  normals(mesh.normals),
+  indices(mesh.indices)
+{
+}
+
+bool RayTracer::intersect(const Ray& ray, Hit& hit, Traversal traversal) const {
+  return traversal == Traversal::Scalar ? bvh.intersect(ray, hit) : wide.intersect(ray, hit);
+}
+
+bool RayTracer::occluded(const Ray& ray, Traversal traversal) const {
+  return traversal == Traversal::Scalar ? bvh.occluded(ray) : wide.occluded(ray);
+}
+
+void RayTracer::surface(const Ray& ray, const Hit& hit, Vec3& normal, Vec3& origin) const {
+  const OBJFile::IndexType& tri = indices[hit.triangle];
+  const Vec3 position = ray.origin + ray.direction*hit.t;
+  const float w = 1.0f-hit.u-hit.v;
+  normal = normals.size() == positions.size()
+    ? normals[tri[0]]*w + normals[tri[1]]*hit.u + normals[tri[2]]*hit.v
+    : Vec3::cross(positions[tri[1]]-positions[tri[0]], positions[tri[2]]-positions[tri[0]]);
+  normal = Vec3::normalize(normal);
+  if (Vec3::dot(normal, ray.direction) > 0.0f) normal = normal*-1.0f;
+
+  // offset secondary rays along the normal to avoid self intersections
+  const float epsilon = 1e-4f*std::max(1.0f, position.length());
+  origin = position + normal*epsilon;
+}
+
+Vec3 RayTracer::trace(const Ray& ray, const Settings& settings, uint32_t depth, Counters& counters) const {
+  Hit hit;
+  if (!intersect(ray, hit, settings.traversal)) return settings.background;
+  Vec3 normal, origin;
+  surface(ray, hit, normal, origin);
+  return shade(ray, normal, origin, settings, depth, -1, counters);
+}
+
+Vec3 RayTracer::shade(const Ray& ray, const Vec3& normal, const Vec3& origin, const Settings& settings,
+                      uint32_t depth, int lit, Counters& counters) const {
+  const Vec3 toLight = settings.lightPosition - origin;
+  float lambert = std::max(0.0f, Vec3::dot(normal, Vec3::normalize(toLight)));
+  if (lambert > 0.0f && settings.shadows) {
+    if (lit < 0) {
+      ++counters.shadowRays;
+      lit = occluded(Ray{origin, toLight, 0.0f, 1.0f}, settings.traversal) ? 0 : 1;
+    }
+    lambert *= float(lit);
+  }
+  Vec3 color = settings.diffuse*(settings.ambient + lambert*(1.0f-settings.ambient));
+
+  if (settings.reflectivity > 0.0f && depth < settings.maxDepth) {
+    ++counters.reflectionRays;
+    const Vec3 direction = Vec3::reflect(Vec3::normalize(ray.direction), normal);
+    color = color*(1.0f-settings.reflectivity) +
+            trace(Ray{origin, direction}, settings, depth+1, counters)*settings.reflectivity;
+  }
+  return color;
+}
+
+void RayTracer::renderTile(Image& image, const Frame& frame, const Settings& settings,
+                           uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, Counters& counters) const {
+  const auto write = [&](uint32_t x, uint32_t y, const Vec3& color) {
+    const size_t index = image.computeIndex(x, y, 0);
+    image.data[index+0] = toByte(color.r);
+    image.data[index+1] = toByte(color.g);
+    image.data[index+2] = toByte(color.b);
+  };
+
+  if (settings.traversal != Traversal::Packet) {
+    for (uint32_t y = y0;y<y1;++y) {
+      for (uint32_t x = x0;x<x1;++x) {
+        write(x, y, trace(frame.primary(x, y), settings, 0, counters));
+      }
+    }
+    return;
+  }
+
+  for (uint32_t y = y0;y<y1;y+=2) {
+    for (uint32_t x = x0;x<x1;x+=2) {
+      // 2x2 quad, lanes outside the tile repeat the first ray and are masked off
+      RayPacket rays;
+      uint32_t mask = 0;
+      for (uint32_t i = 0;i<4;++i) {
+        const uint32_t px = x + (i&1), py = y + (i>>1);
+        const bool inside = px < x1 && py < y1;
+        rays[i] = inside ? frame.primary(px, py) : rays[0];
+        mask |= uint32_t(inside) << i;
+      }
+
+      std::array<Hit, 4> hits;
+      const uint32_t hitMask = wide.intersect(rays, hits, mask);
+
+      RayPacket shadowRays = rays;
+      std::array<Vec3, 4> hitNormals, origins;
+      uint32_t shadowMask = 0;
+      for (uint32_t i = 0;i<4;++i) {
+        if (!(hitMask & (1u << i))) continue;
+        surface(rays[i], hits[i], hitNormals[i], origins[i]);
+        const Vec3 toLight = settings.lightPosition - origins[i];
+        shadowRays[i] = Ray{origins[i], toLight, 0.0f, 1.0f};
+        if (settings.shadows && Vec3::dot(hitNormals[i], toLight) > 0.0f) shadowMask |= 1u << i;
+      }
+      const uint32_t occludedMask = shadowMask ? wide.occluded(shadowRays, shadowMask) : 0;
+      counters.shadowRays += popCount(shadowMask);
+
+      for (uint32_t i = 0;i<4;++i) {
+        if (!(mask & (1u << i))) continue;
+        const Vec3 color = (hitMask & (1u << i))
+          ? shade(rays[i], hitNormals[i], origins[i], settings, 0, (occludedMask & (1u << i)) ? 0 : 1, counters)
+          : settings.background;
+        write(x + (i&1), y + (i>>1), color);
+      }
+    }
+  }
+}
+
+Image RayTracer::render(uint32_t width, uint32_t height, const Settings& settings) {
+  const auto start = std::chrono::steady_clock::now();
+  Image image(width, height, 3);
+  const Frame frame(width, height, settings.view);
+
+  const uint32_t tilesX = (width+TILE_SIZE-1)/TILE_SIZE;
+  const uint32_t tilesY = (height+TILE_SIZE-1)/TILE_SIZE;
+  const size_t tileCount = size_t(tilesX)*tilesY;
+
+  std::atomic<size_t> nextTile{0};
+  std::mutex statsMutex;
+  Counters total;
+
+  Parallel::forRange(0, Parallel::threadCount(), [&](size_t, size_t) {
+    Counters counters;
+    for (size_t tile = nextTile++;tile<tileCount;tile = nextTile++) {
+      const uint32_t x0 = uint32_t(tile%tilesX)*TILE_SIZE;
+      const uint32_t y0 = uint32_t(tile/tilesX)*TILE_SIZE;
+      renderTile(image, frame, settings, x0, y0,
+                 std::min(width, x0+TILE_SIZE), std::min(height, y0+TILE_SIZE), counters);
+    }
+    std::scoped_lock lock(statsMutex);
+    total.shadowRays += counters.shadowRays;
+    total.reflectionRays += counters.reflectionRays;
+  }, 1);
+
+  stats.primaryRays = size_t(width)*height;
+  stats.shadowRays = total.shadowRays;
+  stats.reflectionRays = total.reflectionRays;
+  stats.seconds = secondsSince(start);
+  return image;
+}
+
+RayTracer::TraversalBenchmark RayTracer::benchmarkTraversal(uint32_t width, uint32_t height,
+                                                            const View& view, uint32_t repeat) const {
+  const Frame frame(width, height, view);
+  TraversalBenchmark result;
+
+  // quad-major ray order so the packet path and the single ray paths see the same
+  // rays; odd sizes repeat the edge pixels
+  std::vector<Ray> rays;
+  rays.reserve(size_t(width+1)*(height+1));
+  for (uint32_t y = 0;y<height;y+=2) {
+    for (uint32_t x = 0;x<width;x+=2) {
+      for (uint32_t i = 0;i<4;++i) {
+        const uint32_t px = std::min(width-1, x + (i&1)), py = std::min(height-1, y + (i>>1));
+        rays.push_back(frame.primary(px, py));
+      }
+    }
+  }
+
+  result.rays = rays.size();
+
+  std::vector<float> reference(rays.size()), wideT(rays.size()), packetT(rays.size());
+  const auto fastest = [&](auto&& pass) {
+    double best = std::numeric_limits<double>::infinity();
+    for (uint32_t r = 0;r<std::max(1u, repeat);++r) {
+      const auto start = std::chrono::steady_clock::now();
+      pass();
+      best = std::min(best, secondsSince(start));
+    }
+    return best;
+  };
+
+  result.scalarSeconds = fastest([&]() {
+    for (size_t i = 0;i<rays.size();++i) {
+      Hit hit;
+      reference[i] = bvh.intersect(rays[i], hit) ? hit.t : -1.0f;
+    }
+  });
+  result.wideSeconds = fastest([&]() {
+    for (size_t i = 0;i<rays.size();++i) {
+      Hit hit;
+      wideT[i] = wide.intersect(rays[i], hit) ? hit.t : -1.0f;
+    }
+  });
+  result.packetSeconds = fastest([&]() {
+    for (size_t i = 0;i<rays.size();i+=4) {
+      RayPacket packet;
+      std::array<Hit, 4> hits;
+      std::copy(rays.begin()+std::ptrdiff_t(i), rays.begin()+std::ptrdiff_t(i+4), packet.begin());
+      const uint32_t mask = wide.intersect(packet, hits);
+      for (size_t k = 0;k<4;++k) packetT[i+k] = (mask & (1u << k)) ? hits[k].t : -1.0f;
+    }
+  });
+
+  for (size_t i = 0;i<rays.size();++i) {
+    const float tolerance = 1e-4f*std::max(1.0f, reference[i]);
+    if (std::fabs(wideT[i]-reference[i]) > tolerance || std::fabs(packetT[i]-reference[i]) > tolerance) {
+      ++result.mismatches;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <string>
+
+#include "Vec3.h"
+#include "Image.h"
+#include "OBJFile.h"
+#include "BVH.h"
+#include "BVH4.h"
+
+/**
+ * @file RayTracer.h
+ * @brief Multithreaded Whitted-style CPU ray tracer for OBJ meshes.
+ *
+ * Traces primary rays through a pinhole camera, shades hits with a Lambert
+ * term plus ambient light, casts shadow rays towards a point light and follows
+ * mirror reflections up to a fixed depth. Normals are interpolated from the
+ * mesh's vertex normals.
+ *
+ * The image is split into 16x16 tiles that worker threads fetch from a shared
+ * atomic counter, so expensive tiles (reflective regions) do not stall a
+ * statically assigned thread.
+ *
+ * Rays are traced through a binary @ref BVH or a four-wide @ref BVH4; with
+ * @ref RayTracer::Traversal::Packet the camera rays of every 2x2 pixel quad
+ * and their shadow rays are traced together as ray packets.
+ * @ref RayTracer::benchmarkTraversal() compares the three paths on the same
+ * camera rays.
+ *
+ * @code
+ * OBJFile obj("teapot.obj", true);
+ * RayTracer tracer(obj);
+ * RayTracer::Settings settings;
+ * settings.view.eye = Vec3{0,1,4};
+ * Image image = tracer.render(640, 480, settings);
+ * std::cout << tracer.getStats().toString() << std::endl;
+ * @endcode
+ */
+
+class RayTracer {
+public:
+  /** @brief How rays traverse the scene. */
+  enum class Traversal {
+    Scalar,  ///< One ray at a time through the binary BVH.
+    Wide,    ///< One ray at a time through the four-wide BVH.
+    Packet   ///< 2x2 packets of camera and shadow rays through the four-wide BVH.
+  };
+
+  /** @brief Pinhole camera. */
+  struct View {
+    Vec3 eye{0.0f, 0.0f, 5.0f};    ///< Camera position.
+    Vec3 target{0.0f, 0.0f, 0.0f}; ///< Point the camera looks at.
+    Vec3 up{0.0f, 1.0f, 0.0f};     ///< Up direction.
+    float fovY{45.0f};             ///< Vertical field of view in degrees.
+  };
+
+  /** @brief Camera, light and material of a render. */
+  struct Settings {
+    View view;
+    Vec3 lightPosition{5.0f, 10.0f, 5.0f};   ///< Point light position.
+    Vec3 diffuse{0.8f, 0.7f, 0.6f};          ///< Diffuse surface color.
+    float ambient{0.1f};                     ///< Ambient light intensity.
+    float reflectivity{0.2f};                ///< Fraction of light mirrored, 0 disables reflection rays.
+    uint32_t maxDepth{3};                    ///< Maximum number of reflection bounces.
+    Vec3 background{0.2f, 0.2f, 0.3f};       ///< Color of rays that leave the scene.
+    bool shadows{true};                      ///< Cast shadow rays.
+    Traversal traversal{Traversal::Packet};  ///< Traversal used for all rays.
+  };
+
+  /** @brief Ray counts and timing of the last render. */
+  struct Stats {
+    size_t primaryRays{0};
+    size_t shadowRays{0};
+    size_t reflectionRays{0};
+    double seconds{0.0};
+
+    size_t rays() const {return primaryRays+shadowRays+reflectionRays;}
+    double raysPerSecond() const {return seconds > 0.0 ? double(rays())/seconds : 0.0;}
+    /** @brief Summary line such as "1.2M rays in 0.05s (24.0 Mrays/s)". */
+    std::string toString() const;
+  };
+
+  /** @brief Timings of @ref benchmarkTraversal(). */
+  struct TraversalBenchmark {
+    size_t rays{0};
+    double scalarSeconds{0.0};  ///< Binary BVH, single rays.
+    double wideSeconds{0.0};    ///< Four-wide BVH, single rays.
+    double packetSeconds{0.0};  ///< Four-wide BVH, 2x2 packets.
+    size_t mismatches{0};       ///< Rays whose wide or packet hit differs from the scalar one.
+
+    /** @brief One line per traversal with Mrays/s and the speedup over the scalar path. */
+    std::string toString() const;
+  };
+
+  /**
+   * @brief Build the BVHs over @p mesh.
+   * @param mesh Triangle mesh, normals are used for smooth shading.
+   */
+  explicit RayTracer(const OBJFile& mesh);
+
+  /**
+   * @brief Render the mesh.
+   * @param width    Image width in pixels.
+   * @param height   Image height in pixels.
+   * @param settings Camera, light and material.
+   * @return RGB image, row 0 is the bottom of the view (as BMP::save() and
+   *         GLApp::drawImage() expect).
+   */
+  Image render(uint32_t width, uint32_t height, const Settings& settings);
+
+  /**
+   * @brief Time closest-hit queries of the camera rays of a view on one thread.
+   * @param width      Horizontal ray count.
+   * @param height     Vertical ray count.
+   * @param view       Camera.
+   * @param repeat     Number of passes per traversal, the fastest is reported.
+   */
+  TraversalBenchmark benchmarkTraversal(uint32_t width, uint32_t height, const View& view,
+                                        uint32_t repeat=3) const;
+
+  /** @brief Statistics of the last @ref render() call. */
+  const Stats& getStats() const {return stats;}
+
+  /** @brief The binary acceleration structure. */
+  const BVH& getBVH() const {return bvh;}
+  /** @brief The four-wide acceleration structure. */
+  const BVH4& getBVH4() const {return wide;}
+
+private:
+  struct Counters {
+    size_t shadowRays{0};
+    size_t reflectionRays{0};
+  };
+
+  /** @brief Camera basis of a render. */
+  struct Frame {
+    Vec3 eye, forward, right, up;
+    float halfWidth, halfHeight;
+    uint32_t width, height;
+
+    Frame(uint32_t width, uint32_t height, const View& view);
+    Ray primary(uint32_t x, uint32_t y) const;
+  };
+
+  BVH bvh;
+  BVH4 wide;
+  std::vector<Vec3> positions;
+  std::vector<Vec3> normals;
+  std::vector<OBJFile::IndexType> indices;
+  Stats stats;
+
+  bool intersect(const Ray& ray, Hit& hit, Traversal traversal) const;
+  bool occluded(const Ray& ray, Traversal traversal) const;
+  Vec3 trace(const Ray& ray, const Settings& settings, uint32_t depth, Counters& counters) const;
+  /** @brief Shading normal facing the ray and the offset origin of secondary rays. */
+  void surface(const Ray& ray, const Hit& hit, Vec3& normal, Vec3& origin) const;
+  /**
+   * @brief Color of a hit.
+   * @param lit 1 if the light is visible, 0 if not, -1 to cast the shadow ray here.
+   */
+  Vec3 shade(const Ray& ray, const Vec3& normal, const Vec3& origin, const Settings& settings,
+             uint32_t depth, int lit, Counters& counters) const;
+  void renderTile(Image& image, const Frame& frame, const Settings& settings,
+                  uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, Counters& counters) const;
+};
@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+#include "Rand.h"
+#include "Sampler.h"
+
+#ifndef M_PI
+constexpr float M_PI = 3.14159265358979323846f;
+#endif
+
+namespace {
+  constexpr uint32_t SOBOL_DIMENSIONS = 3;
+  constexpr uint32_t BLUE_NOISE_SIZE = 64;
+  constexpr uint32_t GOLDEN = 0x9E3779B9u;  ///< 2^32/phi, spreads consecutive values in combine().
+
+  /** @brief Map the upper 24 bits of a 0.32 fixed point value to a float in [0,1). */
+  inline float toFloat(uint32_t x) {
+    return float(x >> 8)*(1.0f/16777216.0f);
+  }
+
+  inline uint32_t toFixed(double x) {
+    return uint32_t(x*4294967296.0);
+  }
+
+  /** @brief Integer finalizer with low bias (lowbias32). */
+  inline uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+  }
+
+  inline uint32_t combine(uint32_t seed, uint32_t value) {
+    return hash(seed ^ (value + GOLDEN + (seed << 6) + (seed >> 2)));
+  }
+
+  inline uint32_t reverseBits(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+  }
+
+  /** @brief Hash that only propagates bits upwards (Laine and Karras). */
+  inline uint32_t laineKarras(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x*0x6c50b47cu;
+    x ^= x*0xb82f1e52u;
+    x ^= x*0xc7afe638u;
+    x ^= x*0x8d22f6e6u;
+    return x;
+  }
+
+  /** @brief Nested uniform (Owen) scramble of the bits of @p x. */
+  inline uint32_t owenScramble(uint32_t x, uint32_t seed) {
+    return reverseBits(laineKarras(reverseBits(x), seed));
+  }
+
+  /** @brief Sobol direction numbers from the Joe-Kuo primitive polynomials. */
+  std::array<std::array<uint32_t, 32>, SOBOL_DIMENSIONS> sobolDirections() {
+    std::array<std::array<uint32_t, 32>, SOBOL_DIMENSIONS> v;
+    for (uint32_t i = 0;i<32;++i) v[0][i] = 1u << (31-i);
+
+    struct Polynomial {uint32_t s, a; std::array<uint32_t, 3> m;};
+    const Polynomial polynomials[SOBOL_DIMENSIONS-1] = {{1, 0, {1, 0, 0}}, {2, 1, {1, 3, 0}}};
+    for (uint32_t d = 1;d<SOBOL_DIMENSIONS;++d) {
+      const Polynomial& p = polynomials[d-1];
+      for (uint32_t i = 0;i<32;++i) {
+        if (i < p.s) {
+          v[d][i] = p.m[i] << (31-i);
+          continue;
+        }
+        v[d][i] = v[d][i-p.s] ^ (v[d][i-p.s] >> p.s);
+        for (uint32_t k = 1;k<p.s;++k) {
+          if ((p.a >> (p.s-1-k)) & 1) v[d][i] ^= v[d][i-k];
+        }
+      }
+    }
+    return v;
+  }
+
+  inline uint32_t sobol(uint32_t index, const std::array<uint32_t, 32>& directions) {
+    uint32_t result = 0;
+    for (uint32_t bit = 0;index;index >>= 1, ++bit) {
+      result ^= directions[bit] & (0u - (index & 1));
+    }
+    return result;
+  }
+
+  double radicalInverse(uint32_t base, uint32_t n) {
+    const double inverse = 1.0/base;
+    double factor = inverse;
+    double result = 0.0;
+    for (;n;n /= base) {
+      result += (n%base)*factor;
+      factor *= inverse;
+    }
+    return result;
+  }
+
+  /** @brief 0.32 fixed point steps of the R-sequence in @p dimensions dimensions. */
+  std::array<uint32_t, 3> r2Steps(uint32_t dimensions) {
+    // the generalized golden ratio is the positive root of x^(d+1) = x+1
+    double g = 2.0;
+    for (int i = 0;i<32;++i) g = std::pow(1.0+g, 1.0/(dimensions+1));
+    std::array<uint32_t, 3> steps{};
+    double a = 1.0;
+    for (uint32_t d = 0;d<dimensions;++d) {
+      a /= g;
+      steps[d] = toFixed(a - std::floor(a));
+    }
+    return steps;
+  }
+
+  /** @brief Void-and-cluster ranks (Ulichney 1993) on a toroidal grid. */
+  std::vector<uint32_t> voidAndCluster(uint32_t size) {
+    const uint32_t count = size*size;
+    const float sigma = 1.5f;
+    std::vector<float> kernel(count);
+    for (uint32_t y = 0;y<size;++y) {
+      for (uint32_t x = 0;x<size;++x) {
+        const float dx = float(std::min(x, size-x));
+        const float dy = float(std::min(y, size-y));
+        kernel[y*size+x] = std::exp(-(dx*dx+dy*dy)/(2.0f*sigma*sigma));
+      }
+    }
+
+    std::vector<uint8_t> pattern(count, 0);
+    std::vector<float> energy(count, 0.0f);
+    auto toggle = [&](std::vector<uint8_t>& p, std::vector<float>& e, uint32_t index) {
+      const float sign = p[index] ? -1.0f : 1.0f;
+      p[index] = !p[index];
+      const uint32_t px = index%size, py = index/size;
+      for (uint32_t y = 0;y<size;++y) {
+        const uint32_t ky = ((y+size-py)%size)*size;
+        for (uint32_t x = 0;x<size;++x) {
+          e[y*size+x] += sign*kernel[ky + (x+size-px)%size];
+        }
+      }
+    };
+    auto tightestCluster = [&](const std::vector<uint8_t>& p, const std::vector<float>& e) {
+      uint32_t best = 0;
+      float bestEnergy = -1.0f;
+      for (uint32_t i = 0;i<count;++i) {
+        if (p[i] && e[i] > bestEnergy) {bestEnergy = e[i]; best = i;}
+      }
+      return best;
+    };
+    auto largestVoid = [&](const std::vector<uint8_t>& p, const std::vector<float>& e) {
+      uint32_t best = 0;
+      float bestEnergy = std::numeric_limits<float>::max();
+      for (uint32_t i = 0;i<count;++i) {
+        if (!p[i] && e[i] < bestEnergy) {bestEnergy = e[i]; best = i;}
+      }
+      return best;
+    };
+
+    // initial pattern: random 10% of the pixels, relaxed until stable
+    Random rng(0x5eed);
+    const uint32_t initial = count/10;
+    for (uint32_t placed = 0;placed<initial;) {
+      const uint32_t index = std::min(count-1, uint32_t(rng.rand01()*count));
+      if (pattern[index]) continue;
+      toggle(pattern, energy, index);
+      ++placed;
+    }
+    for (uint32_t iteration = 0;iteration<count;++iteration) {
+      const uint32_t cluster = tightestCluster(pattern, energy);
+      toggle(pattern, energy, cluster);
+      const uint32_t hole = largestVoid(pattern, energy);
+      toggle(pattern, energy, hole);
+      if (hole == cluster) break;
+    }
+
+    std::vector<uint32_t> rank(count, 0);
+    {
+      // ranks below the initial pattern: remove the tightest clusters first
+      std::vector<uint8_t> p = pattern;
+      std::vector<float> e = energy;
+      for (uint32_t r = initial;r>0;--r) {
+        const uint32_t cluster = tightestCluster(p, e);
+        toggle(p, e, cluster);
+        rank[cluster] = r-1;
+      }
+    }
+    // ranks above: fill the largest voids
+    for (uint32_t r = initial;r<count;++r) {
+      const uint32_t hole = largestVoid(pattern, energy);
+      toggle(pattern, energy, hole);
+      rank[hole] = r;
+    }
+    return rank;
+  }
+
+  inline float below1(float x) {
+    return std::min(x, 0.99999994f);
+  }
+}
+
+Sampler::Sampler(Sequence sequence, uint32_t seed) :
+  sequence(sequence),
+  seed(seed)
+{
+}
+
+void Sampler::generate(float* out, size_t count, uint32_t dimensions, const Stream& stream) const {
+  const uint32_t streamSeed = combine(combine(combine(hash(seed), stream.x), stream.y), stream.dimension);
+
+  switch (sequence) {
+    case Sequence::Random : {
+      Random rng(streamSeed, stream.first);
+      rng.fill01(out, count*dimensions);
+      break;
+    }
+    case Sequence::Stratified : {
+      Random rng(streamSeed, stream.first);
+      uint32_t cellsPerAxis = std::max(1u, uint32_t(std::pow(double(count), 1.0/dimensions)));
+      while (std::pow(double(cellsPerAxis), double(dimensions)) < double(count)) ++cellsPerAxis;
+      std::vector<uint32_t> cells(size_t(std::pow(double(cellsPerAxis), double(dimensions))));
+      std::iota(cells.begin(), cells.end(), 0u);
+      rng.shuffle(cells);
+      for (size_t i = 0;i<count;++i) {
+        uint32_t cell = cells[i];
+        for (uint32_t d = 0;d<dimensions;++d) {
+          out[i*dimensions+d] = below1((float(cell%cellsPerAxis) + rng.rand01())/float(cellsPerAxis));
+          cell /= cellsPerAxis;
+        }
+      }
+      break;
+    }
+    case Sequence::Halton : {
+      static const uint32_t bases[3] = {2, 3, 5};
+      for (size_t i = 0;i<count;++i) {
+        const uint32_t index = stream.first + uint32_t(i);
+        for (uint32_t d = 0;d<dimensions;++d) {
+          const uint32_t value = d == 0 ? reverseBits(index) : toFixed(radicalInverse(bases[d], index));
+          out[i*dimensions+d] = toFloat(value + combine(streamSeed, d));
+        }
+      }
+      break;
+    }
+    case Sequence::R2 : {
+      const std::array<uint32_t, 3> steps = r2Steps(dimensions);
+      for (size_t i = 0;i<count;++i) {
+        const uint32_t index = stream.first + uint32_t(i);
+        for (uint32_t d = 0;d<dimensions;++d) {
+          out[i*dimensions+d] = toFloat(combine(streamSeed, d) + index*steps[d]);
+        }
+      }
+      break;
+    }
+    case Sequence::Sobol : {
+      static const std::array<std::array<uint32_t, 32>, SOBOL_DIMENSIONS> directions = sobolDirections();
+      const uint32_t shuffleSeed = combine(streamSeed, 0);
+      std::array<uint32_t, 3> scrambleSeeds;
+      for (uint32_t d = 0;d<dimensions;++d) scrambleSeeds[d] = combine(streamSeed, d+1);
+      for (size_t i = 0;i<count;++i) {
+        const uint32_t index = owenScramble(stream.first + uint32_t(i), shuffleSeed);
+        for (uint32_t d = 0;d<dimensions;++d) {
+          out[i*dimensions+d] = toFloat(owenScramble(sobol(index, directions[d]), scrambleSeeds[d]));
+        }
+      }
+      break;
+    }
+    case Sequence::BlueNoise : {
+      // the tile offset must not depend on the pixel, or the spatial spectrum is lost
+      const Grid2D& tile = blueNoiseTile();
+      const std::array<uint32_t, 3> steps = r2Steps(dimensions);
+      const uint32_t setSeed = combine(hash(seed), stream.dimension);
+      for (uint32_t d = 0;d<dimensions;++d) {
+        const uint32_t offset = combine(setSeed, d);
+        const uint32_t x = (stream.x + (offset & 0xFFFF)) % BLUE_NOISE_SIZE;
+        const uint32_t y = (stream.y + (offset >> 16)) % BLUE_NOISE_SIZE;
+        const uint32_t value = toFixed(tile.getValue(x, y));
+        for (size_t i = 0;i<count;++i) {
+          out[i*dimensions+d] = toFloat(value + (stream.first + uint32_t(i))*steps[d]);
+        }
+      }
+      break;
+    }
+  }
+}
+
+void Sampler::generate1D(float* out, size_t count, const Stream& stream) const {
+  generate(out, count, 1, stream);
+}
+
+// the vector overloads write the interleaved components in place, the path
+// tracer draws one sample per call and must not allocate
+static_assert(sizeof(Vec2) == 2*sizeof(float), "Vec2 must be two packed floats");
+static_assert(sizeof(Vec3) == 3*sizeof(float), "Vec3 must be three packed floats");
+
+void Sampler::generate2D(Vec2* out, size_t count, const Stream& stream) const {
+  generate(reinterpret_cast<float*>(out), count, 2, stream);
+}
+
+void Sampler::generate3D(Vec3* out, size_t count, const Stream& stream) const {
+  generate(reinterpret_cast<float*>(out), count, 3, stream);
+}
+
+std::vector<float> Sampler::get1D(size_t count, const Stream& stream) const {
+  std::vector<float> result(count);
+  generate1D(result.data(), count, stream);
+  return result;
+}
+
+std::vector<Vec2> Sampler::get2D(size_t count, const Stream& stream) const {
+  std::vector<Vec2> result(count);
+  generate2D(result.data(), count, stream);
+  return result;
+}
+
+std::vector<Vec3> Sampler::get3D(size_t count, const Stream& stream) const {
+  std::vector<Vec3> result(count);
+  generate3D(result.data(), count, stream);
+  return result;
+}
+
+Vec3 Sampler::squareToDisc(const Vec2& u) {
+  const float r = std::sqrt(u.x);
+  const float a = 2.0f*float(M_PI)*u.y;
+  return {r*std::cos(a), r*std::sin(a), 0.0f};
+}
+
+Vec3 Sampler::squareToUnitVector(const Vec2& u) {
+  const float z = 1.0f - 2.0f*u.x;
+  const float r = std::sqrt(std::max(0.0f, 1.0f - z*z));
+  const float a = 2.0f*float(M_PI)*u.y;
+  return {r*std::cos(a), r*std::sin(a), z};
+}
+
+Vec3 Sampler::squareToHemisphere(const Vec2& u) {
+  const float z = 1.0f - u.x;
+  const float r = std::sqrt(std::max(0.0f, 1.0f - z*z));
+  const float a = 2.0f*float(M_PI)*u.y;
+  return {r*std::cos(a), r*std::sin(a), z};
+}
+
+Vec3 Sampler::squareToCosineHemisphere(const Vec2& u) {
+  const Vec3 p = squareToDisc(u);
+  return {p.x, p.y, std::sqrt(std::max(0.0f, 1.0f - p.x*p.x - p.y*p.y))};
+}
+
+Vec3 Sampler::cubeToSphere(const Vec3& u) {
+  return squareToUnitVector(Vec2{u.x, u.y}) * std::cbrt(u.z);
+}
+
+const Grid2D& Sampler::blueNoiseTile() {
+  static const Grid2D tile = [] {
+    const std::vector<uint32_t> rank = voidAndCluster(BLUE_NOISE_SIZE);
+    Grid2D result(BLUE_NOISE_SIZE, BLUE_NOISE_SIZE);
+    const float scale = 1.0f/float(rank.size());
+    for (uint32_t y = 0;y<BLUE_NOISE_SIZE;++y) {
+      for (uint32_t x = 0;x<BLUE_NOISE_SIZE;++x) {
+        result.setValue(x, y, (float(rank[y*BLUE_NOISE_SIZE+x]) + 0.5f)*scale);
+      }
+    }
+    return result;
+  }();
+  return tile;
+}
+
+std::vector<Sampler::VarianceResult> Sampler::benchmarkVariance(uint32_t samples, uint32_t trials) {
+  typedef std::chrono::steady_clock Clock;
+  const double smoothExact = std::pow(std::sqrt(M_PI)/2.0*std::erf(1.0), 2.0);
+  const double edgeExact = M_PI/4.0;
+
+  std::vector<VarianceResult> results;
+  std::vector<Vec2> points(samples);
+  for (Sequence sequence : {Sequence::Random, Sequence::Stratified, Sequence::Halton,
+                            Sequence::R2, Sequence::Sobol, Sequence::BlueNoise}) {
+    const Sampler sampler(sequence, 1);
+    VarianceResult result;
+    result.sequence = sequence;
+    for (uint32_t t = 0;t<trials;++t) {
+      const Stream stream{t%BLUE_NOISE_SIZE, t/BLUE_NOISE_SIZE, 0, 0};
+      const Clock::time_point start = Clock::now();
+      sampler.generate2D(points.data(), samples, stream);
+      result.seconds += std::chrono::duration<double>(Clock::now()-start).count();
+
+      double smooth = 0.0, edge = 0.0;
+      for (const Vec2& p : points) {
+        const double r2 = double(p.x)*p.x + double(p.y)*p.y;
+        smooth += std::exp(-r2);
+        edge += r2 < 1.0 ? 1.0 : 0.0;
+      }
+      result.smoothError += std::pow(smooth/samples - smoothExact, 2.0);
+      result.edgeError += std::pow(edge/samples - edgeExact, 2.0);
+    }
+    result.smoothError /= trials;
+    result.edgeError /= trials;
+    results.push_back(result);
+  }
+  return results;
+}
+
+std::string Sampler::toString(const std::vector<VarianceResult>& results) {
+  const VarianceResult* baseline = nullptr;
+  for (const VarianceResult& r : results) {
+    if (r.sequence == Sequence::Random) baseline = &r;
+  }
+
+  std::stringstream ss;
+  ss << std::setprecision(3);
+  for (const VarianceResult& r : results) {
+    ss << std::left << std::setw(11) << toString(r.sequence) << std::right
+       << " smooth MSE " << std::setw(9) << r.smoothError;
+    if (baseline && r.smoothError > 0.0) ss << " (" << std::setw(6) << baseline->smoothError/r.smoothError << "x)";
+    ss << "  edge MSE " << std::setw(9) << r.edgeError;
+    if (baseline && r.edgeError > 0.0) ss << " (" << std::setw(6) << baseline->edgeError/r.edgeError << "x)";
+    ss << "  " << r.seconds*1000.0 << " ms\n";
+  }
+  return ss.str();
+}
+
+std::string Sampler::toString(Sequence sequence) {
+  switch (sequence) {
+    case Sequence::Random     : return "Random";
+    case Sequence::Stratified : return "Stratified";
+    case Sequence::Halton     : return "Halton";
+    case Sequence::R2         : return "R2";
+    case Sequence::Sobol      : return "Sobol";
+    case Sequence::BlueNoise  : return "BlueNoise";
+  }
+  return "Unknown";
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Vec2.h"
+#include "Vec3.h"
+#include "Grid2D.h"
+
+/**
+ * @file Sampler.h
+ * @brief Low-discrepancy and stratified sample sequences for Monte Carlo code.
+ *
+ * Pseudo-random draws from @ref Random converge with O(N^-1/2); the sequences
+ * here cover the unit square more evenly and typically reach the same error
+ * with far fewer samples:
+ * - \c Sobol: Sobol points with hash-based Owen scrambling and index shuffling
+ *   (Burley 2020), the best general-purpose choice.
+ * - \c Halton: radical inverses in bases 2, 3 and 5 with a random rotation.
+ * - \c R2: Roberts' additive recurrence on the generalized golden ratio.
+ * - \c BlueNoise: a 64x64 void-and-cluster tile, animated over the sample
+ *   index with the R-sequence, for when only a few samples per pixel exist:
+ *   the error is spread as high-frequency noise across neighbouring pixels.
+ * - \c Stratified: one jittered sample per cell of a grid over all samples.
+ * - \c Random: plain @ref Random draws, the baseline.
+ *
+ * Samples are generated in bulk for one @ref Sampler::Stream, i.e. a pixel,
+ * a dimension set (say, the bounce depth) and a first sample index. Each
+ * stream gets its own scramble, so neighbouring pixels and bounces are
+ * decorrelated while every single stream keeps its even coverage.
+ * @ref Sampler::benchmarkVariance() shows the error reduction per sequence.
+ *
+ * @code
+ * Sampler sampler(Sampler::Sequence::Sobol);
+ * std::vector<Vec2> u = sampler.get2D(16, {x, y, bounce});
+ * for (const Vec2& s : u) sum += f(Sampler::squareToHemisphere(s));
+ * @endcode
+ */
+class Sampler {
+public:
+  /** @brief Sample sequence. */
+  enum class Sequence {
+    Random,      ///< Independent pseudo-random samples.
+    Stratified,  ///< Jittered grid over the requested count.
+    Halton,      ///< Rotated Halton sequence.
+    R2,          ///< Rotated R-sequence.
+    Sobol,       ///< Owen-scrambled, shuffled Sobol sequence.
+    BlueNoise    ///< Blue-noise tile animated with the R-sequence.
+  };
+
+  /** @brief Identifies an independent sample stream. */
+  struct Stream {
+    uint32_t x{0};          ///< Pixel column.
+    uint32_t y{0};          ///< Pixel row.
+    uint32_t dimension{0};  ///< Dimension set, e.g. camera, first bounce, second bounce.
+    uint32_t first{0};      ///< Index of the first sample (e.g. the pass of a progressive renderer).
+  };
+
+  /** @brief Error of one sequence in @ref benchmarkVariance(). */
+  struct VarianceResult {
+    Sequence sequence{Sequence::Random};
+    double smoothError{0.0};  ///< Mean squared error on a smooth integrand.
+    double edgeError{0.0};    ///< Mean squared error on a discontinuous integrand.
+    double seconds{0.0};      ///< Time spent generating the samples.
+  };
+
+  /**
+   * @brief Create a sampler.
+   * @param sequence Sequence to draw from.
+   * @param seed     Global scramble seed, change it to get an independent
+   *                 realization of the same sequence.
+   */
+  Sampler(Sequence sequence, uint32_t seed=0);
+
+  Sequence getSequence() const {return sequence;}
+
+  /**
+   * @brief Write @p count samples in [0,1) of @p stream to @p out.
+   *
+   * Except for \c Stratified and \c Random, sample i is the same whether it
+   * is drawn alone or as part of a batch, so progressive renderers can draw
+   * one sample per pass with Stream::first set to the pass index.
+   */
+  void generate1D(float* out, size_t count, const Stream& stream) const;
+  /** @brief Write @p count samples in [0,1)^2 of @p stream to @p out. */
+  void generate2D(Vec2* out, size_t count, const Stream& stream) const;
+  /** @brief Write @p count samples in [0,1)^3 of @p stream to @p out. */
+  void generate3D(Vec3* out, size_t count, const Stream& stream) const;
+
+  /** @brief Convenience wrapper returning @ref generate1D() as a vector. */
+  std::vector<float> get1D(size_t count, const Stream& stream) const;
+  /** @brief Convenience wrapper returning @ref generate2D() as a vector. */
+  std::vector<Vec2> get2D(size_t count, const Stream& stream) const;
+  /** @brief Convenience wrapper returning @ref generate3D() as a vector. */
+  std::vector<Vec3> get3D(size_t count, const Stream& stream) const;
+
+  /** @name Warping
+   *  Area preserving maps from the unit square/cube, the low-discrepancy
+   *  counterparts of the samplers in @ref Vec3.
+   */
+  ///@{
+  /** @brief Uniform point in the unit disc on the xy-plane. */
+  static Vec3 squareToDisc(const Vec2& u);
+  /** @brief Uniform unit vector on the sphere. */
+  static Vec3 squareToUnitVector(const Vec2& u);
+  /** @brief Uniform unit vector in the upper hemisphere (z>=0). */
+  static Vec3 squareToHemisphere(const Vec2& u);
+  /** @brief Cosine-weighted unit vector in the upper hemisphere, pdf z/pi. */
+  static Vec3 squareToCosineHemisphere(const Vec2& u);
+  /** @brief Uniform point inside the unit sphere. */
+  static Vec3 cubeToSphere(const Vec3& u);
+  ///@}
+
+  /**
+   * @brief The 64x64 blue-noise tile used by \c BlueNoise.
+   *
+   * Values are void-and-cluster ranks mapped to [0,1), each value occurs
+   * exactly once. Built on first use.
+   */
+  static const Grid2D& blueNoiseTile();
+
+  /**
+   * @brief Compare the integration error of all sequences.
+   *
+   * Integrates a smooth Gaussian bump and the indicator of the quarter disc
+   * over the unit square with @p samples samples, repeated over @p trials
+   * decorrelated streams, and averages the squared error against the exact
+   * values.
+   */
+  static std::vector<VarianceResult> benchmarkVariance(uint32_t samples=64, uint32_t trials=512);
+
+  /** @brief Table of @ref benchmarkVariance() results with the gain over \c Random. */
+  static std::string toString(const std::vector<VarianceResult>& results);
+
+  /** @brief Name of @p sequence. */
+  static std::string toString(Sequence sequence);
+
+private:
+  Sequence sequence;
+  uint32_t seed;
+
+  void generate(float* out, size_t count, uint32_t dimensions, const Stream& stream) const;
+};
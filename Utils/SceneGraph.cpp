@@ -0,0 +1,144 @@
+#include <stdexcept>
+#include <algorithm>
+
+#include "Parallel.h"
+#include "SceneGraph.h"
+
+SceneGraph::NodeID SceneGraph::addNode(NodeID parent, const Mat4& local, int32_t object) {
+  if (parent != NO_PARENT && parent >= parents.size())
+    throw std::out_of_range("SceneGraph: parent node does not exist");
+
+  const NodeID node = NodeID(parents.size());
+  const uint32_t depth = parent == NO_PARENT ? 0 : depths[parent]+1;
+
+  parents.push_back(parent);
+  depths.push_back(depth);
+  localTransforms.push_back(local);
+  worldTransforms.push_back(local);
+  dirty.push_back(1);
+  visible.push_back(1);
+  subtreeVisible.push_back(1);
+  objects.push_back(object);
+  localBounds.push_back(AABB{});
+  worldBounds.push_back(AABB{});
+  updateWorldBounds(node);
+
+  if (levels.size() <= depth) levels.resize(depth+1);
+  levels[depth].push_back(node);
+
+  anyDirty = true;
+  visibilityDirty = true;
+  return node;
+}
+
+void SceneGraph::clear() {
+  parents.clear();
+  depths.clear();
+  localTransforms.clear();
+  worldTransforms.clear();
+  dirty.clear();
+  visible.clear();
+  subtreeVisible.clear();
+  objects.clear();
+  localBounds.clear();
+  worldBounds.clear();
+  levels.clear();
+  anyDirty = false;
+  visibilityDirty = false;
+}
+
+void SceneGraph::setLocalTransform(NodeID node, const Mat4& local) {
+  localTransforms[node] = local;
+  dirty[node] = 1;
+  anyDirty = true;
+}
+
+void SceneGraph::setLocalBounds(NodeID node, const AABB& bounds) {
+  localBounds[node] = bounds;
+  dirty[node] = 1;
+  anyDirty = true;
+}
+
+void SceneGraph::updateWorldBounds(NodeID node) {
+  if (localBounds[node].isEmpty()) {
+    // unbounded nodes must never be culled
+    worldBounds.set(node, AABB{Vec3{-1e30f,-1e30f,-1e30f}, Vec3{1e30f,1e30f,1e30f}});
+  } else {
+    worldBounds.set(node, localBounds[node].transformed(worldTransforms[node]));
+  }
+}
+
+void SceneGraph::setVisible(NodeID node, bool visible) {
+  this->visible[node] = visible ? 1 : 0;
+  visibilityDirty = true;
+}
+
+size_t SceneGraph::update(size_t parallelThreshold) {
+  const size_t nodeCount = parents.size();
+
+  if (visibilityDirty) {
+    for (size_t i = 0;i<nodeCount;++i) {
+      subtreeVisible[i] = visible[i] && (parents[i] == NO_PARENT || subtreeVisible[parents[i]]);
+    }
+    visibilityDirty = false;
+  }
+
+  if (!anyDirty) return 0;
+
+  // parents precede children, so one forward sweep pushes the flags down
+  size_t dirtyCount = 0;
+  for (size_t i = 0;i<nodeCount;++i) {
+    if (!dirty[i] && parents[i] != NO_PARENT && dirty[parents[i]]) dirty[i] = 1;
+    dirtyCount += dirty[i];
+  }
+
+  if (dirtyCount < parallelThreshold) {
+    for (NodeID i = 0;i<nodeCount;++i) {
+      if (dirty[i]) updateWorld(i);
+    }
+  } else {
+    // nodes on one level only depend on the level above
+    for (const std::vector<NodeID>& level : levels) {
+      Parallel::forRange(0, level.size(), [this, &level](size_t begin, size_t end) {
+        for (size_t i = begin;i<end;++i) {
+          if (dirty[level[i]]) updateWorld(level[i]);
+        }
+      }, parallelThreshold/4);
+    }
+  }
+
+  std::fill(dirty.begin(), dirty.end(), 0);
+  anyDirty = false;
+  return dirtyCount;
+}
+
+void SceneGraph::collectVisible(std::vector<VisibleObject>& list,
+                                const std::function<bool(NodeID)>& filter) const {
+  list.clear();
+  for (NodeID i = 0;i<parents.size();++i) {
+    if (objects[i] == NO_OBJECT || !subtreeVisible[i]) continue;
+    if (filter && !filter(i)) continue;
+    list.push_back({objects[i], i});
+  }
+}
+
+std::vector<SceneGraph::VisibleObject> SceneGraph::collectVisible(const std::function<bool(NodeID)>& filter) const {
+  std::vector<VisibleObject> list;
+  collectVisible(list, filter);
+  return list;
+}
+
+size_t SceneGraph::collectVisible(std::vector<VisibleObject>& list, const Frustum& frustum) const {
+  list.clear();
+  frustum.cull(worldBounds, cullMask);
+  size_t culled = 0;
+  for (NodeID i = 0;i<parents.size();++i) {
+    if (objects[i] == NO_OBJECT || !subtreeVisible[i]) continue;
+    if (!cullMask[i]) {
+      ++culled;
+      continue;
+    }
+    list.push_back({objects[i], i});
+  }
+  return culled;
+}
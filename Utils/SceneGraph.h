@@ -0,0 +1,164 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include "Mat4.h"
+#include "Bounds.h"
+#include "Frustum.h"
+
+/**
+ * @file SceneGraph.h
+ * @brief Transform hierarchy with flat SoA storage and dirty-flag propagation.
+ *
+ * Nodes are stored in flat structure-of-arrays vectors (parent, local and
+ * world transforms, flags, attached object). A node can only be attached to
+ * an already existing parent, so the arrays are topologically sorted by
+ * construction: every parent precedes its children. @ref update() therefore
+ * resolves the whole hierarchy in a single forward sweep, recomputing world
+ * matrices only for nodes whose local transform (or that of an ancestor)
+ * changed since the last update. Large dirty sets are processed level by level
+ * with @ref Parallel::forRange().
+ *
+ * Nodes may carry a local-space @ref AABB; its world-space box is refreshed
+ * together with the world matrix and kept in an @ref AABBArray, so a draw list
+ * can be culled against any @ref Frustum (camera, light, ...) per pass.
+ *
+ * Usage:
+ * @code
+ * SceneGraph scene;
+ * SceneGraph::NodeID orbit = scene.addNode();
+ * SceneGraph::NodeID light = scene.addNode(orbit, Mat4::translation(-80,60,80), LIGHT_OBJECT);
+ * // per frame:
+ * scene.setLocalTransform(orbit, Mat4::rotationY(-angle));
+ * scene.update();
+ * for (const SceneGraph::VisibleObject& o : scene.collectVisible())
+ *   draw(o.object, scene.getWorldTransform(o.node));
+ * @endcode
+ *
+ * @note World matrices follow the column-vector convention used throughout
+ *       this code base: world = parentWorld * local.
+ */
+class SceneGraph {
+public:
+  /** @brief Index of a node in the flat arrays. */
+  typedef uint32_t NodeID;
+
+  /** @brief Parent value of root nodes. */
+  static constexpr NodeID NO_PARENT = UINT32_MAX;
+  /** @brief Object value of nodes that only carry a transform. */
+  static constexpr int32_t NO_OBJECT = -1;
+
+  /**
+   * @brief Entry of a per-frame draw list.
+   */
+  struct VisibleObject {
+    int32_t object; ///< Application-defined object id attached to the node.
+    NodeID node;    ///< Node whose world transform positions the object.
+  };
+
+  /**
+   * @brief Append a node below @p parent.
+   * @param parent Parent node or @ref NO_PARENT for a root.
+   * @param local  Transform relative to the parent.
+   * @param object Application-defined object id or @ref NO_OBJECT.
+   * @return ID of the new node (always larger than @p parent).
+   * @throw std::out_of_range If @p parent does not exist.
+   */
+  NodeID addNode(NodeID parent=NO_PARENT, const Mat4& local=Mat4{},
+                 int32_t object=NO_OBJECT);
+
+  /** @brief Remove all nodes. */
+  void clear();
+
+  /** @brief Number of nodes in the graph. */
+  size_t getNodeCount() const {return parents.size();}
+
+  /** @name Per-node accessors */
+  ///@{
+  /** @brief Replace the local transform and mark the subtree dirty. */
+  void setLocalTransform(NodeID node, const Mat4& local);
+  /** @brief Local transform relative to the parent. */
+  const Mat4& getLocalTransform(NodeID node) const {return localTransforms[node];}
+  /** @brief World transform as of the last @ref update(). */
+  const Mat4& getWorldTransform(NodeID node) const {return worldTransforms[node];}
+  /** @brief Parent node or @ref NO_PARENT. */
+  NodeID getParent(NodeID node) const {return parents[node];}
+  /** @brief Depth of the node (roots have depth 0). */
+  uint32_t getDepth(NodeID node) const {return depths[node];}
+  /** @brief Attach an application-defined object id (or @ref NO_OBJECT). */
+  void setObject(NodeID node, int32_t object) {objects[node] = object;}
+  /** @brief Object id attached to the node. */
+  int32_t getObject(NodeID node) const {return objects[node];}
+  /** @brief Show or hide the node; hiding a node hides its whole subtree. */
+  void setVisible(NodeID node, bool visible);
+  /** @brief Visibility flag of the node itself (ignores ancestors). */
+  bool getVisible(NodeID node) const {return visible[node] != 0;}
+  /**
+   * @brief Set the local-space bounds used for culling; an empty box means
+   *        the node is never culled.
+   */
+  void setLocalBounds(NodeID node, const AABB& bounds);
+  /** @brief Local-space bounds of the node. */
+  const AABB& getLocalBounds(NodeID node) const {return localBounds[node];}
+  /** @brief World-space bounds as of the last @ref update(). */
+  AABB getWorldBounds(NodeID node) const {return worldBounds.get(node);}
+  ///@}
+
+  /**
+   * @brief Bring world transforms and subtree visibility up to date.
+   * @param parallelThreshold Dirty-node count from which the update is
+   *        distributed over worker threads level by level.
+   * @return Number of world matrices that were recomputed (0 if nothing moved).
+   */
+  size_t update(size_t parallelThreshold=4096);
+
+  /**
+   * @brief Build the list of visible nodes that carry an object.
+   * @param list   Output list; cleared first, capacity is kept between frames.
+   * @param filter Optional predicate (e.g. a culling test); nodes for which it
+   *               returns false are skipped.
+   * @note Uses the state of the last @ref update().
+   */
+  void collectVisible(std::vector<VisibleObject>& list,
+                      const std::function<bool(NodeID)>& filter=nullptr) const;
+
+  /** @brief Convenience overload returning a new list. */
+  std::vector<VisibleObject> collectVisible(const std::function<bool(NodeID)>& filter=nullptr) const;
+
+  /**
+   * @brief Build the list of visible nodes whose world bounds intersect @p frustum.
+   * @param list    Output list; cleared first.
+   * @param frustum Frustum of the current pass (e.g. camera or light).
+   * @return Number of nodes rejected by the frustum test.
+   */
+  size_t collectVisible(std::vector<VisibleObject>& list, const Frustum& frustum) const;
+
+private:
+  std::vector<NodeID> parents;         ///< Parent per node (NO_PARENT for roots).
+  std::vector<uint32_t> depths;        ///< Hierarchy depth per node.
+  std::vector<Mat4> localTransforms;   ///< Transforms relative to the parent.
+  std::vector<Mat4> worldTransforms;   ///< Cached parentWorld * local.
+  std::vector<uint8_t> dirty;          ///< Local transform changed since last update.
+  std::vector<uint8_t> visible;        ///< Per-node visibility flag.
+  std::vector<uint8_t> subtreeVisible; ///< Visibility including all ancestors.
+  std::vector<int32_t> objects;        ///< Attached object id per node.
+  std::vector<AABB> localBounds;       ///< Local-space bounds per node.
+  AABBArray worldBounds;               ///< World-space bounds (SoA) per node.
+  mutable std::vector<uint8_t> cullMask; ///< Scratch output of Frustum::cull.
+  std::vector<std::vector<NodeID>> levels; ///< Node ids grouped by depth.
+
+  bool anyDirty{false};          ///< At least one transform changed since last update.
+  bool visibilityDirty{false};   ///< At least one visibility flag changed.
+
+  /** @brief Recompute the world matrix and bounds of one node from its parent. */
+  void updateWorld(NodeID node) {
+    worldTransforms[node] = parents[node] == NO_PARENT ? localTransforms[node]
+                          : worldTransforms[parents[node]] * localTransforms[node];
+    updateWorldBounds(node);
+  }
+
+  /** @brief Transform the local bounds of @p node into @ref worldBounds. */
+  void updateWorldBounds(NodeID node);
+};
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <algorithm>
+
+#ifndef __EMSCRIPTEN__
+#include <filesystem>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "ShaderWatcher.h"
+
+#ifndef __EMSCRIPTEN__
+static std::filesystem::path directoryOf(const std::string& file) {
+  const std::filesystem::path dir = std::filesystem::path(file).parent_path();
+  return dir.empty() ? std::filesystem::path(".") : dir;
+}
+
+static std::string normalizedPath(const std::string& file) {
+  return (directoryOf(file) / std::filesystem::path(file).filename()).lexically_normal().string();
+}
+
+static int64_t modificationTime(const std::string& file) {
+  std::error_code ec;
+  const auto time = std::filesystem::last_write_time(file, ec);
+  return ec ? 0 : int64_t(time.time_since_epoch().count());
+}
+#endif
+
+ShaderWatcher::ShaderWatcher() :
+  lastScan{std::chrono::steady_clock::now()}
+{
+#ifdef __linux__
+  inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd < 0)
+    std::cerr << "ShaderWatcher: inotify unavailable, polling modification times" << std::endl;
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+  if (inotifyFd >= 0) close(inotifyFd);
+#endif
+}
+
+void ShaderWatcher::watch(GLProgram& program) {
+  unwatch(program);
+  Entry entry{&program, program.getSourceFiles(), {}};
+  if (entry.files.empty()) return;
+
+#ifndef __EMSCRIPTEN__
+  for (std::string& file : entry.files) {
+    file = normalizedPath(file);
+    entry.stamps.push_back(modificationTime(file));
+#ifdef __linux__
+    watchDirectory(file);
+#endif
+  }
+#endif
+  entries.push_back(entry);
+}
+
+void ShaderWatcher::unwatch(GLProgram& program) {
+  entries.erase(std::remove_if(entries.begin(), entries.end(),
+                               [&program](const Entry& e) {return e.program == &program;}),
+                entries.end());
+}
+
+#ifdef __linux__
+void ShaderWatcher::watchDirectory(const std::string& file) {
+  if (inotifyFd < 0) return;
+  const std::string dir = directoryOf(file).string();
+  for (const auto& d : directories) {
+    if (d.second == dir) return;
+  }
+  // editors either rewrite the file in place or rename a temporary over it
+  const int wd = inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+  if (wd >= 0) directories.push_back({wd, dir});
+}
+#endif
+
+std::vector<size_t> ShaderWatcher::changedEntries() {
+  std::vector<size_t> changed;
+#ifndef __EMSCRIPTEN__
+  auto markFile = [this, &changed](const std::string& path) {
+    for (size_t i = 0;i<entries.size();++i) {
+      if (std::find(entries[i].files.begin(), entries[i].files.end(), path) != entries[i].files.end() &&
+          std::find(changed.begin(), changed.end(), i) == changed.end())
+        changed.push_back(i);
+    }
+  };
+
+#ifdef __linux__
+  if (inotifyFd >= 0) {
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+      for (char* ptr = buffer;ptr<buffer+length;) {
+        const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+        ptr += sizeof(inotify_event) + event->len;
+        if (event->len == 0) continue;
+        for (const auto& d : directories) {
+          if (d.first == event->wd)
+            markFile((std::filesystem::path(d.second) / event->name).lexically_normal().string());
+        }
+      }
+    }
+    return changed;
+  }
+#endif
+
+  // fallback: compare modification times a few times per second
+  const auto now = std::chrono::steady_clock::now();
+  if (now - lastScan < std::chrono::milliseconds(250)) return changed;
+  lastScan = now;
+  for (size_t i = 0;i<entries.size();++i) {
+    for (size_t f = 0;f<entries[i].files.size();++f) {
+      const int64_t stamp = modificationTime(entries[i].files[f]);
+      if (stamp != entries[i].stamps[f]) {
+        entries[i].stamps[f] = stamp;
+        if (std::find(changed.begin(), changed.end(), i) == changed.end()) changed.push_back(i);
+      }
+    }
+  }
+#endif
+  return changed;
+}
+
+size_t ShaderWatcher::poll() {
+  for (size_t i : changedEntries()) {
+    entries[i].program->reloadFromFiles();
+  }
+
+  size_t swapped = 0;
+  for (const Entry& e : entries) {
+    if (e.program->updateReload()) {
+      std::cout << "Reloaded shader program " << e.files.front() << std::endl;
+      ++swapped;
+    }
+  }
+  return swapped;
+}
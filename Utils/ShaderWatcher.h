@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include "GLProgram.h"
+
+/**
+ * @file ShaderWatcher.h
+ * @brief Reloads GLPrograms when their shader files change on disk.
+ *
+ * A @ref ShaderWatcher keeps a list of programs created with
+ * GLProgram::createFromFile(s). On Linux the directories of their shader files
+ * are watched with inotify, elsewhere the modification times are compared a
+ * few times per second. @ref poll() never blocks on a rebuild it started:
+ * it submits a background rebuild (GLProgram::reloadFromFiles()) for every
+ * program whose files changed and swaps in rebuilt programs on later polls,
+ * once the driver reports them finished or, without
+ * \c KHR_parallel_shader_compile, at the earliest one poll after the
+ * submission (GLProgram::updateReload()).
+ *
+ * Usage:
+ * @code
+ * shaderWatcher.watch(pPhong);   // in init()
+ * shaderWatcher.poll();          // once per frame (GLApp does this)
+ * @endcode
+ *
+ * @note The watcher stores pointers; programs must stay at the same address
+ *       while watched (members of the application class are fine).
+ * @note A swapped-in program may assign different attribute locations, while
+ *       VAOs configured with GLArray::configure() keep the old ones. Declare
+ *       the inputs of watched shaders with layout(location = …), or configure
+ *       the arrays again when @ref poll() returns a nonzero count.
+ */
+class ShaderWatcher {
+public:
+  /** @brief Create a watcher without programs. */
+  ShaderWatcher();
+  /** @brief Release the inotify instance. */
+  ~ShaderWatcher();
+
+  ShaderWatcher(const ShaderWatcher&) = delete;
+  ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+  /**
+   * @brief Start watching the source files of @p program.
+   * @note Programs created from strings have no files and are ignored.
+   */
+  void watch(GLProgram& program);
+
+  /** @brief Stop watching @p program. */
+  void unwatch(GLProgram& program);
+
+  /**
+   * @brief Check for changed files and finished rebuilds (non-blocking).
+   * @return Number of programs that were replaced during this call.
+   */
+  size_t poll();
+
+private:
+  /** @brief A watched program and the state of its files. */
+  struct Entry {
+    GLProgram* program;                  ///< Watched program.
+    std::vector<std::string> files;      ///< Its shader files.
+    std::vector<int64_t> stamps;         ///< Last seen modification times (fallback).
+  };
+
+  std::vector<Entry> entries;            ///< All watched programs.
+  std::chrono::steady_clock::time_point lastScan; ///< Time of the last mtime scan (fallback).
+
+#ifdef __linux__
+  int inotifyFd{-1};                     ///< Non-blocking inotify instance.
+  std::vector<std::pair<int, std::string>> directories; ///< Watch descriptor and directory.
+
+  /** @brief Add an inotify watch for the directory of @p file (once). */
+  void watchDirectory(const std::string& file);
+#endif
+
+  /** @brief Collect the indices of entries whose files changed. */
+  std::vector<size_t> changedEntries();
+};
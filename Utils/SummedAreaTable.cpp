@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Parallel.h"
+
+#include "SummedAreaTable.h"
+
+template <typename F>
+static void buildTable(std::vector<double>& table, size_t width, size_t height,
+                       uint8_t componentCount, F loadRow) {
+  const size_t stride = (width+1)*componentCount;
+  table.assign(stride*(height+1), 0.0);
+
+  // prefix sums along each row, rows are independent
+  Parallel::forRange(0, height, [&](size_t begin, size_t end) {
+    for (size_t y = begin;y<end;++y) {
+      double* row = table.data() + (y+1)*stride + componentCount;
+      loadRow(y, row);
+      for (size_t i = componentCount;i<width*componentCount;++i) {
+        row[i] += row[i-componentCount];
+      }
+    }
+  }, 16);
+
+  // prefix sums down each column, on strips of columns so every row is a
+  // contiguous span
+  Parallel::forRange(componentCount, stride, [&](size_t begin, size_t end) {
+    for (size_t y = 2;y<=height;++y) {
+      const double* above = table.data() + (y-1)*stride;
+      double* row = table.data() + y*stride;
+      for (size_t i = begin;i<end;++i) row[i] += above[i];
+    }
+  }, 1024);
+}
+
+SummedAreaTable::SummedAreaTable(const Image& image) :
+  width(image.width),
+  height(image.height),
+  componentCount(image.componentCount)
+{
+  const size_t rowValues = width*componentCount;
+  if (image.layout == MemoryLayout::Linear) {
+    buildTable(table, width, height, componentCount, [&](size_t y, double* row) {
+      const uint8_t* src = image.data.data() + y*rowValues;
+      for (size_t i = 0;i<rowValues;++i) row[i] = src[i];
+    });
+  } else {
+    buildTable(table, width, height, componentCount, [&](size_t y, double* row) {
+      for (size_t x = 0;x<width;++x) {
+        for (uint8_t c = 0;c<componentCount;++c) {
+          row[x*componentCount+c] = image.getValue(uint32_t(x), uint32_t(y), c);
+        }
+      }
+    });
+  }
+}
+
+template <typename T>
+SummedAreaTable::SummedAreaTable(const Grid2Dt<T>& grid) :
+  width(grid.getWidth()),
+  height(grid.getHeight()),
+  componentCount(GridCell<T>::components)
+{
+  const GridLayout& layout = grid.getLayout();
+  const T* cells = grid.getData().data();
+  const bool linear = layout.getLayout() == MemoryLayout::Linear;
+  buildTable(table, width, height, componentCount, [&](size_t y, double* row) {
+    constexpr size_t chunk = 256;
+    T gathered[chunk];
+    float buffer[chunk*GridCell<T>::components];
+    for (size_t x = 0;x<width;x+=chunk) {
+      const size_t count = std::min(chunk, width-x);
+      const T* src = cells + layout.index(x,y);
+      if (!linear) {
+        for (size_t i = 0;i<count;++i) gathered[i] = cells[layout.index(x+i,y)];
+        src = gathered;
+      }
+      GridCell<T>::toFloats(src, buffer, count);
+      for (size_t i = 0;i<count*componentCount;++i) row[x*componentCount+i] = buffer[i];
+    }
+  });
+}
+
+double SummedAreaTable::sum(size_t x0, size_t y0, size_t x1, size_t y1, uint8_t component) const {
+  x1 = std::min(x1, width);
+  y1 = std::min(y1, height);
+  if (x0 >= x1 || y0 >= y1) return 0.0;
+  return at(x1,y1,component) - at(x0,y1,component) - at(x1,y0,component) + at(x0,y0,component);
+}
+
+double SummedAreaTable::mean(size_t x0, size_t y0, size_t x1, size_t y1, uint8_t component) const {
+  x1 = std::min(x1, width);
+  y1 = std::min(y1, height);
+  if (x0 >= x1 || y0 >= y1) return 0.0;
+  return sum(x0, y0, x1, y1, component) / double((x1-x0)*(y1-y0));
+}
+
+double SummedAreaTable::integral(double x, double y, uint8_t component) const {
+  x = std::clamp(x, 0.0, double(width));
+  y = std::clamp(y, 0.0, double(height));
+  const size_t ix = std::min(size_t(x), width > 0 ? width-1 : 0);
+  const size_t iy = std::min(size_t(y), height > 0 ? height-1 : 0);
+  const double fx = x - double(ix);
+  const double fy = y - double(iy);
+  // the integral of a piecewise constant function is bilinear inside a cell
+  const double a = at(ix,   iy,   component);
+  const double b = at(ix+1, iy,   component);
+  const double c = at(ix,   iy+1, component);
+  const double d = at(ix+1, iy+1, component);
+  return a + (b-a)*fx + (c-a)*fy + (d-b-c+a)*fx*fy;
+}
+
+double SummedAreaTable::sum(double x0, double y0, double x1, double y1, uint8_t component) const {
+  if (width == 0 || height == 0) return 0.0;
+  return integral(x1,y1,component) - integral(x0,y1,component) -
+         integral(x1,y0,component) + integral(x0,y0,component);
+}
+
+double SummedAreaTable::mean(double x0, double y0, double x1, double y1, uint8_t component) const {
+  x0 = std::clamp(x0, 0.0, double(width));
+  x1 = std::clamp(x1, 0.0, double(width));
+  y0 = std::clamp(y0, 0.0, double(height));
+  y1 = std::clamp(y1, 0.0, double(height));
+  if (x1 <= x0 || y1 <= y0) return 0.0;
+  return sum(x0, y0, x1, y1, component) / ((x1-x0)*(y1-y0));
+}
+
+template SummedAreaTable::SummedAreaTable(const Grid2Dt<uint8_t>&);
+template SummedAreaTable::SummedAreaTable(const Grid2Dt<uint16_t>&);
+template SummedAreaTable::SummedAreaTable(const Grid2Dt<Half>&);
+template SummedAreaTable::SummedAreaTable(const Grid2Dt<float>&);
+template SummedAreaTable::SummedAreaTable(const Grid2Dt<Vec2>&);
+template SummedAreaTable::SummedAreaTable(const Grid2Dt<Vec3>&);
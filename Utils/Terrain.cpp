@@ -0,0 +1,465 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "Frustum.h"
+#include "Parallel.h"
+#include "ThreadPool.h"
+
+#include "Terrain.h"
+
+#ifdef __EMSCRIPTEN__
+static const std::string shaderHeader{"#version 300 es\nprecision mediump float;\n"};
+#else
+static const std::string shaderHeader{"#version 410\n"};
+#endif
+
+static const std::string vertexShader{R"(
+uniform mat4 MVP;
+in vec3 vPos;
+in vec4 vNormal;
+out vec3 normal;
+void main() {
+  gl_Position = MVP * vec4(vPos, 1.0);
+  normal = vNormal.xyz;
+})"};
+
+static const std::string fragmentShader{R"(
+uniform vec3 lightDirection;
+uniform vec3 color;
+in vec3 normal;
+out vec4 FragColor;
+void main() {
+  float diffuse = max(dot(normalize(normal), lightDirection), 0.0);
+  FragColor = vec4(color*(0.25+0.75*diffuse), 1.0);
+})"};
+
+static size_t indexSize(GLenum type) {
+  switch (type) {
+    case GL_UNSIGNED_BYTE  : return 1;
+    case GL_UNSIGNED_SHORT : return 2;
+    default                : return 4;
+  }
+}
+
+Terrain::Terrain(Grid2D heights) :
+  Terrain(std::move(heights), Settings{})
+{
+}
+
+Terrain::Terrain(Grid2D heights, const Settings& settings) :
+  settings(settings),
+  heights(std::move(heights)),
+  chunksX(0),
+  chunksY(0),
+  levelCount(0),
+  program{GLProgram::createFromString(shaderHeader+vertexShader, shaderHeader+fragmentShader)},
+  mvpLocation{program.getUniformLocation("MVP")},
+  lightLocation{program.getUniformLocation("lightDirection")},
+  colorLocation{program.getUniformLocation("color")},
+  format{{"vPos", GLAttribType::FLOAT, 3},
+         {"vNormal", GLAttribType::INT_2_10_10_10_REV, 4}},
+  baseVertices{GL_ARRAY_BUFFER},
+  baseIndices{GL_ELEMENT_ARRAY_BUFFER}
+{
+  const uint32_t n = settings.chunkSize;
+  if (n < 2 || n > 128 || (n & (n-1)) != 0)
+    throw std::invalid_argument("Terrain: chunkSize must be a power of two in [2,128]");
+  if (this->heights.getWidth() < 2 || this->heights.getHeight() < 2)
+    throw std::invalid_argument("Terrain: heightfield needs at least 2x2 samples");
+
+  chunksX = (this->heights.getWidth()-2)/n + 1;
+  chunksY = (this->heights.getHeight()-2)/n + 1;
+  while ((1u << levelCount) <= n) ++levelCount;
+
+  const size_t chunkCount = chunksX*chunksY;
+  analyze();
+  meshes.resize(chunkCount);
+  building.assign(chunkCount, 0);
+
+  levelIndices.reserve(levelCount);
+  // baseArray is bound since its construction, so binding the index
+  // buffers below does not touch a VAO of someone else
+  for (uint32_t level = 0;level<levelCount;++level) {
+    const std::vector<GLuint> indices = buildIndices(n >> level);
+    levelIndices.emplace_back(GL_ELEMENT_ARRAY_BUFFER);
+    levelIndices.back().setData(indices);
+    levelIndexCounts.push_back(indices.size());
+  }
+
+  // the coarsest level of every chunk in one buffer, chunk after chunk
+  const uint32_t coarsest = levelCount-1;
+  const std::vector<GLuint> coarseIndices = buildIndices(1);
+  const size_t coarseVertexCount = 4 + 4*2;
+  const size_t coarseBytes = coarseVertexCount*format.getStride();
+  std::vector<uint8_t> vertices(chunkCount*coarseBytes);
+  std::vector<GLuint> indices(chunkCount*coarseIndices.size());
+  Parallel::forRange(0, chunkCount, [&](size_t begin, size_t end) {
+    for (size_t chunk = begin;chunk<end;++chunk) {
+      const std::vector<uint8_t> v = buildVertices(chunk, coarsest);
+      std::copy(v.begin(), v.end(), vertices.begin() + std::ptrdiff_t(chunk*coarseBytes));
+      for (size_t i = 0;i<coarseIndices.size();++i) {
+        indices[chunk*coarseIndices.size()+i] = GLuint(chunk*coarseVertexCount) + coarseIndices[i];
+      }
+    }
+  }, 256);
+  baseVertices.setData(vertices, format);
+  baseIndices.setData(indices);
+  baseArray.configure(baseVertices, format, program);
+  baseArray.connectIndexBuffer(baseIndices);
+}
+
+Terrain::~Terrain() {
+  for (Build& build : builds) build.vertices.wait();
+}
+
+float Terrain::sampleHeight(int64_t x, int64_t y) const {
+  x = std::clamp<int64_t>(x, 0, int64_t(heights.getWidth())-1);
+  y = std::clamp<int64_t>(y, 0, int64_t(heights.getHeight())-1);
+  return heights.getData()[heights.getLayout().index(size_t(x), size_t(y))];
+}
+
+void Terrain::analyze() {
+  const size_t n = settings.chunkSize;
+  const size_t side = n+1;
+  const size_t chunkCount = chunksX*chunksY;
+  const float heightScale = std::abs(settings.heightScale);
+  std::vector<float> minHeights(chunkCount);
+  std::vector<float> maxHeights(chunkCount);
+  errors.assign(chunkCount*levelCount, 0.0f);
+
+  Parallel::forRange(0, chunkCount, [&](size_t begin, size_t end) {
+    std::vector<float> h(side*side);
+    for (size_t chunk = begin;chunk<end;++chunk) {
+      const int64_t x0 = int64_t((chunk % chunksX)*n);
+      const int64_t y0 = int64_t((chunk / chunksX)*n);
+      for (size_t y = 0;y<side;++y) {
+        for (size_t x = 0;x<side;++x) h[y*side+x] = sampleHeight(x0+int64_t(x), y0+int64_t(y));
+      }
+      const auto range = std::minmax_element(h.begin(), h.end());
+      minHeights[chunk] = *range.first;
+      maxHeights[chunk] = *range.second;
+
+      // largest deviation of the full resolution samples from the triangles
+      // of each level, kept monotonic so coarser never means more accurate
+      float error = 0.0f;
+      for (uint32_t level = 1;level<levelCount;++level) {
+        const size_t step = size_t(1) << level;
+        const size_t cells = n >> level;
+        for (size_t y = 0;y<side;++y) {
+          const size_t cy = std::min(y/step, cells-1);
+          const float v = float(y - cy*step)/float(step);
+          for (size_t x = 0;x<side;++x) {
+            const size_t cx = std::min(x/step, cells-1);
+            const float u = float(x - cx*step)/float(step);
+            const float a = h[(cy*step)*side + cx*step];
+            const float b = h[(cy*step)*side + (cx+1)*step];
+            const float c = h[((cy+1)*step)*side + (cx+1)*step];
+            const float d = h[((cy+1)*step)*side + cx*step];
+            const float interpolated = u >= v ? a + u*(b-a) + v*(c-b)
+                                              : a + v*(d-a) + u*(c-d);
+            error = std::max(error, std::abs(h[y*side+x] - interpolated));
+          }
+        }
+        errors[chunk*levelCount+level] = error*heightScale;
+      }
+    }
+  }, 16);
+
+  // two neighbours at any levels are at most their coarsest errors apart
+  const uint32_t coarsest = levelCount-1;
+  const float margin = 0.01f*settings.cellSize;
+  skirtDepths.assign(chunkCount, 0.0f);
+  chunkBounds.resize(chunkCount);
+  bounds = AABB{};
+  for (size_t cy = 0;cy<chunksY;++cy) {
+    for (size_t cx = 0;cx<chunksX;++cx) {
+      const size_t chunk = cy*chunksX+cx;
+      float neighbour = 0.0f;
+      if (cx > 0)         neighbour = std::max(neighbour, errors[(chunk-1)*levelCount+coarsest]);
+      if (cx+1 < chunksX) neighbour = std::max(neighbour, errors[(chunk+1)*levelCount+coarsest]);
+      if (cy > 0)         neighbour = std::max(neighbour, errors[(chunk-chunksX)*levelCount+coarsest]);
+      if (cy+1 < chunksY) neighbour = std::max(neighbour, errors[(chunk+chunksX)*levelCount+coarsest]);
+      skirtDepths[chunk] = errors[chunk*levelCount+coarsest] + neighbour + margin;
+
+      const float h0 = minHeights[chunk]*settings.heightScale;
+      const float h1 = maxHeights[chunk]*settings.heightScale;
+      const size_t x1 = std::min((cx+1)*n, heights.getWidth()-1);
+      const size_t y1 = std::min((cy+1)*n, heights.getHeight()-1);
+      AABB box;
+      box.add(settings.origin + Vec3{float(cx*n)*settings.cellSize,
+                                     std::min(h0,h1) - skirtDepths[chunk],
+                                     float(cy*n)*settings.cellSize});
+      box.add(settings.origin + Vec3{float(x1)*settings.cellSize,
+                                     std::max(h0,h1),
+                                     float(y1)*settings.cellSize});
+      chunkBounds.set(chunk, box);
+      bounds.add(box);
+    }
+  }
+}
+
+std::vector<uint8_t> Terrain::buildVertices(size_t chunk, uint32_t level) const {
+  const int64_t n = int64_t(settings.chunkSize);
+  const int64_t step = int64_t(1) << level;
+  const int64_t cells = n >> level;
+  const size_t side = size_t(cells+1);
+  const int64_t x0 = int64_t(chunk % chunksX)*n;
+  const int64_t y0 = int64_t(chunk / chunksX)*n;
+  const int64_t maxX = int64_t(heights.getWidth())-1;
+  const int64_t maxY = int64_t(heights.getHeight())-1;
+  const float cellSize = settings.cellSize;
+  const float heightScale = settings.heightScale;
+  const float depth = skirtDepths[chunk];
+  const size_t stride = format.getStride();
+  std::vector<uint8_t> vertices((side*side + 4*side)*stride);
+
+  auto vertex = [&](size_t index, int64_t x, int64_t y, float drop) {
+    x = std::min(x, maxX);
+    y = std::min(y, maxY);
+    const float position[3] = {
+      settings.origin.x + float(x)*cellSize,
+      settings.origin.y + sampleHeight(x,y)*heightScale - drop,
+      settings.origin.z + float(y)*cellSize
+    };
+    // slope across one cell of this level, so coarse levels shade smoothly
+    const int64_t xl = std::max<int64_t>(x-step, 0), xr = std::min(x+step, maxX);
+    const int64_t yl = std::max<int64_t>(y-step, 0), yr = std::min(y+step, maxY);
+    const float dx = (sampleHeight(xr,y) - sampleHeight(xl,y))*heightScale / (float(xr-xl)*cellSize);
+    const float dz = (sampleHeight(x,yr) - sampleHeight(x,yl))*heightScale / (float(yr-yl)*cellSize);
+    const Vec3 normal = Vec3::normalize(Vec3{-dx, 1.0f, -dz});
+    const float packedNormal[4] = {normal.x, normal.y, normal.z, 0.0f};
+    uint8_t* v = vertices.data() + index*stride;
+    format.packAttribute(v, 0, position);
+    format.packAttribute(v, 1, packedNormal);
+  };
+
+  for (size_t j = 0;j<side;++j) {
+    for (size_t i = 0;i<side;++i) {
+      vertex(j*side+i, x0+int64_t(i)*step, y0+int64_t(j)*step, 0.0f);
+    }
+  }
+
+  // skirt rings in the order of buildIndices(): south, north, west, east
+  const size_t skirt = side*side;
+  const int64_t far = cells*step;
+  for (size_t k = 0;k<side;++k) {
+    const int64_t along = int64_t(k)*step;
+    vertex(skirt + k,        x0+along, y0,       depth);
+    vertex(skirt + side+k,   x0+along, y0+far,   depth);
+    vertex(skirt + 2*side+k, x0,       y0+along, depth);
+    vertex(skirt + 3*side+k, x0+far,   y0+along, depth);
+  }
+  return vertices;
+}
+
+std::vector<GLuint> Terrain::buildIndices(uint32_t n) {
+  const GLuint side = n+1;
+  std::vector<GLuint> indices;
+  indices.reserve(6*n*n + 24*n);
+
+  // counter clockwise seen from +y, split along the same diagonal the
+  // errors of analyze() are measured against
+  for (GLuint j = 0;j<n;++j) {
+    for (GLuint i = 0;i<n;++i) {
+      const GLuint a = j*side+i;
+      const GLuint b = a+1;
+      const GLuint d = a+side;
+      const GLuint c = d+1;
+      indices.insert(indices.end(), {a, c, b, a, d, c});
+    }
+  }
+
+  // skirt quads facing outwards
+  const GLuint skirt = side*side;
+  for (GLuint k = 0;k<n;++k) {
+    const GLuint south = skirt + k;
+    const GLuint north = skirt + side + k;
+    const GLuint west = skirt + 2*side + k;
+    const GLuint east = skirt + 3*side + k;
+    indices.insert(indices.end(), {k, k+1, south, k+1, south+1, south});
+    indices.insert(indices.end(), {n*side+k, north, n*side+k+1, n*side+k+1, north, north+1});
+    indices.insert(indices.end(), {k*side, west, (k+1)*side, (k+1)*side, west, west+1});
+    indices.insert(indices.end(), {k*side+n, (k+1)*side+n, east, (k+1)*side+n, east+1, east});
+  }
+  return indices;
+}
+
+float Terrain::getHeight(float x, float z) const {
+  const float maxX = float(heights.getWidth()-1);
+  const float maxY = float(heights.getHeight()-1);
+  const float gx = std::clamp((x - settings.origin.x)/settings.cellSize, 0.0f, maxX);
+  const float gy = std::clamp((z - settings.origin.z)/settings.cellSize, 0.0f, maxY);
+  const int64_t ix = std::min(int64_t(gx), int64_t(maxX)-1);
+  const int64_t iy = std::min(int64_t(gy), int64_t(maxY)-1);
+  const float u = gx - float(ix);
+  const float v = gy - float(iy);
+  const float a = sampleHeight(ix,   iy);
+  const float b = sampleHeight(ix+1, iy);
+  const float c = sampleHeight(ix+1, iy+1);
+  const float d = sampleHeight(ix,   iy+1);
+  const float h = u >= v ? a + u*(b-a) + v*(c-b) : a + v*(d-a) + u*(c-d);
+  return settings.origin.y + h*settings.heightScale;
+}
+
+uint32_t Terrain::selectLevel(size_t chunk, float distance, float pixelsPerUnit, float pixels) const {
+  // error*pixelsPerUnit/distance <= pixels, without dividing by a zero distance
+  for (uint32_t level = levelCount-1;level>0;--level) {
+    if (errors[chunk*levelCount+level]*pixelsPerUnit <= pixels*distance) return level;
+  }
+  return 0;
+}
+
+void Terrain::release(size_t chunk) {
+  stats.residentBytes -= meshes[chunk]->bytes;
+  --stats.residentChunks;
+  meshes[chunk].reset();
+}
+
+size_t Terrain::uploadBuilds() {
+  size_t uploaded = 0;
+  for (size_t i = 0;i<builds.size() && uploaded < settings.uploadBudget;) {
+    if (!builds[i].isReady()) {
+      ++i;
+      continue;
+    }
+    Build build = std::move(builds[i]);
+    builds.erase(builds.begin()+std::ptrdiff_t(i));
+    building[build.chunk] = 0;
+    const std::vector<uint8_t> vertices = build.vertices.get();
+
+    std::unique_ptr<Mesh>& mesh = meshes[build.chunk];
+    const bool created = !mesh;
+    if (created) {
+      mesh = std::make_unique<Mesh>();
+      ++stats.residentChunks;
+    } else {
+      stats.residentBytes -= mesh->bytes;
+    }
+    mesh->vertices.setData(vertices, format);
+    if (created) mesh->array.configure(mesh->vertices, format, program);
+    mesh->array.connectIndexBuffer(levelIndices[build.level]);
+    mesh->level = build.level;
+    mesh->bytes = vertices.size();
+    mesh->lastFrame = frame;
+    stats.residentBytes += mesh->bytes;
+    uploaded += mesh->bytes;
+  }
+  return uploaded;
+}
+
+void Terrain::evict() {
+  if (stats.residentBytes <= settings.residentBudget) return;
+  std::vector<size_t> candidates;
+  for (size_t chunk = 0;chunk<meshes.size();++chunk) {
+    if (meshes[chunk] && meshes[chunk]->lastFrame < frame) candidates.push_back(chunk);
+  }
+  std::sort(candidates.begin(), candidates.end(), [this](size_t a, size_t b) {
+    return meshes[a]->lastFrame < meshes[b]->lastFrame;
+  });
+  for (size_t chunk : candidates) {
+    if (stats.residentBytes <= settings.residentBudget) break;
+    release(chunk);
+  }
+}
+
+void Terrain::update(const Mat4& view, const Mat4& projection, uint32_t viewportHeight) {
+  ++frame;
+  stats.uploadedBytes = uploadBuilds();
+
+  const Frustum frustum(projection*view);
+  stats.visibleChunks = frustum.cull(chunkBounds, visibility);
+  const Vec3 eye = (Mat4::inverse(view) * Vec4{0.0f, 0.0f, 0.0f, 1.0f}).xyz;
+  const float* p = projection;
+  const float pixelsPerUnit = 0.5f*float(viewportHeight)*p[5];
+  const uint32_t coarsest = levelCount-1;
+
+  struct Request {
+    size_t chunk;
+    uint32_t level;
+    bool refine;
+    float distance;
+  };
+  std::vector<Request> requests;
+  visibleChunks.clear();
+  for (size_t chunk = 0;chunk<visibility.size();++chunk) {
+    if (!visibility[chunk]) continue;
+    const float dx = std::max(std::abs(eye.x-chunkBounds.cx[chunk]) - chunkBounds.ex[chunk], 0.0f);
+    const float dy = std::max(std::abs(eye.y-chunkBounds.cy[chunk]) - chunkBounds.ey[chunk], 0.0f);
+    const float dz = std::max(std::abs(eye.z-chunkBounds.cz[chunk]) - chunkBounds.ez[chunk], 0.0f);
+    const float distance = std::sqrt(dx*dx + dy*dy + dz*dz);
+    visibleChunks.push_back({chunk, distance});
+
+    const uint32_t level = selectLevel(chunk, distance, pixelsPerUnit, settings.maxPixelError);
+    Mesh* mesh = meshes[chunk].get();
+    if (mesh) mesh->lastFrame = frame;
+    if (building[chunk]) continue;
+    const uint32_t resident = mesh ? mesh->level : coarsest;
+    if (level < resident) {
+      requests.push_back({chunk, level, true, distance});
+    } else if (level > resident) {
+      // only coarsen once the chunk is well within the error, so a camera
+      // hovering at a threshold does not rebuild the chunk every frame
+      const uint32_t relaxed = selectLevel(chunk, distance, pixelsPerUnit, 0.5f*settings.maxPixelError);
+      if (relaxed <= resident) continue;
+      if (level == coarsest) {
+        release(chunk);
+      } else {
+        requests.push_back({chunk, level, false, distance});
+      }
+    }
+  }
+
+  // missing detail first, nearest first
+  std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+    if (a.refine != b.refine) return a.refine;
+    return a.distance < b.distance;
+  });
+  for (const Request& request : requests) {
+    if (builds.size() >= settings.maxPendingBuilds) break;
+    const size_t chunk = request.chunk;
+    const uint32_t level = request.level;
+    building[chunk] = 1;
+    builds.push_back({chunk, level, ThreadPool::shared().submit([this, chunk, level]() {
+      return buildVertices(chunk, level);
+    })});
+  }
+
+  evict();
+  std::sort(visibleChunks.begin(), visibleChunks.end(), [](const Visible& a, const Visible& b) {
+    return a.distance < b.distance;
+  });
+  stats.pendingBuilds = builds.size();
+}
+
+void Terrain::render(const Mat4& view, const Mat4& projection,
+                     const Vec3& lightDirection, const Vec3& color) {
+  stats.drawnTriangles = 0;
+  if (visibleChunks.empty()) return;
+
+  program.enable();
+  program.setUniform(mvpLocation, projection*view);
+  program.setUniform(lightLocation, Vec3::normalize(lightDirection));
+  program.setUniform(colorLocation, color);
+
+  const size_t baseCount = levelIndexCounts.back();
+  const size_t baseChunkBytes = baseCount*indexSize(baseIndices.getType());
+  const GLArray* bound = nullptr;
+  for (const Visible& visible : visibleChunks) {
+    const Mesh* mesh = meshes[visible.chunk].get();
+    const GLArray& array = mesh ? mesh->array : baseArray;
+    if (&array != bound) {
+      array.bind();
+      bound = &array;
+    }
+    if (mesh) {
+      const size_t count = levelIndexCounts[mesh->level];
+      GL(glDrawElements(GL_TRIANGLES, GLsizei(count), levelIndices[mesh->level].getType(), (void*)0));
+      stats.drawnTriangles += count/3;
+    } else {
+      GL(glDrawElements(GL_TRIANGLES, GLsizei(baseCount), baseIndices.getType(),
+                        (void*)(visible.chunk*baseChunkBytes)));
+      stats.drawnTriangles += baseCount/3;
+    }
+  }
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <future>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#include "Vec3.h"
+#include "Mat4.h"
+#include "Bounds.h"
+#include "Grid2D.h"
+#include "GLProgram.h"
+#include "GLBuffer.h"
+#include "GLArray.h"
+#include "VertexFormat.h"
+
+/**
+ * @file Terrain.h
+ * @brief Chunked level-of-detail renderer for large @ref Grid2D heightfields.
+ *
+ * The heightfield is split into square chunks of @c chunkSize quads
+ * (geomipmapping). Level l of a chunk keeps every 2^l-th sample, so all
+ * chunks of one level share the same triangulation and draw with one index
+ * buffer per level. At construction every level of every chunk gets its
+ * geometric error, the largest height difference between the full
+ * resolution samples and the simplified surface. Per frame, @ref update()
+ * culls the chunk boxes against the view frustum and picks for each visible
+ * chunk the coarsest level whose error projects to at most
+ * @c maxPixelError pixels.
+ *
+ * Vertex data of the selected levels is built on the shared
+ * @ref ThreadPool and uploaded from @ref update() within a byte budget per
+ * call, nearest and most under-detailed chunks first; meshes that were not
+ * drawn recently are evicted when the resident size exceeds its budget. The
+ * coarsest level of all chunks stays resident in one buffer, so a chunk is
+ * drawn at some level while its detail is still being built.
+ *
+ * Neighbouring chunks at different levels do not share their edge vertices.
+ * Each chunk hangs a skirt from its border, deep enough to cover the largest
+ * possible gap to any neighbour (the sum of both coarsest-level errors), so
+ * the surface is crack free without stitching index buffers.
+ *
+ * Sample (x,y) of the grid lies at world position
+ * origin + (x*cellSize, height*heightScale, y*cellSize), y up. Chunks read
+ * the grid through its @ref GridLayout, a Tiled grid keeps their samples
+ * together in memory.
+ *
+ * @code
+ * Terrain terrain(Noise(settings).generate(8192, 8192, MemoryLayout::Tiled));
+ * // per frame (GL thread), with depth testing enabled:
+ * terrain.update(view, projection, framebufferHeight);
+ * terrain.render(view, projection);
+ * @endcode
+ */
+class Terrain {
+public:
+  /** @brief Geometry, level selection and streaming parameters. */
+  struct Settings {
+    uint32_t chunkSize{64};          ///< Quads per chunk edge at full detail, a power of two (at most 128).
+    float cellSize{1.0f};            ///< World distance between neighbouring samples.
+    float heightScale{1.0f};         ///< World height of a sample value of 1.
+    Vec3 origin{0.0f, 0.0f, 0.0f};   ///< World position of sample (0,0) at height 0.
+    float maxPixelError{2.0f};       ///< Largest allowed screen-space error in pixels.
+    size_t uploadBudget{4*1024*1024};      ///< Vertex bytes uploaded per @ref update().
+    size_t residentBudget{256*1024*1024};  ///< Vertex bytes of detail meshes kept on the GPU.
+    size_t maxPendingBuilds{16};     ///< Chunk meshes built in the background at a time.
+  };
+
+  /** @brief Counters of the last @ref update(). */
+  struct Stats {
+    size_t visibleChunks{0};   ///< Chunks inside the frustum.
+    size_t drawnTriangles{0};  ///< Triangles drawn by @ref render(), skirts included.
+    size_t residentChunks{0};  ///< Chunks with a detail mesh on the GPU.
+    size_t residentBytes{0};   ///< Vertex bytes of those meshes.
+    size_t pendingBuilds{0};   ///< Meshes being built in the background.
+    size_t uploadedBytes{0};   ///< Vertex bytes uploaded by the last @ref update().
+  };
+
+  /**
+   * @brief Analyze @p heights and upload the coarsest level of all chunks.
+   * @param heights  Heightfield, kept by the terrain (move large grids in).
+   * @param settings Geometry and streaming parameters.
+   * @throw std::invalid_argument If chunkSize is not a power of two in
+   *        [2,128] or the grid has fewer than 2×2 samples.
+   */
+  Terrain(Grid2D heights, const Settings& settings);
+
+  /** @brief Terrain with default settings. */
+  explicit Terrain(Grid2D heights);
+
+  /** @brief Wait for the background builds, which reference the terrain. */
+  ~Terrain();
+
+  Terrain(const Terrain&) = delete;
+  Terrain& operator=(const Terrain&) = delete;
+
+  const Settings& getSettings() const {return settings;}
+  const Grid2D& getHeights() const {return heights;}
+  const Stats& getStats() const {return stats;}
+
+  /** @brief Number of chunks along x and along y of the grid. */
+  size_t getChunkCountX() const {return chunksX;}
+  size_t getChunkCountY() const {return chunksY;}
+  /** @brief Number of levels, level 0 is full detail. */
+  uint32_t getLevelCount() const {return levelCount;}
+
+  /** @brief World-space bounds of the whole terrain, skirts included. */
+  const AABB& getBounds() const {return bounds;}
+
+  /**
+   * @brief Interpolated world height below the world position (@p x, @p z).
+   *
+   * Follows the full detail triangulation, positions outside the grid are
+   * clamped to its border.
+   */
+  float getHeight(float x, float z) const;
+
+  /**
+   * @brief Cull, select levels and stream meshes for a view (GL thread only).
+   * @param view             World to camera transform.
+   * @param projection       Perspective projection.
+   * @param viewportHeight   Height of the viewport in pixels, converts the
+   *                         projected error into pixels.
+   */
+  void update(const Mat4& view, const Mat4& projection, uint32_t viewportHeight);
+
+  /**
+   * @brief Draw the chunks selected by the last @ref update(), front to back.
+   * @param lightDirection World direction towards the light.
+   * @param color          Diffuse color of the surface.
+   * @note Uses the current depth and culling state; triangles are counter
+   *       clockwise seen from above.
+   */
+  void render(const Mat4& view, const Mat4& projection,
+              const Vec3& lightDirection=Vec3{0.4f, 1.0f, 0.3f},
+              const Vec3& color=Vec3{0.55f, 0.6f, 0.45f});
+
+private:
+  /** @brief GPU mesh of one chunk at one level. */
+  struct Mesh {
+    GLBuffer vertices{GL_ARRAY_BUFFER};
+    GLArray array;
+    uint32_t level{0};
+    size_t bytes{0};
+    uint64_t lastFrame{0};  ///< Last update() that selected the chunk.
+  };
+
+  /** @brief Vertex data built in the background. */
+  struct Build {
+    size_t chunk;
+    uint32_t level;
+    std::future<std::vector<uint8_t>> vertices;
+
+    bool isReady() const {
+      return vertices.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+  };
+
+  /** @brief Visible chunk of the current frame. */
+  struct Visible {
+    size_t chunk;
+    float distance;
+  };
+
+  Settings settings;
+  Grid2D heights;
+  size_t chunksX;
+  size_t chunksY;
+  uint32_t levelCount;
+  AABB bounds;
+
+  AABBArray chunkBounds;              ///< World bounds per chunk, skirts included.
+  std::vector<float> errors;          ///< World-space error per chunk and level, chunk-major.
+  std::vector<float> skirtDepths;     ///< Skirt depth per chunk.
+
+  GLProgram program;
+  GLint mvpLocation;
+  GLint lightLocation;
+  GLint colorLocation;
+  VertexFormat format;
+  GLArray baseArray;                  ///< Coarsest level of all chunks.
+  GLBuffer baseVertices;
+  GLBuffer baseIndices;
+  std::vector<GLBuffer> levelIndices; ///< Shared triangulation per level.
+  std::vector<size_t> levelIndexCounts;
+
+  std::vector<std::unique_ptr<Mesh>> meshes;  ///< Detail mesh per chunk, may be empty.
+  std::vector<uint8_t> building;      ///< 1 while a chunk has a build in flight.
+  std::vector<Build> builds;
+  std::vector<Visible> visibleChunks;
+  std::vector<uint8_t> visibility;
+  uint64_t frame{0};
+  Stats stats;
+
+  /** @brief Full resolution height at grid sample (x,y), clamped to the grid. */
+  float sampleHeight(int64_t x, int64_t y) const;
+
+  /** @brief Chunk errors, skirts and bounds. */
+  void analyze();
+
+  /** @brief Interleaved vertices of @p chunk at @p level: grid samples, then skirt. */
+  std::vector<uint8_t> buildVertices(size_t chunk, uint32_t level) const;
+
+  /** @brief Triangles and skirt of a chunk with n×n quads. */
+  static std::vector<GLuint> buildIndices(uint32_t n);
+
+  /** @brief Coarsest level with a projected error of at most @p pixels. */
+  uint32_t selectLevel(size_t chunk, float distance, float pixelsPerUnit, float pixels) const;
+
+  /** @brief Upload finished builds within the budget; returns bytes. */
+  size_t uploadBuilds();
+
+  /** @brief Drop the detail mesh of @p chunk, it falls back to the coarsest level. */
+  void release(size_t chunk);
+
+  /** @brief Drop least recently selected meshes until the budget holds. */
+  void evict();
+};
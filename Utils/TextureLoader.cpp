@@ -0,0 +1,72 @@
+#include "TextureLoader.h"
+#include "ThreadPool.h"
+
+TextureLoader::TextureLoader(size_t uploadBudget) :
+  uploadBudget(uploadBudget)
+{
+}
+
+TextureLoader::Handle TextureLoader::request(GLTexture2D& texture, const std::string& filename,
+                                             bool flipY, bool mipmap) {
+  const Handle handle = nextHandle++;
+  pending.push_back({handle, &texture, mipmap, ImageLoader::loadAsync(filename, flipY), {}});
+  loaded.push_back(0);
+  return handle;
+}
+
+TextureLoader::Handle TextureLoader::requestCompressed(GLTexture2D& texture, const std::string& filename,
+                                                       BCFormat format, bool flipY) {
+  const Handle handle = nextHandle++;
+  std::future<CompressedImage> compressed = ThreadPool::shared().submit([filename, format, flipY]() {
+    return BCEncoder::loadOrEncode(filename, format, flipY);
+  });
+  pending.push_back({handle, &texture, false, {}, std::move(compressed)});
+  loaded.push_back(0);
+  return handle;
+}
+
+size_t TextureLoader::upload(Request& request) {
+  // get() rethrows decoding errors
+  size_t bytes;
+  if (request.image.valid()) {
+    const ImageLoader::DecodedImage image = request.image.get();
+    // allocate the mip chain with level 0, generateMipmap() would copy otherwise
+    if (request.mipmap) request.texture->setMipmaps(true);
+    request.texture->setData(image.pixels.get(), image.width, image.height, image.componentCount);
+    bytes = image.size();
+  } else {
+    const CompressedImage image = request.compressed.get();
+    request.texture->setCompressedData(image);
+    bytes = image.data.size();
+  }
+  if (request.mipmap) request.texture->generateMipmap();
+  loaded[request.handle] = 1;
+  return bytes;
+}
+
+size_t TextureLoader::update() {
+  size_t uploaded = 0;
+  for (size_t i = 0;i<pending.size() && uploaded < uploadBudget;) {
+    Request& r = pending[i];
+    if (!r.isReady()) {
+      ++i;
+      continue;
+    }
+    Request request = std::move(r);
+    pending.erase(pending.begin()+std::ptrdiff_t(i));
+    uploaded += upload(request);
+  }
+  return uploaded;
+}
+
+void TextureLoader::finish() {
+  while (!pending.empty()) {
+    Request request = std::move(pending.front());
+    pending.erase(pending.begin());
+    upload(request);
+  }
+}
+
+bool TextureLoader::isLoaded(Handle handle) const {
+  return handle < loaded.size() && loaded[handle];
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <future>
+#include <chrono>
+#include <cstdint>
+
+#include "ImageLoader.h"
+#include "BCEncoder.h"
+#include "GLTexture2D.h"
+
+/**
+ * @file TextureLoader.h
+ * @brief Asynchronous texture loading with budgeted uploads on the GL thread.
+ *
+ * A @ref TextureLoader decodes image files on the shared @ref ThreadPool
+ * (see @ref ImageLoader::loadAsync()) and uploads the finished images into
+ * their @ref GLTexture2D targets from @ref update(), which must be called on
+ * the thread that owns the GL context, typically once per frame (GLApp does
+ * this). Each call uploads at most @ref getUploadBudget() bytes, so a burst
+ * of finished decodes is spread over several frames instead of stalling one.
+ *
+ * Usage:
+ * @code
+ * TextureLoader::Handle h = textureLoader.request(stonesDiffuse, "res/Stones_Diffuse.png");
+ * // per frame: textureLoader.update();
+ * if (textureLoader.isLoaded(h)) ...
+ * @endcode
+ *
+ * @note Target textures are referenced by pointer and must outlive the
+ *       request. Until the upload happened they keep their previous contents.
+ */
+class TextureLoader {
+public:
+  /** @brief Identifies a request. */
+  typedef size_t Handle;
+
+  /**
+   * @brief Create a loader.
+   * @param uploadBudget Bytes uploaded per @ref update() call (at least one
+   *                     texture is always uploaded if one is ready).
+   */
+  explicit TextureLoader(size_t uploadBudget=8*1024*1024);
+
+  /**
+   * @brief Start decoding @p filename for @p texture.
+   * @param texture  Target texture, filled by a later @ref update().
+   * @param filename Image file (formats supported by stb_image).
+   * @param flipY    Flip rows vertically on load.
+   * @param mipmap   Generate mipmaps after the upload.
+   * @return Handle to query the state of the request.
+   */
+  Handle request(GLTexture2D& texture, const std::string& filename,
+                 bool flipY=true, bool mipmap=false);
+
+  /**
+   * @brief Start decoding and block-compressing @p filename for @p texture.
+   *
+   * Runs BCEncoder::loadOrEncode() on the pool, so the file is only encoded
+   * the first time and later runs read the cached blocks.
+   * @param texture  Target texture, filled by a later @ref update().
+   * @param filename Image file (formats supported by stb_image).
+   * @param format   Block compression format.
+   * @param flipY    Flip rows vertically on load.
+   * @return Handle to query the state of the request.
+   */
+  Handle requestCompressed(GLTexture2D& texture, const std::string& filename,
+                           BCFormat format, bool flipY=true);
+
+  /**
+   * @brief Upload finished decodes within the byte budget (GL thread only).
+   * @return Number of bytes uploaded.
+   * @throw ImageLoader::Exception If a requested file could not be decoded.
+   */
+  size_t update();
+
+  /** @brief Block until every request has been decoded and uploaded (GL thread only). */
+  void finish();
+
+  /** @brief True once the texture of @p handle has been uploaded. */
+  bool isLoaded(Handle handle) const;
+  /** @brief Number of requests not uploaded yet. */
+  size_t getPendingCount() const {return pending.size();}
+
+  /** @brief Change the per-update upload budget in bytes. */
+  void setUploadBudget(size_t bytes) {uploadBudget = bytes;}
+  /** @brief Per-update upload budget in bytes. */
+  size_t getUploadBudget() const {return uploadBudget;}
+
+private:
+  /** @brief A request waiting for its decode or upload. */
+  struct Request {
+    Handle handle;                                  ///< Request id.
+    GLTexture2D* texture;                           ///< Upload target.
+    bool mipmap;                                    ///< Generate mipmaps after upload.
+    std::future<ImageLoader::DecodedImage> image;   ///< Result of the decode job (uncompressed).
+    std::future<CompressedImage> compressed;        ///< Result of the encode job (compressed).
+
+    /** @brief True once the decode or encode job has finished. */
+    bool isReady() const {
+      const std::future_status status = image.valid()
+        ? image.wait_for(std::chrono::seconds(0))
+        : compressed.wait_for(std::chrono::seconds(0));
+      return status == std::future_status::ready;
+    }
+  };
+
+  size_t uploadBudget;              ///< Bytes per update().
+  Handle nextHandle{0};             ///< Handle of the next request.
+  std::vector<Request> pending;     ///< Requests in submission order.
+  std::vector<uint8_t> loaded;      ///< Upload state per handle.
+
+  /** @brief Upload @p request (its decode must be finished); returns bytes. */
+  size_t upload(Request& request);
+};
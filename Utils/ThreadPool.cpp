@@ -0,0 +1,42 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threadCount) {
+  for (size_t i = 0;i<threadCount;++i) {
+    workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeup.notify_all();
+  for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::work() {
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wakeup.wait(lock, [this]() {return stopping || !jobs.empty();});
+      if (jobs.empty()) return;
+      job = std::move(jobs.front());
+      jobs.pop_front();
+    }
+    job();
+  }
+}
+
+ThreadPool& ThreadPool::shared() {
+#ifdef __EMSCRIPTEN__
+  static ThreadPool pool{0};
+#else
+  // leave one hardware thread to the render loop
+  static ThreadPool pool{std::max<size_t>(2, std::thread::hardware_concurrency())-1};
+#endif
+  return pool;
+}
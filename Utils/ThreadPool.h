@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+/**
+ * @file ThreadPool.h
+ * @brief Fixed set of worker threads executing queued jobs.
+ *
+ * Unlike @ref Parallel::forRange(), which forks and joins threads for one data
+ * parallel loop, a @ref ThreadPool keeps its workers alive and processes
+ * independent jobs (file decoding, compression, ...) in submission order. Each
+ * @ref ThreadPool::submit() returns a std::future for the job's result;
+ * exceptions thrown by a job are delivered through that future.
+ *
+ * Usage:
+ * @code
+ * std::future<Image> f = ThreadPool::shared().submit([]{return ImageLoader::load("a.png");});
+ * // ... other work ...
+ * Image image = f.get();
+ * @endcode
+ *
+ * @note A pool with zero workers runs every job inside submit(); this is the
+ *       default under Emscripten, where threads are usually unavailable.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Start @p threadCount workers.
+   * @param threadCount Number of workers; 0 executes jobs synchronously.
+   */
+  explicit ThreadPool(size_t threadCount);
+
+  /** @brief Finish all queued jobs and join the workers. */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Queue @p job for execution on a worker.
+   * @return Future receiving the result (or exception) of @p job.
+   */
+  template<typename F>
+  auto submit(F&& job) -> std::future<decltype(job())> {
+    typedef decltype(job()) R;
+    std::shared_ptr<std::packaged_task<R()>> task =
+      std::make_shared<std::packaged_task<R()>>(std::forward<F>(job));
+    std::future<R> result = task->get_future();
+    if (workers.empty()) {
+      (*task)();
+    } else {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back([task]() {(*task)();});
+      }
+      wakeup.notify_one();
+    }
+    return result;
+  }
+
+  /** @brief Number of worker threads. */
+  size_t getThreadCount() const {return workers.size();}
+
+  /**
+   * @brief Process-wide pool with one worker per hardware thread (minus the
+   *        calling thread), created on first use.
+   */
+  static ThreadPool& shared();
+
+private:
+  std::vector<std::thread> workers;          ///< Worker threads.
+  std::deque<std::function<void()>> jobs;    ///< Jobs waiting for a worker.
+  std::mutex mutex;                          ///< Guards @ref jobs and @ref stopping.
+  std::condition_variable wakeup;            ///< Signals new jobs or shutdown.
+  bool stopping{false};                      ///< Set by the destructor.
+
+  /** @brief Worker loop: run jobs until @ref stopping and the queue is empty. */
+  void work();
+};
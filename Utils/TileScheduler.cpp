@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "TileScheduler.h"
+
+TileScheduler::TileScheduler(size_t workerCount) {
+  queues.resize(std::max<size_t>(1, workerCount));
+  for (std::unique_ptr<Queue>& queue : queues) queue = std::make_unique<Queue>();
+}
+
+void TileScheduler::resize(uint32_t width, uint32_t height, uint32_t tileSize) {
+  clear();
+  this->width = width;
+  this->height = height;
+  this->tileSize = std::max(1u, tileSize);
+  tilesX = (width+this->tileSize-1)/this->tileSize;
+  tilesY = (height+this->tileSize-1)/this->tileSize;
+}
+
+void TileScheduler::clear() {
+  for (std::unique_ptr<Queue>& queue : queues) {
+    std::scoped_lock lock(queue->mutex);
+    queue->tiles.clear();
+  }
+  remaining = 0;
+}
+
+void TileScheduler::startPass() {
+  const size_t count = getTileCount();
+  for (size_t w = 0;w<queues.size();++w) {
+    std::scoped_lock lock(queues[w]->mutex);
+    for (size_t i = w;i<count;i+=queues.size()) queues[w]->tiles.push_back(uint32_t(i));
+  }
+  remaining += count;
+}
+
+bool TileScheduler::next(size_t worker, Tile& tile) {
+  worker %= queues.size();
+  {
+    Queue& own = *queues[worker];
+    std::scoped_lock lock(own.mutex);
+    if (!own.tiles.empty()) {
+      tile = makeTile(own.tiles.front());
+      own.tiles.pop_front();
+      --remaining;
+      return true;
+    }
+  }
+
+  // steal from the back, the end of the victim's queue it would reach last
+  for (size_t i = 1;i<queues.size() && remaining.load() > 0;++i) {
+    Queue& victim = *queues[(worker+i)%queues.size()];
+    std::scoped_lock lock(victim.mutex);
+    if (victim.tiles.empty()) continue;
+    tile = makeTile(victim.tiles.back());
+    victim.tiles.pop_back();
+    --remaining;
+    ++stolen;
+    return true;
+  }
+  return false;
+}
+
+TileScheduler::Tile TileScheduler::makeTile(uint32_t index) const {
+  Tile tile;
+  tile.index = index;
+  tile.x0 = uint32_t(index%tilesX)*tileSize;
+  tile.y0 = uint32_t(index/tilesX)*tileSize;
+  tile.x1 = std::min(width, tile.x0+tileSize);
+  tile.y1 = std::min(height, tile.y0+tileSize);
+  return tile;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @file TileScheduler.h
+ * @brief Work-stealing distribution of image tiles over worker threads.
+ *
+ * @ref TileScheduler::startPass() deals all tiles of an image round-robin
+ * into one queue per worker, so every worker starts with tiles spread over
+ * the whole image. A worker takes tiles from the front of its own queue and,
+ * once that is empty, steals from the back of the other queues. Expensive
+ * regions therefore end up shared by all workers instead of stalling the one
+ * they were assigned to.
+ *
+ * Tiles left in the queues when the workers stop stay queued, so a pass can be
+ * spread over several calls (e.g. frames with a time budget).
+ *
+ * @code
+ * TileScheduler scheduler(workerCount);
+ * scheduler.resize(width, height, 16);
+ * scheduler.startPass();
+ * // on worker w:
+ * TileScheduler::Tile tile;
+ * while (scheduler.next(w, tile)) render(tile);
+ * @endcode
+ */
+class TileScheduler {
+public:
+  /** @brief Pixel rectangle [x0,x1) x [y0,y1). */
+  struct Tile {
+    uint32_t index{0};  ///< Row-major tile index.
+    uint32_t x0{0}, y0{0}, x1{0}, y1{0};
+  };
+
+  /** @param workerCount Number of queues, one per worker thread. */
+  explicit TileScheduler(size_t workerCount);
+
+  /** @brief Split a @p width x @p height image into tiles, drops queued tiles. */
+  void resize(uint32_t width, uint32_t height, uint32_t tileSize=16);
+
+  /** @brief Queue every tile once. */
+  void startPass();
+
+  /** @brief Drop all queued tiles. */
+  void clear();
+
+  /**
+   * @brief Fetch the next tile for worker @p worker.
+   * @return False if all queues are empty.
+   */
+  bool next(size_t worker, Tile& tile);
+
+  /** @brief True if no tile of the current pass is left in a queue. */
+  bool passDone() const {return remaining.load() == 0;}
+
+  /** @brief Number of tiles per pass. */
+  size_t getTileCount() const {return tilesX*tilesY;}
+  /** @brief Number of queues. */
+  size_t getWorkerCount() const {return queues.size();}
+  /** @brief Tiles taken from another worker's queue since construction. */
+  size_t getStolenCount() const {return stolen.load();}
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<uint32_t> tiles;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::atomic<size_t> remaining{0};
+  std::atomic<size_t> stolen{0};
+  uint32_t width{0}, height{0}, tileSize{16};
+  size_t tilesX{0}, tilesY{0};
+
+  Tile makeTile(uint32_t index) const;
+};
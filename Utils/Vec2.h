@@ -196,12 +196,11 @@ public:
 
   /**
    * @brief Create a vector with components sampled from [0,1).
+   * @param rng Generator, defaults to the per-thread \c staticRand from @c Rand.h .
    * @return Random vector (x,y) in [0,1) each.
-   * @note Depends on a global/namespace-scope RNG named \c staticRand
-   *       provided by @c Rand.h .
    */
-  static Vec2t random() {
-    return Vec2t{T{staticRand.rand01()},T{staticRand.rand01()}};
+  static Vec2t random(Random& rng=staticRand) {
+    return Vec2t{T{rng.rand01()},T{rng.rand01()}};
   }
 
   /**
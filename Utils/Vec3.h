@@ -325,59 +325,56 @@ public:
 
   /**
    * @brief Create a vector with components sampled from [0,1).
+   * @param rng Generator, defaults to the per-thread \c staticRand from @c Rand.h .
    * @return Random vector (x,y,z) in [0,1) each.
-   * @note Depends on a global/namespace-scope RNG named \c staticRand
-   *       provided by @c Rand.h .
    */
-  static Vec3t<float> random() {
-    return {staticRand.rand01(),staticRand.rand01(),staticRand.rand01()};
+  static Vec3t<float> random(Random& rng=staticRand) {
+    return {rng.rand01(),rng.rand01(),rng.rand01()};
+  }
+
+  /**
+   * @brief Uniform random unit vector on the sphere.
+   * @param rng Generator, see @ref random().
+   * @return Unit-length random direction.
+   */
+  static Vec3t<float> randomUnitVector(Random& rng=staticRand) {
+    const float a = rng.rand0Pi();
+    const float z = rng.rand11();
+    const float r = sqrt(1.0f - z*z);
+    return {r*cosf(a), r*sinf(a), z};
   }
 
   /**
    * @brief Uniform random point inside the unit sphere.
+   *
+   * Scales a random direction by the cube root of a uniform radius sample,
+   * which needs exactly three numbers and no rejection loop.
+   * @param rng Generator, see @ref random().
    * @return Random point with |p| <= 1.
    */
-  static Vec3t<float> randomPointInSphere() {
-    while (true) {
-      Vec3t<float> p{staticRand.rand11(),staticRand.rand11(),staticRand.rand11()};
-      if (p.sqlength() > 1) continue;
-      return p;
-    }
+  static Vec3t<float> randomPointInSphere(Random& rng=staticRand) {
+    return randomUnitVector(rng) * cbrtf(rng.rand01());
   }
 
   /**
    * @brief Uniform random point inside the upper unit hemisphere (z>=0).
+   * @param rng Generator, see @ref random().
    * @return Random point with |p| <= 1 and z >= 0.
    */
-  static Vec3t<float> randomPointInHemisphere() {
-    while (true) {
-      Vec3t<float> p{staticRand.rand01(),staticRand.rand01(),staticRand.rand01()};
-      if (p.sqlength() > 1) continue;
-      return p;
-    }
+  static Vec3t<float> randomPointInHemisphere(Random& rng=staticRand) {
+    const Vec3t<float> p = randomPointInSphere(rng);
+    return {p.x, p.y, fabsf(p.z)};
   }
 
   /**
    * @brief Uniform random point inside the unit disc on the xy-plane.
+   * @param rng Generator, see @ref random().
    * @return Random point with x^2 + y^2 <= 1 and z = 0.
    */
-  static Vec3t<float> randomPointInDisc() {
-    while (true) {
-      Vec3t<float> p{staticRand.rand11(),staticRand.rand11(),0};
-      if (p.sqlength() > 1) continue;
-      return p;
-    }
-  }
-
-  /**
-   * @brief Uniform random unit vector on the sphere.
-   * @return Unit-length random direction.
-   */
-  static Vec3t<float> randomUnitVector() {
-    const float a = staticRand.rand0Pi();
-    const float z = staticRand.rand11();
-    const float r = sqrt(1.0f - z*z);
-    return {r*cosf(a), r*sinf(a), z};
+  static Vec3t<float> randomPointInDisc(Random& rng=staticRand) {
+    const float a = rng.rand0Pi();
+    const float r = sqrt(rng.rand01());
+    return {r*cosf(a), r*sinf(a), 0.0f};
   }
 
   /**
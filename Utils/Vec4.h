@@ -284,12 +284,11 @@ public:
 
   /**
    * @brief Create a vector with components sampled from [0,1).
+   * @param rng Generator, defaults to the per-thread \c staticRand from @c Rand.h .
    * @return Random vector (x,y,z,w) in [0,1) each.
-   * @note Depends on a global/namespace-scope RNG named \c staticRand
-   *       provided by @c Rand.h .
    */
-  static Vec4t<float> random() {
-    return {staticRand.rand01(),staticRand.rand01(),staticRand.rand01(),staticRand.rand01()};
+  static Vec4t<float> random(Random& rng=staticRand) {
+    return {rng.rand01(),rng.rand01(),rng.rand01(),rng.rand01()};
   }
 
   /**
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include "Half.h"
+#include "VertexFormat.h"
+
+static size_t attributeSize(const VertexAttribute& attribute) {
+  if (attribute.type == GLAttribType::INT_2_10_10_10_REV) return sizeof(GLuint);
+  return attribute.components*VertexFormat::typeSize(attribute.type);
+}
+
+template <typename T>
+static void storeNormalized(uint8_t* dst, const float* values, size_t count, float minValue) {
+  for (size_t i = 0;i<count;++i) {
+    const float v = std::clamp(values[i], minValue, 1.0f);
+    const T t = T(std::lround(v*float(std::numeric_limits<T>::max())));
+    std::memcpy(dst+i*sizeof(T), &t, sizeof(T));
+  }
+}
+
+VertexFormat::VertexFormat(std::initializer_list<VertexAttribute> attributes) {
+  for (const VertexAttribute& a : attributes) add(a.name, a.type, a.components);
+}
+
+VertexFormat& VertexFormat::add(const std::string& name, GLAttribType type, size_t components) {
+  if (components < 1 || components > 4 ||
+      (type == GLAttribType::INT_2_10_10_10_REV && components != 4)) {
+    std::stringstream ss;
+    ss << "Invalid component count " << components << " for vertex attribute " << name;
+    throw GLException{ss.str()};
+  }
+  const size_t offset = (stride+3) & ~size_t(3);
+  attributes.push_back({name, type, components, offset});
+  stride = (offset + attributeSize(attributes.back()) + 3) & ~size_t(3);
+  return *this;
+}
+
+size_t VertexFormat::indexOf(const std::string& name) const {
+  for (size_t i = 0;i<attributes.size();++i) {
+    if (attributes[i].name == name) return i;
+  }
+  throw GLException{std::string("Vertex format has no attribute ") + name};
+}
+
+size_t VertexFormat::typeSize(GLAttribType type) {
+  switch (type) {
+    case GLAttribType::FLOAT : return sizeof(GLfloat);
+    case GLAttribType::HALF : return sizeof(GLhalf);
+    case GLAttribType::BYTE_NORM : return sizeof(GLbyte);
+    case GLAttribType::UBYTE_NORM : return sizeof(GLubyte);
+    case GLAttribType::SHORT_NORM : return sizeof(GLshort);
+    case GLAttribType::USHORT_NORM : return sizeof(GLushort);
+    case GLAttribType::INT_2_10_10_10_REV : return sizeof(GLuint);
+  }
+  return 0;
+}
+
+GLhalf VertexFormat::toHalf(float value) {
+  return Half::fromFloat(value);
+}
+
+void VertexFormat::packAttribute(uint8_t* vertex, size_t index, const float* values) const {
+  const VertexAttribute& a = attributes[index];
+  uint8_t* dst = vertex + a.offset;
+  switch (a.type) {
+    case GLAttribType::FLOAT :
+      std::memcpy(dst, values, a.components*sizeof(GLfloat));
+      break;
+    case GLAttribType::HALF :
+      for (size_t i = 0;i<a.components;++i) {
+        const GLhalf h = toHalf(values[i]);
+        std::memcpy(dst+i*sizeof(GLhalf), &h, sizeof(GLhalf));
+      }
+      break;
+    case GLAttribType::BYTE_NORM :
+      storeNormalized<GLbyte>(dst, values, a.components, -1.0f);
+      break;
+    case GLAttribType::UBYTE_NORM :
+      storeNormalized<GLubyte>(dst, values, a.components, 0.0f);
+      break;
+    case GLAttribType::SHORT_NORM :
+      storeNormalized<GLshort>(dst, values, a.components, -1.0f);
+      break;
+    case GLAttribType::USHORT_NORM :
+      storeNormalized<GLushort>(dst, values, a.components, 0.0f);
+      break;
+    case GLAttribType::INT_2_10_10_10_REV : {
+      // x, y, z in the low 30 bits (10 bits each), w in the top two
+      uint32_t packed = 0;
+      for (size_t i = 0;i<4;++i) {
+        const int32_t maxValue = i < 3 ? 511 : 1;
+        const uint32_t bits = i < 3 ? 0x3FF : 0x3;
+        const float v = std::clamp(values[i], -1.0f, 1.0f);
+        const int32_t q = int32_t(std::lround(v*float(maxValue)));
+        packed |= (uint32_t(q) & bits) << (i*10);
+      }
+      std::memcpy(dst, &packed, sizeof(packed));
+      break;
+    }
+  }
+}
+
+std::vector<uint8_t> VertexFormat::pack(const std::vector<VertexSource>& sources, size_t vertexCount) const {
+  if (sources.size() != attributes.size()) {
+    std::stringstream ss;
+    ss << "Vertex format has " << attributes.size() << " attributes but "
+       << sources.size() << " sources were given.";
+    throw GLException{ss.str()};
+  }
+  std::vector<uint8_t> packed(stride*vertexCount, 0);
+  for (size_t i = 0;i<attributes.size();++i) {
+    const size_t sourceStride = sources[i].stride > 0 ? sources[i].stride : attributes[i].components;
+    for (size_t v = 0;v<vertexCount;++v) {
+      packAttribute(packed.data()+v*stride, i, sources[i].data+v*sourceStride);
+    }
+  }
+  return packed;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <initializer_list>
+
+#include "GLEnv.h"
+#include "GLBuffer.h"
+
+/**
+ * @file VertexFormat.h
+ * @brief Declarative description of an interleaved vertex layout.
+ *
+ * A @ref VertexFormat lists the attributes of one vertex (shader name,
+ * component type and count) in buffer order. Offsets and the stride are
+ * derived from that list, every attribute starts on a 4-byte boundary and the
+ * stride is padded to a multiple of 4 bytes, as GL implementations prefer.
+ * Normalization follows from the type: the integer types of ::GLAttribType
+ * are normalized, FLOAT and HALF are not.
+ *
+ * @ref pack() converts separate float arrays into one interleaved byte
+ * buffer, which is uploaded with GLBuffer::setData(const std::vector<uint8_t>&,
+ * const VertexFormat&, GLenum). GLArray::configure() then connects all
+ * attributes against a program in one call, so a VAO is set up once and only
+ * bound per draw.
+ *
+ * Usage:
+ * @code
+ * const VertexFormat format{{"vPos", GLAttribType::FLOAT, 3},
+ *                           {"vNormal", GLAttribType::INT_2_10_10_10_REV, 4},
+ *                           {"vTexCoords", GLAttribType::HALF, 2}};
+ * buffer.setData(format.pack({{positions}, {normals}, {uvs}}, vertexCount), format);
+ * array.configure(buffer, format, program);
+ * @endcode
+ */
+
+/**
+ * @brief One attribute of a @ref VertexFormat.
+ */
+struct VertexAttribute {
+  std::string name;      ///< Attribute identifier in the shader.
+  GLAttribType type;     ///< Component type in the buffer.
+  size_t components;     ///< Components per vertex (1..4, INT_2_10_10_10_REV requires 4).
+  size_t offset{0};      ///< Byte offset within a vertex (set by VertexFormat).
+};
+
+/**
+ * @brief Float input for one attribute of @ref VertexFormat::pack().
+ */
+struct VertexSource {
+  const float* data;     ///< First value of vertex 0.
+  size_t stride{0};      ///< Floats between consecutive vertices (0 = attribute component count).
+};
+
+class VertexFormat {
+public:
+  /** @brief Empty format, see @ref add(). */
+  VertexFormat() = default;
+
+  /**
+   * @brief Create a format from attributes in buffer order (offsets are ignored).
+   * @throw GLException If an attribute has an invalid component count.
+   */
+  VertexFormat(std::initializer_list<VertexAttribute> attributes);
+
+  /**
+   * @brief Append an attribute after the existing ones.
+   * @param name       Attribute identifier in the shader.
+   * @param type       Component type in the buffer.
+   * @param components Components per vertex.
+   * @return *this for chaining.
+   * @throw GLException If @p components is not in 1..4 or is not 4 for INT_2_10_10_10_REV.
+   */
+  VertexFormat& add(const std::string& name, GLAttribType type, size_t components);
+
+  /** @brief Attributes in buffer order, with their byte offsets. */
+  const std::vector<VertexAttribute>& getAttributes() const {return attributes;}
+  /** @brief Bytes per vertex, padded to a multiple of 4. */
+  size_t getStride() const {return stride;}
+
+  /**
+   * @brief Index of the attribute called @p name.
+   * @throw GLException If the format has no such attribute.
+   */
+  size_t indexOf(const std::string& name) const;
+
+  /**
+   * @brief Interleave @p vertexCount vertices, converting floats to the attribute types.
+   * @param sources One source per attribute in format order.
+   * @param vertexCount Number of vertices to pack.
+   * @return getStride()*vertexCount bytes, padding bytes are zero.
+   * @throw GLException If the number of sources does not match the attributes.
+   */
+  std::vector<uint8_t> pack(const std::vector<VertexSource>& sources, size_t vertexCount) const;
+
+  /**
+   * @brief Convert and store the values of attribute @p index of one vertex.
+   * @param vertex Start of the vertex in a packed buffer.
+   * @param index  Attribute index.
+   * @param values getAttributes()[index].components floats.
+   */
+  void packAttribute(uint8_t* vertex, size_t index, const float* values) const;
+
+  /** @brief Size in bytes of one component of @p type (4 for the packed type). */
+  static size_t typeSize(GLAttribType type);
+  /** @brief Convert a float to IEEE half precision (round to nearest even). */
+  static GLhalf toHalf(float value);
+
+private:
+  std::vector<VertexAttribute> attributes;
+  size_t stride{0};
+};
@@ -11,6 +11,8 @@
 
 namespace BMP {
   bool save(const std::string& filename, const Image& source, bool ignoreSize) {
+      if (source.layout != MemoryLayout::Linear)
+        return save(filename, source.toLayout(MemoryLayout::Linear), ignoreSize);
       return save(filename, source.width, source.height,
                   source.data, source.componentCount, ignoreSize);
   }
@@ -238,6 +240,7 @@ namespace BMP {
         target.width = tmp.width;
         target.height = tmp.height;
         target.data = tmp.data;
+        target.layout = tmp.layout;
       }
     }
         